@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <raptor2.h>
+
+/* rdfbench.c: measure parser throughput against the read buffer size
+ *
+ * Usage: rdfbench FILE [REPEATS [SIZE...]]
+ *
+ * FILE is parsed once (syntax guessed) and written to temporary files
+ * as N-Triples, Turtle and RDF/XML.  Each of those is then parsed
+ * REPEATS times (default 3) with each read buffer SIZE in bytes
+ * (default 4K to 16M) set with RAPTOR_OPTION_READ_BUFFER_SIZE, and
+ * the best throughput in megabytes per CPU second is printed.
+ */
+
+#define SYNTAXES_COUNT 3
+
+static const char* const syntaxes[SYNTAXES_COUNT] = {
+  "ntriples", "turtle", "rdfxml"
+};
+
+static const int default_sizes[] = {
+  4096, 65536, 262144, 1048576, 4194304, 16777216, 0
+};
+
+
+static void
+copy_triple(void* user_data, raptor_statement* triple)
+{
+  raptor_pipeline_serialize_statement((raptor_pipeline*)user_data, triple);
+}
+
+
+static void
+count_triple(void* user_data, raptor_statement* triple)
+{
+  (*(unsigned long*)user_data)++;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world = NULL;
+  const char* program = "rdfbench";
+  raptor_parser* rdf_parser;
+  raptor_serializer* serializers[SYNTAXES_COUNT];
+  raptor_pipeline* pipeline;
+  FILE* files[SYNTAXES_COUNT];
+  long file_sizes[SYNTAXES_COUNT];
+  unsigned char *uri_string;
+  raptor_uri *uri;
+  int repeats = 3;
+  const int* sizes = default_sizes;
+  int* arg_sizes = NULL;
+  int i, j, k;
+
+  if(argc < 2) {
+    fprintf(stderr, "USAGE: %s FILE [REPEATS [SIZE...]]\n", program);
+    return 1;
+  }
+  if(argc > 2)
+    repeats = atoi(argv[2]);
+  if(repeats < 1)
+    repeats = 1;
+  if(argc > 3) {
+    arg_sizes = (int*)calloc((size_t)(argc - 2), sizeof(int));
+    if(!arg_sizes)
+      return 1;
+    for(i = 3; i < argc; i++)
+      arg_sizes[i - 3] = atoi(argv[i]);
+    sizes = arg_sizes;
+  }
+
+  world = raptor_new_world();
+
+  uri_string = raptor_uri_filename_to_uri_string(argv[1]);
+  uri = raptor_new_uri(world, uri_string);
+
+  /* write the content in every syntax, each on its own thread */
+  pipeline = raptor_new_pipeline(world, NULL);
+  if(!pipeline) {
+    fprintf(stderr, "%s: Failed to create pipeline\n", program);
+    return 1;
+  }
+
+  for(i = 0; i < SYNTAXES_COUNT; i++) {
+    files[i] = tmpfile();
+    serializers[i] = raptor_new_serializer(world, syntaxes[i]);
+    if(!files[i] || !serializers[i]) {
+      fprintf(stderr, "%s: Failed to create %s output\n", program,
+              syntaxes[i]);
+      return 1;
+    }
+    raptor_serializer_start_to_file_handle(serializers[i], uri, files[i]);
+    raptor_pipeline_add_serializer(pipeline, serializers[i]);
+  }
+
+  rdf_parser = raptor_new_parser(world, "guess");
+  raptor_parser_set_statement_handler(rdf_parser, pipeline, copy_triple);
+  if(raptor_parser_parse_file(rdf_parser, uri, NULL)) {
+    fprintf(stderr, "%s: Failed to parse %s\n", program, argv[1]);
+    return 1;
+  }
+  raptor_free_parser(rdf_parser);
+
+  raptor_pipeline_end(pipeline);
+  raptor_free_pipeline(pipeline);
+
+  for(i = 0; i < SYNTAXES_COUNT; i++) {
+    raptor_serializer_serialize_end(serializers[i]);
+    raptor_free_serializer(serializers[i]);
+    fflush(files[i]);
+    file_sizes[i] = ftell(files[i]);
+  }
+
+  printf("%-10s %10s %10s %12s\n", "parser", "buffer", "MB/s", "triples");
+
+  for(i = 0; i < SYNTAXES_COUNT; i++) {
+    if(!raptor_world_is_parser_name(world, syntaxes[i])) {
+      printf("%-10s (parser not available)\n", syntaxes[i]);
+      fclose(files[i]);
+      continue;
+    }
+
+    for(j = 0; sizes[j] > 0; j++) {
+      double best = 0.0;
+      unsigned long count = 0;
+
+      for(k = 0; k < repeats; k++) {
+        clock_t start;
+        double seconds;
+
+        rdf_parser = raptor_new_parser(world, syntaxes[i]);
+        raptor_parser_set_option(rdf_parser, RAPTOR_OPTION_READ_BUFFER_SIZE,
+                                 NULL, sizes[j]);
+        raptor_parser_set_statement_handler(rdf_parser, &count, count_triple);
+
+        rewind(files[i]);
+        count = 0;
+        start = clock();
+        raptor_parser_parse_file_stream(rdf_parser, files[i], NULL, uri);
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        raptor_free_parser(rdf_parser);
+
+        if(seconds > 0.0 && (best == 0.0 || seconds < best))
+          best = seconds;
+      }
+
+      printf("%-10s %10d %10.1f %12lu\n", syntaxes[i], sizes[j],
+             best > 0.0 ? (double)file_sizes[i] / best / (1024.0 * 1024.0) : 0.0,
+             count);
+    }
+    fclose(files[i]);
+  }
+
+  if(arg_sizes)
+    free(arg_sizes);
+
+  raptor_free_uri(uri);
+  raptor_free_memory(uri_string);
+
+  raptor_free_world(world);
+
+  return 0;
+}
@@ -66,6 +66,10 @@ struct raptor_ntriples_parser_context_s {
   /* current char in line buffer */
   size_t offset;
 
+  /* buffer to decode terms into when parsing borrowed chunks */
+  unsigned char *work;
+  size_t work_size;
+
   char last_char;
   
   /* static statement for use in passing to user code */
@@ -120,6 +124,8 @@ raptor_ntriples_parse_terminate(raptor_parser* rdf_parser)
   ntriples_parser = (raptor_ntriples_parser_context*)rdf_parser->context;
   if(ntriples_parser->line_length)
     RAPTOR_FREE(cdata, ntriples_parser->line);
+  if(ntriples_parser->work)
+    RAPTOR_FREE(cdata, ntriples_parser->work);
 }
 
 
@@ -162,14 +168,26 @@ raptor_ntriples_generate_statement(raptor_parser* parser,
 
 #define MAX_NTRIPLES_TERMS 4
 
+/*
+ * raptor_ntriples_parse_line:
+ * @rdf_parser: parser
+ * @buffer: line content (not NUL terminated)
+ * @work: buffer of at least @len + 1 bytes to decode terms into (or @buffer)
+ * @len: length of line
+ * @max_terms: maximum number of terms allowed
+ *
+ * INTERNAL - Parse one N-Triples / N-Quads line and generate a statement
+ *
+ * Return value: non-0 on failure
+ */
 static int
 raptor_ntriples_parse_line(raptor_parser* rdf_parser,
-                           unsigned char *buffer, size_t len,
-                           int max_terms)
+                           const unsigned char *buffer, unsigned char *work,
+                           size_t len, int max_terms)
 {
   raptor_ntriples_parser_context *ntriples_parser = (raptor_ntriples_parser_context*)rdf_parser->context;
   int i;
-  unsigned char *p;
+  const unsigned char *p;
   raptor_term* terms[MAX_NTRIPLES_TERMS+1] = {NULL, NULL, NULL, NULL, NULL};
   int rc = 0;
   
@@ -204,10 +222,8 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
     return 0;
   
   /* Remove trailing spaces */
-  while(len > 0 && isspace((int)p[len-1])) {
-    p[len-1] = '\0';
+  while(len > 0 && isspace((int)p[len-1]))
     len--;
-  }
 
   /* can't be empty now - that would have been caught above */
   
@@ -258,7 +274,8 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
 
 
     term_len = raptor_ntriples_parse_term(rdf_parser->world, &rdf_parser->locator,
-                                          p, &len, &terms[i], 0);
+                                          p, work + (p - buffer), &len,
+                                          &terms[i], 0);
     if(!term_len) {
       rc = 1;
       goto cleanup;
@@ -297,13 +314,13 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
 #endif
 
     /* Look for terminating '.' after 3rd (ntriples) or 3rd/4th (nquads) term */
-    if(i == (ntriples_parser->is_nquads ? 4 : 3) && *p != '.') {
+    if(i == (ntriples_parser->is_nquads ? 4 : 3) && (!len || *p != '.')) {
       raptor_parser_error(rdf_parser, "Missing terminating \".\"");
       return 0;
     }
 
     /* Still may be optional so check again */
-    if(*p == '.') {
+    if(len && *p == '.') {
       p++;
       len--;
       rdf_parser->locator.column++;
@@ -318,7 +335,7 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
       }
 
       /* Only a comment is allowed here */
-      if(*p && *p != '#') {
+      if(len && *p != '#') {
         raptor_parser_error(rdf_parser, "Junk after terminating \".\"");
         return 0;
       }
@@ -371,6 +388,83 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
 }
 
 
+/*
+ * raptor_ntriples_line_end:
+ * @ptr: start of line
+ * @end_ptr: end of content
+ *
+ * INTERNAL - Find the newline ending an N-Triples line
+ *
+ * Newlines inside quoted strings are skipped.
+ *
+ * Return value: pointer to the newline or @end_ptr if there is none
+ */
+static const unsigned char*
+raptor_ntriples_line_end(const unsigned char *ptr,
+                         const unsigned char *end_ptr)
+{
+  int quote = '\0';
+  int in_uri = '\0';
+  int bq = 0;
+
+  while(ptr < end_ptr) {
+    if(!bq) {
+      if(*ptr == '\\') {
+        bq = 1;
+        ptr++;
+        continue;
+      }
+
+      if(*ptr == '<')
+        in_uri = 1;
+      else if (in_uri && *ptr == '>')
+        in_uri = 0;
+
+      if(!quote) {
+        if((!in_uri && *ptr == '\'') || *ptr == '"')
+          quote = *ptr;
+        if(*ptr == '\n' || *ptr == '\r')
+          break;
+      } else {
+        if(*ptr == quote)
+          quote = 0;
+      }
+    }
+    ptr++;
+    bq = 0;
+  }
+
+  return ptr;
+}
+
+
+/*
+ * raptor_ntriples_parse_finish:
+ * @rdf_parser: parser
+ *
+ * INTERNAL - Check nothing is left over at the end of the content
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_ntriples_parse_finish(raptor_parser* rdf_parser)
+{
+  raptor_ntriples_parser_context *ntriples_parser = (raptor_ntriples_parser_context*)rdf_parser->context;
+
+  if(ntriples_parser->offset != ntriples_parser->line_length) {
+    raptor_parser_error(rdf_parser, "Junk at end of input.");
+    return 1;
+  }
+
+  if(rdf_parser->emitted_default_graph) {
+    raptor_parser_end_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph--;
+  }
+
+  return 0;
+}
+
+
 static int
 raptor_ntriples_parse_chunk(raptor_parser* rdf_parser, 
                             const unsigned char *s, size_t len,
@@ -442,37 +536,7 @@ raptor_ntriples_parse_chunk(raptor_parser* rdf_parser,
       start = line_start = ptr;
     }
 
-    if(1) {
-      int quote = '\0';
-      int in_uri = '\0';
-      int bq = 0;
-      while(ptr < end_ptr) {
-        if(!bq) {
-          if(*ptr == '\\') {
-            bq = 1;
-            ptr++;
-            continue;
-          }
-
-          if(*ptr == '<')
-            in_uri = 1;
-          else if (in_uri && *ptr == '>')
-            in_uri = 0;
-
-          if(!quote) {
-            if((!in_uri && *ptr == '\'') || *ptr == '"')
-              quote = *ptr;
-            if(*ptr == '\n' || *ptr == '\r')
-              break;
-          } else {
-            if(*ptr == quote)
-              quote = 0;
-          }
-        }
-        ptr++;
-        bq = 0;
-      }
-    }
+    ptr = (unsigned char*)raptor_ntriples_line_end(ptr, end_ptr);
 
     if(ptr == end_ptr) {
       if(!is_end)
@@ -495,7 +559,8 @@ raptor_ntriples_parse_chunk(raptor_parser* rdf_parser,
     fputs("<<<\n", stderr);
 #endif
     *ptr = '\0';
-    if(raptor_ntriples_parse_line(rdf_parser, line_start, len, max_terms))
+    if(raptor_ntriples_parse_line(rdf_parser, line_start, line_start, len,
+                                  max_terms))
       return 1;
     
     rdf_parser->locator.line++;
@@ -548,20 +613,136 @@ raptor_ntriples_parse_chunk(raptor_parser* rdf_parser,
   }
 
   /* exit now, no more input */
-  if(is_end) {
-    if(ntriples_parser->offset != ntriples_parser->line_length) {
-       raptor_parser_error(rdf_parser, "Junk at end of input.");
-       return 1;
-    }
+  if(is_end)
+    return raptor_ntriples_parse_finish(rdf_parser);
     
-    if(rdf_parser->emitted_default_graph) {
-      raptor_parser_end_graph(rdf_parser, NULL, 0);
-      rdf_parser->emitted_default_graph--;
+  return 0;
+}
+
+
+/*
+ * raptor_ntriples_parse_chunk_borrowed:
+ * @rdf_parser: parser
+ * @s: content
+ * @len: length of content
+ * @is_end: non-0 if this is the end of the content
+ *
+ * INTERNAL - Parse lines directly from content that stays valid for the call
+ *
+ * Only a partial line at the end of @s is copied, to be joined with
+ * the start of the next chunk.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_ntriples_parse_chunk_borrowed(raptor_parser* rdf_parser,
+                                     const unsigned char *s, size_t len,
+                                     int is_end)
+{
+  raptor_ntriples_parser_context *ntriples_parser = (raptor_ntriples_parser_context*)rdf_parser->context;
+  int max_terms = ntriples_parser->is_nquads ? 4 : 3;
+  const unsigned char *ptr;
+  const unsigned char *start;
+  const unsigned char *end_ptr = s + len;
+
+  if(ntriples_parser->offset < ntriples_parser->line_length) {
+    /* complete the line held from the last chunk in the line buffer */
+    ptr = s;
+    while(ptr < end_ptr && *ptr != '\n' && *ptr != '\r')
+      ptr++;
+    if(ptr < end_ptr)
+      ptr++;
+
+    if(ptr == end_ptr)
+      return raptor_ntriples_parse_chunk(rdf_parser, s, len, is_end);
+
+    if(raptor_ntriples_parse_chunk(rdf_parser, s, ptr - s, 0))
+      return 1;
+
+    if(ntriples_parser->offset < ntriples_parser->line_length)
+      /* newline was inside a string so the line is still incomplete */
+      return raptor_ntriples_parse_chunk(rdf_parser, ptr, end_ptr - ptr,
+                                         is_end);
+    s = ptr;
+  }
+
+  if(ntriples_parser->line_length) {
+    RAPTOR_FREE(cdata, ntriples_parser->line);
+    ntriples_parser->line = NULL;
+    ntriples_parser->line_length = 0;
+  }
+  ntriples_parser->offset = 0;
+
+  ptr = s;
+  while((start = ptr) < end_ptr) {
+    size_t line_len;
+
+    /* skip \n when just seen \r - i.e. \r\n or CR LF */
+    if(ntriples_parser->last_char == '\r' && *ptr == '\n') {
+      ptr++;
+      rdf_parser->locator.byte++;
+      rdf_parser->locator.column = 0;
+      start = ptr;
     }
 
-    return 0;
+    ptr = raptor_ntriples_line_end(ptr, end_ptr);
+
+    if(ptr == end_ptr) {
+      if(!is_end)
+        /* middle of line */
+        break;
+    } else
+      ntriples_parser->last_char = *ptr;
+
+    line_len = ptr - start;
+    rdf_parser->locator.column = 0;
+
+    if(ntriples_parser->work_size < line_len + 1) {
+      size_t work_size = ntriples_parser->work_size ? ntriples_parser->work_size : 256;
+
+      while(work_size < line_len + 1)
+        work_size <<= 1;
+
+      if(ntriples_parser->work)
+        RAPTOR_FREE(cdata, ntriples_parser->work);
+      ntriples_parser->work = RAPTOR_MALLOC(unsigned char*, work_size);
+      if(!ntriples_parser->work) {
+        ntriples_parser->work_size = 0;
+        raptor_parser_fatal_error(rdf_parser, "Out of memory");
+        return 1;
+      }
+      ntriples_parser->work_size = work_size;
+    }
+
+    if(raptor_ntriples_parse_line(rdf_parser, start, ntriples_parser->work,
+                                  line_len, max_terms))
+      return 1;
+
+    rdf_parser->locator.line++;
+
+    /* go past newline */
+    if(ptr < end_ptr) {
+      ptr++;
+      rdf_parser->locator.byte++;
+    }
   }
-    
+
+  if(start < end_ptr) {
+    /* keep the partial line for the next chunk */
+    len = end_ptr - start;
+    ntriples_parser->line = RAPTOR_MALLOC(unsigned char*, len + 1);
+    if(!ntriples_parser->line) {
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return 1;
+    }
+    memcpy(ntriples_parser->line, start, len);
+    ntriples_parser->line[len] = '\0';
+    ntriples_parser->line_length = len;
+  }
+
+  if(is_end)
+    return raptor_ntriples_parse_finish(rdf_parser);
+
   return 0;
 }
 
@@ -695,6 +876,7 @@ raptor_ntriples_parser_register_factory(raptor_parser_factory *factory)
   factory->terminate = raptor_ntriples_parse_terminate;
   factory->start     = raptor_ntriples_parse_start;
   factory->chunk     = raptor_ntriples_parse_chunk;
+  factory->chunk_borrowed = raptor_ntriples_parse_chunk_borrowed;
   factory->recognise_syntax = raptor_ntriples_parse_recognise_syntax;
 
   return rc;
@@ -784,6 +966,7 @@ raptor_nquads_parser_register_factory(raptor_parser_factory *factory)
   factory->terminate = raptor_ntriples_parse_terminate;
   factory->start     = raptor_ntriples_parse_start;
   factory->chunk     = raptor_ntriples_parse_chunk;
+  factory->chunk_borrowed = raptor_ntriples_parse_chunk_borrowed;
   factory->recognise_syntax = raptor_nquads_parse_recognise_syntax;
 
   return rc;
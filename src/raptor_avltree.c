@@ -62,6 +62,7 @@
 
 /* raptor_avltree.c */
 typedef struct raptor_avltree_node_s raptor_avltree_node;
+typedef struct raptor_avltree_node_block_s raptor_avltree_node_block;
 
 /* AVL-tree */
 struct raptor_avltree_s {
@@ -82,6 +83,16 @@ struct raptor_avltree_s {
 
   /* number of nodes in tree */
   unsigned int size;
+
+  /* blocks of nodes allocated for this tree */
+  raptor_avltree_node_block* node_blocks;
+
+  /* free nodes in the blocks, linked by their parent field */
+  raptor_avltree_node* free_nodes;
+
+  /* B+ tree holding the items instead when #RAPTOR_AVLTREE_FLAG_BTREE
+   * is set; all the other fields except print_handler are unused */
+  raptor_btree* btree;
 };
 
 
@@ -107,6 +118,22 @@ struct raptor_avltree_node_s {
 };
 
 
+/* Nodes are allocated from per-tree blocks so a tree's nodes are
+ * close together in memory, starting small and doubling in size */
+#define RAPTOR_AVLTREE_NODE_BLOCK_MIN 16
+#define RAPTOR_AVLTREE_NODE_BLOCK_MAX 4096
+
+struct raptor_avltree_node_block_s {
+  struct raptor_avltree_node_block_s* next;
+
+  /* number of nodes in this block and how many have been handed out */
+  unsigned int count;
+  unsigned int used;
+
+  raptor_avltree_node nodes[1];
+};
+
+
 #ifndef TRUE
 #define	TRUE		1
 #define	FALSE		0
@@ -122,6 +149,8 @@ static void raptor_avltree_balance_right(raptor_avltree* tree, raptor_avltree_no
 static raptor_avltree_node* raptor_avltree_search_internal(raptor_avltree* tree, raptor_avltree_node* node, const void* p_data);
 static int raptor_avltree_visit_internal(raptor_avltree* tree, raptor_avltree_node* node, int depth, raptor_avltree_visit_handler visit_fn, void* user_data);
 static void raptor_free_avltree_internal(raptor_avltree* tree, raptor_avltree_node* node);
+static raptor_avltree_node* raptor_avltree_node_alloc(raptor_avltree* tree);
+static void raptor_avltree_node_free(raptor_avltree* tree, raptor_avltree_node* node);
 #ifdef RAPTOR_DEBUG
 static void raptor_avltree_check_internal(raptor_avltree* tree, raptor_avltree_node* node, unsigned int* count_p);
 #endif
@@ -154,6 +183,17 @@ raptor_new_avltree(raptor_data_compare_handler compare_handler,
   tree->print_handler = NULL;
   tree->flags = flags;
   tree->size = 0;
+  tree->node_blocks = NULL;
+  tree->free_nodes = NULL;
+  tree->btree = NULL;
+
+  if(flags & RAPTOR_AVLTREE_FLAG_BTREE) {
+    tree->btree = raptor_new_btree(compare_handler, free_handler, flags);
+    if(!tree->btree) {
+      RAPTOR_FREE(raptor_avltree, tree);
+      return NULL;
+    }
+  }
   
   return tree;
 }
@@ -168,10 +208,23 @@ raptor_new_avltree(raptor_data_compare_handler compare_handler,
 void
 raptor_free_avltree(raptor_avltree* tree)
 {
+  raptor_avltree_node_block* block;
+
   if(!tree)
     return;
+
+  if(tree->btree)
+    raptor_free_btree(tree->btree);
   
-  raptor_free_avltree_internal(tree, tree->root);
+  /* nodes are freed with their blocks so only visit them for data */
+  if(tree->free_handler)
+    raptor_free_avltree_internal(tree, tree->root);
+
+  for(block = tree->node_blocks; block; ) {
+    raptor_avltree_node_block* next = block->next;
+    RAPTOR_FREE(raptor_avltree_node_block, block);
+    block = next;
+  }
 
   RAPTOR_FREE(raptor_avltree, tree);
 }
@@ -185,11 +238,67 @@ raptor_free_avltree_internal(raptor_avltree* tree, raptor_avltree_node* node)
 
     raptor_free_avltree_internal(tree, node->right);
 
-    if(tree->free_handler)
-      tree->free_handler(node->data);
-    tree->size--;
-    RAPTOR_FREE(raptor_avltree_node, node);
+    tree->free_handler(node->data);
+  }
+}
+
+
+/* Allocate a new block of at least @count nodes */
+static raptor_avltree_node_block*
+raptor_avltree_new_node_block(raptor_avltree* tree, unsigned int count)
+{
+  raptor_avltree_node_block* block;
+
+  block = RAPTOR_MALLOC(raptor_avltree_node_block*,
+                        sizeof(*block) + (count - 1) * sizeof(raptor_avltree_node));
+  if(!block)
+    return NULL;
+
+  block->count = count;
+  block->used = 0;
+  block->next = tree->node_blocks;
+  tree->node_blocks = block;
+
+  return block;
+}
+
+
+/* Get a node from the tree's free nodes or blocks */
+static raptor_avltree_node*
+raptor_avltree_node_alloc(raptor_avltree* tree)
+{
+  raptor_avltree_node_block* block = tree->node_blocks;
+  raptor_avltree_node* node;
+
+  if(tree->free_nodes) {
+    node = tree->free_nodes;
+    tree->free_nodes = node->parent;
+    return node;
+  }
+
+  if(!block || block->used == block->count) {
+    unsigned int count = RAPTOR_AVLTREE_NODE_BLOCK_MIN;
+
+    /* grow with the tree */
+    if(tree->size > count)
+      count = (tree->size < RAPTOR_AVLTREE_NODE_BLOCK_MAX) ?
+              tree->size : RAPTOR_AVLTREE_NODE_BLOCK_MAX;
+
+    block = raptor_avltree_new_node_block(tree, count);
+    if(!block)
+      return NULL;
   }
+
+  return &block->nodes[block->used++];
+}
+
+
+/* Return a node to the tree's free nodes */
+static void
+raptor_avltree_node_free(raptor_avltree* tree, raptor_avltree_node* node)
+{
+  node->parent = tree->free_nodes;
+  tree->free_nodes = node;
 }
 
 
@@ -229,6 +338,10 @@ void*
 raptor_avltree_search(raptor_avltree* tree, const void* p_data)
 {
   raptor_avltree_node* node;
+
+  if(tree->btree)
+    return raptor_btree_search(tree->btree, p_data);
+
   node = raptor_avltree_search_internal(tree, tree->root, p_data);
   return node ? node->data : NULL;
 }
@@ -251,6 +364,10 @@ raptor_avltree_add(raptor_avltree* tree, void* p_data)
 {
   int rebalancing = FALSE;
   int rv;
+
+  if(tree->btree)
+    return raptor_btree_add(tree->btree, p_data);
+
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   RAPTOR_AVLTREE_DEBUG1("Checking tree before adding\n");
   raptor_avltree_check(tree);
@@ -284,6 +401,9 @@ raptor_avltree_remove(raptor_avltree* tree, void* p_data)
 {
   int rebalancing = FALSE;
   void* rdata;
+
+  if(tree->btree)
+    return raptor_btree_remove(tree->btree, p_data);
   
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   RAPTOR_AVLTREE_DEBUG1("Checking tree before removing\n");
@@ -329,6 +449,115 @@ raptor_avltree_delete(raptor_avltree* tree, void* p_data)
 }
 
 
+/* Link in-order @nodes into a balanced subtree and return its height */
+static int
+raptor_avltree_build_internal(raptor_avltree_node* nodes, int count,
+                              raptor_avltree_node* parent,
+                              raptor_avltree_node** node_pp)
+{
+  raptor_avltree_node* node;
+  int mid;
+  int left_height;
+  int right_height;
+
+  if(count <= 0) {
+    *node_pp = NULL;
+    return 0;
+  }
+
+  /* the left subtree gets the extra node for even counts */
+  mid = count / 2;
+  node = &nodes[mid];
+  node->parent = parent;
+
+  left_height = raptor_avltree_build_internal(nodes, mid, node, &node->left);
+  right_height = raptor_avltree_build_internal(nodes + mid + 1,
+                                               count - mid - 1, node,
+                                               &node->right);
+
+  node->balance = RAPTOR_GOOD_CAST(signed char, right_height - left_height);
+  *node_pp = node;
+
+  return 1 + ((left_height > right_height) ? left_height : right_height);
+}
+
+
+/**
+ * raptor_avltree_build_from_sorted:
+ * @tree: empty AVL Tree object
+ * @items: array of data items sorted by the tree comparison handler
+ * @count: number of items in @items
+ *
+ * Add sorted items to an empty AVL Tree in O(n)
+ *
+ * The tree is built balanced directly from the array without
+ * comparisons or rotations and the nodes are allocated together in
+ * order.  Equivalent adjacent items are handled as by
+ * raptor_avltree_add(): the later one replaces or is dropped
+ * according to #RAPTOR_AVLTREE_FLAG_REPLACE_DUPLICATES and the
+ * tree's free handler is called on the item not kept.
+ *
+ * If @items is not sorted or the tree is not empty, nothing is added
+ * and no items are freed.
+ *
+ * Return value: non-0 on failure: <0 if memory is exhausted, >0 if
+ * @items is not sorted or the tree is not empty
+ */
+int
+raptor_avltree_build_from_sorted(raptor_avltree* tree, void** items,
+                                 int count)
+{
+  raptor_avltree_node_block* block;
+  int i;
+  int n;
+
+  if(tree->btree)
+    return raptor_btree_build_from_sorted(tree->btree, items, count);
+
+  if(tree->root)
+    return 1;
+
+  if(count <= 0)
+    return 0;
+
+  for(i = 1; i < count; i++) {
+    if(tree->compare_handler(items[i - 1], items[i]) > 0)
+      return 1;
+  }
+
+  block = raptor_avltree_new_node_block(tree, RAPTOR_BAD_CAST(unsigned int, count));
+  if(!block)
+    return RAPTOR_AVLTREE_ENOMEM;
+
+  n = 0;
+  for(i = 0; i < count; i++) {
+    if(n && !tree->compare_handler(block->nodes[n - 1].data, items[i])) {
+      if(tree->flags & RAPTOR_AVLTREE_FLAG_REPLACE_DUPLICATES) {
+        if(tree->free_handler)
+          tree->free_handler(block->nodes[n - 1].data);
+        block->nodes[n - 1].data = items[i];
+      } else if(tree->free_handler)
+        tree->free_handler(items[i]);
+      continue;
+    }
+
+    block->nodes[n].data = items[i];
+    n++;
+  }
+  block->used = RAPTOR_BAD_CAST(unsigned int, n);
+
+  raptor_avltree_build_internal(block->nodes, n, NULL, &tree->root);
+  tree->size = RAPTOR_BAD_CAST(unsigned int, n);
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  RAPTOR_AVLTREE_DEBUG1("Checking tree after building\n");
+  raptor_avltree_check(tree);
+#endif
+
+  return 0;
+}
+
+
 static int
 raptor_avltree_visit_internal(raptor_avltree* tree, raptor_avltree_node* node,
                               int depth,
@@ -368,6 +597,9 @@ raptor_avltree_visit(raptor_avltree* tree,
                      raptor_avltree_visit_handler visit_handler,
                      void* user_data)
 {
+  if(tree->btree)
+    return raptor_btree_visit(tree->btree, visit_handler, user_data);
+
   return raptor_avltree_visit_internal(tree, tree->root, 0,
                                        visit_handler, user_data);
 }
@@ -680,7 +912,7 @@ raptor_avltree_sprout(raptor_avltree* tree, raptor_avltree_node* parent,
   /* If grounded, add the node here, set the rebalance flag and return */
   if(!*node_pp) {
     RAPTOR_AVLTREE_DEBUG1("grounded. adding new node, setting rebalancing flag true\n");
-    *node_pp = RAPTOR_MALLOC(raptor_avltree_node*, sizeof(**node_pp));
+    *node_pp = raptor_avltree_node_alloc(tree);
     if(!*node_pp) {
       if(tree->free_handler)
         tree->free_handler(p_data);
@@ -802,7 +1034,7 @@ raptor_avltree_delete_internal(raptor_avltree* tree,
         raptor_avltree_balance_left(tree, node_pp, rebalancing_p);
     }
 
-    RAPTOR_FREE(raptor_avltree_node, pr_q);
+    raptor_avltree_node_free(tree, pr_q);
   }
 
   return rdata;
@@ -1018,6 +1250,9 @@ raptor_avltree_balance_right(raptor_avltree* tree,
 int
 raptor_avltree_size(raptor_avltree* tree)
 {
+  if(tree->btree)
+    return raptor_btree_size(tree->btree);
+
   return tree->size;
 }
 
@@ -1253,6 +1488,9 @@ struct raptor_avltree_iterator_s {
   raptor_data_free_handler range_free_handler;
   int direction;
   int is_finished;
+
+  /* iterator over the B+ tree of a #RAPTOR_AVLTREE_FLAG_BTREE tree */
+  raptor_btree_iterator* btree_iterator;
 };
 
 
@@ -1293,6 +1531,18 @@ raptor_new_avltree_iterator(raptor_avltree* tree, void* range,
   iterator->range_free_handler = range_free_handler;
   iterator->direction = direction;
 
+  if(tree->btree) {
+    /* the B+ tree iterator owns range */
+    iterator->btree_iterator = raptor_new_btree_iterator(tree->btree, range,
+                                                         range_free_handler,
+                                                         direction);
+    if(!iterator->btree_iterator) {
+      RAPTOR_FREE(raptor_avltree_iterator, iterator);
+      return NULL;
+    }
+    return iterator;
+  }
+
   if(range) {
     /* find the topmost match (range is contained entirely in tree
      * rooted here) 
@@ -1355,8 +1605,10 @@ raptor_free_avltree_iterator(raptor_avltree_iterator* iterator)
 {
   if(!iterator)
     return;
-  
-  if(iterator->range && iterator->range_free_handler)
+
+  if(iterator->btree_iterator)
+    raptor_free_btree_iterator(iterator->btree_iterator);
+  else if(iterator->range && iterator->range_free_handler)
     iterator->range_free_handler(iterator->range);
 
   RAPTOR_FREE(raptor_avltree_iterator, iterator);
@@ -1375,6 +1627,9 @@ int
 raptor_avltree_iterator_is_end(raptor_avltree_iterator* iterator)
 {
   raptor_avltree_node *node = iterator->current;
+
+  if(iterator->btree_iterator)
+    return raptor_btree_iterator_is_end(iterator->btree_iterator);
   
   if(iterator->is_finished)
     return 1;
@@ -1396,6 +1651,9 @@ int
 raptor_avltree_iterator_next(raptor_avltree_iterator* iterator)
 {
   raptor_avltree_node *node = iterator->current;
+
+  if(iterator->btree_iterator)
+    return raptor_btree_iterator_next(iterator->btree_iterator);
   
   if(!node || iterator->is_finished)
     return 1;
@@ -1429,6 +1687,9 @@ raptor_avltree_iterator_get(raptor_avltree_iterator* iterator)
 {
   raptor_avltree_node *node = iterator->current;
 
+  if(iterator->btree_iterator)
+    return raptor_btree_iterator_get(iterator->btree_iterator);
+
   if(iterator->is_finished)
     return NULL;
 
@@ -1456,7 +1717,7 @@ raptor_avltree_print(raptor_avltree* tree, FILE* stream)
   int rv = 0;
   raptor_avltree_iterator* iter = NULL;
 
-  fprintf(stream, "AVL Tree size %u\n", tree->size);
+  fprintf(stream, "AVL Tree size %d\n", raptor_avltree_size(tree));
   for(i = 0, (iter = raptor_new_avltree_iterator(tree, NULL, NULL, 1));
       iter && !rv;
       i++, (rv = raptor_avltree_iterator_next(iter))) {
@@ -1512,6 +1773,9 @@ raptor_avltree_dump_internal(raptor_avltree* tree, raptor_avltree_node* node,
 int
 raptor_avltree_dump(raptor_avltree* tree, FILE* stream)
 {
+  if(tree->btree)
+    return !raptor_avltree_print(tree, stream);
+
   fprintf(stream, "Dumping avltree %p size %u\n", tree, tree->size);
 
   return raptor_avltree_dump_internal(tree, tree->root, 0, stream);
@@ -1540,6 +1804,11 @@ void
 raptor_avltree_check(raptor_avltree* tree)
 {
   unsigned int count = 0;
+
+  if(tree->btree) {
+    raptor_btree_check(tree->btree);
+    return;
+  }
   
   raptor_avltree_check_internal(tree, tree->root, &count);
   if(count != tree->size) {
@@ -1753,6 +2022,75 @@ main(int argc, char *argv[])
 #endif
   raptor_free_avltree(tree);
 
+
+  /* build from sorted items, with a duplicate */
+  tree = raptor_new_avltree(compare_strings, NULL, 0);
+  if(!tree) {
+    fprintf(stderr, "%s: Failed to create tree\n", program);
+    exit(1);
+  }
+
+  if(1) {
+    const char *sorted_items[RESULT_COUNT + 1] = { "amy", "bij", "daj", "daj", "def", "jib", "ron" };
+    const char *unsorted_items[2] = { "ron", "amy" };
+    int rc;
+
+    rc = raptor_avltree_build_from_sorted(tree, (void**)unsorted_items, 2);
+    if(rc <= 0 || raptor_avltree_size(tree)) {
+      fprintf(stderr, "%s: Building tree from unsorted items returned %d, expected >0\n",
+              program, rc);
+      exit(1);
+    }
+
+    rc = raptor_avltree_build_from_sorted(tree, (void**)sorted_items,
+                                          RESULT_COUNT + 1);
+    if(rc) {
+      fprintf(stderr, "%s: Building tree from sorted items failed, returning error %d\n",
+              program, rc);
+      exit(1);
+    }
+  }
+
+#ifdef RAPTOR_DEBUG
+  raptor_avltree_check(tree);
+#endif
+
+  if(raptor_avltree_size(tree) != RESULT_COUNT) {
+    fprintf(stderr, "%s: Built tree has size %d, expected %d\n", program,
+            raptor_avltree_size(tree), RESULT_COUNT);
+    exit(1);
+  }
+
+  vs.count = 0;
+  vs.results = results;
+  vs.failed = 0;
+  raptor_avltree_visit(tree, check_string, &vs);
+  if(vs.failed) {
+    fprintf(stderr, "%s: Checking built tree failed\n", program);
+    exit(1);
+  }
+
+  /* the built tree stays usable for adds and deletes */
+  for(i = 0; items[i]; i++)
+    raptor_avltree_add(tree, (void*)items[i]);
+  for(i = 0; results[i]; i++) {
+    if(!raptor_avltree_delete(tree, (void*)results[i])) {
+      fprintf(stderr, "%s: Deleting built tree item %d '%s' failed\n",
+              program, i, results[i]);
+      exit(1);
+    }
+#ifdef RAPTOR_DEBUG
+    raptor_avltree_check(tree);
+#endif
+  }
+  if(raptor_avltree_size(tree) != DELETE_COUNT) {
+    fprintf(stderr, "%s: Built tree has size %d after deletes, expected %d\n",
+            program, raptor_avltree_size(tree), DELETE_COUNT);
+    exit(1);
+  }
+
+  raptor_free_avltree(tree);
+
   raptor_free_world(world);
 
   /* keep gcc -Wall happy */
@@ -0,0 +1,844 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_binary.c - Raptor Binary RDF Parser implementation
+ *
+ * Reads the syntax written by raptor_serialize_binary.c; see the
+ * raptor_binary_record description in raptor_internal.h
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * Binary RDF parser object
+ */
+typedef struct {
+  /* unparsed input */
+  unsigned char* buffer;
+  size_t buffer_size;
+  size_t buffer_length;
+
+  /* term dictionary for the current block */
+  raptor_term** terms;
+  size_t terms_count;
+  size_t terms_size;
+
+  /* non-0 once the magic and version have been read */
+  int seen_header;
+
+  /* non-0 once the end record has been read */
+  int seen_end;
+} raptor_binary_parser_context;
+
+
+/*
+ * Return value: number of bytes of the varint at @p, 0 if more input
+ * is needed, <0 if it is too long
+ */
+static int
+raptor_binary_read_varint(const unsigned char* p, const unsigned char* end,
+                          size_t* value_p)
+{
+  size_t value = 0;
+  unsigned int shift = 0;
+  int len = 0;
+
+  while(p < end) {
+    unsigned char c = *p++;
+
+    if(shift >= sizeof(size_t) * 8)
+      return -1;
+
+    value |= RAPTOR_GOOD_CAST(size_t, c & 0x7f) << shift;
+    len++;
+    if(!(c & 0x80)) {
+      *value_p = value;
+      return len;
+    }
+    shift += 7;
+  }
+
+  return 0;
+}
+
+
+/*
+ * Read a varint length and check that many bytes follow it.
+ *
+ * Return value: number of bytes of the length, 0 if more input is
+ * needed, <0 on error
+ */
+static int
+raptor_binary_read_string(const unsigned char* p, const unsigned char* end,
+                          size_t* len_p)
+{
+  int rc;
+
+  rc = raptor_binary_read_varint(p, end, len_p);
+  if(rc <= 0)
+    return rc;
+
+  if(RAPTOR_GOOD_CAST(size_t, end - p - rc) < *len_p)
+    return 0;
+
+  return rc;
+}
+
+
+static void
+raptor_binary_parse_reset_terms(raptor_binary_parser_context* binary_parser)
+{
+  size_t i;
+
+  for(i = 0; i < binary_parser->terms_count; i++)
+    raptor_free_term(binary_parser->terms[i]);
+  binary_parser->terms_count = 0;
+}
+
+
+static int
+raptor_binary_parse_add_term(raptor_parser* rdf_parser, raptor_term* term)
+{
+  raptor_binary_parser_context* binary_parser;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  if(!term) {
+    raptor_parser_fatal_error(rdf_parser, "Out of memory");
+    return 1;
+  }
+
+  if(binary_parser->terms_count == binary_parser->terms_size) {
+    size_t size = binary_parser->terms_size ? binary_parser->terms_size << 1 : 1024;
+    raptor_term** terms;
+
+    terms = RAPTOR_CALLOC(raptor_term**, size, sizeof(raptor_term*));
+    if(!terms) {
+      raptor_free_term(term);
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return 1;
+    }
+    if(binary_parser->terms) {
+      memcpy(terms, binary_parser->terms,
+             sizeof(raptor_term*) * binary_parser->terms_count);
+      RAPTOR_FREE(raptor_term**, binary_parser->terms);
+    }
+    binary_parser->terms = terms;
+    binary_parser->terms_size = size;
+  }
+
+  binary_parser->terms[binary_parser->terms_count++] = term;
+
+  return 0;
+}
+
+
+/* Term types allowed in each statement position */
+static const int raptor_binary_position_types[4] = {
+  (1 << RAPTOR_TERM_TYPE_URI) | (1 << RAPTOR_TERM_TYPE_BLANK),
+  (1 << RAPTOR_TERM_TYPE_URI),
+  (1 << RAPTOR_TERM_TYPE_URI) | (1 << RAPTOR_TERM_TYPE_BLANK) |
+  (1 << RAPTOR_TERM_TYPE_LITERAL),
+  (1 << RAPTOR_TERM_TYPE_URI) | (1 << RAPTOR_TERM_TYPE_BLANK)
+};
+
+static const char* const raptor_binary_position_names[4] = {
+  "subject", "predicate", "object", "graph"
+};
+
+
+/*
+ * Read the statement term indexes and hand the dictionary terms
+ * directly to the statement handler.
+ *
+ * Return value: >0 with the number of bytes used in *@used_p, 0 if
+ * more input is needed, <0 on error
+ */
+static int
+raptor_binary_parse_statement(raptor_parser* rdf_parser,
+                              const unsigned char* p,
+                              const unsigned char* end,
+                              int count, size_t* used_p)
+{
+  raptor_binary_parser_context* binary_parser;
+  raptor_statement* statement = &rdf_parser->statement;
+  raptor_term* terms[4] = { NULL, NULL, NULL, NULL };
+  const unsigned char* start = p;
+  int i;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  for(i = 0; i < count; i++) {
+    size_t id;
+    int rc;
+
+    rc = raptor_binary_read_varint(p, end, &id);
+    if(rc <= 0)
+      return rc;
+    p += rc;
+
+    if(id >= binary_parser->terms_count) {
+      raptor_parser_error(rdf_parser, "Term index %lu is not defined",
+                          RAPTOR_GOOD_CAST(unsigned long, id));
+      return -1;
+    }
+    terms[i] = binary_parser->terms[id];
+
+    if(!(raptor_binary_position_types[i] & (1 << terms[i]->type))) {
+      raptor_parser_error(rdf_parser, "Term index %lu is not allowed as a %s",
+                          RAPTOR_GOOD_CAST(unsigned long, id),
+                          raptor_binary_position_names[i]);
+      return -1;
+    }
+  }
+
+  if(!rdf_parser->emitted_default_graph) {
+    raptor_parser_start_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph++;
+  }
+
+  if(rdf_parser->statement_handler) {
+    statement->subject = terms[0];
+    statement->predicate = terms[1];
+    statement->object = terms[2];
+    statement->graph = terms[3];
+
+    (*rdf_parser->statement_handler)(rdf_parser->user_data, statement);
+
+    /* the terms are still owned by the dictionary */
+    statement->subject = NULL;
+    statement->predicate = NULL;
+    statement->object = NULL;
+    statement->graph = NULL;
+  }
+
+  *used_p = RAPTOR_GOOD_CAST(size_t, p - start);
+
+  return 1;
+}
+
+
+/*
+ * Parse one record from @p.
+ *
+ * Return value: >0 with the number of bytes used in *@used_p, 0 if
+ * more input is needed, <0 on error
+ */
+static int
+raptor_binary_parse_record(raptor_parser* rdf_parser,
+                           const unsigned char* p, const unsigned char* end,
+                           size_t* used_p)
+{
+  raptor_binary_parser_context* binary_parser;
+  raptor_world* world = rdf_parser->world;
+  const unsigned char* start = p;
+  size_t len;
+  int rc;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  switch(*p++) {
+    case RAPTOR_BINARY_RECORD_END:
+      binary_parser->seen_end = 1;
+      break;
+
+    case RAPTOR_BINARY_RECORD_URI:
+      rc = raptor_binary_read_string(p, end, &len);
+      if(rc <= 0)
+        return rc;
+      p += rc;
+      if(raptor_binary_parse_add_term(rdf_parser,
+                                      raptor_new_term_from_counted_uri_string(world, p, len)))
+        return -1;
+      p += len;
+      break;
+
+    case RAPTOR_BINARY_RECORD_BLANK:
+      rc = raptor_binary_read_string(p, end, &len);
+      if(rc <= 0)
+        return rc;
+      p += rc;
+      if(raptor_binary_parse_add_term(rdf_parser,
+                                      raptor_new_term_from_counted_blank(world, p, len)))
+        return -1;
+      p += len;
+      break;
+
+    case RAPTOR_BINARY_RECORD_LITERAL:
+      {
+        const unsigned char* string;
+        size_t string_len;
+        size_t datatype_id;
+        raptor_uri* datatype = NULL;
+        unsigned char language[256];
+
+        rc = raptor_binary_read_string(p, end, &string_len);
+        if(rc <= 0)
+          return rc;
+        p += rc;
+        string = p;
+        p += string_len;
+
+        rc = raptor_binary_read_varint(p, end, &datatype_id);
+        if(rc <= 0)
+          return rc;
+        p += rc;
+
+        rc = raptor_binary_read_string(p, end, &len);
+        if(rc <= 0)
+          return rc;
+        p += rc;
+        if(len >= sizeof(language)) {
+          raptor_parser_error(rdf_parser, "Literal language is too long");
+          return -1;
+        }
+        /* the term constructor needs a NUL terminated language */
+        memcpy(language, p, len);
+        language[len] = '\0';
+
+        if(datatype_id) {
+          raptor_term* datatype_term;
+
+          if(datatype_id > binary_parser->terms_count ||
+             binary_parser->terms[datatype_id - 1]->type != RAPTOR_TERM_TYPE_URI) {
+            raptor_parser_error(rdf_parser,
+                                "Literal datatype %lu is not a defined URI",
+                                RAPTOR_GOOD_CAST(unsigned long, datatype_id - 1));
+            return -1;
+          }
+          datatype_term = binary_parser->terms[datatype_id - 1];
+          datatype = datatype_term->value.uri;
+        }
+
+        if(raptor_binary_parse_add_term(rdf_parser,
+                                        raptor_new_term_from_counted_literal(world,
+                                                                             string, string_len,
+                                                                             datatype,
+                                                                             len ? language : NULL,
+                                                                             RAPTOR_BAD_CAST(unsigned char, len))))
+          return -1;
+        p += len;
+      }
+      break;
+
+    case RAPTOR_BINARY_RECORD_TRIPLE:
+    case RAPTOR_BINARY_RECORD_QUAD:
+      rc = raptor_binary_parse_statement(rdf_parser, p, end,
+                                         (*start == RAPTOR_BINARY_RECORD_QUAD) ? 4 : 3,
+                                         &len);
+      if(rc <= 0)
+        return rc;
+      p += len;
+      break;
+
+    case RAPTOR_BINARY_RECORD_RESET:
+      raptor_binary_parse_reset_terms(binary_parser);
+      break;
+
+    default:
+      raptor_parser_error(rdf_parser, "Unknown record type %d", *start);
+      return -1;
+  }
+
+  *used_p = RAPTOR_GOOD_CAST(size_t, p - start);
+
+  return 1;
+}
+
+
+/**
+ * raptor_binary_parse_init:
+ *
+ * Initialise the Raptor Binary RDF parser.
+ *
+ * Return value: non 0 on failure
+ **/
+
+static int
+raptor_binary_parse_init(raptor_parser* rdf_parser, const char *name)
+{
+  raptor_statement_init(&rdf_parser->statement, rdf_parser->world);
+
+  return 0;
+}
+
+
+/*
+ * raptor_binary_parse_terminate - Free the Raptor Binary RDF parser
+ * @rdf_parser: parser object
+ *
+ **/
+static void
+raptor_binary_parse_terminate(raptor_parser* rdf_parser)
+{
+  raptor_binary_parser_context *binary_parser;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  raptor_binary_parse_reset_terms(binary_parser);
+  if(binary_parser->terms)
+    RAPTOR_FREE(raptor_term**, binary_parser->terms);
+
+  if(binary_parser->buffer)
+    RAPTOR_FREE(char*, binary_parser->buffer);
+}
+
+
+static int
+raptor_binary_parse_chunk(raptor_parser* rdf_parser,
+                          const unsigned char *s, size_t len,
+                          int is_end)
+{
+  raptor_binary_parser_context *binary_parser;
+  const unsigned char* p;
+  const unsigned char* end;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  if(len) {
+    if(binary_parser->buffer_length + len > binary_parser->buffer_size) {
+      size_t size = binary_parser->buffer_size ? binary_parser->buffer_size : 4096;
+      unsigned char* buffer;
+
+      while(size < binary_parser->buffer_length + len)
+        size <<= 1;
+
+      buffer = RAPTOR_MALLOC(unsigned char*, size);
+      if(!buffer) {
+        raptor_parser_fatal_error(rdf_parser, "Out of memory");
+        return 1;
+      }
+      if(binary_parser->buffer_length)
+        memcpy(buffer, binary_parser->buffer, binary_parser->buffer_length);
+      if(binary_parser->buffer)
+        RAPTOR_FREE(char*, binary_parser->buffer);
+      binary_parser->buffer = buffer;
+      binary_parser->buffer_size = size;
+    }
+
+    memcpy(binary_parser->buffer + binary_parser->buffer_length, s, len);
+    binary_parser->buffer_length += len;
+  }
+
+  p = binary_parser->buffer;
+  end = p + binary_parser->buffer_length;
+
+  if(!binary_parser->seen_header) {
+    if(binary_parser->buffer_length < RAPTOR_BINARY_MAGIC_LEN + 1) {
+      if(!is_end)
+        return 0;
+      raptor_parser_error(rdf_parser, "Missing binary RDF header.");
+      return 1;
+    }
+
+    if(memcmp(p, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN)) {
+      raptor_parser_error(rdf_parser, "Not binary RDF content.");
+      return 1;
+    }
+    if(p[RAPTOR_BINARY_MAGIC_LEN] != RAPTOR_BINARY_VERSION) {
+      raptor_parser_error(rdf_parser, "Unsupported binary RDF version %d.",
+                          p[RAPTOR_BINARY_MAGIC_LEN]);
+      return 1;
+    }
+
+    p += RAPTOR_BINARY_MAGIC_LEN + 1;
+    rdf_parser->locator.byte += RAPTOR_BINARY_MAGIC_LEN + 1;
+    binary_parser->seen_header = 1;
+  }
+
+  while(p < end) {
+    size_t used;
+    int rc;
+
+    if(binary_parser->seen_end) {
+      raptor_parser_error(rdf_parser, "Junk after end of input.");
+      return 1;
+    }
+
+    rc = raptor_binary_parse_record(rdf_parser, p, end, &used);
+    if(rc < 0)
+      return 1;
+    if(!rc)
+      /* middle of a record */
+      break;
+
+    p += used;
+    rdf_parser->locator.byte += RAPTOR_BAD_CAST(int, used);
+  }
+
+  /* keep the unparsed bytes */
+  binary_parser->buffer_length = RAPTOR_BAD_CAST(size_t, end - p);
+  if(binary_parser->buffer_length)
+    memmove(binary_parser->buffer, p, binary_parser->buffer_length);
+
+  /* exit now, no more input */
+  if(is_end) {
+    if(binary_parser->buffer_length || !binary_parser->seen_end) {
+      raptor_parser_error(rdf_parser, "Truncated binary RDF input.");
+      return 1;
+    }
+
+    if(rdf_parser->emitted_default_graph) {
+      raptor_parser_end_graph(rdf_parser, NULL, 0);
+      rdf_parser->emitted_default_graph--;
+    }
+  }
+
+  return 0;
+}
+
+
+static int
+raptor_binary_parse_start(raptor_parser* rdf_parser)
+{
+  raptor_locator *locator = &rdf_parser->locator;
+  raptor_binary_parser_context *binary_parser;
+
+  binary_parser = (raptor_binary_parser_context*)rdf_parser->context;
+
+  locator->line = -1;
+  locator->column = -1;
+  locator->byte = 0;
+
+  raptor_binary_parse_reset_terms(binary_parser);
+  binary_parser->buffer_length = 0;
+  binary_parser->seen_header = 0;
+  binary_parser->seen_end = 0;
+
+  return 0;
+}
+
+
+static int
+raptor_binary_parse_recognise_syntax(raptor_parser_factory* factory,
+                                     const unsigned char *buffer, size_t len,
+                                     const unsigned char *identifier,
+                                     const unsigned char *suffix,
+                                     const char *mime_type)
+{
+  int score = 0;
+
+  if(suffix) {
+    if(!strcmp((const char*)suffix, "rbin"))
+      score = 8;
+  }
+
+  if(mime_type) {
+    if(strstr((const char*)mime_type, "x-raptor-binary"))
+      score += 6;
+  }
+
+  if(buffer && len >= RAPTOR_BINARY_MAGIC_LEN &&
+     !memcmp(buffer, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN))
+    score = 10;
+
+  return score;
+}
+
+
+static const char* const binary_names[2] = { "binary", NULL };
+
+static const char* const binary_uri_strings[1] = {
+  NULL
+};
+
+#define BINARY_TYPES_COUNT 1
+static const raptor_type_q binary_types[BINARY_TYPES_COUNT + 1] = {
+  { "application/x-raptor-binary", 27, 10},
+  { NULL, 0, 0}
+};
+
+static int
+raptor_binary_parser_register_factory(raptor_parser_factory *factory)
+{
+  int rc = 0;
+
+  factory->desc.names = binary_names;
+
+  factory->desc.mime_types = binary_types;
+
+  factory->desc.label = "Raptor Binary RDF";
+  factory->desc.uri_strings = binary_uri_strings;
+
+  factory->desc.flags = 0;
+
+  factory->context_length     = sizeof(raptor_binary_parser_context);
+
+  factory->init      = raptor_binary_parse_init;
+  factory->terminate = raptor_binary_parse_terminate;
+  factory->start     = raptor_binary_parse_start;
+  factory->chunk     = raptor_binary_parse_chunk;
+  factory->recognise_syntax = raptor_binary_parse_recognise_syntax;
+
+  return rc;
+}
+
+
+int
+raptor_init_parser_binary(raptor_world* world)
+{
+  return !raptor_world_register_parser_factory(world,
+                                               &raptor_binary_parser_register_factory);
+}
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+/* enough distinct terms for the serializer to reset its dictionary */
+#define TEST_RESET_STATEMENTS 40000
+
+#define TEST_STATEMENTS 300
+
+
+typedef struct {
+  raptor_statement** statements;
+  int count;
+  int size;
+  int mismatches;
+} test_state;
+
+
+static void
+test_statement_handler(void* user_data, raptor_statement* statement)
+{
+  test_state* state = (test_state*)user_data;
+
+  if(state->count >= state->size ||
+     !raptor_statement_equals(state->statements[state->count], statement))
+    state->mismatches++;
+
+  state->count++;
+}
+
+
+static void
+test_log_handler(void* user_data, raptor_log_message* message)
+{
+  (*(int*)user_data)++;
+}
+
+
+static raptor_statement*
+test_make_statement(raptor_world* world, int i)
+{
+  unsigned char buffer[64];
+  raptor_term* s;
+  raptor_term* p;
+  raptor_term* o;
+  raptor_term* g = NULL;
+
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/s%d", i / 2);
+  s = (i % 5) ? raptor_new_term_from_uri_string(world, buffer)
+              : raptor_new_term_from_blank(world, buffer + 19);
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/p%d", i % 7);
+  p = raptor_new_term_from_uri_string(world, buffer);
+  snprintf((char*)buffer, sizeof(buffer), "value %d", i);
+  if(i % 3 == 0)
+    o = raptor_new_term_from_literal(world, buffer, NULL,
+                                     (const unsigned char*)"en");
+  else if(i % 3 == 1) {
+    raptor_uri* dt = raptor_new_uri(world, (const unsigned char*)"http://www.w3.org/2001/XMLSchema#string");
+    o = raptor_new_term_from_literal(world, buffer, dt, NULL);
+    raptor_free_uri(dt);
+  } else
+    o = raptor_new_term_from_blank(world, buffer + 6);
+  if(i % 4 == 0)
+    g = raptor_new_term_from_uri_string(world, (const unsigned char*)"http://example.org/g");
+
+  return raptor_new_statement_from_nodes(world, s, p, o, g);
+}
+
+
+/* Write statements as binary RDF and read them back in chunks */
+static int
+test_round_trip(const char* program, raptor_world* world, int count,
+                size_t chunk_size)
+{
+  raptor_serializer* serializer;
+  raptor_parser* parser;
+  raptor_uri* base_uri;
+  test_state state;
+  void* string = NULL;
+  size_t length = 0;
+  size_t offset;
+  int i;
+  int rc = 0;
+
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+
+  memset(&state, 0, sizeof(state));
+  state.size = count;
+  state.statements = RAPTOR_CALLOC(raptor_statement**, RAPTOR_GOOD_CAST(size_t, count),
+                                   sizeof(raptor_statement*));
+
+  serializer = raptor_new_serializer(world, "binary");
+  raptor_serializer_start_to_string(serializer, base_uri, &string, &length);
+  for(i = 0; i < count; i++) {
+    state.statements[i] = test_make_statement(world, i);
+    raptor_serializer_serialize_statement(serializer, state.statements[i]);
+  }
+  raptor_serializer_serialize_end(serializer);
+  raptor_free_serializer(serializer);
+
+  parser = raptor_new_parser(world, "binary");
+  raptor_parser_set_statement_handler(parser, &state, test_statement_handler);
+  raptor_parser_parse_start(parser, base_uri);
+  for(offset = 0; offset < length && !rc; offset += chunk_size) {
+    size_t len = length - offset;
+
+    if(len > chunk_size)
+      len = chunk_size;
+    if(raptor_parser_parse_chunk(parser, (unsigned char*)string + offset,
+                                 len, 0))
+      rc = 1;
+  }
+  if(!rc && raptor_parser_parse_chunk(parser, NULL, 0, 1))
+    rc = 1;
+  raptor_free_parser(parser);
+
+  if(rc)
+    fprintf(stderr, "%s: parsing %d statements in chunks of %d failed\n",
+            program, count, (int)chunk_size);
+  else if(state.count != count || state.mismatches) {
+    fprintf(stderr, "%s: read %d of %d statements in chunks of %d with %d different\n",
+            program, state.count, count, (int)chunk_size, state.mismatches);
+    rc = 1;
+  }
+
+  for(i = 0; i < count; i++)
+    raptor_free_statement(state.statements[i]);
+  RAPTOR_FREE(raptor_statement**, state.statements);
+  raptor_free_memory(string);
+  raptor_free_uri(base_uri);
+
+  return rc;
+}
+
+
+/* Records after the header: a literal "x", URIs <a>, <b> and blank _:c */
+#define TEST_TERMS \
+  "\003\001x\000\000" "\001\001a" "\001\001b" "\002\001c"
+
+#define TEST_MALFORMED_COUNT 9
+
+static const struct {
+  const char* label;
+  const char* data;
+  size_t length;
+} test_malformed[TEST_MALFORMED_COUNT] = {
+  /* lengths exclude the NUL terminating each string constant */
+  { "bad magic", "RPTRBIX\001\000", 9 },
+  { "bad version", "RPTRBIN\002\000", 9 },
+  { "literal subject", "RPTRBIN\001" TEST_TERMS "\004\000\001\002\000", 27 },
+  { "literal predicate", "RPTRBIN\001" TEST_TERMS "\004\001\000\001\000", 27 },
+  { "blank predicate", "RPTRBIN\001" TEST_TERMS "\004\001\003\001\000", 27 },
+  { "literal graph", "RPTRBIN\001" TEST_TERMS "\005\001\002\001\000\000", 28 },
+  { "undefined term", "RPTRBIN\001" TEST_TERMS "\004\001\002\011\000", 27 },
+  { "unknown record", "RPTRBIN\001" TEST_TERMS "\011\000", 24 },
+  { "truncated", "RPTRBIN\001" TEST_TERMS "\004\001\002", 25 }
+};
+
+
+/* Check malformed input is rejected without returning statements */
+static int
+test_malformed_input(const char* program, raptor_world* world)
+{
+  raptor_uri* base_uri;
+  int i;
+  int rc = 0;
+
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+
+  for(i = 0; i < TEST_MALFORMED_COUNT; i++) {
+    raptor_parser* parser;
+    test_state state;
+    int errors = 0;
+    int failed;
+
+    memset(&state, 0, sizeof(state));
+
+    raptor_world_set_log_handler(world, &errors, test_log_handler);
+    parser = raptor_new_parser(world, "binary");
+    raptor_parser_set_statement_handler(parser, &state, test_statement_handler);
+    raptor_parser_parse_start(parser, base_uri);
+    failed = raptor_parser_parse_chunk(parser,
+                                       (const unsigned char*)test_malformed[i].data,
+                                       test_malformed[i].length, 1);
+    raptor_free_parser(parser);
+    raptor_world_set_log_handler(world, NULL, NULL);
+
+    if(!failed || !errors || state.count) {
+      fprintf(stderr, "%s: %s input returned %d, %d errors and %d statements\n",
+              program, test_malformed[i].label, failed, errors, state.count);
+      rc = 1;
+    }
+  }
+
+  raptor_free_uri(base_uri);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  rc |= test_round_trip(program, world, TEST_STATEMENTS, 1);
+  rc |= test_round_trip(program, world, TEST_STATEMENTS, 7);
+  rc |= test_round_trip(program, world, TEST_RESET_STATEMENTS, 65536);
+  rc |= test_malformed_input(program, world);
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
@@ -0,0 +1,1337 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_btree.c - B+ Tree ordered container
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/* Maximum and minimum number of keys in a node other than the root.
+ * The maximum is odd so that a full node splits into two halves of
+ * the minimum around a middle key.
+ */
+#define RAPTOR_BTREE_MAX_KEYS 31
+#define RAPTOR_BTREE_MIN_KEYS (RAPTOR_BTREE_MAX_KEYS / 2)
+
+#define RAPTOR_BTREE_EXISTS 1
+#define RAPTOR_BTREE_ENOMEM -1
+
+typedef struct raptor_btree_node_s raptor_btree_node;
+
+/* B+ Tree node
+ *
+ * Items are only held in the leaves, which are linked in order.  An
+ * internal node with count keys has count + 1 children and key i is
+ * the smallest item under child i + 1.
+ */
+struct raptor_btree_node_s {
+  /* non-0 for a leaf node */
+  int leaf;
+
+  /* number of keys */
+  int count;
+
+  /* leaf: items; internal: separator items */
+  void* keys[RAPTOR_BTREE_MAX_KEYS];
+
+  /* leaf: previous and next leaves */
+  raptor_btree_node* prev;
+  raptor_btree_node* next;
+};
+
+/* Internal node: a node followed by its children.  Leaves are
+ * allocated as a plain raptor_btree_node without them.
+ */
+typedef struct {
+  raptor_btree_node node;
+
+  raptor_btree_node* children[RAPTOR_BTREE_MAX_KEYS + 1];
+} raptor_btree_internal_node;
+
+/* children of an internal node */
+#define RAPTOR_BTREE_CHILDREN(n) (((raptor_btree_internal_node*)(n))->children)
+
+
+struct raptor_btree_s {
+  /* root node or NULL if the tree is empty */
+  raptor_btree_node* root;
+
+  /* first and last leaves */
+  raptor_btree_node* first;
+  raptor_btree_node* last;
+
+  /* item comparison function */
+  raptor_data_compare_handler compare_handler;
+
+  /* item free function (optional) */
+  raptor_data_free_handler free_handler;
+
+  /* tree bitflags - bitmask of #raptor_avltree_bitflags flags */
+  unsigned int flags;
+
+  /* number of items in tree */
+  unsigned int size;
+};
+
+
+struct raptor_btree_iterator_s {
+  raptor_btree* tree;
+
+  /* current leaf and index in it or NULL when finished */
+  raptor_btree_node* node;
+  int index;
+
+  void* range;
+  raptor_data_free_handler range_free_handler;
+  int direction;
+  int is_finished;
+};
+
+
+static raptor_btree_node*
+raptor_btree_new_node(int leaf)
+{
+  raptor_btree_node* node;
+
+  node = RAPTOR_MALLOC(raptor_btree_node*,
+                       leaf ? sizeof(raptor_btree_node) :
+                              sizeof(raptor_btree_internal_node));
+  if(!node)
+    return NULL;
+
+  node->leaf = leaf;
+  node->count = 0;
+  node->prev = NULL;
+  node->next = NULL;
+
+  return node;
+}
+
+
+static void
+raptor_btree_free_node(raptor_btree* tree, raptor_btree_node* node)
+{
+  int i;
+
+  if(node->leaf) {
+    if(tree->free_handler) {
+      for(i = 0; i < node->count; i++)
+        tree->free_handler(node->keys[i]);
+    }
+  } else {
+    for(i = 0; i <= node->count; i++)
+      raptor_btree_free_node(tree, RAPTOR_BTREE_CHILDREN(node)[i]);
+  }
+
+  RAPTOR_FREE(raptor_btree_node, node);
+}
+
+
+/*
+ * raptor_new_btree:
+ * @compare_handler: item comparison handler for ordering
+ * @free_handler: item free handler (or NULL)
+ * @flags: bitmask of #raptor_avltree_bitflags flags
+ *
+ * INTERNAL - B+ Tree constructor
+ *
+ * Return value: new B+ Tree or NULL on failure
+ */
+raptor_btree*
+raptor_new_btree(raptor_data_compare_handler compare_handler,
+                 raptor_data_free_handler free_handler,
+                 unsigned int flags)
+{
+  raptor_btree* tree;
+
+  tree = RAPTOR_CALLOC(raptor_btree*, 1, sizeof(*tree));
+  if(!tree)
+    return NULL;
+
+  tree->compare_handler = compare_handler;
+  tree->free_handler = free_handler;
+  tree->flags = flags;
+
+  return tree;
+}
+
+
+/*
+ * raptor_free_btree:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - B+ Tree destructor
+ */
+void
+raptor_free_btree(raptor_btree* tree)
+{
+  if(!tree)
+    return;
+
+  if(tree->root)
+    raptor_btree_free_node(tree, tree->root);
+
+  RAPTOR_FREE(raptor_btree, tree);
+}
+
+
+/* Index of the child of internal @node that @data belongs under */
+static int
+raptor_btree_child_index(raptor_btree* tree, raptor_btree_node* node,
+                         const void* data)
+{
+  int lo = 0;
+  int hi = node->count;
+
+  while(lo < hi) {
+    int mid = (lo + hi) / 2;
+    int cmp = tree->compare_handler(data, node->keys[mid]);
+    if(cmp < 0)
+      hi = mid;
+    else if(cmp > 0)
+      lo = mid + 1;
+    else
+      /* keys are unique so no later key can be equal */
+      return mid + 1;
+  }
+
+  return lo;
+}
+
+
+/* Index of @data in leaf @node or where it would be inserted.  Sets
+ * *found_p to non-0 if it is present */
+static int
+raptor_btree_leaf_index(raptor_btree* tree, raptor_btree_node* node,
+                        const void* data, int* found_p)
+{
+  int lo = 0;
+  int hi = node->count;
+
+  *found_p = 0;
+  while(lo < hi) {
+    int mid = (lo + hi) / 2;
+    int cmp = tree->compare_handler(data, node->keys[mid]);
+    if(cmp < 0)
+      hi = mid;
+    else if(cmp > 0)
+      lo = mid + 1;
+    else {
+      *found_p = 1;
+      return mid;
+    }
+  }
+
+  return lo;
+}
+
+
+/* Smallest item under @node */
+static void*
+raptor_btree_node_min(raptor_btree_node* node)
+{
+  while(!node->leaf)
+    node = RAPTOR_BTREE_CHILDREN(node)[0];
+
+  return node->keys[0];
+}
+
+
+/*
+ * raptor_btree_fix_separator:
+ * @tree: B+ Tree object
+ * @data: item to search for
+ * @old: item that may be used as a separator
+ *
+ * INTERNAL - Update any separator that is @old after @old was the
+ * first item in a leaf and has been removed or replaced
+ *
+ * A separator equal to @data can only be on the search path for
+ * @data, to the immediate left of the child followed.
+ */
+static void
+raptor_btree_fix_separator(raptor_btree* tree, const void* data, void* old)
+{
+  raptor_btree_node* node = tree->root;
+
+  while(node && !node->leaf) {
+    int i = raptor_btree_child_index(tree, node, data);
+
+    if(i > 0 && node->keys[i - 1] == old) {
+      node->keys[i - 1] = raptor_btree_node_min(RAPTOR_BTREE_CHILDREN(node)[i]);
+      return;
+    }
+
+    node = RAPTOR_BTREE_CHILDREN(node)[i];
+  }
+}
+
+
+/* Split full child @i of internal @parent into two */
+static int
+raptor_btree_split_child(raptor_btree* tree, raptor_btree_node* parent, int i)
+{
+  raptor_btree_node** children = RAPTOR_BTREE_CHILDREN(parent);
+  raptor_btree_node* child = children[i];
+  raptor_btree_node* right;
+  void* separator;
+  int half = RAPTOR_BTREE_MIN_KEYS;
+
+  right = raptor_btree_new_node(child->leaf);
+  if(!right)
+    return 1;
+
+  if(child->leaf) {
+    /* right leaf takes the upper half; its first item is the separator */
+    right->count = child->count - half;
+    memcpy(right->keys, &child->keys[half], right->count * sizeof(void*));
+    child->count = half;
+    separator = right->keys[0];
+
+    right->prev = child;
+    right->next = child->next;
+    if(child->next)
+      child->next->prev = right;
+    else
+      tree->last = right;
+    child->next = right;
+  } else {
+    /* middle key moves up */
+    right->count = child->count - half - 1;
+    memcpy(right->keys, &child->keys[half + 1], right->count * sizeof(void*));
+    memcpy(RAPTOR_BTREE_CHILDREN(right),
+           &RAPTOR_BTREE_CHILDREN(child)[half + 1],
+           (right->count + 1) * sizeof(raptor_btree_node*));
+    separator = child->keys[half];
+    child->count = half;
+  }
+
+  memmove(&parent->keys[i + 1], &parent->keys[i],
+          (parent->count - i) * sizeof(void*));
+  memmove(&children[i + 2], &children[i + 1],
+          (parent->count - i) * sizeof(raptor_btree_node*));
+  parent->keys[i] = separator;
+  children[i + 1] = right;
+  parent->count++;
+
+  return 0;
+}
+
+
+/*
+ * raptor_btree_add:
+ * @tree: B+ Tree object
+ * @p_data: item to add
+ *
+ * INTERNAL - Add an item to a B+ Tree
+ *
+ * Behaves like raptor_avltree_add(): full nodes are split on the way
+ * down so a failure leaves the tree valid.
+ *
+ * Return value: 0 on success, >0 if equivalent item exists, <0 on failure
+ */
+int
+raptor_btree_add(raptor_btree* tree, void* p_data)
+{
+  raptor_btree_node* node;
+  void* old;
+  int found;
+  int i;
+
+  if(!tree->root) {
+    tree->root = raptor_btree_new_node(1);
+    if(!tree->root)
+      goto enomem;
+    tree->first = tree->last = tree->root;
+  }
+
+  if(tree->root->count == RAPTOR_BTREE_MAX_KEYS) {
+    node = raptor_btree_new_node(0);
+    if(!node)
+      goto enomem;
+    RAPTOR_BTREE_CHILDREN(node)[0] = tree->root;
+    tree->root = node;
+    if(raptor_btree_split_child(tree, node, 0)) {
+      tree->root = RAPTOR_BTREE_CHILDREN(node)[0];
+      RAPTOR_FREE(raptor_btree_node, node);
+      goto enomem;
+    }
+  }
+
+  node = tree->root;
+  while(!node->leaf) {
+    i = raptor_btree_child_index(tree, node, p_data);
+    if(RAPTOR_BTREE_CHILDREN(node)[i]->count == RAPTOR_BTREE_MAX_KEYS) {
+      if(raptor_btree_split_child(tree, node, i))
+        goto enomem;
+      if(tree->compare_handler(p_data, node->keys[i]) >= 0)
+        i++;
+    }
+    node = RAPTOR_BTREE_CHILDREN(node)[i];
+  }
+
+  i = raptor_btree_leaf_index(tree, node, p_data, &found);
+  if(found) {
+    if(!(tree->flags & RAPTOR_AVLTREE_FLAG_REPLACE_DUPLICATES)) {
+      /* ignore item with equivalent key */
+      if(tree->free_handler)
+        tree->free_handler(p_data);
+      return RAPTOR_BTREE_EXISTS;
+    }
+
+    /* replace item with equivalent key */
+    old = node->keys[i];
+    node->keys[i] = p_data;
+    if(!i)
+      raptor_btree_fix_separator(tree, old, old);
+    if(tree->free_handler)
+      tree->free_handler(old);
+    return 0;
+  }
+
+  memmove(&node->keys[i + 1], &node->keys[i],
+          (node->count - i) * sizeof(void*));
+  node->keys[i] = p_data;
+  node->count++;
+  tree->size++;
+
+  return 0;
+
+  enomem:
+  if(tree->free_handler)
+    tree->free_handler(p_data);
+  return RAPTOR_BTREE_ENOMEM;
+}
+
+
+/* Merge child @i + 1 of internal @parent into child @i */
+static void
+raptor_btree_merge_children(raptor_btree* tree, raptor_btree_node* parent,
+                            int i)
+{
+  raptor_btree_node** children = RAPTOR_BTREE_CHILDREN(parent);
+  raptor_btree_node* left = children[i];
+  raptor_btree_node* right = children[i + 1];
+
+  if(left->leaf) {
+    memcpy(&left->keys[left->count], right->keys,
+           right->count * sizeof(void*));
+    left->count += right->count;
+
+    left->next = right->next;
+    if(right->next)
+      right->next->prev = left;
+    else
+      tree->last = left;
+  } else {
+    /* separator moves down between the two */
+    left->keys[left->count] = parent->keys[i];
+    memcpy(&left->keys[left->count + 1], right->keys,
+           right->count * sizeof(void*));
+    memcpy(&RAPTOR_BTREE_CHILDREN(left)[left->count + 1],
+           RAPTOR_BTREE_CHILDREN(right),
+           (right->count + 1) * sizeof(raptor_btree_node*));
+    left->count += right->count + 1;
+  }
+
+  memmove(&parent->keys[i], &parent->keys[i + 1],
+          (parent->count - i - 1) * sizeof(void*));
+  memmove(&children[i + 1], &children[i + 2],
+          (parent->count - i - 1) * sizeof(raptor_btree_node*));
+  parent->count--;
+
+  RAPTOR_FREE(raptor_btree_node, right);
+}
+
+
+/* Refill child @i of internal @parent after it fell below the minimum */
+static void
+raptor_btree_rebalance_child(raptor_btree* tree, raptor_btree_node* parent,
+                             int i)
+{
+  raptor_btree_node** children = RAPTOR_BTREE_CHILDREN(parent);
+  raptor_btree_node* child = children[i];
+  raptor_btree_node* left = (i > 0) ? children[i - 1] : NULL;
+  raptor_btree_node* right = (i < parent->count) ? children[i + 1] : NULL;
+
+  if(left && left->count > RAPTOR_BTREE_MIN_KEYS) {
+    /* borrow the last item of the left sibling */
+    memmove(&child->keys[1], child->keys, child->count * sizeof(void*));
+    if(child->leaf) {
+      child->keys[0] = left->keys[left->count - 1];
+      parent->keys[i - 1] = child->keys[0];
+    } else {
+      memmove(&RAPTOR_BTREE_CHILDREN(child)[1], RAPTOR_BTREE_CHILDREN(child),
+              (child->count + 1) * sizeof(raptor_btree_node*));
+      child->keys[0] = parent->keys[i - 1];
+      RAPTOR_BTREE_CHILDREN(child)[0] =
+        RAPTOR_BTREE_CHILDREN(left)[left->count];
+      parent->keys[i - 1] = left->keys[left->count - 1];
+    }
+    child->count++;
+    left->count--;
+  } else if(right && right->count > RAPTOR_BTREE_MIN_KEYS) {
+    /* borrow the first item of the right sibling */
+    if(child->leaf) {
+      child->keys[child->count] = right->keys[0];
+      memmove(right->keys, &right->keys[1],
+              (right->count - 1) * sizeof(void*));
+      parent->keys[i] = right->keys[0];
+    } else {
+      child->keys[child->count] = parent->keys[i];
+      RAPTOR_BTREE_CHILDREN(child)[child->count + 1] =
+        RAPTOR_BTREE_CHILDREN(right)[0];
+      parent->keys[i] = right->keys[0];
+      memmove(right->keys, &right->keys[1],
+              (right->count - 1) * sizeof(void*));
+      memmove(RAPTOR_BTREE_CHILDREN(right), &RAPTOR_BTREE_CHILDREN(right)[1],
+              right->count * sizeof(raptor_btree_node*));
+    }
+    child->count++;
+    right->count--;
+  } else if(left)
+    raptor_btree_merge_children(tree, parent, i - 1);
+  else
+    raptor_btree_merge_children(tree, parent, i);
+}
+
+
+static void*
+raptor_btree_remove_internal(raptor_btree* tree, raptor_btree_node* node,
+                             void* p_data, int* first_p)
+{
+  void* rdata;
+  int i;
+
+  if(node->leaf) {
+    int found;
+
+    i = raptor_btree_leaf_index(tree, node, p_data, &found);
+    if(!found)
+      return NULL;
+
+    rdata = node->keys[i];
+    memmove(&node->keys[i], &node->keys[i + 1],
+            (node->count - i - 1) * sizeof(void*));
+    node->count--;
+    *first_p = !i;
+
+    return rdata;
+  }
+
+  i = raptor_btree_child_index(tree, node, p_data);
+  rdata = raptor_btree_remove_internal(tree, RAPTOR_BTREE_CHILDREN(node)[i],
+                                       p_data, first_p);
+  if(rdata && RAPTOR_BTREE_CHILDREN(node)[i]->count < RAPTOR_BTREE_MIN_KEYS)
+    raptor_btree_rebalance_child(tree, node, i);
+
+  return rdata;
+}
+
+
+/*
+ * raptor_btree_remove:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - Remove an item from a B+ Tree and return it
+ *
+ * Return value: object or NULL on failure or if not found
+ */
+void*
+raptor_btree_remove(raptor_btree* tree, void* p_data)
+{
+  raptor_btree_node* root = tree->root;
+  void* rdata;
+  int first = 0;
+
+  if(!root)
+    return NULL;
+
+  rdata = raptor_btree_remove_internal(tree, root, p_data, &first);
+  if(!rdata)
+    return NULL;
+
+  tree->size--;
+
+  if(!root->count) {
+    if(root->leaf) {
+      tree->root = tree->first = tree->last = NULL;
+    } else
+      tree->root = RAPTOR_BTREE_CHILDREN(root)[0];
+    RAPTOR_FREE(raptor_btree_node, root);
+  }
+
+  /* the removed item may still be a separator */
+  if(first)
+    raptor_btree_fix_separator(tree, rdata, rdata);
+
+  return rdata;
+}
+
+
+/*
+ * raptor_btree_delete:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - Remove an item from a B+ Tree and free it
+ *
+ * Return value: non-0 if the item was found
+ */
+int
+raptor_btree_delete(raptor_btree* tree, void* p_data)
+{
+  void* rdata;
+
+  rdata = raptor_btree_remove(tree, p_data);
+  if(rdata && tree->free_handler)
+    tree->free_handler(rdata);
+
+  return (rdata != NULL);
+}
+
+
+/*
+ * raptor_btree_search:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item to search for
+ *
+ * INTERNAL - Find an item in a B+ Tree
+ *
+ * Return value: the item or NULL if not found
+ */
+void*
+raptor_btree_search(raptor_btree* tree, const void* p_data)
+{
+  raptor_btree_node* node = tree->root;
+  int found;
+  int i;
+
+  if(!node)
+    return NULL;
+
+  while(!node->leaf) {
+    i = raptor_btree_child_index(tree, node, p_data);
+    node = RAPTOR_BTREE_CHILDREN(node)[i];
+  }
+
+  i = raptor_btree_leaf_index(tree, node, p_data, &found);
+
+  return found ? node->keys[i] : NULL;
+}
+
+
+/*
+ * raptor_btree_visit:
+ * @tree: B+ Tree object
+ * @visit_handler: visit function to call at each item
+ * @user_data: user data pointer for visit function
+ *
+ * INTERNAL - Perform an in-order visit of the items in a B+ Tree
+ *
+ * The depth passed to @visit_handler is always 0.
+ *
+ * Return value: as raptor_avltree_visit(): 0 if the visit was
+ * terminated early by @visit_handler
+ */
+int
+raptor_btree_visit(raptor_btree* tree,
+                   raptor_avltree_visit_handler visit_handler,
+                   void* user_data)
+{
+  raptor_btree_node* node;
+  int i;
+
+  for(node = tree->first; node; node = node->next) {
+    for(i = 0; i < node->count; i++) {
+      if(!visit_handler(0, node->keys[i], user_data))
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/*
+ * raptor_btree_size:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - Get the number of items in a B+ Tree
+ *
+ * Return value: number of items
+ */
+int
+raptor_btree_size(raptor_btree* tree)
+{
+  return RAPTOR_BAD_CAST(int, tree->size);
+}
+
+
+/* Build one level of a tree above @count nodes with smallest items
+ * @mins from the preallocated internal nodes at @pool, returning the
+ * new nodes and their smallest items in place */
+static int
+raptor_btree_build_level(raptor_btree_node** nodes, void** mins, int count,
+                         raptor_btree_node** pool)
+{
+  int parents = (count + RAPTOR_BTREE_MAX_KEYS) / (RAPTOR_BTREE_MAX_KEYS + 1);
+  int n = 0;
+  int p;
+
+  for(p = 0; p < parents; p++) {
+    /* share the children evenly so every node has at least the minimum */
+    int children = count / parents + (p < count % parents);
+    raptor_btree_node* parent = pool[p];
+    int c;
+
+    RAPTOR_BTREE_CHILDREN(parent)[0] = nodes[n];
+    parent->count = children - 1;
+    for(c = 1; c < children; c++) {
+      RAPTOR_BTREE_CHILDREN(parent)[c] = nodes[n + c];
+      parent->keys[c - 1] = mins[n + c];
+    }
+
+    mins[p] = mins[n];
+    nodes[p] = parent;
+    n += children;
+  }
+
+  return parents;
+}
+
+
+/*
+ * raptor_btree_build_from_sorted:
+ * @tree: empty B+ Tree object
+ * @items: array of data items sorted by the tree comparison handler
+ * @count: number of items in @items
+ *
+ * INTERNAL - Add sorted items to an empty B+ Tree in O(n)
+ *
+ * Behaves like raptor_avltree_build_from_sorted().  The leaves are
+ * filled in order and the internal levels built above them.
+ *
+ * Return value: non-0 on failure: <0 if memory is exhausted, >0 if
+ * @items is not sorted or the tree is not empty
+ */
+int
+raptor_btree_build_from_sorted(raptor_btree* tree, void** items, int count)
+{
+  raptor_btree_node** nodes;
+  void** mins = NULL;
+  raptor_btree_node* last = NULL;
+  int leaves;
+  int total;
+  int n;
+  int i;
+  int l;
+
+  if(tree->root)
+    return 1;
+
+  if(count <= 0)
+    return 0;
+
+  for(i = 1; i < count; i++) {
+    if(tree->compare_handler(items[i - 1], items[i]) > 0)
+      return 1;
+  }
+
+  /* count the items that will be kept */
+  n = 1;
+  for(i = 1; i < count; i++) {
+    if(tree->compare_handler(items[i - 1], items[i]))
+      n++;
+  }
+
+  /* count the nodes at every level so they can all be allocated before
+   * any item is consumed */
+  leaves = (n + RAPTOR_BTREE_MAX_KEYS - 1) / RAPTOR_BTREE_MAX_KEYS;
+  total = leaves;
+  for(l = leaves; l > 1; ) {
+    l = (l + RAPTOR_BTREE_MAX_KEYS) / (RAPTOR_BTREE_MAX_KEYS + 1);
+    total += l;
+  }
+
+  nodes = RAPTOR_CALLOC(raptor_btree_node**, RAPTOR_GOOD_CAST(size_t, total),
+                        sizeof(*nodes));
+  if(!nodes)
+    return RAPTOR_BTREE_ENOMEM;
+
+  mins = RAPTOR_CALLOC(void**, RAPTOR_GOOD_CAST(size_t, leaves),
+                       sizeof(*mins));
+  if(!mins)
+    goto enomem;
+
+  for(l = 0; l < total; l++) {
+    nodes[l] = raptor_btree_new_node(l < leaves);
+    if(!nodes[l])
+      goto enomem;
+  }
+
+  l = 0;
+  for(i = 0; i < count; i++) {
+    raptor_btree_node* leaf;
+
+    if(last && !tree->compare_handler(last->keys[last->count - 1], items[i])) {
+      /* equivalent to the previous kept item */
+      if(tree->flags & RAPTOR_AVLTREE_FLAG_REPLACE_DUPLICATES) {
+        if(tree->free_handler)
+          tree->free_handler(last->keys[last->count - 1]);
+        last->keys[last->count - 1] = items[i];
+      } else if(tree->free_handler)
+        tree->free_handler(items[i]);
+      continue;
+    }
+
+    leaf = nodes[l];
+    leaf->keys[leaf->count++] = items[i];
+    last = leaf;
+    if(leaf->count == n / leaves + (l < n % leaves))
+      l++;
+  }
+
+  last = NULL;
+  for(l = 0; l < leaves; l++) {
+    mins[l] = nodes[l]->keys[0];
+    nodes[l]->prev = last;
+    if(last)
+      last->next = nodes[l];
+    last = nodes[l];
+  }
+  tree->first = nodes[0];
+  tree->last = last;
+  tree->size = RAPTOR_BAD_CAST(unsigned int, n);
+
+  /* each level reuses the start of nodes for the parents it built */
+  i = leaves;
+  for(l = leaves; l > 1; ) {
+    int parents = raptor_btree_build_level(nodes, mins, l, &nodes[i]);
+    i += parents;
+    l = parents;
+  }
+  tree->root = nodes[0];
+
+  RAPTOR_FREE(raptor_btree_node**, nodes);
+  RAPTOR_FREE(void**, mins);
+
+  return 0;
+
+  enomem:
+  for(l = 0; l < total; l++) {
+    if(nodes[l])
+      RAPTOR_FREE(raptor_btree_node, nodes[l]);
+  }
+  RAPTOR_FREE(raptor_btree_node**, nodes);
+  if(mins)
+    RAPTOR_FREE(void**, mins);
+  return RAPTOR_BTREE_ENOMEM;
+}
+
+
+/* Check that the iterator item is in range, finishing it if not */
+static void
+raptor_btree_iterator_check(raptor_btree_iterator* iterator)
+{
+  raptor_btree_node* node = iterator->node;
+
+  if(node && iterator->range &&
+     iterator->tree->compare_handler(iterator->range,
+                                     node->keys[iterator->index]))
+    iterator->node = NULL;
+
+  iterator->is_finished = (iterator->node == NULL);
+}
+
+
+/*
+ * raptor_new_btree_iterator:
+ * @tree: B+ Tree object
+ * @range: range or NULL
+ * @range_free_handler: function to free @range object
+ * @direction: <0 to go 'backwards' otherwise 'forwards'
+ *
+ * INTERNAL - Get an in-order iterator over a range or the entire contents
+ *
+ * Behaves like raptor_new_avltree_iterator().
+ *
+ * Return value: a new iterator or NULL on failure
+ */
+raptor_btree_iterator*
+raptor_new_btree_iterator(raptor_btree* tree, void* range,
+                          raptor_data_free_handler range_free_handler,
+                          int direction)
+{
+  raptor_btree_iterator* iterator;
+  raptor_btree_node* node;
+
+  iterator = RAPTOR_CALLOC(raptor_btree_iterator*, 1, sizeof(*iterator));
+  if(!iterator)
+    return NULL;
+
+  iterator->tree = tree;
+  iterator->range = range;
+  iterator->range_free_handler = range_free_handler;
+  iterator->direction = direction;
+
+  node = tree->root;
+  if(!node) {
+    iterator->is_finished = 1;
+    return iterator;
+  }
+
+  if(!range) {
+    if(direction < 0) {
+      iterator->node = tree->last;
+      iterator->index = tree->last->count - 1;
+    } else {
+      iterator->node = tree->first;
+      iterator->index = 0;
+    }
+    return iterator;
+  }
+
+  /* find the first or last item matching range */
+  while(1) {
+    int lo = 0;
+    int hi = node->count;
+
+    while(lo < hi) {
+      int mid = (lo + hi) / 2;
+      int cmp = tree->compare_handler(range, node->keys[mid]);
+      if(cmp > 0 || (direction < 0 && !cmp))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    if(node->leaf) {
+      if(direction < 0) {
+        /* last item not after range */
+        if(lo) {
+          iterator->node = node;
+          iterator->index = lo - 1;
+        } else if(node->prev) {
+          iterator->node = node->prev;
+          iterator->index = node->prev->count - 1;
+        }
+      } else {
+        /* first item not before range */
+        if(lo < node->count) {
+          iterator->node = node;
+          iterator->index = lo;
+        } else if(node->next) {
+          iterator->node = node->next;
+          iterator->index = 0;
+        }
+      }
+      break;
+    }
+
+    node = RAPTOR_BTREE_CHILDREN(node)[lo];
+  }
+
+  raptor_btree_iterator_check(iterator);
+
+  return iterator;
+}
+
+
+/*
+ * raptor_free_btree_iterator:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - B+ Tree iterator destructor
+ */
+void
+raptor_free_btree_iterator(raptor_btree_iterator* iterator)
+{
+  if(!iterator)
+    return;
+
+  if(iterator->range && iterator->range_free_handler)
+    iterator->range_free_handler(iterator->range);
+
+  RAPTOR_FREE(raptor_btree_iterator, iterator);
+}
+
+
+/*
+ * raptor_btree_iterator_is_end:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Test if an iteration is finished
+ *
+ * Return value: non-0 if iteration is finished
+ */
+int
+raptor_btree_iterator_is_end(raptor_btree_iterator* iterator)
+{
+  return iterator->is_finished;
+}
+
+
+/*
+ * raptor_btree_iterator_next:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Move iteration to next/prev object
+ *
+ * Return value: non-0 if iteration is finished
+ */
+int
+raptor_btree_iterator_next(raptor_btree_iterator* iterator)
+{
+  raptor_btree_node* node = iterator->node;
+
+  if(!node || iterator->is_finished)
+    return 1;
+
+  if(iterator->direction < 0) {
+    if(--iterator->index < 0) {
+      node = node->prev;
+      if(node)
+        iterator->index = node->count - 1;
+    }
+  } else {
+    if(++iterator->index == node->count) {
+      node = node->next;
+      iterator->index = 0;
+    }
+  }
+  iterator->node = node;
+
+  raptor_btree_iterator_check(iterator);
+
+  return iterator->is_finished;
+}
+
+
+/*
+ * raptor_btree_iterator_get:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Get current iteration object
+ *
+ * Return value: object or NULL if iteration is finished
+ */
+void*
+raptor_btree_iterator_get(raptor_btree_iterator* iterator)
+{
+  if(iterator->is_finished)
+    return NULL;
+
+  return iterator->node->keys[iterator->index];
+}
+
+
+#ifdef RAPTOR_DEBUG
+
+static void
+raptor_btree_check_node(raptor_btree* tree, raptor_btree_node* node,
+                        void* low, void* high, int depth, int* leaf_depth_p,
+                        unsigned int* count_p)
+{
+  int i;
+
+  if(node != tree->root && node->count < RAPTOR_BTREE_MIN_KEYS) {
+    fprintf(stderr, "B+ Tree %p node %p has %d keys, below the minimum\n",
+            tree, node, node->count);
+    abort();
+  }
+
+  for(i = 0; i < node->count; i++) {
+    if((i && tree->compare_handler(node->keys[i - 1], node->keys[i]) >= 0) ||
+       (low && tree->compare_handler(low, node->keys[i]) > 0) ||
+       (high && tree->compare_handler(node->keys[i], high) >= 0)) {
+      fprintf(stderr, "B+ Tree %p node %p key %d is out of order\n",
+              tree, node, i);
+      abort();
+    }
+  }
+
+  if(node->leaf) {
+    if(*leaf_depth_p < 0)
+      *leaf_depth_p = depth;
+    else if(*leaf_depth_p != depth) {
+      fprintf(stderr, "B+ Tree %p leaf %p is at depth %d not %d\n",
+              tree, node, depth, *leaf_depth_p);
+      abort();
+    }
+    *count_p += RAPTOR_BAD_CAST(unsigned int, node->count);
+    return;
+  }
+
+  for(i = 0; i <= node->count; i++) {
+    raptor_btree_node* child = RAPTOR_BTREE_CHILDREN(node)[i];
+
+    if(i && raptor_btree_node_min(child) != node->keys[i - 1]) {
+      fprintf(stderr, "B+ Tree %p node %p separator %d is not the smallest item of its child\n",
+              tree, node, i - 1);
+      abort();
+    }
+    raptor_btree_check_node(tree, child,
+                            i ? node->keys[i - 1] : low,
+                            (i < node->count) ? node->keys[i] : high,
+                            depth + 1, leaf_depth_p, count_p);
+  }
+}
+
+
+/*
+ * raptor_btree_check:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - Check the structure of a B+ Tree, aborting on errors
+ */
+void
+raptor_btree_check(raptor_btree* tree)
+{
+  unsigned int count = 0;
+  int leaf_depth = -1;
+
+  if(tree->root)
+    raptor_btree_check_node(tree, tree->root, NULL, NULL, 0, &leaf_depth,
+                            &count);
+  if(count != tree->size) {
+    fprintf(stderr, "B+ Tree %p size is %u.  actual count %u\n",
+            tree, tree->size, count);
+    abort();
+  }
+}
+
+#endif
+
+#endif
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static int
+compare_ints(const void *l, const void *r)
+{
+  int a = *(const int*)l;
+  int b = *(const int*)r;
+
+  return (a > b) - (a < b);
+}
+
+
+typedef struct
+{
+  int count;
+  int last;
+  int failed;
+} visit_state;
+
+static int
+check_int(int depth, void* data, void *user_data)
+{
+  visit_state* vs = (visit_state*)user_data;
+  int value = *(int*)data;
+
+  if(vs->count && value <= vs->last)
+    vs->failed = 1;
+  vs->last = value;
+  vs->count++;
+
+  return 1;
+}
+
+
+#define ITEM_COUNT 5000
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  const char *program = raptor_basename(argv[0]);
+  raptor_avltree* tree;
+  raptor_avltree_iterator* iter;
+  static int values[ITEM_COUNT];
+  static int* sorted[ITEM_COUNT];
+  int range_value;
+  visit_state vs;
+  int failures = 0;
+  int i;
+  int pass;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  for(i = 0; i < ITEM_COUNT; i++)
+    values[i] = i;
+
+  for(pass = 0; pass < 2; pass++) {
+    int count;
+
+    tree = raptor_new_avltree(compare_ints, NULL, RAPTOR_AVLTREE_FLAG_BTREE);
+    if(!tree) {
+      fprintf(stderr, "%s: Failed to create tree\n", program);
+      exit(1);
+    }
+
+    if(!pass) {
+      /* add in a scattered order, twice to check duplicates */
+      for(i = 0; i < 2 * ITEM_COUNT; i++) {
+        int v = (int)(((unsigned long)i * 7919UL) % ITEM_COUNT);
+        int rc = raptor_avltree_add(tree, &values[v]);
+        if(rc != (i >= ITEM_COUNT)) {
+          fprintf(stderr, "%s: Adding item %d returned %d\n", program, v, rc);
+          failures++;
+        }
+      }
+    } else {
+      for(i = 0; i < ITEM_COUNT; i++)
+        sorted[i] = &values[i];
+      if(raptor_avltree_build_from_sorted(tree, (void**)sorted, ITEM_COUNT)) {
+        fprintf(stderr, "%s: Building tree from sorted items failed\n",
+                program);
+        failures++;
+      }
+    }
+
+    if(raptor_avltree_size(tree) != ITEM_COUNT) {
+      fprintf(stderr, "%s: Tree has size %d, expected %d\n", program,
+              raptor_avltree_size(tree), ITEM_COUNT);
+      failures++;
+    }
+
+    /* delete every third item */
+    for(i = 0; i < ITEM_COUNT; i += 3) {
+      if(!raptor_avltree_delete(tree, &values[i])) {
+        fprintf(stderr, "%s: Deleting item %d failed\n", program, i);
+        failures++;
+      }
+    }
+#ifdef RAPTOR_DEBUG
+    raptor_avltree_check(tree);
+#endif
+
+    for(i = 0; i < ITEM_COUNT; i++) {
+      int* found = (int*)raptor_avltree_search(tree, &values[i]);
+      if((i % 3) ? (found != &values[i]) : (found != NULL)) {
+        fprintf(stderr, "%s: Searching for item %d gave %p\n", program, i,
+                (void*)found);
+        failures++;
+      }
+    }
+
+    vs.count = 0;
+    vs.last = 0;
+    vs.failed = 0;
+    raptor_avltree_visit(tree, check_int, &vs);
+    count = ITEM_COUNT - (ITEM_COUNT + 2) / 3;
+    if(vs.failed || vs.count != count) {
+      fprintf(stderr, "%s: Visit saw %d items (%s), expected %d in order\n",
+              program, vs.count, vs.failed ? "out of order" : "in order",
+              count);
+      failures++;
+    }
+
+    /* iterate backwards over everything */
+    i = 0;
+    iter = raptor_new_avltree_iterator(tree, NULL, NULL, -1);
+    while(iter && !raptor_avltree_iterator_is_end(iter)) {
+      i++;
+      if(raptor_avltree_iterator_next(iter))
+        break;
+    }
+    raptor_free_avltree_iterator(iter);
+    if(i != count) {
+      fprintf(stderr, "%s: Backwards iterator saw %d items, expected %d\n",
+              program, i, count);
+      failures++;
+    }
+
+    /* a range matching one item, in both directions */
+    range_value = 1000;
+    iter = raptor_new_avltree_iterator(tree, &range_value, NULL, 1);
+    if(!iter || raptor_avltree_iterator_get(iter) != &values[1000] ||
+       !raptor_avltree_iterator_next(iter)) {
+      fprintf(stderr, "%s: Forwards range iterator failed\n", program);
+      failures++;
+    }
+    raptor_free_avltree_iterator(iter);
+
+    iter = raptor_new_avltree_iterator(tree, &range_value, NULL, -1);
+    if(!iter || raptor_avltree_iterator_get(iter) != &values[1000] ||
+       !raptor_avltree_iterator_next(iter)) {
+      fprintf(stderr, "%s: Backwards range iterator failed\n", program);
+      failures++;
+    }
+    raptor_free_avltree_iterator(iter);
+
+    /* a range matching a deleted item */
+    range_value = 999;
+    iter = raptor_new_avltree_iterator(tree, &range_value, NULL, 1);
+    if(!iter || raptor_avltree_iterator_get(iter)) {
+      fprintf(stderr, "%s: Range iterator for a missing item was not empty\n",
+              program);
+      failures++;
+    }
+    raptor_free_avltree_iterator(iter);
+
+    /* empty the tree */
+    for(i = 0; i < ITEM_COUNT; i++) {
+      if(i % 3)
+        raptor_avltree_delete(tree, &values[i]);
+    }
+    if(raptor_avltree_size(tree)) {
+      fprintf(stderr, "%s: Emptied tree has size %d\n", program,
+              raptor_avltree_size(tree));
+      failures++;
+    }
+#ifdef RAPTOR_DEBUG
+    raptor_avltree_check(tree);
+#endif
+
+    raptor_free_avltree(tree);
+  }
+
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif
@@ -0,0 +1,1733 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_compress.c - Raptor compressed content iostreams
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef RAPTOR_ZLIB
+#include <zlib.h>
+#endif
+#ifdef RAPTOR_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef RAPTOR_ZSTD
+#include <zstd.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/* POLICY - size of the buffer compressed content is read into */
+#define RAPTOR_DECOMPRESS_BUFFER_SIZE (64 * 1024)
+
+
+static const char* const raptor_compression_names[RAPTOR_COMPRESSION_LAST + 1] = {
+  "none",
+  "gzip",
+  "bzip2",
+  "zstd"
+};
+
+
+/**
+ * raptor_compression_detect:
+ * @buffer: start of content
+ * @len: length of @buffer
+ *
+ * INTERNAL - Detect compressed content by its magic bytes
+ *
+ * At least #RAPTOR_COMPRESSION_MAGIC_SIZE bytes are needed to detect
+ * all kinds of compression, fewer only if that is all the content.
+ *
+ * Return value: compression of the content or #RAPTOR_COMPRESSION_NONE
+ */
+raptor_compression
+raptor_compression_detect(const unsigned char* buffer, size_t len)
+{
+  /* gzip member with the deflate method */
+  if(len >= 3 && buffer[0] == 0x1f && buffer[1] == 0x8b && buffer[2] == 8)
+    return RAPTOR_COMPRESSION_GZIP;
+
+  /* bzip2 stream "BZh" with a block size digit */
+  if(len >= 4 && buffer[0] == 'B' && buffer[1] == 'Z' && buffer[2] == 'h' &&
+     buffer[3] >= '1' && buffer[3] <= '9')
+    return RAPTOR_COMPRESSION_BZIP2;
+
+  /* zstd frame */
+  if(len >= 4 && buffer[0] == 0x28 && buffer[1] == 0xb5 &&
+     buffer[2] == 0x2f && buffer[3] == 0xfd)
+    return RAPTOR_COMPRESSION_ZSTD;
+
+  return RAPTOR_COMPRESSION_NONE;
+}
+
+
+/**
+ * raptor_compression_is_available:
+ * @compression: compression
+ *
+ * INTERNAL - Check if a compression is supported by this build
+ *
+ * Return value: non-0 if @compression can be read
+ */
+int
+raptor_compression_is_available(raptor_compression compression)
+{
+  switch(compression) {
+    case RAPTOR_COMPRESSION_NONE:
+      return 1;
+
+    case RAPTOR_COMPRESSION_GZIP:
+#ifdef RAPTOR_ZLIB
+      return 1;
+#else
+      return 0;
+#endif
+
+    case RAPTOR_COMPRESSION_BZIP2:
+#ifdef RAPTOR_BZIP2
+      return 1;
+#else
+      return 0;
+#endif
+
+    case RAPTOR_COMPRESSION_ZSTD:
+#ifdef RAPTOR_ZSTD
+      return 1;
+#else
+      return 0;
+#endif
+
+    default:
+      return 0;
+  }
+}
+
+
+/**
+ * raptor_compression_get_name:
+ * @compression: compression
+ *
+ * INTERNAL - Get the name of a compression
+ *
+ * Return value: shared name or NULL if @compression is not known
+ */
+const char*
+raptor_compression_get_name(raptor_compression compression)
+{
+  if(compression > RAPTOR_COMPRESSION_LAST)
+    return NULL;
+
+  return raptor_compression_names[compression];
+}
+
+
+typedef struct {
+  raptor_compression compression;
+
+  FILE* handle;
+  int close_handle;
+
+  /* compressed content read from handle: in[in_offset, in_length) is
+   * not yet used */
+  unsigned char* in;
+  size_t in_offset;
+  size_t in_length;
+
+  /* non-0 when handle has been read to the end */
+  int in_eof;
+
+  /* non-0 while in a gzip member, bzip2 stream or zstd frame */
+  int started;
+
+  /* non-0 when all content was returned */
+  int eof;
+
+  int failed;
+
+#ifdef RAPTOR_ZLIB
+  z_stream zs;
+  int zs_ready;
+#endif
+#ifdef RAPTOR_BZIP2
+  bz_stream bzs;
+  int bzs_ready;
+#endif
+#ifdef RAPTOR_ZSTD
+  ZSTD_DStream* zstd;
+#endif
+} raptor_decompress_context;
+
+
+static void
+raptor_decompress_iostream_finish(void* user_data)
+{
+  raptor_decompress_context* ctx = (raptor_decompress_context*)user_data;
+
+#ifdef RAPTOR_ZLIB
+  if(ctx->zs_ready)
+    inflateEnd(&ctx->zs);
+#endif
+#ifdef RAPTOR_BZIP2
+  if(ctx->bzs_ready)
+    BZ2_bzDecompressEnd(&ctx->bzs);
+#endif
+#ifdef RAPTOR_ZSTD
+  if(ctx->zstd)
+    ZSTD_freeDStream(ctx->zstd);
+#endif
+
+  if(ctx->close_handle)
+    fclose(ctx->handle);
+
+  if(ctx->in)
+    RAPTOR_FREE(char*, ctx->in);
+
+  RAPTOR_FREE(raptor_decompress_context, ctx);
+}
+
+
+/* Read more compressed content once all buffered content is used */
+static int
+raptor_decompress_fill(raptor_decompress_context* ctx)
+{
+  size_t len;
+
+  if(ctx->in_offset < ctx->in_length || ctx->in_eof)
+    return 0;
+
+  len = fread(ctx->in, 1, RAPTOR_DECOMPRESS_BUFFER_SIZE, ctx->handle);
+  ctx->in_offset = 0;
+  ctx->in_length = len;
+
+  if(len < RAPTOR_DECOMPRESS_BUFFER_SIZE) {
+    if(ferror(ctx->handle))
+      return 1;
+    ctx->in_eof = 1;
+  }
+
+  return 0;
+}
+
+
+/* Start decoding a gzip member, bzip2 stream or zstd frame */
+static int
+raptor_decompress_start(raptor_decompress_context* ctx)
+{
+  switch(ctx->compression) {
+    case RAPTOR_COMPRESSION_GZIP:
+#ifdef RAPTOR_ZLIB
+      if(ctx->zs_ready)
+        return (inflateReset(&ctx->zs) != Z_OK);
+      /* 16 + window bits: expect a gzip header and trailer */
+      if(inflateInit2(&ctx->zs, 16 + MAX_WBITS) != Z_OK)
+        return 1;
+      ctx->zs_ready = 1;
+      return 0;
+#else
+      return 1;
+#endif
+
+    case RAPTOR_COMPRESSION_BZIP2:
+#ifdef RAPTOR_BZIP2
+      if(BZ2_bzDecompressInit(&ctx->bzs, 0, 0) != BZ_OK)
+        return 1;
+      ctx->bzs_ready = 1;
+      return 0;
+#else
+      return 1;
+#endif
+
+    case RAPTOR_COMPRESSION_ZSTD:
+#ifdef RAPTOR_ZSTD
+      if(!ctx->zstd) {
+        ctx->zstd = ZSTD_createDStream();
+        if(!ctx->zstd)
+          return 1;
+      }
+      return ZSTD_isError(ZSTD_initDStream(ctx->zstd));
+#else
+      return 1;
+#endif
+
+    case RAPTOR_COMPRESSION_NONE:
+    default:
+      return 1;
+  }
+}
+
+
+/*
+ * Decode some buffered content into @out.  Sets *@used_p and
+ * *@len_p to the number of bytes used and made.
+ *
+ * Return value: <0 on failure, >0 at the end of a gzip member, bzip2
+ * stream or zstd frame, 0 otherwise
+ */
+static int
+raptor_decompress_step(raptor_decompress_context* ctx,
+                       unsigned char* out, size_t out_size,
+                       size_t* used_p, size_t* len_p)
+{
+  unsigned char* in = ctx->in + ctx->in_offset;
+  size_t in_size = ctx->in_length - ctx->in_offset;
+  int status = -1;
+
+  *used_p = 0;
+  *len_p = 0;
+
+  switch(ctx->compression) {
+    case RAPTOR_COMPRESSION_GZIP:
+#ifdef RAPTOR_ZLIB
+      {
+        int rc;
+
+        /* zlib counts in uInt */
+        if(in_size > 0x40000000)
+          in_size = 0x40000000;
+        if(out_size > 0x40000000)
+          out_size = 0x40000000;
+
+        ctx->zs.next_in = in;
+        ctx->zs.avail_in = (uInt)in_size;
+        ctx->zs.next_out = out;
+        ctx->zs.avail_out = (uInt)out_size;
+        rc = inflate(&ctx->zs, Z_NO_FLUSH);
+        *used_p = in_size - ctx->zs.avail_in;
+        *len_p = out_size - ctx->zs.avail_out;
+
+        if(rc == Z_STREAM_END)
+          status = 1;
+        else if(rc == Z_OK || rc == Z_BUF_ERROR)
+          status = 0;
+      }
+#endif
+      break;
+
+    case RAPTOR_COMPRESSION_BZIP2:
+#ifdef RAPTOR_BZIP2
+      {
+        int rc;
+
+        if(in_size > 0x40000000)
+          in_size = 0x40000000;
+        if(out_size > 0x40000000)
+          out_size = 0x40000000;
+
+        ctx->bzs.next_in = (char*)in;
+        ctx->bzs.avail_in = (unsigned int)in_size;
+        ctx->bzs.next_out = (char*)out;
+        ctx->bzs.avail_out = (unsigned int)out_size;
+        rc = BZ2_bzDecompress(&ctx->bzs);
+        *used_p = in_size - ctx->bzs.avail_in;
+        *len_p = out_size - ctx->bzs.avail_out;
+
+        if(rc == BZ_STREAM_END) {
+          BZ2_bzDecompressEnd(&ctx->bzs);
+          ctx->bzs_ready = 0;
+          status = 1;
+        } else if(rc == BZ_OK)
+          status = 0;
+      }
+#endif
+      break;
+
+    case RAPTOR_COMPRESSION_ZSTD:
+#ifdef RAPTOR_ZSTD
+      {
+        ZSTD_inBuffer input;
+        ZSTD_outBuffer output;
+        size_t rc;
+
+        input.src = in;
+        input.size = in_size;
+        input.pos = 0;
+        output.dst = out;
+        output.size = out_size;
+        output.pos = 0;
+        rc = ZSTD_decompressStream(ctx->zstd, &output, &input);
+        *used_p = input.pos;
+        *len_p = output.pos;
+
+        if(!ZSTD_isError(rc))
+          status = (rc == 0) ? 1 : 0;
+      }
+#endif
+      break;
+
+    case RAPTOR_COMPRESSION_NONE:
+    default:
+      break;
+  }
+
+  return status;
+}
+
+
+static int
+raptor_decompress_iostream_read_bytes(void* user_data, void* ptr,
+                                      size_t size, size_t nmemb)
+{
+  raptor_decompress_context* ctx = (raptor_decompress_context*)user_data;
+  unsigned char* out = (unsigned char*)ptr;
+  size_t want = size * nmemb;
+  size_t got = 0;
+
+  if(!size)
+    return 0;
+
+  while(got < want && !ctx->eof) {
+    size_t used;
+    size_t len;
+    int status;
+
+    if(ctx->failed || raptor_decompress_fill(ctx)) {
+      ctx->failed = 1;
+      return -1;
+    }
+
+    if(ctx->compression == RAPTOR_COMPRESSION_NONE) {
+      len = ctx->in_length - ctx->in_offset;
+      if(len > want - got)
+        len = want - got;
+      memcpy(out + got, ctx->in + ctx->in_offset, len);
+      ctx->in_offset += len;
+      got += len;
+      if(!len)
+        ctx->eof = 1;
+      continue;
+    }
+
+    if(!ctx->started) {
+      /* the end of content is only allowed between members */
+      if(ctx->in_offset == ctx->in_length) {
+        ctx->eof = 1;
+        break;
+      }
+      if(raptor_decompress_start(ctx)) {
+        ctx->failed = 1;
+        return -1;
+      }
+      ctx->started = 1;
+    }
+
+    status = raptor_decompress_step(ctx, out + got, want - got, &used, &len);
+    ctx->in_offset += used;
+    got += len;
+
+    if(status > 0)
+      ctx->started = 0;
+    else if(status < 0 ||
+            (!used && !len && (ctx->in_offset < ctx->in_length ||
+                               ctx->in_eof))) {
+      /* corrupt or truncated content */
+      ctx->failed = 1;
+      return -1;
+    }
+  }
+
+  return RAPTOR_BAD_CAST(int, got / size);
+}
+
+
+static int
+raptor_decompress_iostream_read_eof(void* user_data)
+{
+  raptor_decompress_context* ctx = (raptor_decompress_context*)user_data;
+
+  return ctx->eof;
+}
+
+
+static const raptor_iostream_handler raptor_iostream_decompress_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_decompress_iostream_finish,
+  /* .write_byte  = */ NULL,
+  /* .write_bytes = */ NULL,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ raptor_decompress_iostream_read_bytes,
+  /* .read_eof    = */ raptor_decompress_iostream_read_eof,
+  /* .write_iov   = */ NULL
+};
+
+
+/**
+ * raptor_new_iostream_decompress_file_handle:
+ * @world: raptor world
+ * @handle: FILE* handle to read from
+ * @close_handle: non-0 to fclose @handle when the iostream is freed
+ * @prefix: content already read from @handle or NULL
+ * @prefix_len: length of @prefix
+ *
+ * INTERNAL - Constructor - create an iostream reading possibly
+ * compressed content from a FILE* handle
+ *
+ * The content is @prefix followed by the rest of @handle.  The kind
+ * of compression is detected from the magic bytes at the start and
+ * content that is not compressed is returned unchanged.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including when the content uses a compression this build cannot
+ * read
+ */
+raptor_iostream*
+raptor_new_iostream_decompress_file_handle(raptor_world* world, FILE* handle,
+                                           int close_handle,
+                                           const unsigned char* prefix,
+                                           size_t prefix_len)
+{
+  raptor_decompress_context* ctx;
+  raptor_iostream* iostr;
+
+  if(prefix_len > RAPTOR_DECOMPRESS_BUFFER_SIZE)
+    return NULL;
+
+  ctx = RAPTOR_CALLOC(raptor_decompress_context*, 1, sizeof(*ctx));
+  if(!ctx)
+    return NULL;
+
+  ctx->handle = handle;
+  ctx->in = RAPTOR_MALLOC(unsigned char*, RAPTOR_DECOMPRESS_BUFFER_SIZE);
+  if(!ctx->in) {
+    RAPTOR_FREE(raptor_decompress_context, ctx);
+    return NULL;
+  }
+
+  if(prefix_len)
+    memcpy(ctx->in, prefix, prefix_len);
+  ctx->in_length = prefix_len;
+
+  /* read enough to see the magic bytes */
+  if(prefix_len < RAPTOR_COMPRESSION_MAGIC_SIZE) {
+    ctx->in_length += fread(ctx->in + prefix_len, 1,
+                            RAPTOR_COMPRESSION_MAGIC_SIZE - prefix_len,
+                            handle);
+    if(ctx->in_length < RAPTOR_COMPRESSION_MAGIC_SIZE)
+      ctx->in_eof = 1;
+  }
+
+  ctx->compression = raptor_compression_detect(ctx->in, ctx->in_length);
+  if(!raptor_compression_is_available(ctx->compression)) {
+    RAPTOR_FREE(char*, ctx->in);
+    RAPTOR_FREE(raptor_decompress_context, ctx);
+    return NULL;
+  }
+
+  iostr = raptor_new_iostream_from_handler(world, ctx,
+                                           &raptor_iostream_decompress_handler);
+  if(!iostr) {
+    RAPTOR_FREE(char*, ctx->in);
+    RAPTOR_FREE(raptor_decompress_context, ctx);
+    return NULL;
+  }
+
+  /* now owned by the iostream */
+  ctx->close_handle = close_handle;
+
+  return iostr;
+}
+
+
+/**
+ * raptor_new_iostream_from_compressed_filename:
+ * @world: raptor world
+ * @filename: Input filename to open and read from
+ *
+ * Constructor - create a new iostream reading possibly compressed
+ * content from a filename.
+ *
+ * gzip, bzip2 or zstd compressed content, as supported by the
+ * libraries raptor was built with, is detected from its magic bytes
+ * and decompressed.  Other content is read unchanged, as by
+ * raptor_new_iostream_from_filename().
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including compressed content that cannot be read by this build
+ **/
+raptor_iostream*
+raptor_new_iostream_from_compressed_filename(raptor_world* world,
+                                             const char* filename)
+{
+  FILE* handle;
+  raptor_iostream* iostr;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!filename)
+    return NULL;
+
+  raptor_world_open(world);
+
+  handle = fopen(filename, "rb");
+  if(!handle)
+    return NULL;
+
+  iostr = raptor_new_iostream_decompress_file_handle(world, handle, 1,
+                                                     NULL, 0);
+  if(!iostr)
+    fclose(handle);
+
+  return iostr;
+}
+
+
+/**
+ * raptor_new_iostream_from_compressed_file_handle:
+ * @world: raptor world
+ * @handle: Input file_handle to read from
+ *
+ * Constructor - create a new iostream reading possibly compressed
+ * content from a file_handle.
+ *
+ * As raptor_new_iostream_from_compressed_filename() for an already
+ * open @handle, such as stdin.
+ * NOTE: This does not fclose the @handle when it is finished.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including compressed content that cannot be read by this build
+ **/
+raptor_iostream*
+raptor_new_iostream_from_compressed_file_handle(raptor_world* world,
+                                                FILE* handle)
+{
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!handle)
+    return NULL;
+
+  raptor_world_open(world);
+
+  return raptor_new_iostream_decompress_file_handle(world, handle, 0,
+                                                    NULL, 0);
+}
+
+
+/* POLICY - uncompressed size of each gzip block, the BGZF limit that
+ * keeps every compressed block within 64K */
+#define RAPTOR_COMPRESS_GZIP_BLOCK_SIZE 0xff00
+
+/* POLICY - uncompressed size of each zstd frame */
+#define RAPTOR_COMPRESS_ZSTD_BLOCK_SIZE (1024 * 1024)
+
+/* BGZF block: a gzip member with a "BC" extra field holding the
+ * block size */
+#define RAPTOR_BGZF_HEADER_SIZE 18
+#define RAPTOR_BGZF_FOOTER_SIZE 8
+#define RAPTOR_BGZF_MAX_BLOCK_SIZE 65536
+
+#ifdef RAPTOR_ZLIB
+/* empty BGZF block marking the end of the content */
+static const unsigned char raptor_bgzf_eof[28] = {
+  0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00,
+  0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+#endif
+
+
+/**
+ * raptor_compression_from_name:
+ * @name: compression name or NULL
+ * @compression_p: pointer to store the compression
+ *
+ * INTERNAL - Get a compression by name
+ *
+ * A NULL or empty @name is #RAPTOR_COMPRESSION_NONE.
+ *
+ * Return value: non-0 if @name is not known
+ */
+int
+raptor_compression_from_name(const char* name,
+                             raptor_compression* compression_p)
+{
+  int i;
+
+  if(!name || !*name) {
+    *compression_p = RAPTOR_COMPRESSION_NONE;
+    return 0;
+  }
+
+  for(i = 0; i <= RAPTOR_COMPRESSION_LAST; i++) {
+    if(!strcmp(name, raptor_compression_names[i])) {
+      *compression_p = (raptor_compression)i;
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/**
+ * raptor_compression_is_writable:
+ * @compression: compression
+ *
+ * INTERNAL - Check if a compression can be written by this build
+ *
+ * Return value: non-0 if output can be written with @compression
+ */
+int
+raptor_compression_is_writable(raptor_compression compression)
+{
+  switch(compression) {
+    case RAPTOR_COMPRESSION_NONE:
+      return 1;
+
+    case RAPTOR_COMPRESSION_GZIP:
+    case RAPTOR_COMPRESSION_ZSTD:
+      return raptor_compression_is_available(compression);
+
+    case RAPTOR_COMPRESSION_BZIP2:
+    default:
+      return 0;
+  }
+}
+
+
+typedef struct {
+  raptor_compression compression;
+
+  /* uncompressed content */
+  unsigned char* in;
+  size_t in_length;
+
+  /* compressed block */
+  unsigned char* out;
+  size_t out_size;
+  size_t out_length;
+
+#ifdef RAPTOR_ZLIB
+  z_stream zs;
+  int zs_ready;
+#endif
+#ifdef RAPTOR_ZSTD
+  ZSTD_CCtx* cctx;
+#endif
+} raptor_compress_block;
+
+
+/*
+ * Content is copied into fixed-size blocks that are compressed
+ * independently by a thread pool.  The blocks are split into two
+ * batches: while the blocks of one batch are being compressed, the
+ * writer fills the other.  When that is full, the first batch is
+ * waited for and written out in order before the second is queued.
+ */
+typedef struct {
+  raptor_world* world;
+
+  raptor_compression compression;
+
+  FILE* handle;
+  int close_handle;
+
+  size_t block_size;
+
+  raptor_thread_pool* pool;
+
+  /* 2 * batch_size blocks */
+  raptor_compress_block* blocks;
+  int batch_size;
+
+  /* batch being filled (0 or 1) and the number of its blocks that
+   * are full */
+  int batch;
+  int filled;
+
+  /* number of blocks of the other batch queued but not written */
+  int pending;
+
+  /* number of blocks written */
+  unsigned long written;
+
+  int ended;
+  int failed;
+} raptor_compress_context;
+
+
+static int
+raptor_compress_block_init(raptor_compress_block* block,
+                           raptor_compression compression, size_t block_size)
+{
+  block->compression = compression;
+
+  block->in = RAPTOR_MALLOC(unsigned char*, block_size);
+  if(!block->in)
+    return 1;
+
+#ifdef RAPTOR_ZLIB
+  if(compression == RAPTOR_COMPRESSION_GZIP) {
+    /* raw deflate; the BGZF header and footer are written here */
+    if(deflateInit2(&block->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                    -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      return 1;
+    block->zs_ready = 1;
+    block->out_size = RAPTOR_BGZF_MAX_BLOCK_SIZE;
+  }
+#endif
+#ifdef RAPTOR_ZSTD
+  if(compression == RAPTOR_COMPRESSION_ZSTD) {
+    block->cctx = ZSTD_createCCtx();
+    if(!block->cctx)
+      return 1;
+    block->out_size = ZSTD_compressBound(block_size);
+  }
+#endif
+
+  block->out = RAPTOR_MALLOC(unsigned char*, block->out_size);
+
+  return (block->out == NULL);
+}
+
+
+static void
+raptor_compress_block_finish(raptor_compress_block* block)
+{
+#ifdef RAPTOR_ZLIB
+  if(block->zs_ready)
+    deflateEnd(&block->zs);
+#endif
+#ifdef RAPTOR_ZSTD
+  if(block->cctx)
+    ZSTD_freeCCtx(block->cctx);
+#endif
+  if(block->in)
+    RAPTOR_FREE(char*, block->in);
+  if(block->out)
+    RAPTOR_FREE(char*, block->out);
+}
+
+
+#ifdef RAPTOR_ZLIB
+static void
+raptor_compress_put_le(unsigned char* p, unsigned long value, int bytes)
+{
+  while(bytes--) {
+    *p++ = RAPTOR_GOOD_CAST(unsigned char, value & 0xff);
+    value >>= 8;
+  }
+}
+
+
+/* deflate block->in into the BGZF block body, returning non-0 if
+ * it did not fit */
+static int
+raptor_compress_block_deflate(raptor_compress_block* block, z_stream* zs)
+{
+  zs->next_in = block->in;
+  zs->avail_in = RAPTOR_GOOD_CAST(uInt, block->in_length);
+  zs->next_out = block->out + RAPTOR_BGZF_HEADER_SIZE;
+  zs->avail_out = RAPTOR_GOOD_CAST(uInt, block->out_size -
+                                   RAPTOR_BGZF_HEADER_SIZE -
+                                   RAPTOR_BGZF_FOOTER_SIZE);
+
+  if(deflate(zs, Z_FINISH) != Z_STREAM_END)
+    return 1;
+
+  block->out_length = RAPTOR_BGZF_HEADER_SIZE + zs->total_out;
+  return 0;
+}
+#endif
+
+
+/* thread pool task compressing one block */
+static int
+raptor_compress_block_task(void* data)
+{
+  raptor_compress_block* block = (raptor_compress_block*)data;
+
+#ifdef RAPTOR_ZLIB
+  if(block->compression == RAPTOR_COMPRESSION_GZIP) {
+    unsigned char* p;
+
+    deflateReset(&block->zs);
+    if(raptor_compress_block_deflate(block, &block->zs)) {
+      z_stream zs;
+      int rc;
+
+      /* content that does not compress is stored, which always fits */
+      memset(&zs, 0, sizeof(zs));
+      if(deflateInit2(&zs, 0, Z_DEFLATED, -MAX_WBITS, 8,
+                      Z_DEFAULT_STRATEGY) != Z_OK)
+        return 1;
+      rc = raptor_compress_block_deflate(block, &zs);
+      deflateEnd(&zs);
+      if(rc)
+        return 1;
+    }
+
+    p = block->out;
+    p[0] = 0x1f; p[1] = 0x8b; p[2] = 8; p[3] = 4; /* FEXTRA */
+    raptor_compress_put_le(p + 4, 0, 4); /* MTIME */
+    p[8] = 0; p[9] = 0xff; /* XFL, OS unknown */
+    raptor_compress_put_le(p + 10, 6, 2); /* XLEN */
+    p[12] = 'B'; p[13] = 'C';
+    raptor_compress_put_le(p + 14, 2, 2);
+    raptor_compress_put_le(p + 16, block->out_length +
+                           RAPTOR_BGZF_FOOTER_SIZE - 1, 2);
+
+    p = block->out + block->out_length;
+    raptor_compress_put_le(p, crc32(crc32(0L, Z_NULL, 0), block->in,
+                                    RAPTOR_GOOD_CAST(uInt, block->in_length)),
+                           4);
+    raptor_compress_put_le(p + 4, block->in_length, 4);
+    block->out_length += RAPTOR_BGZF_FOOTER_SIZE;
+
+    return 0;
+  }
+#endif
+
+#ifdef RAPTOR_ZSTD
+  if(block->compression == RAPTOR_COMPRESSION_ZSTD) {
+    size_t size;
+
+    size = ZSTD_compressCCtx(block->cctx, block->out, block->out_size,
+                             block->in, block->in_length,
+                             ZSTD_CLEVEL_DEFAULT);
+    if(ZSTD_isError(size))
+      return 1;
+    block->out_length = size;
+
+    return 0;
+  }
+#endif
+
+  return 1;
+}
+
+
+static void
+raptor_compress_fail(raptor_compress_context* ctx, const char* message)
+{
+  if(!ctx->failed)
+    raptor_log_error_formatted(ctx->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                               "%s %s compressed output", message,
+                               raptor_compression_get_name(ctx->compression));
+  ctx->failed = 1;
+}
+
+
+/* wait for the pending blocks of the other batch and write them */
+static int
+raptor_compress_write_pending(raptor_compress_context* ctx)
+{
+  raptor_compress_block* blocks;
+  int i;
+
+  if(raptor_thread_pool_wait(ctx->pool))
+    raptor_compress_fail(ctx, "Failed to create");
+
+  blocks = &ctx->blocks[(1 - ctx->batch) * ctx->batch_size];
+  for(i = 0; i < ctx->pending && !ctx->failed; i++) {
+    if(fwrite(blocks[i].out, 1, blocks[i].out_length, ctx->handle) !=
+       blocks[i].out_length)
+      raptor_compress_fail(ctx, "Failed to write");
+    ctx->written++;
+  }
+  ctx->pending = 0;
+
+  return ctx->failed;
+}
+
+
+/* queue the first @count blocks of the batch being filled and switch
+ * to filling the other batch */
+static int
+raptor_compress_queue_batch(raptor_compress_context* ctx, int count)
+{
+  raptor_compress_block* blocks;
+  int i;
+
+  if(ctx->pending && raptor_compress_write_pending(ctx))
+    return 1;
+
+  blocks = &ctx->blocks[ctx->batch * ctx->batch_size];
+  for(i = 0; i < count; i++) {
+    if(raptor_thread_pool_add_task(ctx->pool, raptor_compress_block_task,
+                                   &blocks[i])) {
+      /* let any queued blocks finish before failing */
+      raptor_thread_pool_wait(ctx->pool);
+      raptor_compress_fail(ctx, "Failed to create");
+      return 1;
+    }
+  }
+
+  ctx->pending = count;
+  ctx->batch = 1 - ctx->batch;
+  ctx->filled = 0;
+
+  blocks = &ctx->blocks[ctx->batch * ctx->batch_size];
+  for(i = 0; i < ctx->batch_size; i++)
+    blocks[i].in_length = 0;
+
+  return 0;
+}
+
+
+static int
+raptor_compress_iostream_write_bytes(void* user_data, const void* ptr,
+                                     size_t size, size_t nmemb)
+{
+  raptor_compress_context* ctx = (raptor_compress_context*)user_data;
+  const unsigned char* p = (const unsigned char*)ptr;
+  size_t len = size * nmemb;
+
+  if(ctx->failed || ctx->ended)
+    return -1;
+
+  while(len > 0) {
+    raptor_compress_block* block;
+    size_t count;
+
+    block = &ctx->blocks[ctx->batch * ctx->batch_size + ctx->filled];
+    count = ctx->block_size - block->in_length;
+    if(count > len)
+      count = len;
+
+    memcpy(block->in + block->in_length, p, count);
+    block->in_length += count;
+    p += count;
+    len -= count;
+
+    if(block->in_length == ctx->block_size &&
+       ++ctx->filled == ctx->batch_size &&
+       raptor_compress_queue_batch(ctx, ctx->batch_size))
+      return -1;
+  }
+
+  return RAPTOR_BAD_CAST(int, nmemb);
+}
+
+
+static int
+raptor_compress_iostream_write_byte(void* user_data, const int byte)
+{
+  unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+
+  return (raptor_compress_iostream_write_bytes(user_data, &c, 1, 1) != 1);
+}
+
+
+static int
+raptor_compress_iostream_write_end(void* user_data)
+{
+  raptor_compress_context* ctx = (raptor_compress_context*)user_data;
+  int count;
+
+  if(ctx->ended)
+    return ctx->failed;
+  ctx->ended = 1;
+
+  if(ctx->failed)
+    return 1;
+
+  count = ctx->filled;
+  if(ctx->blocks[ctx->batch * ctx->batch_size + count].in_length)
+    count++;
+
+  /* empty content is still written as one (empty) block */
+  if(!count && !ctx->written && !ctx->pending)
+    count = 1;
+
+  if(raptor_compress_queue_batch(ctx, count) ||
+     raptor_compress_write_pending(ctx))
+    return 1;
+
+#ifdef RAPTOR_ZLIB
+  if(ctx->compression == RAPTOR_COMPRESSION_GZIP &&
+     fwrite(raptor_bgzf_eof, 1, sizeof(raptor_bgzf_eof), ctx->handle) !=
+     sizeof(raptor_bgzf_eof))
+    raptor_compress_fail(ctx, "Failed to write");
+#endif
+
+  if(fflush(ctx->handle))
+    raptor_compress_fail(ctx, "Failed to write");
+
+  return ctx->failed;
+}
+
+
+static void
+raptor_compress_iostream_finish(void* user_data)
+{
+  raptor_compress_context* ctx = (raptor_compress_context*)user_data;
+  int i;
+
+  raptor_compress_iostream_write_end(ctx);
+
+  if(ctx->pool)
+    raptor_free_thread_pool(ctx->pool);
+
+  if(ctx->blocks) {
+    for(i = 0; i < 2 * ctx->batch_size; i++)
+      raptor_compress_block_finish(&ctx->blocks[i]);
+    RAPTOR_FREE(raptor_compress_block*, ctx->blocks);
+  }
+
+  if(ctx->close_handle)
+    fclose(ctx->handle);
+
+  RAPTOR_FREE(raptor_compress_context, ctx);
+}
+
+
+static const raptor_iostream_handler raptor_iostream_compress_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_compress_iostream_finish,
+  /* .write_byte  = */ raptor_compress_iostream_write_byte,
+  /* .write_bytes = */ raptor_compress_iostream_write_bytes,
+  /* .write_end   = */ raptor_compress_iostream_write_end,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ NULL
+};
+
+
+/**
+ * raptor_new_iostream_compress_file_handle:
+ * @world: raptor world
+ * @handle: FILE* handle to write to
+ * @close_handle: non-0 to fclose @handle when the iostream is freed
+ * @compression: compression to write
+ * @threads: number of threads to compress with
+ *
+ * INTERNAL - Constructor - create an iostream writing compressed
+ * content to a FILE* handle
+ *
+ * The content is compressed in independent blocks by @threads
+ * worker threads, or in the writing thread if @threads is less
+ * than 2.  gzip content is written as BGZF blocks followed by the
+ * BGZF end of file marker block, which any gzip reader accepts;
+ * zstd content as a sequence of frames.  All content is written
+ * when the iostream is ended or freed.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including when this build cannot write @compression
+ */
+raptor_iostream*
+raptor_new_iostream_compress_file_handle(raptor_world* world, FILE* handle,
+                                         int close_handle,
+                                         raptor_compression compression,
+                                         int threads)
+{
+  raptor_compress_context* ctx;
+  raptor_iostream* iostr;
+  int i;
+
+  if(compression == RAPTOR_COMPRESSION_NONE ||
+     !raptor_compression_is_writable(compression))
+    return NULL;
+
+  ctx = RAPTOR_CALLOC(raptor_compress_context*, 1, sizeof(*ctx));
+  if(!ctx)
+    return NULL;
+
+  ctx->world = world;
+  ctx->compression = compression;
+  ctx->handle = handle;
+  ctx->block_size = (compression == RAPTOR_COMPRESSION_GZIP) ?
+    RAPTOR_COMPRESS_GZIP_BLOCK_SIZE : RAPTOR_COMPRESS_ZSTD_BLOCK_SIZE;
+
+  ctx->pool = raptor_new_thread_pool(world, threads);
+  if(!ctx->pool)
+    goto failed;
+
+  ctx->batch_size = raptor_thread_pool_get_threads_count(ctx->pool);
+  if(ctx->batch_size < 1)
+    ctx->batch_size = 1;
+
+  ctx->blocks = RAPTOR_CALLOC(raptor_compress_block*,
+                              RAPTOR_GOOD_CAST(size_t, 2 * ctx->batch_size),
+                              sizeof(raptor_compress_block));
+  if(!ctx->blocks)
+    goto failed;
+
+  for(i = 0; i < 2 * ctx->batch_size; i++) {
+    if(raptor_compress_block_init(&ctx->blocks[i], compression,
+                                  ctx->block_size))
+      goto failed;
+  }
+
+  iostr = raptor_new_iostream_from_handler(world, ctx,
+                                           &raptor_iostream_compress_handler);
+  if(!iostr)
+    goto failed;
+
+  /* now owned by the iostream */
+  ctx->close_handle = close_handle;
+
+  return iostr;
+
+  failed:
+  /* nothing was written */
+  ctx->ended = 1;
+  raptor_compress_iostream_finish(ctx);
+  return NULL;
+}
+
+
+/**
+ * raptor_new_iostream_to_compressed_filename:
+ * @world: raptor world
+ * @filename: Output filename to open and write to
+ * @compression: compression name "gzip", "zstd" or "none", or NULL for none
+ * @threads: number of worker threads to compress with; 0 or 1 for none
+ *
+ * Constructor - create a new iostream writing compressed content to
+ * a filename.
+ *
+ * The content is compressed in independent blocks that are spread
+ * over @threads worker threads, so that compressing can keep up with
+ * the writer.  gzip content is written in the BGZF block format used
+ * by bgzip, which any gzip reader can read.  zstd content is written
+ * as a sequence of frames.  With no compression this is the same as
+ * raptor_new_iostream_to_filename().
+ *
+ * The content is only complete once the iostream has been freed.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including a @compression that is not known or cannot be written
+ * by this build
+ **/
+raptor_iostream*
+raptor_new_iostream_to_compressed_filename(raptor_world* world,
+                                           const char* filename,
+                                           const char* compression,
+                                           int threads)
+{
+  raptor_compression c;
+  FILE* handle;
+  raptor_iostream* iostr;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!filename)
+    return NULL;
+
+  if(raptor_compression_from_name(compression, &c))
+    return NULL;
+
+  if(c == RAPTOR_COMPRESSION_NONE)
+    return raptor_new_iostream_to_filename(world, filename);
+
+  if(!raptor_compression_is_writable(c))
+    return NULL;
+
+  raptor_world_open(world);
+
+  handle = fopen(filename, "wb");
+  if(!handle)
+    return NULL;
+
+  iostr = raptor_new_iostream_compress_file_handle(world, handle, 1,
+                                                   c, threads);
+  if(!iostr)
+    fclose(handle);
+
+  return iostr;
+}
+
+
+/**
+ * raptor_new_iostream_to_compressed_file_handle:
+ * @world: raptor world
+ * @handle: FILE* handle to write to
+ * @compression: compression name "gzip", "zstd" or "none", or NULL for none
+ * @threads: number of worker threads to compress with; 0 or 1 for none
+ *
+ * Constructor - create a new iostream writing compressed content to
+ * a FILE*.
+ *
+ * As raptor_new_iostream_to_compressed_filename() for an already
+ * open @handle, such as stdout.
+ * NOTE: This does not fclose the @handle when it is finished.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure,
+ * including a @compression that is not known or cannot be written
+ * by this build
+ **/
+raptor_iostream*
+raptor_new_iostream_to_compressed_file_handle(raptor_world* world,
+                                              FILE* handle,
+                                              const char* compression,
+                                              int threads)
+{
+  raptor_compression c;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!handle)
+    return NULL;
+
+  if(raptor_compression_from_name(compression, &c))
+    return NULL;
+
+  if(c == RAPTOR_COMPRESSION_NONE)
+    return raptor_new_iostream_to_file_handle(world, handle);
+
+  raptor_world_open(world);
+
+  return raptor_new_iostream_compress_file_handle(world, handle, 0,
+                                                  c, threads);
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_TEXT "<http://example.org/s> <http://example.org/p> \"o\" .\n"
+
+/* TEST_TEXT compressed by gzip -n, bzip2 and zstd */
+static const unsigned char test_gzip[55] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb3, 0xc9,
+  0x28, 0x29, 0x29, 0xb0, 0xd2, 0xd7, 0x4f, 0xad, 0x48, 0xcc, 0x2d, 0xc8,
+  0x49, 0xd5, 0xcb, 0x2f, 0x4a, 0xd7, 0x2f, 0xb6, 0x53, 0xb0, 0xc1, 0x22,
+  0x5c, 0x60, 0xa7, 0xa0, 0x94, 0xaf, 0xa4, 0xa0, 0xc7, 0x05, 0x00, 0xd9,
+  0xf8, 0xc8, 0x07, 0x34, 0x00, 0x00, 0x00
+};
+
+static const unsigned char test_bzip2[81] = {
+  0x42, 0x5a, 0x68, 0x39, 0x31, 0x41, 0x59, 0x26, 0x53, 0x59, 0x3f, 0x8f,
+  0x86, 0xf4, 0x00, 0x00, 0x09, 0x59, 0x80, 0x00, 0x10, 0x50, 0x01, 0x80,
+  0x15, 0x22, 0xc6, 0xdc, 0x40, 0x20, 0x00, 0x40, 0x95, 0x27, 0x94, 0xf4,
+  0xd2, 0x68, 0x3c, 0x8d, 0x42, 0x98, 0x4d, 0x34, 0x06, 0x98, 0x8a, 0xfc,
+  0xf1, 0xf3, 0x19, 0x30, 0x60, 0xec, 0x81, 0xb2, 0x9a, 0xa2, 0x47, 0x36,
+  0x41, 0x72, 0x48, 0x92, 0x87, 0xa3, 0x42, 0x29, 0x46, 0xcf, 0xc5, 0xdc,
+  0x91, 0x4e, 0x14, 0x24, 0x0f, 0xe3, 0xe1, 0xbd, 0x00
+};
+
+static const unsigned char test_zstd[48] = {
+  0x28, 0xb5, 0x2f, 0xfd, 0x20, 0x34, 0x3d, 0x01, 0x00, 0x04, 0x02, 0x3c,
+  0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x65, 0x78, 0x61, 0x6d, 0x70,
+  0x6c, 0x65, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x73, 0x3e, 0x20, 0x70, 0x3e,
+  0x20, 0x22, 0x6f, 0x22, 0x20, 0x2e, 0x0a, 0x01, 0x00, 0x95, 0x9e, 0x4d
+};
+
+
+static void
+test_statement_handler(void* user_data, raptor_statement* statement)
+{
+  (*(int*)user_data)++;
+}
+
+
+/* Write @data twice to a temporary file, as concatenated members,
+ * optionally leaving off the last @truncate bytes */
+static FILE*
+test_file(const unsigned char* data, size_t len, size_t truncate)
+{
+  FILE* fh = tmpfile();
+
+  if(!fh)
+    return NULL;
+
+  fwrite(data, 1, len, fh);
+  fwrite(data, 1, len - truncate, fh);
+  rewind(fh);
+
+  return fh;
+}
+
+
+static int
+test_decompress(const char* program, raptor_world* world,
+                raptor_compression compression,
+                const unsigned char* data, size_t len)
+{
+  const char* name = raptor_compression_get_name(compression);
+  const size_t text_len = strlen(TEST_TEXT);
+  raptor_iostream* iostr;
+  raptor_parser* parser;
+  raptor_uri* base_uri;
+  unsigned char buffer[256];
+  size_t got = 0;
+  int count = 0;
+  int n;
+  FILE* fh;
+  int rc = 0;
+
+  if(raptor_compression_detect(data, len) != compression) {
+    fprintf(stderr, "%s: %s content was not detected\n", program, name);
+    return 1;
+  }
+
+  if(!raptor_compression_is_available(compression))
+    return 0;
+
+  /* read in small pieces */
+  fh = test_file(data, len, 0);
+  iostr = raptor_new_iostream_from_compressed_file_handle(world, fh);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to create %s iostream\n", program, name);
+    fclose(fh);
+    return 1;
+  }
+  while((n = raptor_iostream_read_bytes(buffer + got, 1, 7, iostr)) > 0) {
+    got += RAPTOR_GOOD_CAST(size_t, n);
+    if(got > sizeof(buffer) - 7)
+      break;
+  }
+  if(n < 0 || got != 2 * text_len || !raptor_iostream_read_eof(iostr) ||
+     memcmp(buffer, TEST_TEXT, text_len) ||
+     memcmp(buffer + text_len, TEST_TEXT, text_len)) {
+    fprintf(stderr, "%s: %s content read back wrongly\n", program, name);
+    rc = 1;
+  }
+  raptor_free_iostream(iostr);
+  fclose(fh);
+
+  /* truncated content is an error */
+  fh = test_file(data, len, 5);
+  iostr = raptor_new_iostream_from_compressed_file_handle(world, fh);
+  if(iostr) {
+    while((n = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr)) > 0)
+      ;
+    if(n >= 0) {
+      fprintf(stderr, "%s: truncated %s content was not an error\n",
+              program, name);
+      rc = 1;
+    }
+    raptor_free_iostream(iostr);
+  }
+  fclose(fh);
+
+  /* parse a compressed file */
+  fh = test_file(data, len, 0);
+  parser = raptor_new_parser(world, "ntriples");
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  raptor_parser_set_statement_handler(parser, &count, test_statement_handler);
+  if(raptor_parser_parse_file_stream(parser, fh, NULL, base_uri) ||
+     count != 2) {
+    fprintf(stderr, "%s: parsing %s content returned %d statements\n",
+            program, name, count);
+    rc = 1;
+  }
+  raptor_free_uri(base_uri);
+  raptor_free_parser(parser);
+  fclose(fh);
+
+  return rc;
+}
+
+
+#define TEST_COMPRESS_LINES 40000
+#define TEST_COMPRESS_RANDOM_SIZE (200 * 1024)
+
+/* Write many lines and some content that does not compress, read it
+ * back and check that it is unchanged */
+static int
+test_compress(const char* program, raptor_world* world,
+              raptor_compression compression, int threads)
+{
+  const char* name = raptor_compression_get_name(compression);
+  unsigned char* content;
+  unsigned char* buffer;
+  size_t len = 0;
+  size_t offset;
+  size_t got = 0;
+  unsigned long seed = 42;
+  raptor_iostream* iostr;
+  FILE* fh;
+  int i;
+  int n;
+  int rc = 0;
+
+  content = RAPTOR_MALLOC(unsigned char*, TEST_COMPRESS_LINES * 64 +
+                          TEST_COMPRESS_RANDOM_SIZE);
+  buffer = RAPTOR_MALLOC(unsigned char*, TEST_COMPRESS_LINES * 64 +
+                         TEST_COMPRESS_RANDOM_SIZE + 1);
+  if(!content || !buffer) {
+    fprintf(stderr, "%s: Out of memory\n", program);
+    exit(1);
+  }
+
+  for(i = 0; i < TEST_COMPRESS_LINES; i++)
+    len += RAPTOR_GOOD_CAST(size_t,
+                            sprintf((char*)content + len,
+                                    "<http://example.org/s%d> <http://example.org/p> \"%d\" .\n",
+                                    i, i % 97));
+  for(i = 0; i < TEST_COMPRESS_RANDOM_SIZE; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    content[len++] = RAPTOR_GOOD_CAST(unsigned char, (seed >> 16) & 0xff);
+  }
+
+  fh = tmpfile();
+  if(!fh) {
+    fprintf(stderr, "%s: Failed to create a temporary file\n", program);
+    exit(1);
+  }
+
+  iostr = raptor_new_iostream_to_compressed_file_handle(world, fh, name,
+                                                        threads);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to create %s output iostream\n", program,
+            name);
+    rc = 1;
+    goto tidy;
+  }
+
+  /* write in uneven pieces, some a byte at a time */
+  for(offset = 0; offset < len; ) {
+    size_t count = 1 + (offset % 5003);
+
+    if(count > len - offset)
+      count = len - offset;
+    if(count < 3) {
+      if(raptor_iostream_write_byte(content[offset], iostr))
+        rc = 1;
+      count = 1;
+    } else if(raptor_iostream_write_bytes(content + offset, 1, count,
+                                          iostr) != RAPTOR_BAD_CAST(int, count))
+      rc = 1;
+    offset += count;
+  }
+  raptor_free_iostream(iostr);
+  if(rc) {
+    fprintf(stderr, "%s: Failed to write %s content\n", program, name);
+    goto tidy;
+  }
+
+#ifdef RAPTOR_ZLIB
+  if(compression == RAPTOR_COMPRESSION_GZIP) {
+    unsigned char header[18];
+    long size;
+    long block_offset = 0;
+    long block_size = 0;
+    int blocks = 0;
+
+    /* follow the BGZF block sizes to the end of file marker */
+    fseek(fh, 0L, SEEK_END);
+    size = ftell(fh);
+    while(block_offset < size) {
+      fseek(fh, block_offset, SEEK_SET);
+      if(fread(header, 1, sizeof(header), fh) != sizeof(header) ||
+         header[0] != 0x1f || header[1] != 0x8b || header[3] != 4 ||
+         header[12] != 'B' || header[13] != 'C')
+        break;
+      block_size = 1 + (header[16] | (header[17] << 8));
+      block_offset += block_size;
+      blocks++;
+    }
+    /* the last block is the 28 byte end of file marker */
+    if(block_offset != size || blocks < 3 || block_size != 28) {
+      fprintf(stderr, "%s: gzip content is not in BGZF blocks\n", program);
+      rc = 1;
+    }
+  }
+#endif
+
+  rewind(fh);
+  iostr = raptor_new_iostream_from_compressed_file_handle(world, fh);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to read %s content\n", program, name);
+    rc = 1;
+    goto tidy;
+  }
+  while((n = raptor_iostream_read_bytes(buffer + got, 1, 65536, iostr)) > 0) {
+    got += RAPTOR_GOOD_CAST(size_t, n);
+    if(got > len)
+      break;
+  }
+  raptor_free_iostream(iostr);
+  if(n < 0 || got != len || memcmp(buffer, content, len)) {
+    fprintf(stderr,
+            "%s: %s content written with %d threads read back wrongly\n",
+            program, name, threads);
+    rc = 1;
+  }
+
+  tidy:
+  fclose(fh);
+  RAPTOR_FREE(char*, buffer);
+  RAPTOR_FREE(char*, content);
+
+  return rc;
+}
+
+
+/* Serialize a statement with the compression option set */
+static int
+test_serialize_compressed(const char* program, raptor_world* world,
+                          raptor_compression compression)
+{
+  const char* name = raptor_compression_get_name(compression);
+  const size_t text_len = strlen(TEST_TEXT);
+  raptor_serializer* serializer;
+  raptor_statement* statement;
+  raptor_iostream* iostr;
+  unsigned char buffer[256];
+  int n = 0;
+  FILE* fh;
+  int rc = 0;
+
+  fh = tmpfile();
+  serializer = raptor_new_serializer(world, "ntriples");
+  if(!fh || !serializer) {
+    fprintf(stderr, "%s: Failed to create serializer\n", program);
+    exit(1);
+  }
+
+  raptor_serializer_set_option(serializer, RAPTOR_OPTION_COMPRESSION,
+                               name, 0);
+  if(raptor_serializer_start_to_file_handle(serializer, NULL, fh)) {
+    fprintf(stderr, "%s: Failed to start %s serializing\n", program, name);
+    rc = 1;
+  } else {
+    statement = raptor_new_statement_from_nodes(world,
+      raptor_new_term_from_uri_string(world,
+                                      (const unsigned char*)"http://example.org/s"),
+      raptor_new_term_from_uri_string(world,
+                                      (const unsigned char*)"http://example.org/p"),
+      raptor_new_term_from_literal(world, (const unsigned char*)"o",
+                                   NULL, NULL),
+      NULL);
+    raptor_serializer_serialize_statement(serializer, statement);
+    raptor_free_statement(statement);
+    raptor_serializer_serialize_end(serializer);
+
+    rewind(fh);
+    if(fread(buffer, 1, RAPTOR_COMPRESSION_MAGIC_SIZE, fh) !=
+       RAPTOR_COMPRESSION_MAGIC_SIZE ||
+       raptor_compression_detect(buffer, RAPTOR_COMPRESSION_MAGIC_SIZE) !=
+       compression) {
+      fprintf(stderr, "%s: serialized content is not %s compressed\n",
+              program, name);
+      rc = 1;
+    }
+
+    rewind(fh);
+    iostr = raptor_new_iostream_from_compressed_file_handle(world, fh);
+    if(iostr) {
+      n = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr);
+      raptor_free_iostream(iostr);
+    }
+    if(n != RAPTOR_BAD_CAST(int, text_len) ||
+       memcmp(buffer, TEST_TEXT, text_len)) {
+      fprintf(stderr, "%s: %s serialized content read back wrongly\n",
+              program, name);
+      rc = 1;
+    }
+  }
+
+  raptor_free_serializer(serializer);
+  fclose(fh);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  raptor_iostream* iostr;
+  unsigned char buffer[256];
+  int i;
+  int n;
+  FILE* fh;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  rc |= test_decompress(program, world, RAPTOR_COMPRESSION_GZIP,
+                        test_gzip, sizeof(test_gzip));
+  rc |= test_decompress(program, world, RAPTOR_COMPRESSION_BZIP2,
+                        test_bzip2, sizeof(test_bzip2));
+  rc |= test_decompress(program, world, RAPTOR_COMPRESSION_ZSTD,
+                        test_zstd, sizeof(test_zstd));
+
+  for(i = RAPTOR_COMPRESSION_GZIP; i <= RAPTOR_COMPRESSION_LAST; i++) {
+    raptor_compression compression = (raptor_compression)i;
+    const char* name = raptor_compression_get_name(compression);
+
+    if(!raptor_compression_is_writable(compression)) {
+      iostr = raptor_new_iostream_to_compressed_file_handle(world, stdout,
+                                                            name, 0);
+      if(iostr) {
+        fprintf(stderr, "%s: Created an iostream writing unsupported %s\n",
+                program, name);
+        raptor_free_iostream(iostr);
+        rc = 1;
+      }
+      continue;
+    }
+
+    rc |= test_compress(program, world, compression, 0);
+    rc |= test_compress(program, world, compression, 3);
+    rc |= test_serialize_compressed(program, world, compression);
+  }
+
+  if(raptor_new_iostream_to_compressed_file_handle(world, stdout, "lzma", 0)) {
+    fprintf(stderr, "%s: Created an iostream writing unknown compression\n",
+            program);
+    rc = 1;
+  }
+
+  /* uncompressed content is read unchanged, even if short */
+  fh = tmpfile();
+  fputs("BZ", fh);
+  rewind(fh);
+  iostr = raptor_new_iostream_from_compressed_file_handle(world, fh);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to create iostream\n", program);
+    rc = 1;
+  } else {
+    n = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr);
+    if(n != 2 || memcmp(buffer, "BZ", 2) || !raptor_iostream_read_eof(iostr)) {
+      fprintf(stderr, "%s: Uncompressed content read back wrongly\n",
+              program);
+      rc = 1;
+    }
+    raptor_free_iostream(iostr);
+  }
+  fclose(fh);
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
@@ -154,6 +154,58 @@ raptor_string_escaped_write(const unsigned char *string,
 }
 
 
+/**
+ * raptor_string_needs_escapes:
+ * @string: UTF-8 string
+ * @len: length of UTF-8 string
+ * @delim: Terminating delimiter character for string or \0
+ * @flags: bit flags - see #raptor_escaped_write_bitflags
+ *
+ * INTERNAL - Check if raptor_string_escaped_write() may change a string
+ *
+ * If this returns 0, writing the @len bytes of @string unchanged
+ * gives the same output as raptor_string_escaped_write() with the
+ * same arguments.  The check is conservative and may return non-0
+ * for some strings that would be written unchanged, such as non-ASCII
+ * strings allowed by #RAPTOR_ESCAPED_WRITE_BITFLAG_UTF8.
+ *
+ * Return value: non-0 if the string may need escaping
+ **/
+int
+raptor_string_needs_escapes(const unsigned char *string, size_t len,
+                            const char delim, unsigned int flags)
+{
+  int control_escapes;
+  size_t i;
+
+  if(!string || string[len])
+    return 1;
+
+  control_escapes = (flags & (RAPTOR_ESCAPED_WRITE_BITFLAG_SPARQL_URI_ESCAPES |
+                              RAPTOR_ESCAPED_WRITE_BITFLAG_BS_ESCAPES_TNRU |
+                              RAPTOR_ESCAPED_WRITE_BITFLAG_BS_ESCAPES_BF)) != 0;
+
+  for(i = 0; i < len; i++) {
+    unsigned char c = string[i];
+
+    if(!c || c >= 0x7f || c == '\\' || (delim && c == delim))
+      return 1;
+
+    if(c < 0x20 && control_escapes)
+      return 1;
+
+    if(flags & RAPTOR_ESCAPED_WRITE_BITFLAG_SPARQL_URI_ESCAPES) {
+      if(c == 0x20 ||
+         c == '<' || c == '>' || c == '"' ||
+         c == '{' || c == '}' || c == '|' || c == '^' || c == '`')
+        return 1;
+    }
+  }
+
+  return 0;
+}
+
+
 /**
  * raptor_string_python_write:
  * @string: UTF-8 string to write
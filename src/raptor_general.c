@@ -179,10 +179,18 @@ raptor_world_open(raptor_world* world)
 
   world->opened = 1;
 
+  rc = raptor_threads_init(world);
+  if(rc)
+    return rc;
+
   rc = raptor_uri_init(world);
   if(rc)
     return rc;
 
+  rc = raptor_terms_init(world);
+  if(rc)
+    return rc;
+
   rc = raptor_concepts_init(world);
   if(rc)
     return rc;
@@ -244,8 +252,12 @@ raptor_free_world(raptor_world* world)
 
   raptor_concepts_finish(world);
 
+  raptor_terms_finish(world);
+
   raptor_uri_finish(world);
 
+  raptor_threads_finish(world);
+
   RAPTOR_FREE(raptor_world, world);
 }
 
@@ -293,7 +305,9 @@ raptor_world_default_generate_bnodeid_handler(void *user_data,
   if(user_bnodeid)
     return user_bnodeid;
 
+  RAPTOR_WORLD_LOCK(world);
   id = ++world->default_generate_bnodeid_handler_base;
+  RAPTOR_WORLD_UNLOCK(world);
 
   id_length = raptor_format_integer(NULL, 0, id, /* base */ 10, -1, '\0');
 
@@ -473,6 +487,14 @@ raptor_world_set_flag(raptor_world *world, raptor_world_flag flag, int value)
       world->uri_interning = value;
       break;
 
+    case RAPTOR_WORLD_FLAG_TERM_INTERNING:
+      world->term_interning = value;
+      break;
+
+    case RAPTOR_WORLD_FLAG_URI_ORDINALS:
+      world->uri_ordinals = value;
+      break;
+
     case RAPTOR_WORLD_FLAG_WWW_SKIP_INIT_FINISH:
       world->www_skip_www_init_finish = value;
       break;
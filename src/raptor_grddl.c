@@ -637,18 +637,22 @@ raptor_grddl_ensure_internal_parser(raptor_parser* rdf_parser,
     /* Disable graph marks in newly constructed internal parser */
     grddl_parser->internal_parser->emit_graph_marks = 0;
     
-    grddl_parser->saved_user_data = rdf_parser->user_data;
-    grddl_parser->saved_statement_handler = rdf_parser->statement_handler;
+    /* the user's handler, not any duplicate filter wrapping it; the
+     * internal parser filters duplicates itself */
+    grddl_parser->saved_user_data = RAPTOR_PARSER_USER_DATA(rdf_parser);
+    grddl_parser->saved_statement_handler = rdf_parser->dedup ?
+      rdf_parser->dedup_statement_handler : rdf_parser->statement_handler;
   }
 
   /* Filter the triples for profile/namespace URIs */
-  if(filter) {
-    grddl_parser->internal_parser->user_data = rdf_parser;
-    grddl_parser->internal_parser->statement_handler = raptor_grddl_filter_triples;
-  } else {
-    grddl_parser->internal_parser->user_data = grddl_parser->saved_user_data;
-    grddl_parser->internal_parser->statement_handler = grddl_parser->saved_statement_handler;
-  }
+  if(filter)
+    raptor_parser_set_statement_handler(grddl_parser->internal_parser,
+                                        rdf_parser,
+                                        raptor_grddl_filter_triples);
+  else
+    raptor_parser_set_statement_handler(grddl_parser->internal_parser,
+                                        grddl_parser->saved_user_data,
+                                        grddl_parser->saved_statement_handler);
 
   return 0;
 }
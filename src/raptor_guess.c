@@ -111,10 +111,19 @@ raptor_guess_parse_content_type_handler(raptor_parser* rdf_parser,
 }
 
 
+/*
+ * raptor_guess_parse_guess:
+ * @rdf_parser: guess parser
+ * @buffer: first chunk of content
+ * @len: length of @buffer
+ *
+ * INTERNAL - Pick and start the internal parser on the first chunk
+ *
+ * Return value: non-0 on failure
+ */
 static int
-raptor_guess_parse_chunk(raptor_parser* rdf_parser, 
-                        const unsigned char *buffer, size_t len,
-                        int is_end)
+raptor_guess_parse_guess(raptor_parser* rdf_parser,
+                         const unsigned char *buffer, size_t len)
 {
   raptor_guess_parser_context* guess_parser = (raptor_guess_parser_context*)rdf_parser->context;
 
@@ -175,11 +184,40 @@ raptor_guess_parse_chunk(raptor_parser* rdf_parser,
   }
   
 
+  return 0;
+}
+
+
+static int
+raptor_guess_parse_chunk(raptor_parser* rdf_parser, 
+                        const unsigned char *buffer, size_t len,
+                        int is_end)
+{
+  raptor_guess_parser_context* guess_parser = (raptor_guess_parser_context*)rdf_parser->context;
+
+  if(raptor_guess_parse_guess(rdf_parser, buffer, len))
+    return 1;
+
   /* now we can pass on calls to internal guess_parser */
   return raptor_parser_parse_chunk(guess_parser->parser, buffer, len, is_end);
 }
 
 
+static int
+raptor_guess_parse_chunk_borrowed(raptor_parser* rdf_parser,
+                                  const unsigned char *buffer, size_t len,
+                                  int is_end)
+{
+  raptor_guess_parser_context* guess_parser = (raptor_guess_parser_context*)rdf_parser->context;
+
+  if(raptor_guess_parse_guess(rdf_parser, buffer, len))
+    return 1;
+
+  return raptor_parser_parse_chunk_borrowed(guess_parser->parser,
+                                            buffer, len, is_end, NULL, NULL);
+}
+
+
 static const char*
 raptor_guess_accept_header(raptor_parser* rdf_parser)
 {
@@ -245,6 +283,7 @@ raptor_guess_parser_register_factory(raptor_parser_factory *factory)
   factory->init      = raptor_guess_parse_init;
   factory->terminate = raptor_guess_parse_terminate;
   factory->chunk     = raptor_guess_parse_chunk;
+  factory->chunk_borrowed = raptor_guess_parse_chunk_borrowed;
   factory->content_type_handler = raptor_guess_parse_content_type_handler;
   factory->accept_header = raptor_guess_accept_header;
   factory->get_name = raptor_guess_guess_get_name;
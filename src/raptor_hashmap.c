@@ -0,0 +1,602 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_hashmap.c - Raptor open addressing hash map
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * A hash map is an unordered map from keys to values using user
+ * hash and equality handlers on the keys.
+ *
+ * The entries are kept in one array of 2^n slots with linear probing
+ * and Robin Hood insertion: an entry further from its home slot takes
+ * the place of one nearer to its own, so probe lengths stay short and
+ * a lookup can stop as soon as it passes entries closer to home than
+ * the key it is looking for.  Removal shifts the following entries
+ * back instead of leaving tombstones.
+ */
+
+
+/* smallest table allocated */
+#define RAPTOR_HASHMAP_MIN_SIZE 8
+
+
+typedef struct {
+  raptor_hash hash;
+  /* NULL if the slot is empty */
+  void* key;
+  void* value;
+} raptor_hashmap_entry;
+
+
+struct raptor_hashmap_s {
+  raptor_hashmap_hash_handler hash_handler;
+  raptor_hashmap_equals_handler equals_handler;
+
+  /* key and value free functions (optional) */
+  raptor_data_free_handler key_free_handler;
+  raptor_data_free_handler value_free_handler;
+
+  /* table of 2^n entries, allocated on first add */
+  raptor_hashmap_entry* table;
+  size_t table_size;
+
+  /* number of entries */
+  size_t count;
+
+  /* expected number of entries */
+  size_t initial_size;
+};
+
+
+/* distance of the entry in slot @i from its home slot */
+#define RAPTOR_HASHMAP_DISTANCE(map, entry, i) \
+  (((i) - RAPTOR_GOOD_CAST(size_t, (entry)->hash)) & ((map)->table_size - 1))
+
+
+/**
+ * raptor_new_hashmap:
+ * @hash_handler: key hash function
+ * @equals_handler: key equality function
+ * @key_free_handler: key free function (or NULL)
+ * @value_free_handler: value free function (or NULL)
+ * @initial_size: expected number of entries (or 0)
+ *
+ * INTERNAL - Constructor - create a new hash map
+ *
+ * Keys must not be NULL.  Values may be NULL, which makes the map a set.
+ *
+ * Return value: new hash map or NULL on failure
+ */
+raptor_hashmap*
+raptor_new_hashmap(raptor_hashmap_hash_handler hash_handler,
+                   raptor_hashmap_equals_handler equals_handler,
+                   raptor_data_free_handler key_free_handler,
+                   raptor_data_free_handler value_free_handler,
+                   int initial_size)
+{
+  raptor_hashmap* map;
+
+  map = RAPTOR_CALLOC(raptor_hashmap*, 1, sizeof(*map));
+  if(!map)
+    return NULL;
+
+  map->hash_handler = hash_handler;
+  map->equals_handler = equals_handler;
+  map->key_free_handler = key_free_handler;
+  map->value_free_handler = value_free_handler;
+  if(initial_size > 0)
+    map->initial_size = RAPTOR_GOOD_CAST(size_t, initial_size);
+
+  return map;
+}
+
+
+static void
+raptor_hashmap_free_entry(raptor_hashmap* map, raptor_hashmap_entry* entry)
+{
+  if(map->key_free_handler)
+    map->key_free_handler(entry->key);
+  if(map->value_free_handler && entry->value)
+    map->value_free_handler(entry->value);
+  entry->key = NULL;
+  entry->value = NULL;
+}
+
+
+/**
+ * raptor_free_hashmap:
+ * @map: hash map
+ *
+ * INTERNAL - Destructor - destroy a hash map and free all the entries
+ */
+void
+raptor_free_hashmap(raptor_hashmap* map)
+{
+  size_t i;
+
+  if(!map)
+    return;
+
+  if(map->table) {
+    for(i = 0; i < map->table_size; i++) {
+      if(map->table[i].key)
+        raptor_hashmap_free_entry(map, &map->table[i]);
+    }
+    RAPTOR_FREE(raptor_hashmap_entry*, map->table);
+  }
+
+  RAPTOR_FREE(raptor_hashmap, map);
+}
+
+
+/* Find the slot holding @key or NULL if it is not present */
+static raptor_hashmap_entry*
+raptor_hashmap_find(raptor_hashmap* map, const void* key, raptor_hash hash)
+{
+  size_t mask;
+  size_t i;
+  size_t distance;
+
+  if(!map->count)
+    return NULL;
+
+  mask = map->table_size - 1;
+  i = RAPTOR_GOOD_CAST(size_t, hash) & mask;
+  for(distance = 0; ; distance++, i = (i + 1) & mask) {
+    raptor_hashmap_entry* entry = &map->table[i];
+
+    /* an empty slot or an entry nearer its home ends the search */
+    if(!entry->key || RAPTOR_HASHMAP_DISTANCE(map, entry, i) < distance)
+      return NULL;
+
+    if(entry->hash == hash && map->equals_handler(entry->key, key))
+      return entry;
+  }
+}
+
+
+/* Insert an entry known not to be present into a table with space */
+static void
+raptor_hashmap_insert(raptor_hashmap* map, raptor_hashmap_entry* new_entry)
+{
+  raptor_hashmap_entry carry = *new_entry;
+  size_t mask = map->table_size - 1;
+  size_t i = RAPTOR_GOOD_CAST(size_t, carry.hash) & mask;
+  size_t distance;
+
+  for(distance = 0; ; distance++, i = (i + 1) & mask) {
+    raptor_hashmap_entry* entry = &map->table[i];
+    size_t entry_distance;
+
+    if(!entry->key) {
+      *entry = carry;
+      break;
+    }
+
+    /* take the slot from an entry nearer its home and carry that on */
+    entry_distance = RAPTOR_HASHMAP_DISTANCE(map, entry, i);
+    if(entry_distance < distance) {
+      raptor_hashmap_entry tmp = *entry;
+      *entry = carry;
+      carry = tmp;
+      distance = entry_distance;
+    }
+  }
+
+  map->count++;
+}
+
+
+/* Make room for one more entry, growing to keep the table at most 3/4
+ * full.  If the table cannot grow, a table with a free slot is still
+ * used so adding only fails when it is completely full. */
+static int
+raptor_hashmap_ensure(raptor_hashmap* map)
+{
+  raptor_hashmap_entry* old_table = map->table;
+  size_t old_size = map->table_size;
+  size_t size;
+  size_t i;
+
+  if(map->table && (map->count + 1) * 4 <= map->table_size * 3)
+    return 0;
+
+  size = old_size ? old_size * 2 : RAPTOR_HASHMAP_MIN_SIZE;
+  while(size * 3 < map->initial_size * 4)
+    size <<= 1;
+
+  map->table = RAPTOR_CALLOC(raptor_hashmap_entry*, size,
+                             sizeof(raptor_hashmap_entry));
+  if(!map->table) {
+    map->table = old_table;
+    return (map->count < old_size) ? 0 : -1;
+  }
+  map->table_size = size;
+  map->count = 0;
+
+  for(i = 0; i < old_size; i++) {
+    if(old_table[i].key)
+      raptor_hashmap_insert(map, &old_table[i]);
+  }
+
+  if(old_table)
+    RAPTOR_FREE(raptor_hashmap_entry*, old_table);
+
+  return 0;
+}
+
+
+/**
+ * raptor_hashmap_add:
+ * @map: hash map
+ * @key: key
+ * @value: value (or NULL)
+ *
+ * INTERNAL - Add a key and value to a hash map if the key is not present
+ *
+ * On success the map owns @key and @value.  Otherwise they are still
+ * owned by the caller.
+ *
+ * Return value: 0 if added, >0 if an equal key is present, <0 on failure
+ */
+int
+raptor_hashmap_add(raptor_hashmap* map, void* key, void* value)
+{
+  raptor_hashmap_entry entry;
+
+  entry.hash = map->hash_handler(key);
+  if(raptor_hashmap_find(map, key, entry.hash))
+    return 1;
+
+  if(raptor_hashmap_ensure(map))
+    return -1;
+
+  entry.key = key;
+  entry.value = value;
+  raptor_hashmap_insert(map, &entry);
+
+  return 0;
+}
+
+
+/**
+ * raptor_hashmap_put:
+ * @map: hash map
+ * @key: key
+ * @value: value (or NULL)
+ *
+ * INTERNAL - Add a key and value to a hash map, replacing any equal key
+ *
+ * A replaced key and value are freed with the map free handlers
+ * unless they are the same pointers as @key and @value.  On success
+ * the map owns @key and @value.  On failure they are still owned by
+ * the caller.
+ *
+ * Return value: 0 if added, >0 if an equal key was replaced, <0 on failure
+ */
+int
+raptor_hashmap_put(raptor_hashmap* map, void* key, void* value)
+{
+  raptor_hashmap_entry* entry;
+  raptor_hash hash;
+
+  hash = map->hash_handler(key);
+  entry = raptor_hashmap_find(map, key, hash);
+  if(!entry)
+    return raptor_hashmap_add(map, key, value);
+
+  if(map->key_free_handler && entry->key != key)
+    map->key_free_handler(entry->key);
+  if(map->value_free_handler && entry->value && entry->value != value)
+    map->value_free_handler(entry->value);
+  entry->key = key;
+  entry->value = value;
+
+  return 1;
+}
+
+
+/**
+ * raptor_hashmap_get:
+ * @map: hash map
+ * @key: key to find
+ *
+ * INTERNAL - Get the value for a key
+ *
+ * Use raptor_hashmap_get_key() to tell a missing key from a NULL value.
+ *
+ * Return value: value (still owned by the map) or NULL if the key is not present
+ */
+void*
+raptor_hashmap_get(raptor_hashmap* map, const void* key)
+{
+  raptor_hashmap_entry* entry;
+
+  entry = raptor_hashmap_find(map, key, map->hash_handler(key));
+
+  return entry ? entry->value : NULL;
+}
+
+
+/**
+ * raptor_hashmap_get_key:
+ * @map: hash map
+ * @key: key to find
+ *
+ * INTERNAL - Get the key in a hash map equal to a key
+ *
+ * Return value: key (still owned by the map) or NULL if the key is not present
+ */
+void*
+raptor_hashmap_get_key(raptor_hashmap* map, const void* key)
+{
+  raptor_hashmap_entry* entry;
+
+  entry = raptor_hashmap_find(map, key, map->hash_handler(key));
+
+  return entry ? entry->key : NULL;
+}
+
+
+/**
+ * raptor_hashmap_remove:
+ * @map: hash map
+ * @key: key to remove
+ *
+ * INTERNAL - Remove a key from a hash map and free the key and value
+ *
+ * Return value: non-0 if the key was present
+ */
+int
+raptor_hashmap_remove(raptor_hashmap* map, const void* key)
+{
+  raptor_hashmap_entry* entry;
+  size_t mask;
+  size_t i;
+  size_t next;
+
+  entry = raptor_hashmap_find(map, key, map->hash_handler(key));
+  if(!entry)
+    return 0;
+
+  raptor_hashmap_free_entry(map, entry);
+  map->count--;
+
+  /* shift back the following entries that are away from their home */
+  mask = map->table_size - 1;
+  i = RAPTOR_GOOD_CAST(size_t, entry - map->table);
+  for(next = (i + 1) & mask;
+      map->table[next].key &&
+        RAPTOR_HASHMAP_DISTANCE(map, &map->table[next], next);
+      i = next, next = (next + 1) & mask) {
+    map->table[i] = map->table[next];
+    map->table[next].key = NULL;
+    map->table[next].value = NULL;
+  }
+
+  return 1;
+}
+
+
+/**
+ * raptor_hashmap_size:
+ * @map: hash map
+ *
+ * INTERNAL - Get the number of entries in a hash map
+ *
+ * Return value: number of entries
+ */
+int
+raptor_hashmap_size(raptor_hashmap* map)
+{
+  return RAPTOR_BAD_CAST(int, map->count);
+}
+
+
+/**
+ * raptor_hashmap_visit:
+ * @map: hash map
+ * @visit_handler: function to call for each entry
+ * @user_data: user data for @visit_handler
+ *
+ * INTERNAL - Call a function for each entry in a hash map in no particular order
+ *
+ * The map must not be changed by @visit_handler.  The visit stops
+ * early if @visit_handler returns 0.
+ *
+ * Return value: as raptor_avltree_visit(): 0 if the visit was
+ * terminated early by @visit_handler
+ */
+int
+raptor_hashmap_visit(raptor_hashmap* map,
+                     raptor_hashmap_visit_handler visit_handler,
+                     void* user_data)
+{
+  size_t i;
+
+  for(i = 0; i < map->table_size; i++) {
+    raptor_hashmap_entry* entry = &map->table[i];
+
+    if(entry->key && !visit_handler(entry->key, entry->value, user_data))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/**
+ * raptor_hashmap_string_hash:
+ * @key: NUL-terminated string
+ *
+ * INTERNAL - Hash map hash handler for string keys
+ *
+ * Return value: hash of the string
+ */
+raptor_hash
+raptor_hashmap_string_hash(const void* key)
+{
+  const unsigned char* string = (const unsigned char*)key;
+
+  return raptor_hash_bytes(string, strlen((const char*)string), 0);
+}
+
+
+/**
+ * raptor_hashmap_string_equals:
+ * @key1: NUL-terminated string
+ * @key2: NUL-terminated string
+ *
+ * INTERNAL - Hash map equality handler for string keys
+ *
+ * Return value: non-0 if the strings are equal
+ */
+int
+raptor_hashmap_string_equals(const void* key1, const void* key2)
+{
+  return !strcmp((const char*)key1, (const char*)key2);
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_ITEMS 5000
+
+static char*
+test_make_key(int i)
+{
+  char* key = RAPTOR_MALLOC(char*, 16);
+  if(key)
+    snprintf(key, 16, "key%d", i);
+  return key;
+}
+
+
+static int
+test_count_entries(void* key, void* value, void* user_data)
+{
+  (*(int*)user_data)++;
+  return 1;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_hashmap* map;
+  static int values[TEST_ITEMS];
+  char probe[16];
+  int failures = 0;
+  int count;
+  int i;
+
+  map = raptor_new_hashmap(raptor_hashmap_string_hash,
+                           raptor_hashmap_string_equals,
+                           free, NULL, 0);
+  if(!map) {
+    fprintf(stderr, "%s: Failed to create hash map\n", program);
+    exit(1);
+  }
+
+  for(i = 0; i < TEST_ITEMS; i++) {
+    values[i] = i;
+    if(raptor_hashmap_add(map, test_make_key(i), &values[i])) {
+      fprintf(stderr, "%s: Adding key%d failed\n", program, i);
+      failures++;
+    }
+  }
+
+  /* adding an equal key fails and leaves the key with the caller */
+  snprintf(probe, sizeof(probe), "key%d", 42);
+  if(raptor_hashmap_add(map, probe, NULL) <= 0) {
+    fprintf(stderr, "%s: Adding a duplicate key succeeded\n", program);
+    failures++;
+  }
+
+  /* remove every other key */
+  for(i = 0; i < TEST_ITEMS; i += 2) {
+    snprintf(probe, sizeof(probe), "key%d", i);
+    if(!raptor_hashmap_remove(map, probe)) {
+      fprintf(stderr, "%s: Removing key%d failed\n", program, i);
+      failures++;
+    }
+  }
+
+  for(i = 0; i < TEST_ITEMS; i++) {
+    int* value;
+
+    snprintf(probe, sizeof(probe), "key%d", i);
+    value = (int*)raptor_hashmap_get(map, probe);
+    if((i % 2) ? (value != &values[i]) : (value != NULL)) {
+      fprintf(stderr, "%s: Getting key%d returned %p\n", program, i,
+              (void*)value);
+      failures++;
+    }
+  }
+
+  /* replace a value */
+  if(raptor_hashmap_put(map, test_make_key(1), &values[0]) <= 0 ||
+     raptor_hashmap_get(map, "key1") != &values[0]) {
+    fprintf(stderr, "%s: Replacing key1 failed\n", program);
+    failures++;
+  }
+
+  count = 0;
+  raptor_hashmap_visit(map, test_count_entries, &count);
+  if(count != TEST_ITEMS / 2 || raptor_hashmap_size(map) != TEST_ITEMS / 2) {
+    fprintf(stderr, "%s: Hash map has %d entries (size %d), expected %d\n",
+            program, count, raptor_hashmap_size(map), TEST_ITEMS / 2);
+    failures++;
+  }
+
+  raptor_free_hashmap(map);
+
+  return failures;
+}
+
+#endif
@@ -212,6 +212,7 @@ typedef struct raptor_parser_factory_s raptor_parser_factory;
 typedef struct raptor_serializer_factory_s raptor_serializer_factory;
 typedef struct raptor_id_set_s raptor_id_set;
 typedef struct raptor_uri_detail_s raptor_uri_detail;
+typedef struct raptor_hashmap_s raptor_hashmap;
 
 
 /* raptor_option.c */
@@ -410,14 +411,54 @@ void raptor_concepts_finish(raptor_world* world);
 /* raptor_iostream.c */
 raptor_world* raptor_iostream_get_world(raptor_iostream *iostr);
 
+/* POLICY - largest number of fragments in a write batch */
+#define RAPTOR_IOSTREAM_BATCH_IOV_COUNT 32
+
+/* POLICY - size of the write batch buffer short fragments are copied to */
+#define RAPTOR_IOSTREAM_BATCH_BUFFER_SIZE 1024
+
+/* POLICY - fragments shorter than this are copied into a write batch
+ * buffer rather than referenced */
+#define RAPTOR_IOSTREAM_BATCH_COPY_SIZE 32
+
+/* POLICY - smallest total size of fragments written to a file with
+ * writev() rather than through stdio */
+#define RAPTOR_IOSTREAM_WRITEV_MIN_SIZE (16 * 1024)
+
+/*
+ * Fragments collected to write to an iostream with one call to
+ * raptor_iostream_write_iov()
+ */
+typedef struct {
+  raptor_iostream* iostr;
+
+  raptor_iovec iov[RAPTOR_IOSTREAM_BATCH_IOV_COUNT];
+  int iov_count;
+
+  unsigned char buffer[RAPTOR_IOSTREAM_BATCH_BUFFER_SIZE];
+  size_t buffer_length;
+
+  int failed;
+} raptor_iostream_batch;
+
+RAPTOR_INTERNAL_API void raptor_iostream_batch_init(raptor_iostream_batch* batch, raptor_iostream* iostr);
+RAPTOR_INTERNAL_API int raptor_iostream_batch_add(raptor_iostream_batch* batch, const void* ptr, size_t len);
+RAPTOR_INTERNAL_API int raptor_iostream_batch_copy(raptor_iostream_batch* batch, const void* ptr, size_t len);
+RAPTOR_INTERNAL_API int raptor_iostream_batch_flush(raptor_iostream_batch* batch);
+
+/* raptor_escaped.c */
+RAPTOR_INTERNAL_API int raptor_string_needs_escapes(const unsigned char* string, size_t len, const char delim, unsigned int flags);
+
 
 /* Raptor Namespace Stack node */
 struct raptor_namespace_stack_s {
   raptor_world* world;
   int size;
 
-  int table_size;
-  raptor_namespace** table;
+  /* in-scope namespaces, most recently started first */
+  raptor_namespace* top;
+  /* innermost namespace for each prefix, keyed by prefix */
+  raptor_hashmap* prefixes;
   raptor_namespace* def_namespace;
 
   raptor_uri *rdf_ms_uri;
@@ -461,13 +502,23 @@ raptor_namespace** raptor_namespace_stack_to_array(raptor_namespace_stack *nstac
 #endif
 
 
-/* Size of buffer to use when reading from a file */
+/* Default size of buffer to use when reading from a file */
 #if defined(BUFSIZ) && BUFSIZ > 4096
 #define RAPTOR_READ_BUFFER_SIZE BUFSIZ
 #else
 #define RAPTOR_READ_BUFFER_SIZE 4096
 #endif
 
+/* POLICY - largest read buffer size that can be set with
+ * RAPTOR_OPTION_READ_BUFFER_SIZE */
+#define RAPTOR_READ_BUFFER_MAX_SIZE (64 * 1024 * 1024)
+
+/* POLICY - smallest unread file size that is read through a memory map */
+#define RAPTOR_MMAP_MIN_SIZE (64 * 1024)
+
+/* POLICY - largest part of a memory-mapped file passed on at once */
+#define RAPTOR_MMAP_WINDOW_SIZE (1024 * 1024)
+
 
 /*
  * Raptor parser object
@@ -535,10 +586,24 @@ struct raptor_parser_s {
   /* internal data for lexers */
   void* lexer_user_data;
 
-  /* internal read buffer */
-  unsigned char buffer[RAPTOR_READ_BUFFER_SIZE + 1];
+  /* duplicate statement filter during a parse or NULL.  While it is
+   * set, statement_handler and user_data point at the filter and the
+   * user's handler and data are kept below.
+   */
+  struct raptor_statement_dedup_s* dedup;
+  raptor_statement_handler dedup_statement_handler;
+  void* dedup_user_data;
+
+  /* internal read buffer of buffer_size bytes plus a NUL, allocated
+   * when first used */
+  unsigned char* buffer;
+  size_t buffer_size;
 };
 
+/* user data pointer for a parser's handlers */
+#define RAPTOR_PARSER_USER_DATA(parser) \
+  ((parser)->dedup ? (parser)->dedup_user_data : (parser)->user_data)
+
 
 /** A Parser Factory */
 struct raptor_parser_factory_s {
@@ -566,6 +631,14 @@ struct raptor_parser_factory_s {
   /* parse a chunk of memory */
   int (*chunk)(raptor_parser* parser, const unsigned char *buffer, size_t len, int is_end);
 
+  /* parse a chunk of memory that stays valid until the call returns,
+   * without copying it (OPTIONAL) - if not implemented, chunk() is used */
+  int (*chunk_borrowed)(raptor_parser* parser, const unsigned char *buffer, size_t len, int is_end);
+
+  /* non-0 if a memory-mapped file is best passed to chunk() whole
+   * rather than in windows, such as when the parser copies all input */
+  int mmap_whole_file;
+
   /* finish the parser factory */
   void (*finish_factory)(raptor_parser_factory* factory);
 
@@ -696,9 +769,27 @@ void raptor_stats_print(raptor_parser *rdf_parser, FILE *stream);
 #endif
 RAPTOR_INTERNAL_API const char* raptor_basename(const char *name);
 int raptor_term_print_as_ntriples(const raptor_term *term, FILE* stream);
+int raptor_terms_init(raptor_world* world);
+raptor_hash raptor_hash_bytes(const unsigned char* data, size_t len, raptor_hash seed);
+void raptor_terms_finish(raptor_world* world);
+
+/*
+ * Every term made by raptor is allocated as a raptor_term_private so
+ * its hash can be calculated once, before the term is shared.  Any
+ * literal or blank node strings follow it in the same allocation.
+ */
+typedef struct {
+  raptor_term term;
+  /* raptor_term_hash() value */
+  raptor_hash hash;
+} raptor_term_private;
+
+#define RAPTOR_TERM_PRIVATE(t) ((raptor_term_private*)(t))
+
+raptor_hash raptor_term_calculate_hash(raptor_term* term);
 
 /* raptor_ntriples.c */
-size_t raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator, unsigned char *string, size_t *len_p, raptor_term** term_p, int allow_turtle);
+size_t raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator, const unsigned char *string, unsigned char *buffer, size_t *len_p, raptor_term** term_p, int allow_turtle);
 
 /* raptor_parse.c */
 raptor_parser_factory* raptor_world_get_parser_factory(raptor_world* world, const char *name);  
@@ -803,6 +894,7 @@ int raptor_uri_init(raptor_world* world);
 void raptor_uri_finish(raptor_world* world);
 raptor_uri* raptor_new_uri_from_rdf_ordinal(raptor_world* world, int ordinal);
 size_t raptor_uri_normalize_path(unsigned char* path_buffer, size_t path_len);
+raptor_hash raptor_uri_get_hash(raptor_uri* uri);
 
 /* parsers */
 int raptor_init_parser_rdfxml(raptor_world* world);
@@ -817,6 +909,7 @@ int raptor_init_parser_rss(raptor_world* world);
 int raptor_init_parser_rdfa(raptor_world* world);
 int raptor_init_parser_json(raptor_world* world);
 int raptor_init_parser_nquads(raptor_world* world);
+int raptor_init_parser_binary(raptor_world* world);
 
 void raptor_terminate_parser_grddl_common(raptor_world *world);
 
@@ -938,6 +1031,40 @@ int raptor_init_serializer_html(raptor_world* world);
 /* raptor_serialize_json.c */  
 int raptor_init_serializer_json(raptor_world* world);
 
+/* raptor_serialize_binary.c */
+int raptor_init_serializer_binary(raptor_world* world);
+
+/* Binary RDF syntax shared by raptor_binary.c and raptor_serialize_binary.c
+ *
+ * The syntax is the magic string followed by a version byte and then a
+ * sequence of records, each starting with a raptor_binary_record byte.
+ * Integers are unsigned LEB128 varints and strings are a varint length
+ * followed by that many bytes with no escaping.  Term records append
+ * the term to a dictionary and statement records refer to terms by
+ * their dictionary index.  A reset record empties the dictionary so
+ * that neither side needs to keep more than one block of terms.
+ */
+#define RAPTOR_BINARY_MAGIC "RPTRBIN"
+#define RAPTOR_BINARY_MAGIC_LEN 7
+#define RAPTOR_BINARY_VERSION 1
+
+typedef enum {
+  /* end of the data */
+  RAPTOR_BINARY_RECORD_END     = 0,
+  /* string: URI */
+  RAPTOR_BINARY_RECORD_URI     = 1,
+  /* string: blank node ID */
+  RAPTOR_BINARY_RECORD_BLANK   = 2,
+  /* string: value; varint: datatype term index + 1 or 0; string: language */
+  RAPTOR_BINARY_RECORD_LITERAL = 3,
+  /* varints: subject, predicate, object term indexes */
+  RAPTOR_BINARY_RECORD_TRIPLE  = 4,
+  /* varints: subject, predicate, object, graph term indexes */
+  RAPTOR_BINARY_RECORD_QUAD    = 5,
+  /* empty the term dictionary */
+  RAPTOR_BINARY_RECORD_RESET   = 6
+} raptor_binary_record;
+
 /* raptor_unicode.c */
 extern const raptor_unichar raptor_unicode_max_codepoint;
 
@@ -986,7 +1113,9 @@ struct  raptor_www_s {
   void *old_xmlGenericErrorContext;
 #endif
 
-  char buffer[RAPTOR_WWW_BUFFER_SIZE + 1];
+  /* I/O buffer of buffer_size bytes plus a NUL */
+  char* buffer;
+  size_t buffer_size;
 
   char *user_agent;
 
@@ -1027,6 +1156,7 @@ void raptor_www_libxml_free(raptor_www *www);
 int raptor_www_libxml_fetch(raptor_www *www);
 
 void raptor_www_error(raptor_www *www, const char *message, ...) RAPTOR_PRINTF_FORMAT(2, 3);
+int raptor_www_set_buffer_size(raptor_www* www, size_t size);
 
 void raptor_www_curl_init(raptor_www *www);
 void raptor_www_curl_free(raptor_www *www);
@@ -1297,6 +1427,74 @@ int raptor_avltree_dump(raptor_avltree* tree, FILE* stream);
 void raptor_avltree_check(raptor_avltree* tree);
 #endif
 
+/* raptor_btree.c */
+typedef struct raptor_btree_s raptor_btree;
+typedef struct raptor_btree_iterator_s raptor_btree_iterator;
+
+raptor_btree* raptor_new_btree(raptor_data_compare_handler compare_handler, raptor_data_free_handler free_handler, unsigned int flags);
+void raptor_free_btree(raptor_btree* tree);
+int raptor_btree_add(raptor_btree* tree, void* p_data);
+int raptor_btree_build_from_sorted(raptor_btree* tree, void** items, int count);
+void* raptor_btree_remove(raptor_btree* tree, void* p_data);
+int raptor_btree_delete(raptor_btree* tree, void* p_data);
+void* raptor_btree_search(raptor_btree* tree, const void* p_data);
+int raptor_btree_visit(raptor_btree* tree, raptor_avltree_visit_handler visit_handler, void* user_data);
+int raptor_btree_size(raptor_btree* tree);
+raptor_btree_iterator* raptor_new_btree_iterator(raptor_btree* tree, void* range, raptor_data_free_handler range_free_handler, int direction);
+void raptor_free_btree_iterator(raptor_btree_iterator* iterator);
+int raptor_btree_iterator_is_end(raptor_btree_iterator* iterator);
+int raptor_btree_iterator_next(raptor_btree_iterator* iterator);
+void* raptor_btree_iterator_get(raptor_btree_iterator* iterator);
+#ifdef RAPTOR_DEBUG
+void raptor_btree_check(raptor_btree* tree);
+#endif
+
+/* raptor_hashmap.c */
+/*
+ * raptor_hashmap_hash_handler:
+ * @key: key
+ *
+ * Hash map key hash function
+ *
+ * Return value: hash of @key
+ */
+typedef raptor_hash (*raptor_hashmap_hash_handler)(const void* key);
+
+/*
+ * raptor_hashmap_equals_handler:
+ * @key1: first key
+ * @key2: second key
+ *
+ * Hash map key equality function
+ *
+ * Return value: non-0 if the keys are equal
+ */
+typedef int (*raptor_hashmap_equals_handler)(const void* key1, const void* key2);
+
+/*
+ * raptor_hashmap_visit_handler:
+ * @key: key
+ * @value: value
+ * @user_data: user data arg to raptor_hashmap_visit()
+ *
+ * Hash map visitor function as given to raptor_hashmap_visit()
+ *
+ * Return value: non-0 to continue the visit
+ */
+typedef int (*raptor_hashmap_visit_handler)(void* key, void* value, void* user_data);
+
+RAPTOR_INTERNAL_API raptor_hashmap* raptor_new_hashmap(raptor_hashmap_hash_handler hash_handler, raptor_hashmap_equals_handler equals_handler, raptor_data_free_handler key_free_handler, raptor_data_free_handler value_free_handler, int initial_size);
+RAPTOR_INTERNAL_API void raptor_free_hashmap(raptor_hashmap* map);
+RAPTOR_INTERNAL_API int raptor_hashmap_add(raptor_hashmap* map, void* key, void* value);
+RAPTOR_INTERNAL_API int raptor_hashmap_put(raptor_hashmap* map, void* key, void* value);
+RAPTOR_INTERNAL_API void* raptor_hashmap_get(raptor_hashmap* map, const void* key);
+RAPTOR_INTERNAL_API void* raptor_hashmap_get_key(raptor_hashmap* map, const void* key);
+RAPTOR_INTERNAL_API int raptor_hashmap_remove(raptor_hashmap* map, const void* key);
+RAPTOR_INTERNAL_API int raptor_hashmap_size(raptor_hashmap* map);
+RAPTOR_INTERNAL_API int raptor_hashmap_visit(raptor_hashmap* map, raptor_hashmap_visit_handler visit_handler, void* user_data);
+RAPTOR_INTERNAL_API raptor_hash raptor_hashmap_string_hash(const void* key);
+RAPTOR_INTERNAL_API int raptor_hashmap_string_equals(const void* key1, const void* key2);
+
 
 raptor_qname* raptor_new_qname_from_resource(raptor_sequence* namespaces, raptor_namespace_stack* nstack, int* namespace_count, raptor_abbrev_node* node);
 
@@ -1380,6 +1578,158 @@ int raptor_rdfxmla_serialize_set_write_typed_nodes(raptor_serializer* serializer
 /* snprintf.c */
 size_t raptor_format_integer(char* buffer, size_t bufsize, int integer, unsigned int base, int width, char padding);
 
+/* raptor_compress.c */
+typedef enum {
+  RAPTOR_COMPRESSION_NONE,
+  RAPTOR_COMPRESSION_GZIP,
+  RAPTOR_COMPRESSION_BZIP2,
+  RAPTOR_COMPRESSION_ZSTD,
+  RAPTOR_COMPRESSION_LAST = RAPTOR_COMPRESSION_ZSTD
+} raptor_compression;
+
+/* number of bytes needed to detect any compressed content */
+#define RAPTOR_COMPRESSION_MAGIC_SIZE 4
+
+RAPTOR_INTERNAL_API raptor_compression raptor_compression_detect(const unsigned char* buffer, size_t len);
+RAPTOR_INTERNAL_API int raptor_compression_is_available(raptor_compression compression);
+RAPTOR_INTERNAL_API const char* raptor_compression_get_name(raptor_compression compression);
+RAPTOR_INTERNAL_API int raptor_compression_from_name(const char* name, raptor_compression* compression_p);
+RAPTOR_INTERNAL_API int raptor_compression_is_writable(raptor_compression compression);
+RAPTOR_INTERNAL_API raptor_iostream* raptor_new_iostream_decompress_file_handle(raptor_world* world, FILE* handle, int close_handle, const unsigned char* prefix, size_t prefix_len);
+RAPTOR_INTERNAL_API raptor_iostream* raptor_new_iostream_compress_file_handle(raptor_world* world, FILE* handle, int close_handle, raptor_compression compression, int threads);
+
+/* raptor_mmap.c */
+typedef struct {
+  /* unread content of the file */
+  unsigned char* data;
+  size_t length;
+
+  /* whole file mapping */
+  void* map;
+  size_t map_length;
+} raptor_mapped_file;
+
+RAPTOR_INTERNAL_API int raptor_mapped_file_open(raptor_mapped_file* mapped, FILE* stream, size_t min_size);
+RAPTOR_INTERNAL_API void raptor_mapped_file_close(raptor_mapped_file* mapped);
+
+/* raptor_uring.c */
+
+/* POLICY - default size of each buffer of a queued file iostream */
+#define RAPTOR_URING_BUFFER_SIZE (256 * 1024)
+
+/* POLICY - smallest buffer size of a queued file iostream */
+#define RAPTOR_URING_MIN_BUFFER_SIZE 4096
+
+/* POLICY - largest number of requests a queued file iostream keeps in flight */
+#define RAPTOR_URING_MAX_QUEUE_DEPTH 64
+
+RAPTOR_INTERNAL_API raptor_iostream* raptor_new_iostream_from_file_handle_uring(raptor_world* world, FILE* handle, int queue_depth, size_t buffer_size);
+RAPTOR_INTERNAL_API raptor_iostream* raptor_new_iostream_to_filename_uring(raptor_world* world, const char* filename, int queue_depth, size_t buffer_size);
+
+/* raptor_statement_sorter.c */
+typedef struct raptor_statement_sorter_s raptor_statement_sorter;
+
+/*
+ * raptor_statement_sorter_handler:
+ * @user_data: user data
+ * @statement: statement
+ *
+ * Handler called with each statement by raptor_statement_sorter_visit()
+ *
+ * Return value: non-0 to stop the visit
+ */
+typedef int (*raptor_statement_sorter_handler)(void* user_data, raptor_statement* statement);
+
+RAPTOR_INTERNAL_API raptor_statement_sorter* raptor_new_statement_sorter(raptor_world* world, size_t memory_limit);
+RAPTOR_INTERNAL_API void raptor_free_statement_sorter(raptor_statement_sorter* sorter);
+RAPTOR_INTERNAL_API void raptor_statement_sorter_set_threads(raptor_statement_sorter* sorter, int threads);
+RAPTOR_INTERNAL_API int raptor_statement_sorter_add(raptor_statement_sorter* sorter, raptor_statement* statement);
+RAPTOR_INTERNAL_API int raptor_statement_sorter_visit(raptor_statement_sorter* sorter, raptor_statement_sorter_handler handler, void* user_data);
+RAPTOR_INTERNAL_API int raptor_statement_sorter_get_runs_count(raptor_statement_sorter* sorter);
+
+/* raptor_statement_dedup.c */
+typedef struct raptor_statement_dedup_s raptor_statement_dedup;
+
+RAPTOR_INTERNAL_API raptor_statement_dedup* raptor_new_statement_dedup(raptor_world* world, int limit, int use_bloom);
+RAPTOR_INTERNAL_API void raptor_free_statement_dedup(raptor_statement_dedup* dedup);
+RAPTOR_INTERNAL_API int raptor_statement_dedup_check(raptor_statement_dedup* dedup, raptor_statement* statement);
+
+/* raptor_threads.c */
+typedef struct raptor_mutex_s raptor_mutex;
+typedef struct raptor_thread_pool_s raptor_thread_pool;
+
+/*
+ * raptor_thread_task_handler:
+ * @data: task data
+ *
+ * Task run by a #raptor_thread_pool worker.
+ *
+ * Return value: non-0 on failure
+ */
+typedef int (*raptor_thread_task_handler)(void* data);
+
+int raptor_threads_init(raptor_world* world);
+void raptor_threads_finish(raptor_world* world);
+RAPTOR_INTERNAL_API raptor_mutex* raptor_new_mutex(raptor_world* world);
+RAPTOR_INTERNAL_API void raptor_free_mutex(raptor_mutex* mutex);
+RAPTOR_INTERNAL_API void raptor_mutex_lock(raptor_mutex* mutex);
+RAPTOR_INTERNAL_API void raptor_mutex_unlock(raptor_mutex* mutex);
+RAPTOR_INTERNAL_API raptor_thread_pool* raptor_new_thread_pool(raptor_world* world, int threads);
+RAPTOR_INTERNAL_API void raptor_free_thread_pool(raptor_thread_pool* pool);
+RAPTOR_INTERNAL_API int raptor_thread_pool_get_threads_count(raptor_thread_pool* pool);
+RAPTOR_INTERNAL_API int raptor_thread_pool_add_task(raptor_thread_pool* pool, raptor_thread_task_handler handler, void* data);
+RAPTOR_INTERNAL_API int raptor_thread_pool_wait(raptor_thread_pool* pool);
+RAPTOR_INTERNAL_API void raptor_world_internal_threads_start(raptor_world* world);
+RAPTOR_INTERNAL_API void raptor_world_internal_threads_end(raptor_world* world);
+
+/* Take the world lock around updates of world-shared state, only
+ * while worker threads are sharing the world */
+#ifdef RAPTOR_THREADS
+#define RAPTOR_WORLD_LOCK(world) \
+  do { if((world) && (world)->threads_active) raptor_mutex_lock((world)->mutex); } while(0)
+#define RAPTOR_WORLD_UNLOCK(world) \
+  do { if((world) && (world)->threads_active) raptor_mutex_unlock((world)->mutex); } while(0)
+#else
+#define RAPTOR_WORLD_LOCK(world) do { } while(0)
+#define RAPTOR_WORLD_UNLOCK(world) do { } while(0)
+#endif
+
+/* raptor_read_ahead.c */
+typedef struct raptor_read_ahead_s raptor_read_ahead;
+
+/*
+ * raptor_read_ahead_read_handler:
+ * @user_data: user data
+ * @buffer: buffer to read into
+ * @size: size of @buffer
+ * @len_p: pointer to store the number of bytes read
+ *
+ * Read the next part of some content for a #raptor_read_ahead
+ *
+ * Return value: 0 if more content may follow, >0 at the end of content
+ * or <0 on failure
+ */
+typedef int (*raptor_read_ahead_read_handler)(void* user_data, unsigned char* buffer, size_t size, size_t* len_p);
+
+/* POLICY - size of each buffer of a parser reading ahead */
+#define RAPTOR_READ_AHEAD_BUFFER_SIZE (256 * 1024)
+
+/* POLICY - largest number of buffers a parser reads ahead into */
+#define RAPTOR_READ_AHEAD_MAX_BUFFERS 8
+
+RAPTOR_INTERNAL_API raptor_read_ahead* raptor_new_read_ahead(raptor_world* world, int buffers, size_t buffer_size, raptor_read_ahead_read_handler handler, void* user_data);
+RAPTOR_INTERNAL_API void raptor_free_read_ahead(raptor_read_ahead* ra);
+RAPTOR_INTERNAL_API int raptor_read_ahead_next(raptor_read_ahead* ra, unsigned char** buffer_p, size_t* len_p);
+
+/* sort_r.c */
+RAPTOR_INTERNAL_API void raptor_sort_parallel(void** base, size_t nel, raptor_data_compare_handler compare, raptor_thread_pool* pool);
+
+/* raptor_sequence.c */
+RAPTOR_INTERNAL_API void raptor_sequence_sort_parallel(raptor_sequence* seq, raptor_data_compare_handler compare, raptor_thread_pool* pool);
+
+/* raptor_statement.c */
+RAPTOR_INTERNAL_API void raptor_statement_radix_sort(raptor_statement** statements, size_t count);
+
 /* raptor_world structure */
 #define RAPTOR1_WORLD_MAGIC_1 0
 #define RAPTOR1_WORLD_MAGIC_2 1
@@ -1454,6 +1804,9 @@ struct raptor_world_s {
 
   raptor_avltree *uris_tree;
 
+  /* interned literal and blank node terms or NULL if not interning */
+  raptor_avltree *terms_tree;
+
   raptor_uri* concepts[RDF_NS_LAST + 1];
 
   raptor_term* terms[RDF_NS_LAST + 1];
@@ -1464,6 +1817,18 @@ struct raptor_world_s {
   /* should */
   int uri_interning;
 
+  /* should literal and blank node terms be interned */
+  int term_interning;
+
+  /* should interned URIs be numbered in sorted order for comparison */
+  int uri_ordinals;
+  /* changed when a URI is interned; older URI ordinals are then stale */
+  unsigned long uri_ordinals_epoch;
+  /* comparisons that found stale ordinals since the last numbering */
+  unsigned long uri_ordinals_misses;
+  /* count of URIs numbered so far while numbering */
+  unsigned long uri_ordinals_count;
+
   /* generate blank node ID policy */
   void *generate_bnodeid_handler_user_data;
   raptor_generate_bnodeid_handler generate_bnodeid_handler;
@@ -1477,6 +1842,12 @@ struct raptor_world_s {
   raptor_uri* xsd_decimal_uri;
   raptor_uri* xsd_double_uri;
   raptor_uri* xsd_integer_uri;
+
+  /* lock for world-shared state while worker threads are running */
+  raptor_mutex* mutex;
+
+  /* >0 while worker threads may be using this world */
+  int threads_active;
 };
 
 /* raptor_www.c */
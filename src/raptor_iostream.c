@@ -30,6 +30,18 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 /* Raptor includes */
 #include "raptor2.h"
@@ -38,6 +50,17 @@
 
 #ifndef STANDALONE
 
+#if defined(HAVE_WRITEV) && defined(HAVE_SYS_UIO_H) && defined(HAVE_UNISTD_H)
+#define RAPTOR_WRITEV 1
+
+/* most fragments passed to one writev() call */
+#if defined(IOV_MAX) && IOV_MAX < 64
+#define RAPTOR_WRITEV_IOV_MAX IOV_MAX
+#else
+#define RAPTOR_WRITEV_IOV_MAX 64
+#endif
+#endif
+
 #define RAPTOR_IOSTREAM_MODE_READ  1
 #define RAPTOR_IOSTREAM_MODE_WRITE 2
 
@@ -75,6 +98,10 @@ raptor_iostream_calculate_modes(const raptor_iostream_handler * const handler)
      (handler->write_byte || handler->write_bytes))
     mode |= RAPTOR_IOSTREAM_MODE_WRITE;
 
+  /* API V3 checks */
+  if((handler->version >= 3) && handler->write_iov)
+    mode |= RAPTOR_IOSTREAM_MODE_WRITE;
+
   return mode;
 }
 
@@ -86,7 +113,7 @@ raptor_iostream_check_handler(const raptor_iostream_handler * const handler,
 {
   int mode;
 
-  if(handler->version < 1 || handler->version > 2)
+  if(handler->version < 1 || handler->version > 3)
     return 0;
 
   mode = raptor_iostream_calculate_modes(handler);
@@ -177,7 +204,8 @@ static const raptor_iostream_handler raptor_iostream_sink_handler = {
   /* .write_bytes = */ raptor_sink_iostream_write_bytes,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ raptor_sink_iostream_read_bytes,
-  /* .read_eof    = */ raptor_sink_iostream_read_eof
+  /* .read_eof    = */ raptor_sink_iostream_read_eof,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -235,6 +263,88 @@ raptor_filename_iostream_write_end(void *user_data)
   return fclose(handle);
 }
 
+#ifdef RAPTOR_WRITEV
+/* write all the fragments to a file descriptor */
+static int
+raptor_iostream_fd_writev(int fd, const raptor_iovec *iov, int iovcnt)
+{
+  struct iovec vec[RAPTOR_WRITEV_IOV_MAX];
+  int count = 0;
+  int i = 0;
+  size_t offset = 0;
+
+  while(i < iovcnt || count) {
+    ssize_t n;
+
+    /* fill vec from fragment i, starting offset bytes in */
+    while(i < iovcnt && count < RAPTOR_WRITEV_IOV_MAX) {
+      if(iov[i].length > offset) {
+        vec[count].iov_base = (char*)iov[i].base + offset;
+        vec[count].iov_len = iov[i].length - offset;
+        count++;
+      }
+      i++;
+      offset = 0;
+    }
+    if(!count)
+      break;
+
+    n = writev(fd, vec, count);
+    if(n < 0) {
+#ifdef EINTR
+      if(errno == EINTR)
+        continue;
+#endif
+      return 1;
+    }
+
+    /* drop what was written and keep the rest for the next call */
+    while(count && RAPTOR_GOOD_CAST(size_t, n) >= vec[0].iov_len) {
+      n -= RAPTOR_BAD_CAST(ssize_t, vec[0].iov_len);
+      count--;
+      memmove(&vec[0], &vec[1], RAPTOR_GOOD_CAST(size_t, count) * sizeof(vec[0]));
+    }
+    if(count) {
+      vec[0].iov_base = (char*)vec[0].iov_base + n;
+      vec[0].iov_len -= RAPTOR_GOOD_CAST(size_t, n);
+    }
+  }
+
+  return 0;
+}
+#endif
+
+static int
+raptor_filename_iostream_write_iov(void *user_data,
+                                   const raptor_iovec *iov, int iovcnt)
+{
+  FILE* handle = (FILE*)user_data;
+  int i;
+#ifdef RAPTOR_WRITEV
+  size_t length = 0;
+
+  for(i = 0; i < iovcnt; i++)
+    length += iov[i].length;
+
+  /* Large writes skip copying into the stdio buffer.  The FILE* is
+   * private to this iostream and never seeked, so the stdio and file
+   * descriptor positions stay the same after the flush. */
+  if(length >= RAPTOR_IOSTREAM_WRITEV_MIN_SIZE && fileno(handle) >= 0) {
+    if(fflush(handle))
+      return 1;
+    return raptor_iostream_fd_writev(fileno(handle), iov, iovcnt);
+  }
+#endif
+
+  for(i = 0; i < iovcnt; i++) {
+    if(iov[i].length &&
+       fwrite(iov[i].base, 1, iov[i].length, handle) != iov[i].length)
+      return 1;
+  }
+
+  return 0;
+}
+
 static int
 raptor_filename_iostream_read_bytes(void *user_data,
                                     void *ptr, size_t size, size_t nmemb)
@@ -251,14 +361,15 @@ raptor_filename_iostream_read_eof(void *user_data)
 }
 
 static const raptor_iostream_handler raptor_iostream_write_filename_handler = {
-  /* .version     = */ 2,
+  /* .version     = */ 3,
   /* .init        = */ NULL,
   /* .finish      = */ raptor_filename_iostream_finish,
   /* .write_byte  = */ raptor_filename_iostream_write_byte,
   /* .write_bytes = */ raptor_filename_iostream_write_bytes,
   /* .write_end   = */ raptor_filename_iostream_write_end,
   /* .read_bytes  = */ NULL,
-  /* .read_eof    = */ NULL
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ raptor_filename_iostream_write_iov
 };
 
 
@@ -322,7 +433,8 @@ static const raptor_iostream_handler raptor_iostream_write_file_handler = {
   /* .write_bytes = */ raptor_filename_iostream_write_bytes,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ NULL,
-  /* .read_eof    = */ NULL
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -447,7 +559,8 @@ static const raptor_iostream_handler raptor_iostream_write_string_handler = {
   /* .write_bytes = */ raptor_write_string_iostream_write_bytes,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ NULL,
-  /* .read_eof    = */ NULL
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -563,7 +676,8 @@ static const raptor_iostream_handler raptor_iostream_read_filename_handler = {
   /* .write_bytes = */ NULL,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ raptor_filename_iostream_read_bytes,
-  /* .read_eof    = */ raptor_filename_iostream_read_eof
+  /* .read_eof    = */ raptor_filename_iostream_read_eof,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -627,7 +741,8 @@ static const raptor_iostream_handler raptor_iostream_read_file_handle_handler =
   /* .write_bytes = */ NULL,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ raptor_filename_iostream_read_bytes,
-  /* .read_eof    = */ raptor_filename_iostream_read_eof
+  /* .read_eof    = */ raptor_filename_iostream_read_eof,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -721,10 +836,21 @@ raptor_iostream_write_byte(const int byte, raptor_iostream *iostr)
 
   if(iostr->flags & RAPTOR_IOSTREAM_FLAGS_EOF)
     return 1;
-  if(!iostr->handler->write_byte)
-    return 1;
   if(!(iostr->mode & RAPTOR_IOSTREAM_MODE_WRITE))
     return 1;
+
+  if(!iostr->handler->write_byte) {
+    unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+    raptor_iovec iov;
+
+    /* V3 handlers may only provide write_iov */
+    if(iostr->handler->version < 3 || !iostr->handler->write_iov)
+      return 1;
+    iov.base = &c;
+    iov.length = 1;
+    return iostr->handler->write_iov(iostr->user_data, &iov, 1);
+  }
+
   return iostr->handler->write_byte(iostr->user_data, byte);
 }
 
@@ -748,12 +874,22 @@ raptor_iostream_write_bytes(const void *ptr, size_t size, size_t nmemb,
   
   if(iostr->flags & RAPTOR_IOSTREAM_FLAGS_EOF)
     return -1;
-  if(!iostr->handler->write_bytes)
-    return -1;
   if(!(iostr->mode & RAPTOR_IOSTREAM_MODE_WRITE))
     return -1;
 
-  nobj = iostr->handler->write_bytes(iostr->user_data, ptr, size, nmemb);
+  if(!iostr->handler->write_bytes) {
+    raptor_iovec iov;
+
+    /* V3 handlers may only provide write_iov */
+    if(iostr->handler->version < 3 || !iostr->handler->write_iov)
+      return -1;
+    iov.base = ptr;
+    iov.length = size * nmemb;
+    if(iostr->handler->write_iov(iostr->user_data, &iov, 1))
+      return -1;
+    nobj = RAPTOR_BAD_CAST(int, nmemb);
+  } else
+    nobj = iostr->handler->write_bytes(iostr->user_data, ptr, size, nmemb);
   if(nobj > 0)
     iostr->offset += (size * nobj);
 
@@ -761,6 +897,203 @@ raptor_iostream_write_bytes(const void *ptr, size_t size, size_t nmemb,
 }
 
 
+/**
+ * raptor_iostream_write_iov:
+ * @iov: array of fragments to write
+ * @iovcnt: number of fragments in @iov
+ * @iostr: raptor iostream
+ *
+ * Write several fragments of bytes to the iostream in order.
+ *
+ * The fragments are passed to the handler's write_iov method in one
+ * call where the handler provides one (version 3 or later), so that
+ * for example a file may be written with a single system call
+ * without first copying the fragments together.  Otherwise each
+ * fragment is written in turn with raptor_iostream_write_bytes().
+ *
+ * Return value: non-0 on failure
+ **/
+int
+raptor_iostream_write_iov(const raptor_iovec *iov, int iovcnt,
+                          raptor_iostream *iostr)
+{
+  size_t length = 0;
+  int i;
+
+  if(iostr->flags & RAPTOR_IOSTREAM_FLAGS_EOF)
+    return 1;
+  if(!(iostr->mode & RAPTOR_IOSTREAM_MODE_WRITE))
+    return 1;
+  if(iovcnt <= 0)
+    return (iovcnt < 0);
+
+  if(iostr->handler->version >= 3 && iostr->handler->write_iov) {
+    for(i = 0; i < iovcnt; i++)
+      length += iov[i].length;
+    if(iostr->handler->write_iov(iostr->user_data, iov, iovcnt))
+      return 1;
+    iostr->offset += length;
+    return 0;
+  }
+
+  for(i = 0; i < iovcnt; i++) {
+    const unsigned char* p = (const unsigned char*)iov[i].base;
+    size_t j;
+
+    if(!iov[i].length)
+      continue;
+
+    if(iostr->handler->write_bytes) {
+      if(iostr->handler->write_bytes(iostr->user_data, p, 1,
+                                     iov[i].length) !=
+         RAPTOR_BAD_CAST(int, iov[i].length))
+        return 1;
+    } else {
+      for(j = 0; j < iov[i].length; j++) {
+        if(iostr->handler->write_byte(iostr->user_data, p[j]))
+          return 1;
+      }
+    }
+    iostr->offset += iov[i].length;
+  }
+
+  return 0;
+}
+
+
+/**
+ * raptor_iostream_batch_init:
+ * @batch: batch to initialise
+ * @iostr: iostream to write to
+ *
+ * INTERNAL - Start collecting writes to an iostream into a batch
+ *
+ * Small writes are gathered in the batch and written to @iostr
+ * together with raptor_iostream_write_iov() when the batch is full
+ * or flushed.  A batch needs no freeing and is usually on the stack.
+ */
+void
+raptor_iostream_batch_init(raptor_iostream_batch* batch,
+                           raptor_iostream* iostr)
+{
+  batch->iostr = iostr;
+  batch->iov_count = 0;
+  batch->buffer_length = 0;
+  batch->failed = 0;
+}
+
+
+/**
+ * raptor_iostream_batch_flush:
+ * @batch: batch
+ *
+ * INTERNAL - Write the fragments collected in a batch and empty it
+ *
+ * Return value: non-0 if this or any earlier write of the batch failed
+ */
+int
+raptor_iostream_batch_flush(raptor_iostream_batch* batch)
+{
+  if(batch->iov_count && !batch->failed) {
+    if(raptor_iostream_write_iov(batch->iov, batch->iov_count, batch->iostr))
+      batch->failed = 1;
+  }
+
+  batch->iov_count = 0;
+  batch->buffer_length = 0;
+
+  return batch->failed;
+}
+
+
+/**
+ * raptor_iostream_batch_copy:
+ * @batch: batch
+ * @ptr: bytes to write
+ * @len: number of bytes
+ *
+ * INTERNAL - Add a copy of some bytes to a batch
+ *
+ * The bytes may be changed or freed as soon as this returns.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_iostream_batch_copy(raptor_iostream_batch* batch,
+                           const void* ptr, size_t len)
+{
+  raptor_iovec* last;
+
+  if(!len)
+    return batch->failed;
+
+  if(batch->buffer_length + len > RAPTOR_IOSTREAM_BATCH_BUFFER_SIZE ||
+     batch->iov_count == RAPTOR_IOSTREAM_BATCH_IOV_COUNT) {
+    if(raptor_iostream_batch_flush(batch))
+      return 1;
+
+    /* too big to copy: write it now, before the caller can free it */
+    if(len > RAPTOR_IOSTREAM_BATCH_BUFFER_SIZE) {
+      batch->iov[0].base = ptr;
+      batch->iov[0].length = len;
+      batch->iov_count = 1;
+      return raptor_iostream_batch_flush(batch);
+    }
+  }
+
+  memcpy(batch->buffer + batch->buffer_length, ptr, len);
+
+  /* extend the previous fragment if it ends where this copy starts */
+  last = batch->iov_count ? &batch->iov[batch->iov_count - 1] : NULL;
+  if(last &&
+     (const unsigned char*)last->base + last->length ==
+       batch->buffer + batch->buffer_length)
+    last->length += len;
+  else {
+    last = &batch->iov[batch->iov_count++];
+    last->base = batch->buffer + batch->buffer_length;
+    last->length = len;
+  }
+  batch->buffer_length += len;
+
+  return 0;
+}
+
+
+/**
+ * raptor_iostream_batch_add:
+ * @batch: batch
+ * @ptr: bytes to write
+ * @len: number of bytes
+ *
+ * INTERNAL - Add some bytes to a batch without copying them
+ *
+ * The bytes must not be changed or freed until the batch is flushed.
+ * Short fragments are copied anyway since that is cheaper than
+ * passing them separately.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_iostream_batch_add(raptor_iostream_batch* batch,
+                          const void* ptr, size_t len)
+{
+  if(len < RAPTOR_IOSTREAM_BATCH_COPY_SIZE)
+    return raptor_iostream_batch_copy(batch, ptr, len);
+
+  if(batch->iov_count == RAPTOR_IOSTREAM_BATCH_IOV_COUNT) {
+    if(raptor_iostream_batch_flush(batch))
+      return 1;
+  }
+
+  batch->iov[batch->iov_count].base = ptr;
+  batch->iov[batch->iov_count].length = len;
+  batch->iov_count++;
+
+  return batch->failed;
+}
+
+
 /**
  * raptor_iostream_string_write:
  * @string: string
@@ -1072,7 +1405,8 @@ static const raptor_iostream_handler raptor_iostream_read_string_handler = {
   /* .write_bytes = */ NULL,
   /* .write_end   = */ NULL,
   /* .read_bytes  = */ raptor_read_string_iostream_read_bytes,
-  /* .read_eof    = */ raptor_read_string_iostream_read_eof
+  /* .read_eof    = */ raptor_read_string_iostream_read_eof,
+  /* .write_iov   = */ NULL
 };
 
 
@@ -1577,6 +1911,198 @@ test_read_from_sink(raptor_world *world, size_t read_len, size_t expected_len)
 }
 
 
+#define IOV_BIG_SIZE (RAPTOR_IOSTREAM_WRITEV_MIN_SIZE + 1000)
+
+/* collects bytes for a handler that only provides write_iov */
+static unsigned char *test_iov_buffer;
+static size_t test_iov_buffer_len;
+
+static int
+test_iov_only_write_iov(void *user_data, const raptor_iovec *iov, int iovcnt)
+{
+  int i;
+
+  for(i = 0; i < iovcnt; i++) {
+    memcpy(test_iov_buffer + test_iov_buffer_len, iov[i].base, iov[i].length);
+    test_iov_buffer_len += iov[i].length;
+  }
+
+  return 0;
+}
+
+static const raptor_iostream_handler test_iov_only_handler = {
+  /* .version     = */ 3,
+  /* .init        = */ NULL,
+  /* .finish      = */ NULL,
+  /* .write_byte  = */ NULL,
+  /* .write_bytes = */ NULL,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ test_iov_only_write_iov
+};
+
+static int
+test_write_iov(raptor_world *world, const char* filename)
+{
+  raptor_iostream *iostr = NULL;
+  raptor_iostream_batch batch;
+  raptor_iovec iov[5];
+  unsigned char *big = NULL;
+  unsigned char *expected = NULL;
+  unsigned char *got = NULL;
+  void *string = NULL;
+  size_t string_len = 0;
+  size_t expected_len;
+  size_t got_len;
+  size_t offset;
+  FILE *handle = NULL;
+  int pass;
+  int i;
+  int rc = 0;
+  const char* const label="write iostream with fragments";
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  fprintf(stderr, "%s: Testing %s\n", program, label);
+#endif
+
+  big = (unsigned char*)malloc(IOV_BIG_SIZE);
+  expected = (unsigned char*)malloc(3 * IOV_BIG_SIZE);
+  got = (unsigned char*)malloc(3 * IOV_BIG_SIZE);
+  if(!big || !expected || !got) {
+    rc = 1;
+    goto tidy;
+  }
+  for(i = 0; i < IOV_BIG_SIZE; i++)
+    big[i] = (unsigned char)('a' + (i % 26));
+
+  /* fragments of mixed sizes including an empty one */
+  iov[0].base = "<"; iov[0].length = 1;
+  iov[1].base = big; iov[1].length = IOV_BIG_SIZE;
+  iov[2].base = "|"; iov[2].length = 1;
+  iov[3].base = ""; iov[3].length = 0;
+  iov[4].base = big; iov[4].length = IOV_BIG_SIZE / 2;
+
+  expected_len = 0;
+  expected[expected_len++] = '>';
+  memcpy(expected + expected_len, "<", 1); expected_len += 1;
+  memcpy(expected + expected_len, big, IOV_BIG_SIZE);
+  expected_len += IOV_BIG_SIZE;
+  memcpy(expected + expected_len, "|", 1); expected_len += 1;
+  memcpy(expected + expected_len, big, IOV_BIG_SIZE / 2);
+  expected_len += IOV_BIG_SIZE / 2;
+  expected[expected_len++] = '!';
+
+  /* pass 0 writes a file with writev(), pass 1 a string without V3
+   * and pass 2 a handler with only write_iov */
+  test_iov_buffer = got;
+  for(pass = 0; pass < 3; pass++) {
+    if(!pass)
+      iostr = raptor_new_iostream_to_filename(world, filename);
+    else if(pass == 1)
+      iostr = raptor_new_iostream_to_string(world, &string, &string_len, NULL);
+    else {
+      test_iov_buffer_len = 0;
+      iostr = raptor_new_iostream_from_handler(world, NULL,
+                                               &test_iov_only_handler);
+    }
+    if(!iostr) {
+      fprintf(stderr, "%s: Failed to create %s\n", program, label);
+      rc = 1;
+      goto tidy;
+    }
+
+    raptor_iostream_write_byte('>', iostr);
+    if(raptor_iostream_write_iov(iov, 5, iostr)) {
+      fprintf(stderr, "%s: %s failed\n", program, label);
+      rc = 1;
+    }
+    raptor_iostream_write_byte('!', iostr);
+
+    if(raptor_iostream_tell(iostr) != expected_len) {
+      fprintf(stderr, "%s: %s wrote %lu bytes, expected %lu\n", program,
+              label, raptor_iostream_tell(iostr), (unsigned long)expected_len);
+      rc = 1;
+    }
+    raptor_free_iostream(iostr); iostr = NULL;
+
+    if(!pass) {
+      handle = fopen(filename, "rb");
+      got_len = handle ? fread(got, 1, 3 * IOV_BIG_SIZE, handle) : 0;
+      if(handle) {
+        fclose(handle); handle = NULL;
+      }
+      remove(filename);
+    } else if(pass == 1) {
+      got_len = string_len;
+      if(string)
+        memcpy(got, string, string_len);
+    } else
+      got_len = test_iov_buffer_len;
+
+    if(got_len != expected_len || memcmp(got, expected, expected_len)) {
+      fprintf(stderr, "%s: %s pass %d wrote the wrong content\n", program,
+              label, pass);
+      rc = 1;
+    }
+  }
+  if(string) {
+    raptor_free_memory(string); string = NULL;
+  }
+
+  /* small copies and large references through a batch stay in order */
+  iostr = raptor_new_iostream_to_string(world, &string, &string_len, NULL);
+  if(!iostr) {
+    rc = 1;
+    goto tidy;
+  }
+  raptor_iostream_batch_init(&batch, iostr);
+  expected_len = 0;
+  for(i = 0; i < 100; i++) {
+    size_t len = RAPTOR_GOOD_CAST(size_t, (i * 37) % 300);
+
+    offset = RAPTOR_GOOD_CAST(size_t, i % 100);
+    if(i % 3)
+      raptor_iostream_batch_add(&batch, big + offset, len);
+    else
+      raptor_iostream_batch_copy(&batch, big + offset, len);
+    memcpy(expected + expected_len, big + offset, len);
+    expected_len += len;
+  }
+  raptor_iostream_batch_copy(&batch, big, IOV_BIG_SIZE);
+  memcpy(expected + expected_len, big, IOV_BIG_SIZE);
+  expected_len += IOV_BIG_SIZE;
+  if(raptor_iostream_batch_flush(&batch)) {
+    fprintf(stderr, "%s: %s batch failed\n", program, label);
+    rc = 1;
+  }
+  raptor_free_iostream(iostr); iostr = NULL;
+
+  if(!string || string_len != expected_len ||
+     memcmp(string, expected, expected_len)) {
+    fprintf(stderr, "%s: %s batch wrote the wrong content\n", program, label);
+    rc = 1;
+  }
+
+  tidy:
+  if(iostr)
+    raptor_free_iostream(iostr);
+  if(string)
+    raptor_free_memory(string);
+  if(big)
+    free(big);
+  if(expected)
+    free(expected);
+  if(got)
+    free(got);
+
+  if(rc)
+    fprintf(stderr, "%s: FAILED Testing %s\n", program, label);
+
+  return rc;
+}
+
+
 #define OUT_FILENAME "out.bin"
 #define OUT_BYTES_COUNT 14
 #define TEST_STRING "Hello, world!"
@@ -1619,6 +2145,7 @@ main(int argc, char *argv[])
   failures+= test_write_to_sink(world,
                                 TEST_STRING,
                                 TEST_STRING_LEN, (int)OUT_BYTES_COUNT);
+  failures+= test_write_iov(world, (const char*)OUT_FILENAME);
 
   remove(OUT_FILENAME);
 
@@ -133,6 +133,8 @@ raptor_log_error(raptor_world* world, raptor_log_level level,
     if(world->internal_ignore_errors)
       return;
 
+    RAPTOR_WORLD_LOCK(world);
+
     memset(&world->message, '\0', sizeof(world->message));
     world->message.code = -1;
     world->message.domain = RAPTOR_DOMAIN_NONE;
@@ -146,8 +148,11 @@ raptor_log_error(raptor_world* world, raptor_log_level level,
        * functions are called.
        */
       handler(world->message_handler_user_data, &world->message);
+      RAPTOR_WORLD_UNLOCK(world);
       return;
     }
+
+    RAPTOR_WORLD_UNLOCK(world);
   }
 
   /* default - print it to stderr */
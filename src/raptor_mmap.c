@@ -0,0 +1,267 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_mmap.c - Raptor memory-mapped file reading
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_UNISTD_H)
+#define RAPTOR_MMAP 1
+#endif
+
+
+#ifndef STANDALONE
+
+/**
+ * raptor_mapped_file_open:
+ * @mapped: mapped file to initialise
+ * @stream: FILE* to map the unread content of
+ * @min_size: smallest unread size worth mapping
+ *
+ * INTERNAL - Map the unread content of a regular file into memory
+ *
+ * The content from the current position of @stream to the end of
+ * the file is made available at @mapped->data for @mapped->length
+ * bytes, advised for sequential access and, where supported, huge
+ * pages.  The mapping is read-only so a stray write faults rather
+ * than silently changing a copy of the content.  The stream position
+ * is moved to the end of the file as if it had been read.
+ *
+ * Fails without changing @stream if mapping is not supported, or if
+ * @stream is not a regular file with at least @min_size bytes
+ * unread, when the caller should read the stream as usual.  The file
+ * must not be truncated while it is mapped.
+ *
+ * Return value: non-0 if the content was not mapped
+ */
+int
+raptor_mapped_file_open(raptor_mapped_file* mapped, FILE* stream,
+                        size_t min_size)
+{
+#ifdef RAPTOR_MMAP
+  struct stat buf;
+  long offset;
+  size_t size;
+  void* map;
+  int fd;
+#endif
+
+  memset(mapped, 0, sizeof(*mapped));
+
+#ifdef RAPTOR_MMAP
+  fd = fileno(stream);
+  if(fd < 0 || fstat(fd, &buf) || !S_ISREG(buf.st_mode))
+    return 1;
+
+  offset = ftell(stream);
+  if(offset < 0 || RAPTOR_GOOD_CAST(off_t, offset) > buf.st_size)
+    return 1;
+
+  size = RAPTOR_GOOD_CAST(size_t, buf.st_size);
+  if(RAPTOR_GOOD_CAST(off_t, size) != buf.st_size ||
+     size - RAPTOR_GOOD_CAST(size_t, offset) < min_size ||
+     !size)
+    return 1;
+
+  map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(map == MAP_FAILED)
+    return 1;
+
+#ifdef HAVE_MADVISE
+#ifdef MADV_SEQUENTIAL
+  madvise(map, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+  madvise(map, size, MADV_HUGEPAGE);
+#endif
+#endif
+
+  if(fseek(stream, 0L, SEEK_END)) {
+    munmap(map, size);
+    return 1;
+  }
+
+  mapped->map = map;
+  mapped->map_length = size;
+  mapped->data = (unsigned char*)map + offset;
+  mapped->length = size - RAPTOR_GOOD_CAST(size_t, offset);
+
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+
+/**
+ * raptor_mapped_file_close:
+ * @mapped: mapped file
+ *
+ * INTERNAL - Unmap a file mapped with raptor_mapped_file_open()
+ */
+void
+raptor_mapped_file_close(raptor_mapped_file* mapped)
+{
+#ifdef RAPTOR_MMAP
+  if(mapped->map)
+    munmap(mapped->map, mapped->map_length);
+#endif
+
+  memset(mapped, 0, sizeof(*mapped));
+}
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_LINES 20000
+
+static void
+test_statement_handler(void* user_data, raptor_statement* statement)
+{
+  (*(int*)user_data)++;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  raptor_mapped_file mapped;
+  raptor_parser* parser;
+  raptor_uri* base_uri;
+  FILE* fh;
+  long size;
+  int count = 0;
+  int i;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  fh = tmpfile();
+  if(!fh) {
+    fprintf(stderr, "%s: Failed to create a temporary file\n", program);
+    exit(1);
+  }
+
+  /* lines of varying length so windows end mid-line */
+  for(i = 0; i < TEST_LINES; i++)
+    fprintf(fh, "<http://example.org/s%d> <http://example.org/p> \"%*d\" .\n",
+            i, 1 + (i % 37), i);
+  fflush(fh);
+  size = ftell(fh);
+  rewind(fh);
+
+  if(!raptor_mapped_file_open(&mapped, fh, RAPTOR_GOOD_CAST(size_t, size) + 1)) {
+    fprintf(stderr, "%s: Mapped a file smaller than the minimum size\n",
+            program);
+    rc = 1;
+    raptor_mapped_file_close(&mapped);
+  }
+
+  /* skip the first line as if it had been read */
+  while(fgetc(fh) != '\n')
+    ;
+
+#ifdef RAPTOR_MMAP
+  {
+    long offset = ftell(fh);
+
+    if(raptor_mapped_file_open(&mapped, fh, 0)) {
+      fprintf(stderr, "%s: Failed to map a regular file\n", program);
+      rc = 1;
+    } else {
+      if(mapped.length != RAPTOR_GOOD_CAST(size_t, size - offset) ||
+         memcmp(mapped.data, "<http://example.org/s1>", 23)) {
+        fprintf(stderr, "%s: Mapped the wrong content\n", program);
+        rc = 1;
+      }
+      if(fgetc(fh) != EOF) {
+        fprintf(stderr, "%s: Mapped stream is not at the end\n", program);
+        rc = 1;
+      }
+      raptor_mapped_file_close(&mapped);
+    }
+  }
+#endif
+
+  /* parse the whole file, through a mapping if supported */
+  rewind(fh);
+  parser = raptor_new_parser(world, "ntriples");
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  if(!parser || !base_uri) {
+    fprintf(stderr, "%s: Failed to create parser\n", program);
+    exit(1);
+  }
+  raptor_parser_set_statement_handler(parser, &count, test_statement_handler);
+  if(raptor_parser_parse_file_stream(parser, fh, NULL, base_uri)) {
+    fprintf(stderr, "%s: Parsing failed\n", program);
+    rc = 1;
+  }
+  if(count != TEST_LINES) {
+    fprintf(stderr, "%s: Parsing returned %d statements, expected %d\n",
+            program, count, TEST_LINES);
+    rc = 1;
+  }
+
+  raptor_free_uri(base_uri);
+  raptor_free_parser(parser);
+  fclose(fh);
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
@@ -93,25 +93,48 @@ const unsigned char * const raptor_xmlschema_datatypes_namespace_uri = (const un
 const unsigned char * const raptor_owl_namespace_uri = (const unsigned char *)"http://www.w3.org/2002/07/owl#";
 
 
-/* hash function to hash namespace prefix strings (usually short strings)
- *
- * Uses DJ Bernstein original hash function - good on short text keys.
+/* hash map handlers for the innermost namespace of each prefix.
+ * The keys are namespaces compared by prefix; the default namespace
+ * has a NULL prefix which is distinct from any prefix string.
  */
-static unsigned int
-raptor_hash_ns_string(const unsigned char *str, int length)
+static raptor_hash
+raptor_namespace_prefix_hash(const void* key)
 {
-  unsigned int hash = 5381;
-  int c;
-  
-  for(; length && (c = *str++); length--) {
-    hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-  }
+  const raptor_namespace* ns = (const raptor_namespace*)key;
+
+  return raptor_hash_bytes(ns->prefix ? ns->prefix : (const unsigned char*)"",
+                           ns->prefix_length, 0);
+}
+
+
+static int
+raptor_namespace_prefix_equals(const void* key1, const void* key2)
+{
+  const raptor_namespace* ns1 = (const raptor_namespace*)key1;
+  const raptor_namespace* ns2 = (const raptor_namespace*)key2;
+
+  if(!ns1->prefix || !ns2->prefix)
+    return !ns1->prefix && !ns2->prefix;
 
-  return hash;
+  return ns1->prefix_length == ns2->prefix_length &&
+         !memcmp(ns1->prefix, ns2->prefix, ns1->prefix_length);
 }
 
 
-#define RAPTOR_NAMESPACES_HASHTABLE_SIZE 1024
+/* Find the innermost namespace below @ns on the stack with the same prefix */
+static raptor_namespace*
+raptor_namespace_find_shadowed(raptor_namespace* ns)
+{
+  raptor_namespace* below;
+
+  for(below = ns->next; below; below = below->next) {
+    if(raptor_namespace_prefix_equals(below, ns))
+      break;
+  }
+
+  return below;
+}
+
 /**
  * raptor_namespaces_init:
  * @world: raptor_world object
@@ -137,12 +160,12 @@ raptor_namespaces_init(raptor_world* world,
   nstack->world = world;
 
   nstack->size = 0;
-  
-  nstack->table_size = RAPTOR_NAMESPACES_HASHTABLE_SIZE;
-  nstack->table = RAPTOR_CALLOC(raptor_namespace**,
-                                RAPTOR_NAMESPACES_HASHTABLE_SIZE,
-                                sizeof(raptor_namespace*));
-  if(!nstack->table)
+
+  nstack->top = NULL;
+  nstack->prefixes = raptor_new_hashmap(raptor_namespace_prefix_hash,
+                                        raptor_namespace_prefix_equals,
+                                        NULL, NULL, 0);
+  if(!nstack->prefixes)
     return -1;
 
   nstack->def_namespace = NULL;
@@ -229,15 +252,17 @@ void
 raptor_namespaces_start_namespace(raptor_namespace_stack *nstack, 
                                   raptor_namespace *nspace)
 {
-  unsigned int hash = raptor_hash_ns_string(nspace->prefix,
-                                            nspace->prefix_length);
-  const int bucket = hash % nstack->table_size;
-
   nstack->size++;
-  
-  if(nstack->table[bucket])
-    nspace->next = nstack->table[bucket];
-  nstack->table[bucket] = nspace;
+
+  nspace->next = nstack->top;
+  nstack->top = nspace;
+
+  /* without the map, prefixes are found by walking the stack */
+  if(nstack->prefixes &&
+     raptor_hashmap_put(nstack->prefixes, nspace, nspace) < 0) {
+    raptor_free_hashmap(nstack->prefixes);
+    nstack->prefixes = NULL;
+  }
 
   if(!nstack->def_namespace)
     nstack->def_namespace = nspace;
@@ -291,24 +316,17 @@ raptor_namespaces_start_namespace_full(raptor_namespace_stack *nstack,
 void
 raptor_namespaces_clear(raptor_namespace_stack *nstack)
 {
-  if(nstack->table) {
-    int bucket;
-
-    for(bucket = 0; bucket < nstack->table_size; bucket++) {
-      raptor_namespace *ns = nstack->table[bucket];
-      while(ns) {
-        raptor_namespace* next_ns = ns->next;
-        
-        raptor_free_namespace(ns);
-        nstack->size--;
-        ns = next_ns;
-      }
-      nstack->table[bucket] = NULL;
-    }
+  while(nstack->top) {
+    raptor_namespace* ns = nstack->top;
+
+    nstack->top = ns->next;
+    raptor_free_namespace(ns);
+    nstack->size--;
+  }
 
-    RAPTOR_FREE(raptor_namespaces, nstack->table);
-    nstack->table = NULL;
-    nstack->table_size = 0;
+  if(nstack->prefixes) {
+    raptor_free_hashmap(nstack->prefixes);
+    nstack->prefixes = NULL;
   }
 
   if(nstack->world) {
@@ -356,24 +374,36 @@ raptor_free_namespaces(raptor_namespace_stack *nstack)
 void 
 raptor_namespaces_end_for_depth(raptor_namespace_stack *nstack, int depth)
 {
-  int bucket;
-  for(bucket = 0; bucket < nstack->table_size; bucket++) {
-    while(nstack->table[bucket] &&
-          nstack->table[bucket]->depth == depth) {
-      raptor_namespace* ns = nstack->table[bucket];
-      raptor_namespace* next_ns = ns->next;
+  raptor_namespace** ns_p = &nstack->top;
+
+  while(*ns_p) {
+    raptor_namespace* ns = *ns_p;
+
+    if(ns->depth != depth) {
+      ns_p = &ns->next;
+      continue;
+    }
 
 #ifndef STANDALONE
 #ifdef RAPTOR_DEBUG_VERBOSE
-      RAPTOR_DEBUG3("namespace prefix %s depth %d\n",
-                    ns->prefix ? (char*)ns->prefix : "(default)", depth);
+    RAPTOR_DEBUG3("namespace prefix %s depth %d\n",
+                  ns->prefix ? (char*)ns->prefix : "(default)", depth);
 #endif
 #endif
-      raptor_free_namespace(ns);
-      nstack->size--;
 
-      nstack->table[bucket] = next_ns;
+    /* the prefix now binds to the namespace it shadowed, if any */
+    if(nstack->prefixes && raptor_hashmap_get(nstack->prefixes, ns) == ns) {
+      raptor_namespace* shadowed = raptor_namespace_find_shadowed(ns);
+
+      if(shadowed)
+        raptor_hashmap_put(nstack->prefixes, shadowed, shadowed);
+      else
+        raptor_hashmap_remove(nstack->prefixes, ns);
     }
+
+    *ns_p = ns->next;
+    raptor_free_namespace(ns);
+    nstack->size--;
   }
 }
 
@@ -389,13 +419,7 @@ raptor_namespaces_end_for_depth(raptor_namespace_stack *nstack, int depth)
 raptor_namespace*
 raptor_namespaces_get_default_namespace(raptor_namespace_stack *nstack)
 {
-  unsigned int hash = raptor_hash_ns_string((const unsigned char *)"", 0);
-  const int bucket = hash % nstack->table_size;
-  raptor_namespace* ns;
-
-  for(ns = nstack->table[bucket]; ns && ns->prefix; ns = ns->next)
-    ;
-  return ns;
+  return raptor_namespaces_find_namespace(nstack, NULL, 0);
 }
 
 
@@ -417,23 +441,21 @@ raptor_namespace*
 raptor_namespaces_find_namespace(raptor_namespace_stack *nstack, 
                                  const unsigned char *prefix, int prefix_length)
 {
+  raptor_namespace key;
   raptor_namespace* ns;
-  unsigned int hash = raptor_hash_ns_string(prefix, prefix_length);
-  int bucket;
 
-  if(!nstack || !nstack->table_size)
+  if(!nstack)
     return NULL;
 
-  bucket = hash % (nstack->table_size);
-  for(ns = nstack->table[bucket]; ns ; ns = ns->next) {
-    if(!prefix) {
-      if(!ns->prefix)
-        break;
-    } else {
-      if((unsigned int)prefix_length == ns->prefix_length && 
-         !strncmp((char*)prefix, (char*)ns->prefix, prefix_length))
-        break;
-    }
+  key.prefix = prefix;
+  key.prefix_length = prefix ? RAPTOR_BAD_CAST(unsigned int, prefix_length) : 0;
+
+  if(nstack->prefixes)
+    return (raptor_namespace*)raptor_hashmap_get(nstack->prefixes, &key);
+
+  for(ns = nstack->top; ns; ns = ns->next) {
+    if(raptor_namespace_prefix_equals(ns, &key))
+      break;
   }
 
   return ns;
@@ -453,17 +475,15 @@ raptor_namespace*
 raptor_namespaces_find_namespace_by_uri(raptor_namespace_stack *nstack, 
                                         raptor_uri *ns_uri)
 {
-  int bucket;
+  raptor_namespace* ns;
 
   if(!ns_uri)
     return NULL;
   
-  for(bucket = 0; bucket < nstack->table_size; bucket++) {
-    raptor_namespace* ns;
-    for(ns = nstack->table[bucket]; ns ; ns = ns->next)
-      if(raptor_uri_equals(ns->uri, ns_uri))
-        return ns;
-   }
+  for(ns = nstack->top; ns; ns = ns->next) {
+    if(raptor_uri_equals(ns->uri, ns_uri))
+      return ns;
+  }
   
   return NULL;
 }
@@ -483,12 +503,10 @@ raptor_namespaces_namespace_in_scope(raptor_namespace_stack *nstack,
                                      const raptor_namespace *nspace)
 {
   raptor_namespace* ns;
-  int bucket;
   
-  for(bucket = 0; bucket < nstack->table_size; bucket++) {
-    for(ns = nstack->table[bucket]; ns ; ns = ns->next)
-      if(raptor_uri_equals(ns->uri, nspace->uri))
-        return 1;
+  for(ns = nstack->top; ns; ns = ns->next) {
+    if(raptor_uri_equals(ns->uri, nspace->uri))
+      return 1;
   }
   return 0;
 }
@@ -977,35 +995,30 @@ raptor_new_qname_from_namespace_uri(raptor_namespace_stack *nstack,
   unsigned char *ns_uri_string;
   size_t ns_uri_len;
   unsigned char *name = NULL;
-  int bucket;
 
   if(!uri)
     return NULL;
   
   uri_string = raptor_uri_as_counted_string(uri, &uri_len);
 
-  for(bucket = 0; bucket < nstack->table_size; bucket++) {
-    for(ns = nstack->table[bucket]; ns ; ns = ns->next) {
-      if(!ns->uri)
-        continue;
-      
-      ns_uri_string = raptor_uri_as_counted_string(ns->uri,
-                                                      &ns_uri_len);
-      if(ns_uri_len >= uri_len)
-        continue;
-      if(strncmp((const char*)uri_string, (const char*)ns_uri_string,
-                 ns_uri_len))
-        continue;
-      
-      /* uri_string is a prefix of ns_uri_string */
-      name = uri_string + ns_uri_len;
-      if(!raptor_xml_name_check(name, uri_len-ns_uri_len, xml_version))
-        name = NULL;
-      
-      /* If name is set, we've found a prefix with a legal XML name value */
-      if(name)
-        break;
-    }
+  for(ns = nstack->top; ns; ns = ns->next) {
+    if(!ns->uri)
+      continue;
+    
+    ns_uri_string = raptor_uri_as_counted_string(ns->uri,
+                                                    &ns_uri_len);
+    if(ns_uri_len >= uri_len)
+      continue;
+    if(strncmp((const char*)uri_string, (const char*)ns_uri_string,
+               ns_uri_len))
+      continue;
+    
+    /* uri_string is a prefix of ns_uri_string */
+    name = uri_string + ns_uri_len;
+    if(!raptor_xml_name_check(name, uri_len-ns_uri_len, xml_version))
+      name = NULL;
+    
+    /* If name is set, we've found a prefix with a legal XML name value */
     if(name)
       break;
   }
@@ -1039,35 +1052,28 @@ raptor_namespace_stack_to_array(raptor_namespace_stack *nstack,
 {
   raptor_namespace** ns_list;
   size_t size = 0;
-  int bucket;
+  raptor_namespace* ns;
   
   ns_list = RAPTOR_CALLOC(raptor_namespace**, nstack->size,
                           sizeof(raptor_namespace*));
   if(!ns_list)
     return NULL;
   
-  for(bucket = 0; bucket < nstack->table_size; bucket++) {
-    raptor_namespace* ns;
-
-    for(ns = nstack->table[bucket]; ns; ns = ns->next) {
-      int skip = 0;
-      unsigned int i;
-      if(ns->depth < 1)
-        continue;
-      
-      for(i = 0; i < size; i++) {
-        raptor_namespace* ns2 = ns_list[i];
-        if((!ns->prefix && !ns2->prefix) ||
-           (ns->prefix && ns2->prefix && 
-            !strcmp((const char*)ns->prefix, (const char*)ns2->prefix))) {
-          /* this prefix was seen (overridden) earlier so skip */
-          skip = 1;
-          break;
-        }
+  for(ns = nstack->top; ns; ns = ns->next) {
+    int skip = 0;
+    unsigned int i;
+    if(ns->depth < 1)
+      continue;
+    
+    for(i = 0; i < size; i++) {
+      if(raptor_namespace_prefix_equals(ns, ns_list[i])) {
+        /* this prefix was seen (overridden) earlier so skip */
+        skip = 1;
+        break;
       }
-      if(!skip)
-        ns_list[size++] = ns;
     }
+    if(!skip)
+      ns_list[size++] = ns;
   }
   
   if(size_p)
@@ -300,8 +300,8 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
           for(ii = 0; ii < ulen; ii++) {
             char cc = p[ii];
             if(!isxdigit(RAPTOR_GOOD_CAST(char, cc))) {
-              raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "N-Triples string error - illegal hex digit %c in Unicode escape '%c%s...'",
-                            cc, c, p);
+              raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "N-Triples string error - illegal hex digit %c in Unicode escape '%c%.*s...'",
+                            cc, c, RAPTOR_BAD_CAST(int, *lenp), p);
               n = 1;
               break;
             }
@@ -312,7 +312,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
           n = sscanf((const char*)p, ((ulen == 4) ? "%04lx" : "%08lx"), &unichar);
           if(n != 1) {
-            raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal Uncode escape '%c%s...'", c, p);
+            raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal Uncode escape '%c%.*s...'", c, RAPTOR_BAD_CAST(int, *lenp), p);
             break;
           }
         }
@@ -443,6 +443,7 @@ raptor_parse_turtle_term_internal(raptor_world* world,
  * @world: raptor world
  * @locator: raptor locator (in/out) (or NULL)
  * @string: string input (in)
+ * @buffer: buffer to decode into (or @string to decode in place)
  * @len_p: pointer to length of @string (in/out)
  * @term_p: pointer to store term (out)
  * @allow_turtle: non-0 to allow Turtle forms such as integers, boolean
@@ -453,20 +454,25 @@ raptor_parse_turtle_term_internal(raptor_world* world,
  * proceeds to be used in error messages.  The final value is written
  * into the #raptor_term pointed at by @term_p
  *
+ * @string is only read and need not be NUL terminated.  Unescaped
+ * term strings are written into @buffer at the same offsets as they
+ * appear in @string so @buffer must be at least *@len_p + 1 bytes.
+ *
  * Return value: number of bytes processed or 0 on failure
  */
 size_t
 raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
-                           unsigned char *string, size_t *len_p,
+                           const unsigned char *string, unsigned char *buffer,
+                           size_t *len_p,
                            raptor_term** term_p, int allow_turtle)
 {
-  unsigned char *p = string;
+  const unsigned char *p = string;
   unsigned char *dest;
   size_t term_length = 0;
 
   switch(*p) {
     case '<':
-      dest = p;
+      dest = buffer + (p - string);
 
       p++;
       (*len_p)--;
@@ -476,7 +482,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
       }
 
       if(raptor_ntriples_parse_term_internal(world, locator,
-                                             (const unsigned char**)&p,
+                                             &p,
                                              dest, len_p, &term_length,
                                              '>', RAPTOR_TERM_CLASS_URI)) {
         goto fail;
@@ -523,10 +529,10 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
       if(allow_turtle) {
         raptor_uri* datatype_uri = NULL;
 
-        dest = p;
+        dest = buffer + (p - string);
 
         if(raptor_parse_turtle_term_internal(world, locator,
-                                             (const unsigned char**)&p,
+                                             &p,
                                              dest, len_p, &term_length,
                                              &datatype_uri)) {
           goto fail;
@@ -536,12 +542,14 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
                                                dest,
                                                datatype_uri,
                                                NULL /* language */);
+        if(datatype_uri)
+          raptor_free_uri(datatype_uri);
       } else
         goto fail;
       break;
 
     case '"':
-      dest = p;
+      dest = buffer + (p - string);
 
       p++;
       (*len_p)--;
@@ -551,7 +559,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
       }
 
       if(raptor_ntriples_parse_term_internal(world, locator,
-                                             (const unsigned char**)&p,
+                                             &p,
                                              dest, len_p, &term_length,
                                              '"', RAPTOR_TERM_CLASS_STRING)) {
         goto fail;
@@ -566,7 +574,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           unsigned char *q;
           size_t lang_len;
 
-          object_literal_language = p;
+          object_literal_language = buffer + (p - string);
 
           /* Skip - */
           p++;
@@ -582,14 +590,14 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           }
 
           if(raptor_ntriples_parse_term_internal(world, locator,
-                                  (const unsigned char**)&p,
+                                  &p,
                                   object_literal_language, len_p, &lang_len,
                                   '\0', RAPTOR_TERM_CLASS_LANGUAGE)) {
             goto fail;
           }
 
           if(!lang_len) {
-            raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Invalid language tag at @%s", p);
+            raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Invalid language tag at @%.*s", RAPTOR_BAD_CAST(int, *len_p), p);
             goto fail;
           }
 
@@ -608,7 +616,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
         if(*len_p > 1 && *p == '^' && p[1] == '^') {
 
-          object_literal_datatype = p;
+          object_literal_datatype = buffer + (p - string);
 
           /* Skip ^^ */
           p += 2;
@@ -631,7 +639,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           }
 
           if(raptor_ntriples_parse_term_internal(world, locator,
-                                  (const unsigned char**)&p,
+                                  &p,
                                   object_literal_datatype, len_p, NULL,
                                   '>', RAPTOR_TERM_CLASS_URI)) {
             goto fail;
@@ -663,6 +671,8 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
                                                dest,
                                                datatype_uri,
                                                object_literal_language);
+        if(datatype_uri)
+          raptor_free_uri(datatype_uri);
       }
 
       break;
@@ -670,7 +680,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
       case '_':
         /* store where _ was */
-        dest = p;
+        dest = buffer + (p - string);
 
         p++;
         (*len_p)--;
@@ -694,7 +704,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
         }
 
         if(raptor_ntriples_parse_term_internal(world, locator,
-                                               (const unsigned char**)&p,
+                                               &p,
                                                dest, len_p, &term_length,
                                                '\0',
                                                RAPTOR_TERM_CLASS_BNODEID)) {
@@ -296,6 +296,66 @@ static const struct
     RAPTOR_OPTION_VALUE_TYPE_BOOL,
     "loadExternalEntities",
     "Parsers and SAX2 should load external entities."
+  },
+  { RAPTOR_OPTION_THREADS,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "threads",
+    "Number of worker threads serializers may use."
+  },
+  { RAPTOR_OPTION_MEMORY_LIMIT,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "memoryLimit",
+    "Kilobytes of statements serializers may buffer before using temporary files."
+  },
+  { RAPTOR_OPTION_SORT_UNIQUE,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_BOOL,
+    "sortUnique",
+    "Write sorted statements without duplicates."
+  },
+  { RAPTOR_OPTION_DEDUP,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "dedup",
+    "Number of recent statements to remember to remove duplicates."
+  },
+  { RAPTOR_OPTION_DEDUP_BLOOM,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_BOOL,
+    "dedupBloom",
+    "Use a Bloom filter when removing duplicate statements."
+  },
+  { RAPTOR_OPTION_READ_AHEAD,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "readAhead",
+    "Number of buffers to read content into ahead of parsing in a thread."
+  },
+  { RAPTOR_OPTION_COMPRESSION,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_STRING,
+    "compression",
+    "Compress serializer output with gzip or zstd."
+  },
+  { RAPTOR_OPTION_IO_QUEUE_DEPTH,
+    (raptor_option_area)(RAPTOR_OPTION_AREA_PARSER | RAPTOR_OPTION_AREA_SERIALIZER),
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "ioQueueDepth",
+    "Number of large file reads or writes to keep in flight."
+  },
+  { RAPTOR_OPTION_IO_BUFFER_SIZE,
+    (raptor_option_area)(RAPTOR_OPTION_AREA_PARSER | RAPTOR_OPTION_AREA_SERIALIZER),
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "ioBufferSize",
+    "Size in bytes of each file read or write kept in flight."
+  },
+  { RAPTOR_OPTION_READ_BUFFER_SIZE,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "readBufferSize",
+    "Size in bytes of the chunks parsers read content in."
   }
 };
 
@@ -128,6 +128,10 @@ raptor_parsers_init(raptor_world *world)
   rc+= raptor_init_parser_nquads(world) != 0;
 #endif
 
+#ifdef RAPTOR_PARSER_BINARY
+  rc+= raptor_init_parser_binary(world) != 0;
+#endif
+
   return rc;
 }
 
@@ -414,6 +418,67 @@ raptor_new_parser_for_content(raptor_world* world,
 }
 
 
+/* Statement handler that drops duplicates before calling the user handler */
+static void
+raptor_parser_dedup_statement_handler(void *user_data,
+                                      raptor_statement *statement)
+{
+  raptor_parser* rdf_parser = (raptor_parser*)user_data;
+
+  /* on failure to remember the statement, pass it on anyway */
+  if(raptor_statement_dedup_check(rdf_parser->dedup, statement) > 0)
+    return;
+
+  if(rdf_parser->dedup_statement_handler)
+    (*rdf_parser->dedup_statement_handler)(rdf_parser->dedup_user_data,
+                                           statement);
+}
+
+
+static void
+raptor_parser_end_dedup(raptor_parser *rdf_parser)
+{
+  if(!rdf_parser->dedup)
+    return;
+
+  rdf_parser->statement_handler = rdf_parser->dedup_statement_handler;
+  rdf_parser->user_data = rdf_parser->dedup_user_data;
+
+  raptor_free_statement_dedup(rdf_parser->dedup);
+  rdf_parser->dedup = NULL;
+}
+
+
+static int
+raptor_parser_start_dedup(raptor_parser *rdf_parser)
+{
+  int limit;
+  int use_bloom;
+
+  raptor_parser_end_dedup(rdf_parser);
+
+  limit = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_DEDUP);
+  if(limit <= 0)
+    return 0;
+
+  use_bloom = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_DEDUP_BLOOM);
+
+  rdf_parser->dedup = raptor_new_statement_dedup(rdf_parser->world, limit,
+                                                 use_bloom);
+  if(!rdf_parser->dedup) {
+    raptor_parser_fatal_error(rdf_parser, "Out of memory");
+    return 1;
+  }
+
+  rdf_parser->dedup_statement_handler = rdf_parser->statement_handler;
+  rdf_parser->dedup_user_data = rdf_parser->user_data;
+  rdf_parser->statement_handler = raptor_parser_dedup_statement_handler;
+  rdf_parser->user_data = rdf_parser;
+
+  return 0;
+}
+
+
 /**
  * raptor_parser_parse_start:
  * @rdf_parser: RDF parser
@@ -449,6 +514,9 @@ raptor_parser_parse_start(raptor_parser *rdf_parser, raptor_uri *uri)
   rdf_parser->locator.column = -1;
   rdf_parser->locator.byte   = -1;
 
+  if(raptor_parser_start_dedup(rdf_parser))
+    return 1;
+
   if(rdf_parser->factory->start)
     return rdf_parser->factory->start(rdf_parser);
   else
@@ -476,10 +544,70 @@ int
 raptor_parser_parse_chunk(raptor_parser* rdf_parser,
                           const unsigned char *buffer, size_t len, int is_end) 
 {
+  int rc;
+
   if(rdf_parser->sb)
     raptor_stringbuffer_append_counted_string(rdf_parser->sb, buffer, len, 1);
     
-  return rdf_parser->factory->chunk(rdf_parser, buffer, len, is_end);
+  rc = rdf_parser->factory->chunk(rdf_parser, buffer, len, is_end);
+
+  if(is_end)
+    raptor_parser_end_dedup(rdf_parser);
+
+  return rc;
+}
+
+
+/**
+ * raptor_parser_parse_chunk_borrowed:
+ * @rdf_parser: RDF parser
+ * @buffer: content to parse
+ * @len: length of buffer
+ * @is_end: non-0 if this is the end of the content (such as EOF)
+ * @release_handler: function to call when @buffer is no longer used (or NULL)
+ * @release_user_data: user data for @release_handler
+ *
+ * Parse a block of content into triples without copying it.
+ *
+ * As raptor_parser_parse_chunk() but the caller promises that
+ * @buffer stays valid and unchanged until @release_handler is
+ * called, such as for content in a memory-mapped file or a network
+ * buffer.  Parsers that support it (N-Triples and N-Quads) build
+ * terms directly from @buffer and only copy a partial line left at
+ * the end of it; other parsers copy the content as usual.
+ *
+ * @release_handler is always called, even on failure, and currently
+ * before this function returns.
+ *
+ * This method can only be called after raptor_parser_parse_start() has
+ * initialised the parser.
+ *
+ * Return value: non-0 on failure.
+ **/
+int
+raptor_parser_parse_chunk_borrowed(raptor_parser* rdf_parser,
+                                   const unsigned char *buffer, size_t len,
+                                   int is_end,
+                                   raptor_parser_chunk_release_handler release_handler,
+                                   void *release_user_data)
+{
+  int rc;
+
+  if(rdf_parser->factory->chunk_borrowed) {
+    if(rdf_parser->sb)
+      raptor_stringbuffer_append_counted_string(rdf_parser->sb, buffer, len, 1);
+
+    rc = rdf_parser->factory->chunk_borrowed(rdf_parser, buffer, len, is_end);
+
+    if(is_end)
+      raptor_parser_end_dedup(rdf_parser);
+  } else
+    rc = raptor_parser_parse_chunk(rdf_parser, buffer, len, is_end);
+
+  if(release_handler)
+    release_handler(release_user_data, buffer, len);
+
+  return rc;
 }
 
 
@@ -499,6 +627,8 @@ raptor_free_parser(raptor_parser* rdf_parser)
   if(rdf_parser->factory)
     rdf_parser->factory->terminate(rdf_parser);
 
+  raptor_parser_end_dedup(rdf_parser);
+
   if(rdf_parser->www)
     raptor_free_www(rdf_parser->www);
 
@@ -511,12 +641,221 @@ raptor_free_parser(raptor_parser* rdf_parser)
   if(rdf_parser->sb)
     raptor_free_stringbuffer(rdf_parser->sb);
 
+  if(rdf_parser->buffer)
+    RAPTOR_FREE(char*, rdf_parser->buffer);
+
   raptor_object_options_clear(&rdf_parser->options);
 
   RAPTOR_FREE(raptor_parser, rdf_parser);
 }
 
 
+/*
+ * Get the size of the chunks to read content in, set by
+ * RAPTOR_OPTION_READ_BUFFER_SIZE, or 0 if it is not set
+ */
+static size_t
+raptor_parser_get_read_buffer_size_option(raptor_parser* rdf_parser)
+{
+  int size;
+
+  size = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_READ_BUFFER_SIZE);
+  if(size <= 0)
+    return 0;
+  if(size > RAPTOR_READ_BUFFER_MAX_SIZE)
+    return RAPTOR_READ_BUFFER_MAX_SIZE;
+  return RAPTOR_GOOD_CAST(size_t, size);
+}
+
+
+/*
+ * Get the parser read buffer, allocated with room for a NUL after
+ * the size set by RAPTOR_OPTION_READ_BUFFER_SIZE
+ */
+static unsigned char*
+raptor_parser_get_read_buffer(raptor_parser* rdf_parser, size_t* size_p)
+{
+  size_t size = raptor_parser_get_read_buffer_size_option(rdf_parser);
+
+  if(!size)
+    size = RAPTOR_READ_BUFFER_SIZE;
+
+  if(rdf_parser->buffer && rdf_parser->buffer_size != size) {
+    RAPTOR_FREE(char*, rdf_parser->buffer);
+    rdf_parser->buffer = NULL;
+  }
+
+  if(!rdf_parser->buffer) {
+    rdf_parser->buffer = RAPTOR_MALLOC(unsigned char*, size + 1);
+    if(!rdf_parser->buffer) {
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return NULL;
+    }
+    rdf_parser->buffer_size = size;
+  }
+
+  *size_p = size;
+  return rdf_parser->buffer;
+}
+
+
+/*
+ * Parse the content of a mapped file as the chunks of a parse, in
+ * windows or whole if the parser prefers it.
+ */
+static int
+raptor_parser_parse_mapped_file(raptor_parser* rdf_parser,
+                                raptor_mapped_file* mapped)
+{
+  const unsigned char* p = mapped->data;
+  size_t remaining = mapped->length;
+  size_t window;
+  int rc = 0;
+
+  window = raptor_parser_get_read_buffer_size_option(rdf_parser);
+  if(!window)
+    window = RAPTOR_MMAP_WINDOW_SIZE;
+
+  if(rdf_parser->factory->mmap_whole_file)
+    window = remaining;
+
+  while(1) {
+    size_t len = (remaining < window) ? remaining : window;
+    int is_end = (len == remaining);
+
+    /* the mapping outlives the parse so the parser can borrow it */
+    rc = raptor_parser_parse_chunk_borrowed(rdf_parser, p, len, is_end,
+                                            NULL, NULL);
+    if(rc || is_end)
+      break;
+
+    p += len;
+    remaining -= len;
+  }
+
+  return rc;
+}
+
+
+/*
+ * Parse content read ahead by a reader thread into @buffers buffers
+ */
+static int
+raptor_parser_parse_read_ahead(raptor_parser* rdf_parser, int buffers,
+                               raptor_read_ahead_read_handler handler,
+                               void* user_data)
+{
+  raptor_read_ahead* ra;
+  size_t buffer_size;
+  int rc = 0;
+
+  if(buffers > RAPTOR_READ_AHEAD_MAX_BUFFERS)
+    buffers = RAPTOR_READ_AHEAD_MAX_BUFFERS;
+
+  buffer_size = raptor_parser_get_read_buffer_size_option(rdf_parser);
+  if(!buffer_size)
+    buffer_size = RAPTOR_READ_AHEAD_BUFFER_SIZE;
+
+  ra = raptor_new_read_ahead(rdf_parser->world, buffers,
+                             buffer_size, handler, user_data);
+  if(!ra) {
+    raptor_parser_fatal_error(rdf_parser, "Out of memory");
+    return 1;
+  }
+
+  while(1) {
+    unsigned char* buffer;
+    size_t len;
+    int status;
+
+    status = raptor_read_ahead_next(ra, &buffer, &len);
+    if(status < 0) {
+      raptor_parser_error(rdf_parser, "Failed to read content");
+      rc = 1;
+      break;
+    }
+
+    rc = raptor_parser_parse_chunk(rdf_parser, buffer, len, (status > 0));
+    if(rc || status > 0)
+      break;
+  }
+
+  raptor_free_read_ahead(ra);
+
+  return rc;
+}
+
+
+static int
+raptor_parser_read_file_stream(void* user_data, unsigned char* buffer,
+                               size_t size, size_t* len_p)
+{
+  FILE* stream = (FILE*)user_data;
+
+  *len_p = fread(buffer, 1, size, stream);
+
+  return (*len_p < size || feof(stream));
+}
+
+
+static int
+raptor_parser_read_iostream(void* user_data, unsigned char* buffer,
+                            size_t size, size_t* len_p)
+{
+  raptor_iostream* iostr = (raptor_iostream*)user_data;
+  int ilen;
+
+  ilen = raptor_iostream_read_bytes(buffer, 1, size, iostr);
+  if(ilen < 0)
+    return -1;
+  *len_p = RAPTOR_GOOD_CAST(size_t, ilen);
+
+  return (*len_p < size || raptor_iostream_read_eof(iostr));
+}
+
+
+/* Parse all content of an iostream after the parse was started */
+static int
+raptor_parser_parse_iostream_content(raptor_parser* rdf_parser,
+                                     raptor_iostream* iostr)
+{
+  int rc = 0;
+  int read_ahead;
+  unsigned char* buffer;
+  size_t buffer_size;
+
+  read_ahead = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_READ_AHEAD);
+  if(read_ahead > 1)
+    return raptor_parser_parse_read_ahead(rdf_parser, read_ahead,
+                                          raptor_parser_read_iostream, iostr);
+
+  buffer = raptor_parser_get_read_buffer(rdf_parser, &buffer_size);
+  if(!buffer)
+    return 1;
+  
+  while(!raptor_iostream_read_eof(iostr)) {
+    int ilen;
+    size_t len;
+    int is_end;
+
+    ilen = raptor_iostream_read_bytes(buffer, 1, buffer_size, iostr);
+    if(ilen < 0) {
+      raptor_parser_error(rdf_parser, "Failed to read content");
+      rc = 1;
+      break;
+    }
+    len = RAPTOR_GOOD_CAST(size_t, ilen);
+    is_end = (len < buffer_size);
+
+    rc = raptor_parser_parse_chunk(rdf_parser, buffer, len, is_end);
+    if(rc || is_end)
+      break;
+  }
+  
+  return rc;
+}
+
+
 /**
  * raptor_parser_parse_file_stream:
  * @rdf_parser: parser
@@ -526,6 +865,13 @@ raptor_free_parser(raptor_parser* rdf_parser)
  *
  * Parse RDF content from a FILE*.
  *
+ * Content compressed with gzip, bzip2 or zstd is detected from its
+ * magic bytes and decompressed, if raptor was built with the
+ * library for it.
+ *
+ * If #RAPTOR_OPTION_IO_QUEUE_DEPTH is set, uncompressed content of a
+ * regular file is read with that many large reads in flight.
+ *
  * After draining the FILE* stream (EOF), fclose is not called on it.
  *
  * Return value: non 0 on failure
@@ -537,6 +883,14 @@ raptor_parser_parse_file_stream(raptor_parser* rdf_parser,
 {
   int rc = 0;
   raptor_locator *locator = &rdf_parser->locator;
+  raptor_mapped_file mapped;
+  int read_ahead;
+  int queue_depth;
+  unsigned char* buffer;
+  size_t buffer_size;
+  unsigned char magic[RAPTOR_COMPRESSION_MAGIC_SIZE];
+  size_t magic_len;
+  raptor_compression compression;
 
   if(!stream || !base_uri)
     return 1;
@@ -546,12 +900,78 @@ raptor_parser_parse_file_stream(raptor_parser* rdf_parser,
 
   if(raptor_parser_parse_start(rdf_parser, base_uri))
     return 1;
+
+  /* Decompress compressed content, and content that cannot be read
+   * again after looking at its magic bytes such as from a pipe */
+  magic_len = fread(magic, 1, RAPTOR_COMPRESSION_MAGIC_SIZE, stream);
+  compression = raptor_compression_detect(magic, magic_len);
+  if(compression != RAPTOR_COMPRESSION_NONE ||
+     (magic_len &&
+      fseek(stream, -RAPTOR_GOOD_CAST(long, magic_len), SEEK_CUR))) {
+    raptor_iostream* iostr;
+
+    if(!raptor_compression_is_available(compression)) {
+      raptor_parser_error(rdf_parser,
+                          "Cannot read %s compressed content - not supported",
+                          raptor_compression_get_name(compression));
+      return 1;
+    }
+
+    iostr = raptor_new_iostream_decompress_file_handle(rdf_parser->world,
+                                                       stream, 0,
+                                                       magic, magic_len);
+    if(!iostr) {
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return 1;
+    }
+
+    rc = raptor_parser_parse_iostream_content(rdf_parser, iostr);
+    raptor_free_iostream(iostr);
+    return (rc != 0);
+  }
+
+  /* Queued reads of a regular file were asked for */
+  queue_depth = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser,
+                                           RAPTOR_OPTION_IO_QUEUE_DEPTH);
+  if(queue_depth > 0) {
+    raptor_iostream* iostr;
+    int buffer_size;
+
+    buffer_size = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser,
+                                             RAPTOR_OPTION_IO_BUFFER_SIZE);
+    iostr = raptor_new_iostream_from_file_handle_uring(rdf_parser->world,
+                                                       stream, queue_depth,
+                                                       (buffer_size > 0) ? RAPTOR_GOOD_CAST(size_t, buffer_size) : 0);
+    if(iostr) {
+      rc = raptor_parser_parse_iostream_content(rdf_parser, iostr);
+      raptor_free_iostream(iostr);
+      return (rc != 0);
+    }
+  }
+
+  if(!raptor_mapped_file_open(&mapped, stream, RAPTOR_MMAP_MIN_SIZE)) {
+    rc = raptor_parser_parse_mapped_file(rdf_parser, &mapped);
+    raptor_mapped_file_close(&mapped);
+    return (rc != 0);
+  }
+
+  read_ahead = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_READ_AHEAD);
+  if(read_ahead > 1) {
+    rc = raptor_parser_parse_read_ahead(rdf_parser, read_ahead,
+                                        raptor_parser_read_file_stream,
+                                        stream);
+    return (rc != 0);
+  }
   
-  while(!feof(stream)) {
-    size_t len = fread(rdf_parser->buffer, 1, RAPTOR_READ_BUFFER_SIZE, stream);
-    int is_end = (len < RAPTOR_READ_BUFFER_SIZE);
-    rdf_parser->buffer[len] = '\0';
-    rc = raptor_parser_parse_chunk(rdf_parser, rdf_parser->buffer, len, is_end);
+  buffer = raptor_parser_get_read_buffer(rdf_parser, &buffer_size);
+  if(!buffer)
+    return 1;
+
+  while(1) {
+    size_t len = fread(buffer, 1, buffer_size, stream);
+    int is_end = (len < buffer_size);
+    buffer[len] = '\0';
+    rc = raptor_parser_parse_chunk(rdf_parser, buffer, len, is_end);
     if(rc || is_end)
       break;
   }
@@ -568,6 +988,9 @@ raptor_parser_parse_file_stream(raptor_parser* rdf_parser,
  *
  * Parse RDF content at a file URI.
  *
+ * Compressed content is decompressed as described for
+ * raptor_parser_parse_file_stream().
+ *
  * If @uri is NULL (source is stdin), then the @base_uri is required.
  * 
  * Return value: non 0 on failure
@@ -739,6 +1162,7 @@ raptor_parser_parse_uri_with_connection(raptor_parser* rdf_parser,
   char* cert_passphrase = NULL;
   int ssl_verify_peer;
   int ssl_verify_host;
+  size_t www_buffer_size;
 
   if(connection) {
     if(rdf_parser->www)
@@ -763,6 +1187,13 @@ raptor_parser_parse_uri_with_connection(raptor_parser* rdf_parser,
     }
   }
 
+  www_buffer_size = raptor_parser_get_read_buffer_size_option(rdf_parser);
+  if(www_buffer_size &&
+     raptor_www_set_buffer_size(rdf_parser->www, www_buffer_size)) {
+    raptor_parser_fatal_error(rdf_parser, "Out of memory");
+    return 1;
+  }
+
   rpbc.rdf_parser = rdf_parser;
   rpbc.base_uri = base_uri;
   rpbc.final_uri = NULL;
@@ -976,6 +1407,12 @@ raptor_parser_set_statement_handler(raptor_parser* parser,
                                     void *user_data,
                                     raptor_statement_handler handler)
 {
+  if(parser->dedup) {
+    parser->dedup_user_data = user_data;
+    parser->dedup_statement_handler = handler;
+    return;
+  }
+
   parser->user_data = user_data;
   parser->statement_handler = handler;
 }
@@ -998,7 +1435,10 @@ raptor_parser_set_graph_mark_handler(raptor_parser* parser,
                                      void *user_data,
                                      raptor_graph_mark_handler handler)
 {
-  parser->user_data = user_data;
+  if(parser->dedup)
+    parser->dedup_user_data = user_data;
+  else
+    parser->user_data = user_data;
   parser->graph_mark_handler = handler;
 }
 
@@ -1047,6 +1487,33 @@ raptor_parser_set_uri_filter(raptor_parser* parser,
 }
 
 
+/**
+ * raptor_parser_set_dedup:
+ * @parser: parser object
+ * @limit: number of recent statements to remember or 0 to not remove duplicates
+ *
+ * Set the parser to not return duplicate statements.
+ *
+ * Statements, including their graph, that are the same as a recent
+ * distinct statement returned are not passed to the statement
+ * handler.  At least the last @limit / 2 and at most the last @limit
+ * distinct statements are remembered.  Memory use grows with @limit.
+ *
+ * This is the same as setting #RAPTOR_OPTION_DEDUP with
+ * raptor_parser_set_option() and takes effect from the next parse.
+ *
+ * Return value: non-0 on failure
+ **/
+int
+raptor_parser_set_dedup(raptor_parser* parser, int limit)
+{
+  if(limit < 0)
+    return 1;
+
+  return raptor_parser_set_option(parser, RAPTOR_OPTION_DEDUP, NULL, limit);
+}
+
+
 /**
  * raptor_parser_set_option:
  * @parser: #raptor_parser parser object
@@ -1257,6 +1724,14 @@ compare_syntax_score(const void *a, const void *b) {
 
 #define RAPTOR_MIN_GUESS_SCORE 2
 
+/* Only use first N bytes to avoid HTML documents that contain
+ * RDF/XML examples
+ */
+#define FIRSTN 1024
+#if FIRSTN > RAPTOR_READ_BUFFER_SIZE
+#error "RAPTOR_READ_BUFFER_SIZE is not large enough"
+#endif
+
 /**
  * raptor_world_guess_parser_name:
  * @world: world object
@@ -1286,6 +1761,7 @@ raptor_world_guess_parser_name(raptor_world* world,
   raptor_parser_factory *factory;
   unsigned char *suffix = NULL;
   struct syntax_score* scores;
+  unsigned char first[FIRSTN + 1];
 
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, raptor_world, NULL);
 
@@ -1325,6 +1801,14 @@ raptor_world_guess_parser_name(raptor_world* world,
     }
   }
 
+  if(buffer && len > FIRSTN) {
+    /* recognise a NUL terminated copy; @buffer may be read-only */
+    memcpy(first, buffer, FIRSTN);
+    first[FIRSTN] = '\0';
+    buffer = first;
+    len = FIRSTN;
+  }
+
   for(i = 0;
       (factory = (raptor_parser_factory*)raptor_sequence_get_at(world->parsers, i));
       i++) {
@@ -1364,29 +1848,11 @@ raptor_world_guess_parser_name(raptor_world* world,
         break;
     }
     
-    if(factory->recognise_syntax) {
-      int c = -1;
-    
-      /* Only use first N bytes to avoid HTML documents that contain
-       * RDF/XML examples
-       */
-#define FIRSTN 1024
-#if FIRSTN > RAPTOR_READ_BUFFER_SIZE
-#error "RAPTOR_READ_BUFFER_SIZE is not large enough"
-#endif
-      if(buffer && len && len > FIRSTN) {
-        c = buffer[FIRSTN];
-        ((char*)buffer)[FIRSTN] = '\0';
-      }
-
+    if(factory->recognise_syntax)
       score += factory->recognise_syntax(factory, buffer, len, 
                                          identifier, suffix, 
                                          mime_type);
 
-      if(c >= 0)
-        ((char*)buffer)[FIRSTN] = RAPTOR_GOOD_CAST(char, c);
-    }
-
     scores[i].score = score < 10 ? score : 10; 
     scores[i].factory = factory;
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 2
@@ -1444,8 +1910,12 @@ raptor_parser_copy_user_state(raptor_parser *to_parser,
 {
   int rc = 0;
   
-  to_parser->user_data = from_parser->user_data;
-  to_parser->statement_handler = from_parser->statement_handler;
+  /* the user's handler; @to_parser sets up its own dedup filter */
+  raptor_parser_set_statement_handler(to_parser,
+                                      RAPTOR_PARSER_USER_DATA(from_parser),
+                                      from_parser->dedup ?
+                                      from_parser->dedup_statement_handler :
+                                      from_parser->statement_handler);
   to_parser->namespace_handler = from_parser->namespace_handler;
   to_parser->namespace_handler_user_data = from_parser->namespace_handler_user_data;
   to_parser->uri_filter = from_parser->uri_filter;
@@ -1658,7 +2128,7 @@ raptor_parser_start_graph(raptor_parser* parser, raptor_uri* uri,
     return;
   
   if(parser->graph_mark_handler)
-    (*parser->graph_mark_handler)(parser->user_data, uri, flags);
+    (*parser->graph_mark_handler)(RAPTOR_PARSER_USER_DATA(parser), uri, flags);
 }
 
 
@@ -1673,7 +2143,7 @@ raptor_parser_end_graph(raptor_parser* parser, raptor_uri* uri, int is_declared)
     return;
   
   if(parser->graph_mark_handler)
-    (*parser->graph_mark_handler)(parser->user_data, uri, flags);
+    (*parser->graph_mark_handler)(RAPTOR_PARSER_USER_DATA(parser), uri, flags);
 }
 
 
@@ -1712,6 +2182,8 @@ raptor_parser_get_graph(raptor_parser* rdf_parser)
 }
 
 
+
+
 /**
  * raptor_parser_parse_iostream:
  * @rdf_parser: parser
@@ -1737,25 +2209,8 @@ raptor_parser_parse_iostream(raptor_parser* rdf_parser, raptor_iostream *iostr,
   rc = raptor_parser_parse_start(rdf_parser, base_uri);
   if(rc)
     return rc;
-  
-  while(!raptor_iostream_read_eof(iostr)) {
-    int ilen;
-    size_t len;
-    int is_end;
-
-    ilen = raptor_iostream_read_bytes(rdf_parser->buffer, 1,
-                                      RAPTOR_READ_BUFFER_SIZE, iostr);
-    if(ilen < 0)
-      break;
-    len = RAPTOR_GOOD_CAST(size_t, ilen);
-    is_end = (len < RAPTOR_READ_BUFFER_SIZE);
 
-    rc = raptor_parser_parse_chunk(rdf_parser, rdf_parser->buffer, len, is_end);
-    if(rc || is_end)
-      break;
-  }
-  
-  return rc;
+  return raptor_parser_parse_iostream_content(rdf_parser, iostr);
 }
 
 
@@ -1769,6 +2224,142 @@ raptor_parser_parse_iostream(raptor_parser* rdf_parser, raptor_iostream *iostr,
 int main(int argc, char *argv[]);
 
 
+static const char test_chunk_content[] =
+  "<http://example.org/s> <http://example.org/p> \"a \\\"quoted\\\" string\"@en-GB .\r\n"
+  "_:b1 <http://example.org/p> \"caf\\u00E9\"^^<http://example.org/dt> .\n"
+  "# comment\n"
+  "\n"
+  "<http://example.org/s> <http://example.org/p> _:b2 .   \n"
+  "<http://example.org/s> <http://example.org/p> <http://example.org/o>.";
+
+#define TEST_CHUNK_STATEMENTS_COUNT 4
+
+static void
+test_chunk_statement_handler(void *user_data, raptor_statement *statement)
+{
+  raptor_stringbuffer* sb = (raptor_stringbuffer*)user_data;
+  raptor_term* terms[3];
+  int i;
+
+  terms[0] = statement->subject;
+  terms[1] = statement->predicate;
+  terms[2] = statement->object;
+
+  for(i = 0; i < 3; i++) {
+    unsigned char* str = raptor_term_to_string(terms[i]);
+
+    raptor_stringbuffer_append_string(sb, str, 1);
+    raptor_stringbuffer_append_counted_string(sb, (const unsigned char*)" ", 1, 1);
+    raptor_free_memory(str);
+  }
+  raptor_stringbuffer_append_counted_string(sb, (const unsigned char*)".\n", 2, 1);
+}
+
+
+static void
+test_chunk_release_handler(void *user_data, const unsigned char *buffer,
+                           size_t len)
+{
+  (*(int*)user_data)++;
+  /* the parser must not use the chunk after this */
+  free((void*)buffer);
+}
+
+
+/* Parse the test content in chunks of every size up to the whole,
+ * each in a buffer of exactly that size freed when it is released
+ */
+static int
+test_parse_chunk_borrowed(raptor_world* world, const char* program)
+{
+  raptor_uri* base_uri;
+  raptor_parser* parser;
+  raptor_stringbuffer* expected_sb;
+  const unsigned char* expected;
+  size_t len = strlen(test_chunk_content);
+  size_t chunk_size;
+  int count = 0;
+  int rc = 0;
+
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  expected_sb = raptor_new_stringbuffer();
+
+  parser = raptor_new_parser(world, "ntriples");
+  raptor_parser_set_statement_handler(parser, expected_sb,
+                                      test_chunk_statement_handler);
+  raptor_parser_parse_start(parser, base_uri);
+  if(raptor_parser_parse_chunk(parser,
+                               (const unsigned char*)test_chunk_content,
+                               len, 1)) {
+    fprintf(stderr, "%s: parsing test content failed\n", program);
+    rc = 1;
+  }
+  raptor_free_parser(parser);
+
+  expected = raptor_stringbuffer_as_string(expected_sb);
+  for(chunk_size = 0; expected[chunk_size]; chunk_size++) {
+    if(expected[chunk_size] == '\n')
+      count++;
+  }
+  if(count != TEST_CHUNK_STATEMENTS_COUNT) {
+    fprintf(stderr, "%s: parsing test content returned %d statements, expected %d\n",
+            program, count, TEST_CHUNK_STATEMENTS_COUNT);
+    rc = 1;
+  }
+
+  for(chunk_size = 1; !rc && chunk_size <= len; chunk_size++) {
+    raptor_stringbuffer* sb = raptor_new_stringbuffer();
+    size_t offset;
+    int chunks = 0;
+    int released = 0;
+
+    parser = raptor_new_parser(world, "ntriples");
+    raptor_parser_set_statement_handler(parser, sb,
+                                        test_chunk_statement_handler);
+    raptor_parser_parse_start(parser, base_uri);
+
+    for(offset = 0; offset < len; offset += chunk_size) {
+      size_t size = (len - offset < chunk_size) ? len - offset : chunk_size;
+      unsigned char* chunk = (unsigned char*)malloc(size);
+
+      memcpy(chunk, test_chunk_content + offset, size);
+      chunks++;
+      if(raptor_parser_parse_chunk_borrowed(parser, chunk, size,
+                                            (offset + size == len),
+                                            test_chunk_release_handler,
+                                            &released)) {
+        fprintf(stderr, "%s: borrowed parse with chunk size %d failed\n",
+                program, (int)chunk_size);
+        rc = 1;
+        break;
+      }
+    }
+    raptor_free_parser(parser);
+
+    if(!rc && released != chunks) {
+      fprintf(stderr, "%s: chunk size %d released %d chunks, expected %d\n",
+              program, (int)chunk_size, released, chunks);
+      rc = 1;
+    }
+
+    if(!rc && strcmp((const char*)raptor_stringbuffer_as_string(sb),
+                     (const char*)expected)) {
+      fprintf(stderr, "%s: chunk size %d returned statements\n%s\nexpected\n%s\n",
+              program, (int)chunk_size,
+              raptor_stringbuffer_as_string(sb), expected);
+      rc = 1;
+    }
+
+    raptor_free_stringbuffer(sb);
+  }
+
+  raptor_free_stringbuffer(expected_sb);
+  raptor_free_uri(base_uri);
+
+  return rc;
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -1820,6 +2411,9 @@ main(int argc, char *argv[])
   }
   RAPTOR_FREE(char*, s);
 
+  if(test_parse_chunk_borrowed(world, program))
+    return 1;
+
   raptor_free_world(world);
   
   return 0;
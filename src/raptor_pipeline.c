@@ -0,0 +1,813 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_pipeline.c - Raptor serializer pipeline thread
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef RAPTOR_THREADS
+#include <pthread.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * Statements and namespace declarations from the producer, such as a
+ * parser's handlers, are added to batches in a ring.  Each serializer
+ * has a thread which takes the batches in the same order, so one
+ * stream of statements can be written by several serializers at
+ * once.  A batch is reused once every serializer thread has finished
+ * with it; the last one clears it.  Each statement holds a reference
+ * to its terms so the serializers may keep copies.  Batches are large
+ * so the hand-off is rare and a mutex and condition variables are
+ * cheap enough.
+ *
+ * Without thread support or if a thread cannot be started, that
+ * serializer is called directly by the producer.
+ */
+
+
+/* POLICY - statements and namespaces per batch */
+#define RAPTOR_PIPELINE_BATCH_SIZE 1024
+
+/* POLICY - batches in the ring */
+#define RAPTOR_PIPELINE_BATCHES 4
+
+
+typedef struct {
+  /* namespace to declare or NULL for a statement */
+  raptor_namespace* nspace;
+
+  /* statement holding a reference on each term */
+  raptor_statement statement;
+} raptor_pipeline_item;
+
+
+typedef struct {
+  raptor_pipeline* pipeline;
+
+  raptor_serializer* serializer;
+
+  /* non-0 if the serializer is called on its own thread */
+  int threaded;
+
+#ifdef RAPTOR_THREADS
+  pthread_t thread;
+
+  /* number of batches serialized (protected by the pipeline lock) */
+  unsigned long done;
+#endif
+} raptor_pipeline_consumer;
+
+
+struct raptor_pipeline_s {
+  raptor_world* world;
+
+  /* sequence of raptor_pipeline_consumer* */
+  raptor_sequence* consumers;
+
+  /* number of consumers with a thread */
+  int threads_count;
+
+  /* ring of batches and the number of items in each */
+  raptor_pipeline_item* batches[RAPTOR_PIPELINE_BATCHES];
+  int counts[RAPTOR_PIPELINE_BATCHES];
+
+  /* batch being filled by the producer */
+  int write_index;
+
+  /* non-0 if the producer holds the batch at write_index */
+  int filling;
+
+  /* namespace stack owning namespace copies (created when needed) */
+  raptor_namespace_stack* nstack;
+
+  /* count of inline serializer calls that failed since the last end */
+  int failures;
+
+#ifdef RAPTOR_THREADS
+  /* protects all fields below and consumer done counts */
+  pthread_mutex_t lock;
+
+  /* signalled when a batch is filled or the threads should stop */
+  pthread_cond_t filled_cond;
+
+  /* signalled when a batch is serialized by all threads */
+  pthread_cond_t free_cond;
+
+  /* number of batches handed off to the serializer threads */
+  unsigned long filled;
+
+  /* serializer threads yet to finish with each batch */
+  int pending[RAPTOR_PIPELINE_BATCHES];
+
+  /* count of threaded serializer calls that failed since the last end */
+  int threads_failures;
+
+  /* batches ready for the producer */
+  int free_count;
+
+  int stop;
+#endif
+};
+
+
+static void
+raptor_free_pipeline_consumer(void* data)
+{
+  RAPTOR_FREE(raptor_pipeline_consumer, data);
+}
+
+
+#ifdef RAPTOR_THREADS
+static int
+raptor_pipeline_serialize_item(raptor_serializer* serializer,
+                               raptor_pipeline_item* item)
+{
+  if(item->nspace)
+    return raptor_serializer_set_namespace_from_namespace(serializer,
+                                                          item->nspace);
+
+  return raptor_serializer_serialize_statement(serializer, &item->statement);
+}
+
+
+static void*
+raptor_pipeline_serializer_thread(void* arg)
+{
+  raptor_pipeline_consumer* consumer = (raptor_pipeline_consumer*)arg;
+  raptor_pipeline* pipeline = consumer->pipeline;
+
+  while(1) {
+    raptor_pipeline_item* batch;
+    int index;
+    int count;
+    int failures = 0;
+    int last;
+    int i;
+
+    pthread_mutex_lock(&pipeline->lock);
+    while(consumer->done == pipeline->filled && !pipeline->stop)
+      pthread_cond_wait(&pipeline->filled_cond, &pipeline->lock);
+    if(consumer->done == pipeline->filled) {
+      /* stopped and nothing left to do */
+      pthread_mutex_unlock(&pipeline->lock);
+      break;
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    /* the batch is not changed until every thread is done with it */
+    index = (int)(consumer->done % RAPTOR_PIPELINE_BATCHES);
+    batch = pipeline->batches[index];
+    count = pipeline->counts[index];
+    for(i = 0; i < count; i++) {
+      if(raptor_pipeline_serialize_item(consumer->serializer, &batch[i]))
+        failures++;
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->threads_failures += failures;
+    consumer->done++;
+    last = !--pipeline->pending[index];
+    pthread_mutex_unlock(&pipeline->lock);
+
+    if(!last)
+      continue;
+
+    for(i = 0; i < count; i++) {
+      if(batch[i].nspace) {
+        raptor_free_namespace(batch[i].nspace);
+        batch[i].nspace = NULL;
+      } else
+        raptor_statement_clear(&batch[i].statement);
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->free_count++;
+    pthread_cond_signal(&pipeline->free_cond);
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+
+  return NULL;
+}
+#endif
+
+
+/**
+ * raptor_new_pipeline:
+ * @world: raptor world
+ * @serializer: serializer to run on another thread or NULL
+ *
+ * Constructor - create a pipeline to serialize statements on threads
+ *
+ * Statements and namespaces given to
+ * raptor_pipeline_serialize_statement() and
+ * raptor_pipeline_set_namespace_from_namespace() are passed in
+ * batches to a thread that calls @serializer with them in the same
+ * order, so that producing statements, such as by parsing, and
+ * serializing them use two CPUs.  More serializers may be added with
+ * raptor_pipeline_add_serializer() to write the same statements in
+ * several syntaxes in parallel.
+ *
+ * Each serializer must be started before statements are added and
+ * must not be used by the caller until raptor_pipeline_end() returns.
+ * Typical use is to call raptor_pipeline_serialize_statement() from
+ * a parser statement handler and then raptor_pipeline_end() and
+ * raptor_serializer_serialize_end() after parsing.
+ *
+ * If raptor was built without thread support or a thread cannot be
+ * started, the serializer is called directly.
+ *
+ * Return value: new pipeline or NULL on failure
+ */
+raptor_pipeline*
+raptor_new_pipeline(raptor_world* world, raptor_serializer* serializer)
+{
+  raptor_pipeline* pipeline;
+#ifdef RAPTOR_THREADS
+  int i;
+#endif
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  raptor_world_open(world);
+
+  pipeline = RAPTOR_CALLOC(raptor_pipeline*, 1, sizeof(*pipeline));
+  if(!pipeline)
+    return NULL;
+
+  pipeline->world = world;
+
+#ifdef RAPTOR_THREADS
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->filled_cond, NULL);
+  pthread_cond_init(&pipeline->free_cond, NULL);
+  pipeline->free_count = RAPTOR_PIPELINE_BATCHES;
+#endif
+
+  pipeline->consumers = raptor_new_sequence(raptor_free_pipeline_consumer,
+                                            NULL);
+  if(!pipeline->consumers) {
+    raptor_free_pipeline(pipeline);
+    return NULL;
+  }
+
+#ifdef RAPTOR_THREADS
+  for(i = 0; i < RAPTOR_PIPELINE_BATCHES; i++) {
+    int j;
+
+    pipeline->batches[i] = RAPTOR_CALLOC(raptor_pipeline_item*,
+                                         RAPTOR_PIPELINE_BATCH_SIZE,
+                                         sizeof(raptor_pipeline_item));
+    if(!pipeline->batches[i]) {
+      raptor_free_pipeline(pipeline);
+      return NULL;
+    }
+    for(j = 0; j < RAPTOR_PIPELINE_BATCH_SIZE; j++)
+      raptor_statement_init(&pipeline->batches[i][j].statement, world);
+  }
+#endif
+
+  if(serializer && raptor_pipeline_add_serializer(pipeline, serializer)) {
+    raptor_free_pipeline(pipeline);
+    return NULL;
+  }
+
+  return pipeline;
+}
+
+
+/**
+ * raptor_free_pipeline:
+ * @pipeline: pipeline
+ *
+ * Destructor - serialize any remaining statements, stop the
+ * serializer threads and destroy the pipeline
+ *
+ * The serializers are not ended or freed.
+ */
+void
+raptor_free_pipeline(raptor_pipeline* pipeline)
+{
+  int i;
+
+  if(!pipeline)
+    return;
+
+#ifdef RAPTOR_THREADS
+  if(pipeline->threads_count) {
+    raptor_pipeline_end(pipeline);
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->stop = 1;
+    pthread_cond_broadcast(&pipeline->filled_cond);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    for(i = 0; i < raptor_sequence_size(pipeline->consumers); i++) {
+      raptor_pipeline_consumer* consumer;
+
+      consumer = (raptor_pipeline_consumer*)raptor_sequence_get_at(pipeline->consumers, i);
+      if(consumer->threaded) {
+        pthread_join(consumer->thread, NULL);
+        raptor_world_internal_threads_end(pipeline->world);
+      }
+    }
+  }
+
+  pthread_cond_destroy(&pipeline->free_cond);
+  pthread_cond_destroy(&pipeline->filled_cond);
+  pthread_mutex_destroy(&pipeline->lock);
+#endif
+
+  if(pipeline->consumers)
+    raptor_free_sequence(pipeline->consumers);
+
+  for(i = 0; i < RAPTOR_PIPELINE_BATCHES; i++) {
+    if(pipeline->batches[i])
+      RAPTOR_FREE(raptor_pipeline_item*, pipeline->batches[i]);
+  }
+
+  if(pipeline->nstack)
+    raptor_free_namespaces(pipeline->nstack);
+
+  RAPTOR_FREE(raptor_pipeline, pipeline);
+}
+
+
+/**
+ * raptor_pipeline_add_serializer:
+ * @pipeline: pipeline
+ * @serializer: serializer to run on another thread
+ *
+ * Add a serializer to a pipeline
+ *
+ * Every statement and namespace added to the pipeline afterwards is
+ * given to each of its serializers, each on its own thread and in the
+ * same order, so one parse can be written in several syntaxes in
+ * parallel.  The serializers should write to separate iostreams.
+ *
+ * This must be called before any statements are added or after
+ * raptor_pipeline_end().
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_pipeline_add_serializer(raptor_pipeline* pipeline,
+                               raptor_serializer* serializer)
+{
+  raptor_pipeline_consumer* consumer;
+
+  consumer = RAPTOR_CALLOC(raptor_pipeline_consumer*, 1, sizeof(*consumer));
+  if(!consumer)
+    return 1;
+
+  consumer->pipeline = pipeline;
+  consumer->serializer = serializer;
+
+  if(raptor_sequence_push(pipeline->consumers, consumer))
+    /* the consumer was freed by the sequence */
+    return 1;
+
+#ifdef RAPTOR_THREADS
+  /* the pipeline is idle so no lock is needed */
+  consumer->done = pipeline->filled;
+
+  /* the serializer thread shares the world with the producer */
+  raptor_world_internal_threads_start(pipeline->world);
+
+  if(pthread_create(&consumer->thread, NULL,
+                    raptor_pipeline_serializer_thread, consumer)) {
+    /* Could not start the thread: fall back to serializing inline */
+    raptor_world_internal_threads_end(pipeline->world);
+    raptor_log_error(pipeline->world, RAPTOR_LOG_LEVEL_WARN, NULL,
+                     "Failed to start serializer thread - serializing serially");
+  } else {
+    consumer->threaded = 1;
+    pipeline->threads_count++;
+  }
+#endif
+
+  return 0;
+}
+
+
+/* Call the serializers without threads directly */
+static void
+raptor_pipeline_serialize_inline(raptor_pipeline* pipeline,
+                                 raptor_statement* statement,
+                                 raptor_namespace* nspace)
+{
+  int i;
+
+  if(pipeline->threads_count == raptor_sequence_size(pipeline->consumers))
+    return;
+
+  for(i = 0; i < raptor_sequence_size(pipeline->consumers); i++) {
+    raptor_pipeline_consumer* consumer;
+    int rc;
+
+    consumer = (raptor_pipeline_consumer*)raptor_sequence_get_at(pipeline->consumers, i);
+    if(consumer->threaded)
+      continue;
+
+    if(nspace)
+      rc = raptor_serializer_set_namespace_from_namespace(consumer->serializer,
+                                                          nspace);
+    else
+      rc = raptor_serializer_serialize_statement(consumer->serializer,
+                                                 statement);
+    if(rc)
+      pipeline->failures++;
+  }
+}
+
+
+#ifdef RAPTOR_THREADS
+/* Pass the batch being filled to the serializer threads */
+static void
+raptor_pipeline_hand_off(raptor_pipeline* pipeline)
+{
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->pending[pipeline->write_index] = pipeline->threads_count;
+  pipeline->filled++;
+  pthread_cond_broadcast(&pipeline->filled_cond);
+  pthread_mutex_unlock(&pipeline->lock);
+
+  pipeline->write_index = (pipeline->write_index + 1) % RAPTOR_PIPELINE_BATCHES;
+  pipeline->filling = 0;
+}
+
+
+/* Get the next item to fill, waiting for a free batch if needed */
+static raptor_pipeline_item*
+raptor_pipeline_next_item(raptor_pipeline* pipeline)
+{
+  int index = pipeline->write_index;
+
+  if(!pipeline->filling) {
+    pthread_mutex_lock(&pipeline->lock);
+    while(!pipeline->free_count)
+      pthread_cond_wait(&pipeline->free_cond, &pipeline->lock);
+    pipeline->free_count--;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    pipeline->counts[index] = 0;
+    pipeline->filling = 1;
+  }
+
+  return &pipeline->batches[index][pipeline->counts[index]];
+}
+
+
+/* Count the item returned by raptor_pipeline_next_item() as added */
+static void
+raptor_pipeline_add_item(raptor_pipeline* pipeline)
+{
+  if(++pipeline->counts[pipeline->write_index] == RAPTOR_PIPELINE_BATCH_SIZE)
+    raptor_pipeline_hand_off(pipeline);
+}
+#endif
+
+
+/**
+ * raptor_pipeline_serialize_statement:
+ * @pipeline: pipeline
+ * @statement: statement to serialize
+ *
+ * Add a statement to be serialized by the pipeline's serializers
+ *
+ * The statement is not copied but a reference is taken on each of
+ * its terms, so @statement may be changed or freed after this
+ * returns.
+ *
+ * Return value: non-0 on failure; failures of the serializers are
+ * returned by raptor_pipeline_end()
+ */
+int
+raptor_pipeline_serialize_statement(raptor_pipeline* pipeline,
+                                    raptor_statement* statement)
+{
+#ifdef RAPTOR_THREADS
+  raptor_pipeline_item* item;
+
+  if(pipeline->threads_count) {
+    item = raptor_pipeline_next_item(pipeline);
+
+    item->nspace = NULL;
+    item->statement.subject = raptor_term_copy(statement->subject);
+    item->statement.predicate = raptor_term_copy(statement->predicate);
+    item->statement.object = raptor_term_copy(statement->object);
+    item->statement.graph = raptor_term_copy(statement->graph);
+
+    raptor_pipeline_add_item(pipeline);
+  }
+#endif
+
+  raptor_pipeline_serialize_inline(pipeline, statement, NULL);
+
+  return 0;
+}
+
+
+/**
+ * raptor_pipeline_set_namespace_from_namespace:
+ * @pipeline: pipeline
+ * @nspace: namespace to declare
+ *
+ * Add a namespace declaration for the pipeline's serializers
+ *
+ * The namespace is declared with
+ * raptor_serializer_set_namespace_from_namespace() after any
+ * statements added before it.  @nspace is copied.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_pipeline_set_namespace_from_namespace(raptor_pipeline* pipeline,
+                                             raptor_namespace* nspace)
+{
+#ifdef RAPTOR_THREADS
+  raptor_pipeline_item* item;
+  raptor_namespace* ns;
+
+  if(pipeline->threads_count) {
+    if(!pipeline->nstack) {
+      pipeline->nstack = raptor_new_namespaces(pipeline->world, 0);
+      if(!pipeline->nstack)
+        return 1;
+    }
+
+    ns = raptor_new_namespace_from_uri(pipeline->nstack, nspace->prefix,
+                                       nspace->uri, nspace->depth);
+    if(!ns)
+      return 1;
+
+    item = raptor_pipeline_next_item(pipeline);
+    item->nspace = ns;
+    raptor_pipeline_add_item(pipeline);
+  }
+#endif
+
+  raptor_pipeline_serialize_inline(pipeline, NULL, nspace);
+
+  return 0;
+}
+
+
+/**
+ * raptor_pipeline_end:
+ * @pipeline: pipeline
+ *
+ * Wait until all statements and namespaces added to the pipeline are
+ * serialized
+ *
+ * After this returns the serializers may be used by the caller, such
+ * as to call raptor_serializer_serialize_end(), and more statements
+ * or serializers may be added to the pipeline.
+ *
+ * Return value: number of serializer calls that failed since the last end
+ */
+int
+raptor_pipeline_end(raptor_pipeline* pipeline)
+{
+  int failures = 0;
+
+#ifdef RAPTOR_THREADS
+  if(pipeline->threads_count) {
+    if(pipeline->filling) {
+      if(pipeline->counts[pipeline->write_index])
+        raptor_pipeline_hand_off(pipeline);
+      else {
+        /* give back the unused batch */
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->free_count++;
+        pthread_mutex_unlock(&pipeline->lock);
+        pipeline->filling = 0;
+      }
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    while(pipeline->free_count < RAPTOR_PIPELINE_BATCHES)
+      pthread_cond_wait(&pipeline->free_cond, &pipeline->lock);
+    failures = pipeline->threads_failures;
+    pipeline->threads_failures = 0;
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+#endif
+
+  failures += pipeline->failures;
+  pipeline->failures = 0;
+
+  return failures;
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_STATEMENTS_COUNT 5000
+
+#define TEST_SYNTAXES_MAX 3
+
+
+/* Serialize statements through a pipeline to each syntax at once and
+ * compare each output with serializing them directly
+ */
+static int
+test_pipeline(const char* program, raptor_world* world,
+              const char* const* syntax_names, int syntaxes_count)
+{
+  raptor_uri* base_uri;
+  raptor_namespace_stack* nstack;
+  raptor_namespace* nspace;
+  raptor_serializer* serializers[TEST_SYNTAXES_MAX];
+  raptor_pipeline* pipeline = NULL;
+  raptor_statement* statement;
+  void* expected[TEST_SYNTAXES_MAX];
+  size_t expected_lens[TEST_SYNTAXES_MAX];
+  void* outputs[TEST_SYNTAXES_MAX];
+  size_t output_lens[TEST_SYNTAXES_MAX];
+  int pass;
+  int j;
+  int rc = 0;
+
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  nstack = raptor_new_namespaces(world, 0);
+  nspace = raptor_new_namespace_from_uri(nstack, (const unsigned char*)"ex",
+                                         base_uri, 0);
+
+  for(j = 0; j < syntaxes_count; j++) {
+    expected[j] = NULL;
+    outputs[j] = NULL;
+  }
+
+  for(pass = 0; pass < 2 && !rc; pass++) {
+    int i;
+
+    if(pass) {
+      pipeline = raptor_new_pipeline(world, NULL);
+      if(!pipeline) {
+        fprintf(stderr, "%s: raptor_new_pipeline() failed\n", program);
+        rc = 1;
+        break;
+      }
+    }
+
+    for(j = 0; j < syntaxes_count; j++) {
+      serializers[j] = raptor_new_serializer(world, syntax_names[j]);
+      raptor_serializer_start_to_string(serializers[j], base_uri,
+                                        pass ? &outputs[j] : &expected[j],
+                                        pass ? &output_lens[j] : &expected_lens[j]);
+      if(pipeline && raptor_pipeline_add_serializer(pipeline, serializers[j])) {
+        fprintf(stderr, "%s: raptor_pipeline_add_serializer() failed\n",
+                program);
+        rc = 1;
+      }
+    }
+
+    if(pipeline)
+      raptor_pipeline_set_namespace_from_namespace(pipeline, nspace);
+    else {
+      for(j = 0; j < syntaxes_count; j++)
+        raptor_serializer_set_namespace_from_namespace(serializers[j], nspace);
+    }
+
+    for(i = 0; i < TEST_STATEMENTS_COUNT; i++) {
+      unsigned char s[64];
+      unsigned char o[32];
+      raptor_term* subject;
+      raptor_term* object;
+      raptor_term* predicate;
+
+      snprintf((char*)s, sizeof(s), "http://example.org/s%d", i / 3);
+      snprintf((char*)o, sizeof(o), "literal %d", i);
+      subject = raptor_new_term_from_uri_string(world, s);
+      predicate = raptor_new_term_from_uri_string(world,
+                                                  (const unsigned char*)"http://example.org/p");
+      object = raptor_new_term_from_literal(world, o, NULL, NULL);
+      statement = raptor_new_statement_from_nodes(world, subject, predicate,
+                                                  object, NULL);
+
+      if(pipeline)
+        raptor_pipeline_serialize_statement(pipeline, statement);
+      else {
+        for(j = 0; j < syntaxes_count; j++)
+          raptor_serializer_serialize_statement(serializers[j], statement);
+      }
+
+      /* the pipeline must hold its own references */
+      raptor_free_statement(statement);
+    }
+
+    if(pipeline) {
+      if(raptor_pipeline_end(pipeline)) {
+        fprintf(stderr, "%s: pipeline returned failures\n", program);
+        rc = 1;
+      }
+      raptor_free_pipeline(pipeline);
+      pipeline = NULL;
+    }
+
+    for(j = 0; j < syntaxes_count; j++) {
+      raptor_serializer_serialize_end(serializers[j]);
+      raptor_free_serializer(serializers[j]);
+    }
+  }
+
+  for(j = 0; j < syntaxes_count; j++) {
+    if(!rc &&
+       (!expected[j] || !outputs[j] || output_lens[j] != expected_lens[j] ||
+        memcmp(outputs[j], expected[j], expected_lens[j]))) {
+      fprintf(stderr, "%s: %s pipeline output differs (%d bytes, expected %d)\n",
+              program, syntax_names[j], (int)output_lens[j],
+              (int)expected_lens[j]);
+      rc = 1;
+    }
+
+    if(expected[j])
+      raptor_free_memory(expected[j]);
+    if(outputs[j])
+      raptor_free_memory(outputs[j]);
+  }
+
+  raptor_free_namespace(nspace);
+  raptor_free_namespaces(nstack);
+  raptor_free_uri(base_uri);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  static const char* const tee_syntaxes[TEST_SYNTAXES_MAX] = {
+    "ntriples", "turtle", "nquads"
+  };
+  const char* syntaxes[TEST_SYNTAXES_MAX];
+  int syntaxes_count = 0;
+  int i;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  for(i = 0; i < TEST_SYNTAXES_MAX; i++) {
+    if(!raptor_world_is_serializer_name(world, tee_syntaxes[i]))
+      continue;
+
+    /* one serializer */
+    rc |= test_pipeline(program, world, &tee_syntaxes[i], 1);
+    syntaxes[syntaxes_count++] = tee_syntaxes[i];
+  }
+
+  /* all of them from one stream */
+  rc |= test_pipeline(program, world, syntaxes, syntaxes_count);
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
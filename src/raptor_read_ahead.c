@@ -0,0 +1,585 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_read_ahead.c - Raptor read-ahead reader thread
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef RAPTOR_THREADS
+#include <pthread.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * A ring of buffers is passed between one reader thread and the one
+ * consumer.  The reader fills free buffers in order and the consumer
+ * takes filled buffers in the same order, keeping the buffer it was
+ * last given until it asks for the next one.  Buffers are large so
+ * the hand-off is rare and a mutex and condition variables are cheap
+ * enough.
+ *
+ * Without thread support, with fewer than 2 buffers or if the thread
+ * cannot be started, the consumer reads into a single buffer itself.
+ */
+
+struct raptor_read_ahead_s {
+  raptor_world* world;
+
+  raptor_read_ahead_read_handler handler;
+  void* user_data;
+
+  /* ring of buffers, each with room for a trailing NUL */
+  unsigned char** buffers;
+  int buffers_count;
+  size_t buffer_size;
+
+  /* length and read status for each buffer */
+  size_t* lengths;
+  int* statuses;
+
+  /* next buffer to be given to the consumer */
+  int read_index;
+
+  /* non-0 if the consumer holds the buffer before read_index */
+  int holding;
+
+  /* non-0 after the consumer is given the last buffer */
+  int finished;
+
+#ifdef RAPTOR_THREADS
+  /* non-0 if the reader thread was started */
+  int threaded;
+
+  pthread_t thread;
+
+  /* protects all fields below */
+  pthread_mutex_t lock;
+
+  /* signalled when a buffer is filled */
+  pthread_cond_t filled_cond;
+
+  /* signalled when a buffer is freed or the reader should stop */
+  pthread_cond_t free_cond;
+
+  /* buffers ready for the consumer and for the reader */
+  int filled_count;
+  int free_count;
+
+  int stop;
+#endif
+};
+
+
+static int
+raptor_read_ahead_fill(raptor_read_ahead* ra, int index)
+{
+  size_t len = 0;
+  int status;
+
+  status = ra->handler(ra->user_data, ra->buffers[index], ra->buffer_size,
+                       &len);
+  if(status < 0 || len > ra->buffer_size)
+    len = 0;
+
+  ra->buffers[index][len] = '\0';
+  ra->lengths[index] = len;
+  ra->statuses[index] = status;
+
+  return status;
+}
+
+
+#ifdef RAPTOR_THREADS
+static void*
+raptor_read_ahead_reader(void* arg)
+{
+  raptor_read_ahead* ra = (raptor_read_ahead*)arg;
+  int write_index = 0;
+
+  while(1) {
+    int status;
+
+    pthread_mutex_lock(&ra->lock);
+    while(!ra->free_count && !ra->stop)
+      pthread_cond_wait(&ra->free_cond, &ra->lock);
+    if(ra->stop) {
+      pthread_mutex_unlock(&ra->lock);
+      break;
+    }
+    ra->free_count--;
+    pthread_mutex_unlock(&ra->lock);
+
+    /* the buffer is owned by this thread until it is counted filled */
+    status = raptor_read_ahead_fill(ra, write_index);
+
+    pthread_mutex_lock(&ra->lock);
+    ra->filled_count++;
+    pthread_cond_signal(&ra->filled_cond);
+    pthread_mutex_unlock(&ra->lock);
+
+    if(status)
+      break;
+
+    write_index = (write_index + 1) % ra->buffers_count;
+  }
+
+  return NULL;
+}
+#endif
+
+
+/**
+ * raptor_new_read_ahead:
+ * @world: raptor world
+ * @buffers: number of buffers
+ * @buffer_size: size of each buffer
+ * @handler: read handler
+ * @user_data: user data for @handler
+ *
+ * INTERNAL - Constructor - create a reader that reads ahead in a thread
+ *
+ * A reader thread calls @handler to fill up to @buffers buffers of
+ * @buffer_size bytes ahead of the consumer.  @handler is called from
+ * that thread only, one call at a time, until it returns non-0, so
+ * it must not use state the consumer uses meanwhile.
+ *
+ * If @buffers is less than 2, raptor was built without thread
+ * support or the thread cannot be started, @handler is called by
+ * raptor_read_ahead_next() instead.
+ *
+ * Return value: new reader or NULL on failure
+ */
+raptor_read_ahead*
+raptor_new_read_ahead(raptor_world* world, int buffers, size_t buffer_size,
+                      raptor_read_ahead_read_handler handler, void* user_data)
+{
+  raptor_read_ahead* ra;
+  int i;
+
+  ra = RAPTOR_CALLOC(raptor_read_ahead*, 1, sizeof(*ra));
+  if(!ra)
+    return NULL;
+
+  ra->world = world;
+  ra->handler = handler;
+  ra->user_data = user_data;
+  ra->buffer_size = buffer_size;
+
+#ifdef RAPTOR_THREADS
+  ra->buffers_count = (buffers < 2) ? 1 : buffers;
+#else
+  ra->buffers_count = 1;
+#endif
+
+  ra->buffers = RAPTOR_CALLOC(unsigned char**,
+                              RAPTOR_GOOD_CAST(size_t, ra->buffers_count),
+                              sizeof(unsigned char*));
+  ra->lengths = RAPTOR_CALLOC(size_t*,
+                              RAPTOR_GOOD_CAST(size_t, ra->buffers_count),
+                              sizeof(size_t));
+  ra->statuses = RAPTOR_CALLOC(int*,
+                               RAPTOR_GOOD_CAST(size_t, ra->buffers_count),
+                               sizeof(int));
+  if(!ra->buffers || !ra->lengths || !ra->statuses)
+    goto failed;
+
+  for(i = 0; i < ra->buffers_count; i++) {
+    ra->buffers[i] = RAPTOR_MALLOC(unsigned char*, buffer_size + 1);
+    if(!ra->buffers[i])
+      goto failed;
+  }
+
+#ifdef RAPTOR_THREADS
+  if(ra->buffers_count < 2)
+    return ra;
+
+  pthread_mutex_init(&ra->lock, NULL);
+  pthread_cond_init(&ra->filled_cond, NULL);
+  pthread_cond_init(&ra->free_cond, NULL);
+  ra->free_count = ra->buffers_count;
+
+  if(pthread_create(&ra->thread, NULL, raptor_read_ahead_reader, ra)) {
+    /* Could not start the thread: fall back to reading inline */
+    raptor_log_error(world, RAPTOR_LOG_LEVEL_WARN, NULL,
+                     "Failed to start reader thread - reading serially");
+    pthread_cond_destroy(&ra->free_cond);
+    pthread_cond_destroy(&ra->filled_cond);
+    pthread_mutex_destroy(&ra->lock);
+  } else
+    ra->threaded = 1;
+#endif
+
+  return ra;
+
+  failed:
+  raptor_free_read_ahead(ra);
+  return NULL;
+}
+
+
+/**
+ * raptor_free_read_ahead:
+ * @ra: reader
+ *
+ * INTERNAL - Destructor - stop the reader thread and destroy the reader
+ *
+ * This may be called before the last buffer is read; it waits for
+ * any call of the read handler in progress to return.
+ */
+void
+raptor_free_read_ahead(raptor_read_ahead* ra)
+{
+  int i;
+
+  if(!ra)
+    return;
+
+#ifdef RAPTOR_THREADS
+  if(ra->threaded) {
+    pthread_mutex_lock(&ra->lock);
+    ra->stop = 1;
+    pthread_cond_signal(&ra->free_cond);
+    pthread_mutex_unlock(&ra->lock);
+
+    pthread_join(ra->thread, NULL);
+
+    pthread_cond_destroy(&ra->free_cond);
+    pthread_cond_destroy(&ra->filled_cond);
+    pthread_mutex_destroy(&ra->lock);
+  }
+#endif
+
+  if(ra->buffers) {
+    for(i = 0; i < ra->buffers_count; i++) {
+      if(ra->buffers[i])
+        RAPTOR_FREE(char*, ra->buffers[i]);
+    }
+    RAPTOR_FREE(char**, ra->buffers);
+  }
+  if(ra->lengths)
+    RAPTOR_FREE(size_t*, ra->lengths);
+  if(ra->statuses)
+    RAPTOR_FREE(int*, ra->statuses);
+
+  RAPTOR_FREE(raptor_read_ahead, ra);
+}
+
+
+/**
+ * raptor_read_ahead_next:
+ * @ra: reader
+ * @buffer_p: pointer to store the next buffer
+ * @len_p: pointer to store the length of the next buffer
+ *
+ * INTERNAL - Get the next buffer of content, waiting until it is read
+ *
+ * The buffer stays valid and unchanged until the next call, may be
+ * written to by the caller, and has a NUL after @len_p bytes.  The
+ * buffer returned with the end of content may be empty.
+ *
+ * Return value: 0 if more content may follow, >0 at the end of content
+ * or <0 on a read error or if called after the end
+ */
+int
+raptor_read_ahead_next(raptor_read_ahead* ra, unsigned char** buffer_p,
+                       size_t* len_p)
+{
+  int index;
+
+  *buffer_p = NULL;
+  *len_p = 0;
+
+  if(ra->finished)
+    return -1;
+
+#ifdef RAPTOR_THREADS
+  if(ra->threaded) {
+    pthread_mutex_lock(&ra->lock);
+    if(ra->holding) {
+      ra->free_count++;
+      pthread_cond_signal(&ra->free_cond);
+    }
+    while(!ra->filled_count)
+      pthread_cond_wait(&ra->filled_cond, &ra->lock);
+    ra->filled_count--;
+    pthread_mutex_unlock(&ra->lock);
+  } else
+#endif
+    raptor_read_ahead_fill(ra, ra->read_index);
+
+  index = ra->read_index;
+  ra->read_index = (ra->read_index + 1) % ra->buffers_count;
+  ra->holding = 1;
+
+  if(ra->statuses[index])
+    ra->finished = 1;
+
+  *buffer_p = ra->buffers[index];
+  *len_p = ra->lengths[index];
+
+  return ra->statuses[index];
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_BUFFER_SIZE 1000
+#define TEST_CONTENT_SIZE 123457
+
+typedef struct {
+  /* bytes produced so far */
+  size_t offset;
+
+  /* size of content or 0 for endless content */
+  size_t size;
+
+  /* offset to fail at or 0 */
+  size_t fail_at;
+} test_source;
+
+
+static int
+test_read_handler(void* user_data, unsigned char* buffer, size_t size,
+                  size_t* len_p)
+{
+  test_source* source = (test_source*)user_data;
+  size_t len = size;
+  size_t i;
+
+  if(source->fail_at && source->offset >= source->fail_at)
+    return -1;
+
+  if(source->size && source->size - source->offset < len)
+    len = source->size - source->offset;
+
+  /* short reads must not be taken as the end */
+  if(len > 7 && (source->offset % 3) == 1)
+    len = 7;
+
+  for(i = 0; i < len; i++)
+    buffer[i] = (unsigned char)('a' + (source->offset + i) % 26);
+  source->offset += len;
+  *len_p = len;
+
+  return (source->size && source->offset == source->size);
+}
+
+
+static int
+test_read_ahead(const char* program, raptor_world* world, int buffers,
+                test_source* source, size_t stop_at)
+{
+  raptor_read_ahead* ra;
+  unsigned char* buffer;
+  size_t len;
+  size_t offset = 0;
+  int status;
+  int rc = 0;
+
+  ra = raptor_new_read_ahead(world, buffers, TEST_BUFFER_SIZE,
+                             test_read_handler, source);
+  if(!ra) {
+    fprintf(stderr, "%s: raptor_new_read_ahead(%d) failed\n", program,
+            buffers);
+    return 1;
+  }
+
+  do {
+    size_t i;
+
+    status = raptor_read_ahead_next(ra, &buffer, &len);
+    if(status < 0)
+      break;
+
+    if(buffer[len]) {
+      fprintf(stderr, "%s: %d buffers: buffer at %d is not NUL terminated\n",
+              program, buffers, (int)offset);
+      rc = 1;
+    }
+    for(i = 0; i < len; i++) {
+      if(buffer[i] != (unsigned char)('a' + (offset + i) % 26)) {
+        fprintf(stderr, "%s: %d buffers: wrong content at %d\n", program,
+                buffers, (int)(offset + i));
+        rc = 1;
+        break;
+      }
+    }
+    offset += len;
+
+    /* scribble over the buffer, which the reader must not reuse yet */
+    memset(buffer, '!', len);
+  } while(!status && (!stop_at || offset < stop_at));
+
+  if(source->fail_at) {
+    /* the reader stopped at the error so its offset may be read */
+    if(status >= 0 || offset != source->offset) {
+      fprintf(stderr, "%s: %d buffers: read error not returned at %d\n",
+              program, buffers, (int)offset);
+      rc = 1;
+    }
+  } else if(!stop_at) {
+    if(status <= 0 || offset != source->size) {
+      fprintf(stderr, "%s: %d buffers: read %d bytes, expected %d\n",
+              program, buffers, (int)offset, (int)source->size);
+      rc = 1;
+    }
+    if(raptor_read_ahead_next(ra, &buffer, &len) >= 0) {
+      fprintf(stderr, "%s: %d buffers: read past the end\n", program,
+              buffers);
+      rc = 1;
+    }
+  }
+
+  raptor_free_read_ahead(ra);
+
+  return rc;
+}
+
+
+#define TEST_LINES 20000
+
+static void
+test_statement_handler(void* user_data, raptor_statement* statement)
+{
+  (*(int*)user_data)++;
+}
+
+
+/* parse N-Triples from an iostream larger than several read buffers */
+static int
+test_parse_iostream(const char* program, raptor_world* world, int buffers)
+{
+  raptor_stringbuffer* sb;
+  raptor_iostream* iostr;
+  raptor_parser* parser;
+  raptor_uri* base_uri;
+  unsigned char line[100];
+  int count = 0;
+  int i;
+  int rc = 0;
+
+  sb = raptor_new_stringbuffer();
+  for(i = 0; i < TEST_LINES; i++) {
+    snprintf((char*)line, sizeof(line),
+             "<http://example.org/s%d> <http://example.org/p> \"%*d\" .\n",
+             i, 1 + (i % 37), i);
+    raptor_stringbuffer_append_string(sb, line, 1);
+  }
+
+  iostr = raptor_new_iostream_from_string(world,
+                                          raptor_stringbuffer_as_string(sb),
+                                          raptor_stringbuffer_length(sb));
+  parser = raptor_new_parser(world, "ntriples");
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  if(!iostr || !parser || !base_uri) {
+    fprintf(stderr, "%s: Failed to create parser\n", program);
+    exit(1);
+  }
+
+  raptor_parser_set_option(parser, RAPTOR_OPTION_READ_AHEAD, NULL, buffers);
+  raptor_parser_set_statement_handler(parser, &count, test_statement_handler);
+  if(raptor_parser_parse_iostream(parser, iostr, base_uri)) {
+    fprintf(stderr, "%s: %d buffers: Parsing failed\n", program, buffers);
+    rc = 1;
+  }
+  if(count != TEST_LINES) {
+    fprintf(stderr,
+            "%s: %d buffers: Parsing returned %d statements, expected %d\n",
+            program, buffers, count, TEST_LINES);
+    rc = 1;
+  }
+
+  raptor_free_uri(base_uri);
+  raptor_free_parser(parser);
+  raptor_free_iostream(iostr);
+  raptor_free_stringbuffer(sb);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  int buffers;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  for(buffers = 0; buffers <= 3; buffers++) {
+    test_source source;
+
+    /* whole content */
+    memset(&source, 0, sizeof(source));
+    source.size = TEST_CONTENT_SIZE;
+    rc |= test_read_ahead(program, world, buffers, &source, 0);
+
+    /* content that is a whole number of buffers */
+    memset(&source, 0, sizeof(source));
+    source.size = TEST_BUFFER_SIZE * 20;
+    rc |= test_read_ahead(program, world, buffers, &source, 0);
+
+    /* read error */
+    memset(&source, 0, sizeof(source));
+    source.size = TEST_CONTENT_SIZE;
+    source.fail_at = TEST_CONTENT_SIZE / 2;
+    rc |= test_read_ahead(program, world, buffers, &source, 0);
+
+    /* stopping early with endless content */
+    memset(&source, 0, sizeof(source));
+    rc |= test_read_ahead(program, world, buffers, &source,
+                          TEST_CONTENT_SIZE);
+
+    rc |= test_parse_iostream(program, world, buffers);
+  }
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
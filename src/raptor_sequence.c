@@ -564,6 +564,31 @@ raptor_sequence_sort_r(raptor_sequence* seq,
 }
 
 
+/**
+ * raptor_sequence_sort_parallel:
+ * @seq: sequence to sort
+ * @compare: comparison function with args (a, b)
+ * @pool: thread pool or NULL
+ *
+ * INTERNAL - Sort a sequence inline using the worker threads of a pool
+ *
+ * As raptor_sequence_sort() but the sort is shared between the
+ * workers of @pool with raptor_sort_parallel() so @compare must be
+ * safe to call from several threads at once.
+ */
+void
+raptor_sequence_sort_parallel(raptor_sequence* seq,
+                              raptor_data_compare_handler compare,
+                              raptor_thread_pool* pool)
+{
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN(seq, raptor_sequence);
+
+  if(seq->size > 1)
+    raptor_sort_parallel(&seq->sequence[seq->start],
+                         RAPTOR_GOOD_CAST(size_t, seq->size), compare, pool);
+}
+
+
 /**
  * raptor_sequence_print:
  * @seq: sequence to sort
@@ -779,6 +804,8 @@ raptor_sequence_print_string(void *data, FILE *fh)
 }
 
 #define assert_match_string(function, expr, string) do { char *result = expr; if(strcmp(result, string)) { fprintf(stderr, "%s:" #function " failed - returned %s, expected %s\n", program, result, string); exit(1); } } while(0)
+#define TEST_SORT_ITEMS 20000
+
 #define assert_match_int(function, expr, value) do { int result = expr; if(result != value) { fprintf(stderr, "%s:" #function " failed - returned %d, expected %d\n", program, result, value); exit(1); } } while(0)
 
 int
@@ -787,7 +814,10 @@ main(int argc, char *argv[])
   const char *program = raptor_basename(argv[0]);
   raptor_sequence* seq1 = raptor_new_sequence(NULL, raptor_sequence_print_string);
   raptor_sequence* seq2 = raptor_new_sequence(NULL, raptor_sequence_print_string);
+  raptor_world *world;
+  char *strings;
   char *s;
+  int threads;
   int i;
 
   if(raptor_sequence_pop(seq1) || raptor_sequence_unshift(seq1)) {
@@ -890,6 +920,47 @@ main(int argc, char *argv[])
   assert_match_int(raptor_sequence_size, raptor_sequence_size(seq1), 0);
   raptor_free_sequence(seq1);
 
+  /* test parallel sorting, with and without worker threads */
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  strings = (char*)malloc(TEST_SORT_ITEMS * 8);
+  if(!strings)
+    exit(1);
+  for(i = 0; i < TEST_SORT_ITEMS; i++)
+    sprintf(&strings[i * 8], "%07d", (i * 7919) % TEST_SORT_ITEMS);
+
+  for(threads = 0; threads <= 3; threads += 3) {
+    raptor_thread_pool* pool = raptor_new_thread_pool(world, threads);
+    if(!pool) {
+      fprintf(stderr, "%s: raptor_new_thread_pool failed\n", program);
+      exit(1);
+    }
+
+    seq1 = raptor_new_sequence(NULL, raptor_sequence_print_string);
+    for(i = 0; i < TEST_SORT_ITEMS; i++)
+      raptor_sequence_push(seq1, &strings[i * 8]);
+
+    raptor_sequence_sort_parallel(seq1, raptor_compare_strings, pool);
+
+    assert_match_int(raptor_sequence_size, raptor_sequence_size(seq1),
+                     TEST_SORT_ITEMS);
+    for(i = 0; i < TEST_SORT_ITEMS; i++) {
+      char expected[12];
+
+      sprintf(expected, "%07d", i);
+      s = (char*)raptor_sequence_get_at(seq1, i);
+      assert_match_string(raptor_sequence_sort_parallel, s, expected);
+    }
+
+    raptor_free_sequence(seq1);
+    raptor_free_thread_pool(pool);
+  }
+
+  free(strings);
+  raptor_free_world(world);
+
   return (0);
 }
 #endif
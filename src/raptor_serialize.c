@@ -115,6 +115,10 @@ raptor_serializers_init(raptor_world* world)
   rc += raptor_init_serializer_nquads(world) != 0;
 #endif
 
+#ifdef RAPTOR_SERIALIZER_BINARY
+  rc += raptor_init_serializer_binary(world) != 0;
+#endif
+
   return rc;
 }
 
@@ -394,6 +398,39 @@ raptor_serializer_start_to_iostream(raptor_serializer *rdf_serializer,
 }
 
 
+/*
+ * raptor_serializer_check_compression:
+ * @rdf_serializer: the #raptor_serializer
+ * @name: compression name or NULL
+ *
+ * Check that output can be written with the compression @name
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_serializer_check_compression(raptor_serializer *rdf_serializer,
+                                    const char *name)
+{
+  raptor_compression compression;
+
+  if(raptor_compression_from_name(name, &compression)) {
+    raptor_log_error_formatted(rdf_serializer->world, RAPTOR_LOG_LEVEL_ERROR,
+                               NULL, "Unknown output compression %s", name);
+    return 1;
+  }
+
+  if(!raptor_compression_is_writable(compression)) {
+    raptor_log_error_formatted(rdf_serializer->world, RAPTOR_LOG_LEVEL_ERROR,
+                               NULL,
+                               "Cannot write %s compressed output - not supported",
+                               name);
+    return 1;
+  }
+
+  return 0;
+}
+
+
 /**
  * raptor_serializer_start_to_filename:
  * @rdf_serializer:  the #raptor_serializer
@@ -401,13 +438,28 @@ raptor_serializer_start_to_iostream(raptor_serializer *rdf_serializer,
  *
  * Start serializing to a filename.
  * 
+ * The output is compressed if #RAPTOR_OPTION_COMPRESSION is set,
+ * otherwise it is written with #RAPTOR_OPTION_IO_QUEUE_DEPTH large
+ * writes in flight if that is set.
+ *
  * Return value: non-0 on failure.
  **/
 int
 raptor_serializer_start_to_filename(raptor_serializer *rdf_serializer,
                                     const char *filename)
 {
-  unsigned char *uri_string = raptor_uri_filename_to_uri_string(filename);
+  const char *compression;
+  raptor_compression compression_type;
+  int threads;
+  int queue_depth;
+  unsigned char *uri_string;
+
+  compression = RAPTOR_OPTIONS_GET_STRING(rdf_serializer,
+                                          RAPTOR_OPTION_COMPRESSION);
+  if(raptor_serializer_check_compression(rdf_serializer, compression))
+    return 1;
+
+  uri_string = raptor_uri_filename_to_uri_string(filename);
   if(!uri_string)
     return 1;
 
@@ -420,8 +472,31 @@ raptor_serializer_start_to_filename(raptor_serializer *rdf_serializer,
 
   RAPTOR_FREE(char*, uri_string);
 
-  rdf_serializer->iostream = raptor_new_iostream_to_filename(rdf_serializer->world,
-                                                             filename);
+  rdf_serializer->iostream = NULL;
+
+  /* Queued writes were asked for and the output is not compressed */
+  queue_depth = RAPTOR_OPTIONS_GET_NUMERIC(rdf_serializer,
+                                           RAPTOR_OPTION_IO_QUEUE_DEPTH);
+  if(queue_depth > 0 &&
+     !raptor_compression_from_name(compression, &compression_type) &&
+     compression_type == RAPTOR_COMPRESSION_NONE) {
+    int buffer_size;
+
+    buffer_size = RAPTOR_OPTIONS_GET_NUMERIC(rdf_serializer,
+                                             RAPTOR_OPTION_IO_BUFFER_SIZE);
+    rdf_serializer->iostream = raptor_new_iostream_to_filename_uring(rdf_serializer->world,
+                                                                     filename,
+                                                                     queue_depth,
+                                                                     (buffer_size > 0) ? RAPTOR_GOOD_CAST(size_t, buffer_size) : 0);
+  }
+
+  if(!rdf_serializer->iostream) {
+    threads = RAPTOR_OPTIONS_GET_NUMERIC(rdf_serializer, RAPTOR_OPTION_THREADS);
+    rdf_serializer->iostream = raptor_new_iostream_to_compressed_filename(rdf_serializer->world,
+                                                                          filename,
+                                                                          compression,
+                                                                          threads);
+  }
   if(!rdf_serializer->iostream)
     return 1;
 
@@ -483,6 +558,8 @@ raptor_serializer_start_to_string(raptor_serializer *rdf_serializer,
  *
  * Start serializing to a FILE*.
  * 
+ * The output is compressed if #RAPTOR_OPTION_COMPRESSION is set.
+ *
  * NOTE: This does not fclose the handle when it is finished.
  *
  * Return value: non-0 on failure.
@@ -491,6 +568,14 @@ int
 raptor_serializer_start_to_file_handle(raptor_serializer *rdf_serializer,
                                        raptor_uri *uri, FILE *fh) 
 {
+  const char *compression;
+  int threads;
+
+  compression = RAPTOR_OPTIONS_GET_STRING(rdf_serializer,
+                                          RAPTOR_OPTION_COMPRESSION);
+  if(raptor_serializer_check_compression(rdf_serializer, compression))
+    return 1;
+
   if(rdf_serializer->base_uri)
     raptor_free_uri(rdf_serializer->base_uri);
 
@@ -501,7 +586,11 @@ raptor_serializer_start_to_file_handle(raptor_serializer *rdf_serializer,
   rdf_serializer->locator.uri = rdf_serializer->base_uri;
   rdf_serializer->locator.line = rdf_serializer->locator.column = 0;
 
-  rdf_serializer->iostream = raptor_new_iostream_to_file_handle(rdf_serializer->world, fh);
+  threads = RAPTOR_OPTIONS_GET_NUMERIC(rdf_serializer, RAPTOR_OPTION_THREADS);
+  rdf_serializer->iostream = raptor_new_iostream_to_compressed_file_handle(rdf_serializer->world,
+                                                                           fh,
+                                                                           compression,
+                                                                           threads);
   if(!rdf_serializer->iostream)
     return 1;
 
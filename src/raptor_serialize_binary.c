@@ -0,0 +1,387 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_serialize_binary.c - Binary RDF serializer
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+/* Maximum number of terms in a block before the dictionary is reset */
+#ifndef RAPTOR_BINARY_BLOCK_TERMS
+#define RAPTOR_BINARY_BLOCK_TERMS 65536
+#endif
+
+/* Most terms a single statement can add: 4 terms and 4 datatypes */
+#define RAPTOR_BINARY_STATEMENT_MAX_TERMS 8
+
+
+typedef struct {
+  raptor_term* term;
+  unsigned long id;
+} raptor_binary_dictionary_entry;
+
+
+/*
+ * Raptor binary serializer object
+ */
+typedef struct {
+  /* term to raptor_binary_dictionary_entry for the current block */
+  raptor_avltree* dictionary;
+
+  /* number of terms in the current block */
+  unsigned long terms_count;
+} raptor_binary_serializer_context;
+
+
+
+static int
+raptor_binary_dictionary_entry_compare(const void* a, const void* b)
+{
+  const raptor_binary_dictionary_entry* e1;
+  const raptor_binary_dictionary_entry* e2;
+
+  e1 = (const raptor_binary_dictionary_entry*)a;
+  e2 = (const raptor_binary_dictionary_entry*)b;
+
+  return raptor_term_compare(e1->term, e2->term);
+}
+
+
+static void
+raptor_free_binary_dictionary_entry(void* data)
+{
+  raptor_binary_dictionary_entry* entry;
+
+  entry = (raptor_binary_dictionary_entry*)data;
+  raptor_free_term(entry->term);
+  RAPTOR_FREE(raptor_binary_dictionary_entry, entry);
+}
+
+
+static int
+raptor_binary_serialize_new_dictionary(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  if(context->dictionary)
+    raptor_free_avltree(context->dictionary);
+  context->terms_count = 0;
+
+  context->dictionary = raptor_new_avltree(raptor_binary_dictionary_entry_compare,
+                                           raptor_free_binary_dictionary_entry,
+                                           0);
+  return (context->dictionary == NULL);
+}
+
+
+/* create a new serializer */
+static int
+raptor_binary_serialize_init(raptor_serializer* serializer, const char *name)
+{
+  return raptor_binary_serialize_new_dictionary(serializer);
+}
+
+
+/* destroy a serializer */
+static void
+raptor_binary_serialize_terminate(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  if(context->dictionary) {
+    raptor_free_avltree(context->dictionary);
+    context->dictionary = NULL;
+  }
+}
+
+
+/* add a namespace */
+static int
+raptor_binary_serialize_declare_namespace(raptor_serializer* serializer,
+                                          raptor_uri *uri,
+                                          const unsigned char *prefix)
+{
+  /* NOP */
+  return 0;
+}
+
+
+static void
+raptor_binary_write_varint(unsigned long value, raptor_iostream* iostr)
+{
+  unsigned char buffer[16];
+  size_t len = 0;
+
+  while(value >= 0x80) {
+    buffer[len++] = RAPTOR_GOOD_CAST(unsigned char, (value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buffer[len++] = RAPTOR_GOOD_CAST(unsigned char, value);
+
+  raptor_iostream_write_bytes(buffer, 1, len, iostr);
+}
+
+
+static void
+raptor_binary_write_string(const unsigned char* string, size_t len,
+                           raptor_iostream* iostr)
+{
+  raptor_binary_write_varint(RAPTOR_GOOD_CAST(unsigned long, len), iostr);
+  if(len)
+    raptor_iostream_write_bytes(string, 1, len, iostr);
+}
+
+
+/*
+ * Find the dictionary index of @term, writing a term record and
+ * adding it to the dictionary if it is not yet in the current block.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_serialize_term(raptor_serializer* serializer,
+                             raptor_term* term, unsigned long* id_p)
+{
+  raptor_binary_serializer_context* context;
+  raptor_iostream* iostr = serializer->iostream;
+  raptor_binary_dictionary_entry key;
+  raptor_binary_dictionary_entry* entry;
+  unsigned long datatype_id = 0;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  key.term = term;
+  entry = (raptor_binary_dictionary_entry*)raptor_avltree_search(context->dictionary,
+                                                                 &key);
+  if(entry) {
+    *id_p = entry->id;
+    return 0;
+  }
+
+  if(term->type == RAPTOR_TERM_TYPE_LITERAL &&
+     term->value.literal.datatype) {
+    raptor_term* datatype_term;
+    int rc;
+
+    /* datatypes are stored as URI terms so they are shared */
+    datatype_term = raptor_new_term_from_uri(serializer->world,
+                                             term->value.literal.datatype);
+    if(!datatype_term)
+      return 1;
+    rc = raptor_binary_serialize_term(serializer, datatype_term, &datatype_id);
+    raptor_free_term(datatype_term);
+    if(rc)
+      return 1;
+    datatype_id++;
+  }
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      {
+        const unsigned char* uri_string;
+        size_t uri_len;
+
+        uri_string = raptor_uri_as_counted_string(term->value.uri, &uri_len);
+        raptor_iostream_write_byte(RAPTOR_BINARY_RECORD_URI, iostr);
+        raptor_binary_write_string(uri_string, uri_len, iostr);
+      }
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      raptor_iostream_write_byte(RAPTOR_BINARY_RECORD_BLANK, iostr);
+      raptor_binary_write_string(term->value.blank.string,
+                                 term->value.blank.string_len, iostr);
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      raptor_iostream_write_byte(RAPTOR_BINARY_RECORD_LITERAL, iostr);
+      raptor_binary_write_string(term->value.literal.string,
+                                 term->value.literal.string_len, iostr);
+      raptor_binary_write_varint(datatype_id, iostr);
+      raptor_binary_write_string(term->value.literal.language,
+                                 term->value.literal.language_len, iostr);
+      break;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      raptor_log_error_formatted(serializer->world, RAPTOR_LOG_LEVEL_ERROR,
+                                 NULL, "Triple has unsupported term type %d",
+                                 term->type);
+      return 1;
+  }
+
+  entry = RAPTOR_MALLOC(raptor_binary_dictionary_entry*, sizeof(*entry));
+  if(!entry)
+    return 1;
+
+  entry->term = raptor_term_copy(term);
+  if(!entry->term) {
+    RAPTOR_FREE(raptor_binary_dictionary_entry, entry);
+    return 1;
+  }
+  entry->id = context->terms_count++;
+
+  if(raptor_avltree_add(context->dictionary, entry))
+    return 1;
+
+  *id_p = entry->id;
+
+  return 0;
+}
+
+
+/* start a serialize */
+static int
+raptor_binary_serialize_start(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  if(context->terms_count && raptor_binary_serialize_new_dictionary(serializer))
+    return 1;
+
+  raptor_iostream_write_bytes(RAPTOR_BINARY_MAGIC, 1, RAPTOR_BINARY_MAGIC_LEN,
+                              serializer->iostream);
+  raptor_iostream_write_byte(RAPTOR_BINARY_VERSION, serializer->iostream);
+
+  return 0;
+}
+
+
+/* serialize a statement */
+static int
+raptor_binary_serialize_statement(raptor_serializer* serializer,
+                                  raptor_statement *statement)
+{
+  raptor_binary_serializer_context* context;
+  raptor_iostream* iostr = serializer->iostream;
+  raptor_term* terms[4];
+  unsigned long ids[4];
+  int count = 3;
+  int i;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  if(context->terms_count + RAPTOR_BINARY_STATEMENT_MAX_TERMS >
+     RAPTOR_BINARY_BLOCK_TERMS) {
+    raptor_iostream_write_byte(RAPTOR_BINARY_RECORD_RESET, iostr);
+    if(raptor_binary_serialize_new_dictionary(serializer))
+      return 1;
+  }
+
+  terms[0] = statement->subject;
+  terms[1] = statement->predicate;
+  terms[2] = statement->object;
+  terms[3] = statement->graph;
+  if(terms[3])
+    count = 4;
+
+  for(i = 0; i < count; i++) {
+    if(raptor_binary_serialize_term(serializer, terms[i], &ids[i]))
+      return 1;
+  }
+
+  raptor_iostream_write_byte((count == 4) ? RAPTOR_BINARY_RECORD_QUAD :
+                                            RAPTOR_BINARY_RECORD_TRIPLE,
+                             iostr);
+  for(i = 0; i < count; i++)
+    raptor_binary_write_varint(ids[i], iostr);
+
+  return 0;
+}
+
+
+/* end a serialize */
+static int
+raptor_binary_serialize_end(raptor_serializer* serializer)
+{
+  raptor_iostream_write_byte(RAPTOR_BINARY_RECORD_END, serializer->iostream);
+
+  return 0;
+}
+
+
+/* finish the serializer factory */
+static void
+raptor_binary_serialize_finish_factory(raptor_serializer_factory* factory)
+{
+
+}
+
+
+static const char* const binary_names[2] = { "binary", NULL};
+
+static const char* const binary_uri_strings[1] = {
+  NULL
+};
+
+#define BINARY_TYPES_COUNT 1
+static const raptor_type_q binary_types[BINARY_TYPES_COUNT + 1] = {
+  { "application/x-raptor-binary", 27, 10},
+  { NULL, 0, 0}
+};
+
+static int
+raptor_binary_serializer_register_factory(raptor_serializer_factory *factory)
+{
+  factory->desc.names = binary_names;
+  factory->desc.mime_types = binary_types;
+
+  factory->desc.label = "Raptor Binary RDF";
+  factory->desc.uri_strings = binary_uri_strings;
+
+  factory->context_length     = sizeof(raptor_binary_serializer_context);
+
+  factory->init                = raptor_binary_serialize_init;
+  factory->terminate           = raptor_binary_serialize_terminate;
+  factory->declare_namespace   = raptor_binary_serialize_declare_namespace;
+  factory->serialize_start     = raptor_binary_serialize_start;
+  factory->serialize_statement = raptor_binary_serialize_statement;
+  factory->serialize_end       = raptor_binary_serialize_end;
+  factory->finish_factory      = raptor_binary_serialize_finish_factory;
+
+  return 0;
+}
+
+
+int
+raptor_init_serializer_binary(raptor_world* world)
+{
+  return !raptor_serializer_register_factory(world,
+                                             &raptor_binary_serializer_register_factory);
+}
@@ -49,8 +49,9 @@ typedef struct {
   /* JSON writer object */
   raptor_json_writer* json_writer;
 
-  /* Ordered sequence of triples if is_resource */
-  raptor_avltree* avltree;
+  /* Ordered set of triples if is_resource; written to sorted runs
+   * on disk past RAPTOR_OPTION_MEMORY_LIMIT */
+  raptor_statement_sorter* sorter;
 
   /* Last statement generated if is_resource (shared pointer) */
   raptor_statement* last_statement;
@@ -101,9 +102,9 @@ raptor_json_serialize_terminate(raptor_serializer* serializer)
     context->json_writer = NULL;
   }
 
-  if(context->avltree) {
-    raptor_free_avltree(context->avltree);
-    context->avltree = NULL;
+  if(context->sorter) {
+    raptor_free_statement_sorter(context->sorter);
+    context->sorter = NULL;
   }
 }
 
@@ -125,14 +126,28 @@ raptor_json_serialize_start(raptor_serializer* serializer)
     return 1;
 
   if(context->is_resource) {
-    context->avltree = raptor_new_avltree((raptor_data_compare_handler)raptor_statement_compare,
-                                          (raptor_data_free_handler)raptor_free_statement,
-                                          0);
-    if(!context->avltree) {
+    int memory_limit;
+
+    memory_limit = RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                              RAPTOR_OPTION_MEMORY_LIMIT);
+    if(memory_limit < 0)
+      memory_limit = 0;
+
+    if(context->sorter)
+      raptor_free_statement_sorter(context->sorter);
+    context->last_statement = NULL;
+
+    context->sorter = raptor_new_statement_sorter(serializer->world,
+                                                  RAPTOR_GOOD_CAST(size_t, memory_limit) * 1024);
+    if(!context->sorter) {
       raptor_free_json_writer(context->json_writer);
       context->json_writer = NULL;
       return 1;
     }
+
+    raptor_statement_sorter_set_threads(context->sorter,
+                                        RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                                                   RAPTOR_OPTION_THREADS));
   }
 
   /* start callback */
@@ -164,12 +179,8 @@ raptor_json_serialize_statement(raptor_serializer* serializer,
 {
   raptor_json_context* context = (raptor_json_context*)serializer->context;
 
-  if(context->is_resource) {
-    raptor_statement* s = raptor_statement_copy(statement);
-    if(!s)
-      return 1;
-    return raptor_avltree_add(context->avltree, s);
-  }
+  if(context->is_resource)
+    return raptor_statement_sorter_add(context->sorter, statement);
 
   if(context->need_subject_comma) {
     raptor_iostream_write_byte(',', serializer->iostream);
@@ -208,14 +219,13 @@ raptor_json_serialize_statement(raptor_serializer* serializer,
 }
 
 
-/* return 0 to abort visit */
+/* return non-0 to abort visit */
 static int
-raptor_json_serialize_avltree_visit(int depth, void* data, void *user_data)
+raptor_json_serialize_sorter_visit(void *user_data, raptor_statement* statement)
 {
   raptor_serializer* serializer = (raptor_serializer*)user_data;
   raptor_json_context* context = (raptor_json_context*)serializer->context;
 
-  raptor_statement* statement = (raptor_statement*)data;
   raptor_statement* s1 = statement;
   raptor_statement* s2 = context->last_statement;
   int new_subject = 0;
@@ -328,7 +338,7 @@ raptor_json_serialize_avltree_visit(int depth, void* data, void *user_data)
   context->need_object_comma = 1;
   context->last_statement = statement;
 
-  return 1;
+  return 0;
 }
 
 
@@ -345,9 +355,9 @@ raptor_json_serialize_end(raptor_serializer* serializer)
     raptor_json_writer_start_block(context->json_writer, '{');
     raptor_json_writer_newline(context->json_writer);
     
-    raptor_avltree_visit(context->avltree,
-                         raptor_json_serialize_avltree_visit,
-                         serializer);
+    raptor_statement_sorter_visit(context->sorter,
+                                  raptor_json_serialize_sorter_visit,
+                                  serializer);
 
     /* end last triples block */
     if(context->last_statement) {
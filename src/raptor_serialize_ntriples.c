@@ -46,6 +46,9 @@
  */
 typedef struct {
   int is_nquads;
+
+  /* Ordered set of statements when writing sorted unique output */
+  raptor_statement_sorter* sorter;
 } raptor_ntriples_serializer_context;
 
 
@@ -67,7 +70,14 @@ raptor_ntriples_serialize_init(raptor_serializer* serializer, const char *name)
 static void
 raptor_ntriples_serialize_terminate(raptor_serializer* serializer)
 {
+  raptor_ntriples_serializer_context* ntriples_serializer;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
 
+  if(ntriples_serializer->sorter) {
+    raptor_free_statement_sorter(ntriples_serializer->sorter);
+    ntriples_serializer->sorter = NULL;
+  }
 }
   
 
@@ -82,14 +92,38 @@ raptor_ntriples_serialize_declare_namespace(raptor_serializer* serializer,
 }
 
 
-#if 0
 /* start a serialize */
 static int
 raptor_ntriples_serialize_start(raptor_serializer* serializer)
 {
+  raptor_ntriples_serializer_context* ntriples_serializer;
+  int memory_limit;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
+
+  if(ntriples_serializer->sorter) {
+    raptor_free_statement_sorter(ntriples_serializer->sorter);
+    ntriples_serializer->sorter = NULL;
+  }
+
+  if(!RAPTOR_OPTIONS_GET_NUMERIC(serializer, RAPTOR_OPTION_SORT_UNIQUE))
+    return 0;
+
+  memory_limit = RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                            RAPTOR_OPTION_MEMORY_LIMIT);
+  if(memory_limit < 0)
+    memory_limit = 0;
+
+  ntriples_serializer->sorter = raptor_new_statement_sorter(serializer->world,
+                                                            RAPTOR_GOOD_CAST(size_t, memory_limit) * 1024);
+  if(!ntriples_serializer->sorter)
+    return 1;
+
+  raptor_statement_sorter_set_threads(ntriples_serializer->sorter,
+                                      RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                                                 RAPTOR_OPTION_THREADS));
   return 0;
 }
-#endif
 
 
 
@@ -170,6 +204,73 @@ raptor_term_ntriples_write(const raptor_term *term, raptor_iostream* iostr)
 }
 
 
+/* add a term to a batch, without copying or escaping it if possible */
+static int
+raptor_ntriples_batch_term(raptor_iostream_batch* batch,
+                           const raptor_term *term, unsigned int flags)
+{
+  raptor_uri* datatype = NULL;
+  const unsigned char* string;
+  size_t len;
+  size_t datatype_len = 0;
+  const unsigned char* datatype_string = NULL;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      string = raptor_uri_as_counted_string(term->value.uri, &len);
+      if(raptor_string_needs_escapes(string, len, '>',
+                                     RAPTOR_ESCAPED_WRITE_NTRIPLES_URI))
+        break;
+      raptor_iostream_batch_copy(batch, "<", 1);
+      raptor_iostream_batch_add(batch, string, len);
+      return raptor_iostream_batch_copy(batch, ">", 1);
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      raptor_iostream_batch_copy(batch, "_:", 2);
+      return raptor_iostream_batch_add(batch, term->value.blank.string,
+                                       term->value.blank.string_len);
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      string = term->value.literal.string;
+      len = term->value.literal.string_len;
+      if(raptor_string_needs_escapes(string, len, '"', flags))
+        break;
+      datatype = term->value.literal.datatype;
+      if(datatype) {
+        datatype_string = raptor_uri_as_counted_string(datatype,
+                                                       &datatype_len);
+        if(raptor_string_needs_escapes(datatype_string, datatype_len, '>',
+                                       RAPTOR_ESCAPED_WRITE_NTRIPLES_URI))
+          break;
+      }
+
+      raptor_iostream_batch_copy(batch, "\"", 1);
+      raptor_iostream_batch_add(batch, string, len);
+      raptor_iostream_batch_copy(batch, "\"", 1);
+      if(term->value.literal.language) {
+        raptor_iostream_batch_copy(batch, "@", 1);
+        raptor_iostream_batch_add(batch, term->value.literal.language,
+                                  term->value.literal.language_len);
+      }
+      if(datatype) {
+        raptor_iostream_batch_copy(batch, "^^<", 3);
+        raptor_iostream_batch_add(batch, datatype_string, datatype_len);
+        raptor_iostream_batch_copy(batch, ">", 1);
+      }
+      return batch->failed;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  /* write anything else in order after the batched content */
+  if(raptor_iostream_batch_flush(batch))
+    return 1;
+  return raptor_term_escaped_write(term, flags, batch->iostr);
+}
+
+
 /**
  * raptor_statement_ntriples_write:
  * @statement: statement to write
@@ -187,29 +288,36 @@ raptor_statement_ntriples_write(const raptor_statement *statement,
                                 int write_graph_term)
 {
   unsigned int flags = RAPTOR_ESCAPED_WRITE_NTRIPLES_LITERAL;
+  raptor_iostream_batch batch;
 
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(statement, raptor_statement, 1);
 
-  if(raptor_term_escaped_write(statement->subject, flags, iostr))
+  /* Collect the terms of the statement to write with a single
+   * raptor_iostream_write_iov() call in the common case that they
+   * need no escapes.
+   */
+  raptor_iostream_batch_init(&batch, iostr);
+
+  if(raptor_ntriples_batch_term(&batch, statement->subject, flags))
     return 1;
   
-  raptor_iostream_write_byte(' ', iostr);
-  if(raptor_term_escaped_write(statement->predicate, flags, iostr))
+  raptor_iostream_batch_copy(&batch, " ", 1);
+  if(raptor_ntriples_batch_term(&batch, statement->predicate, flags))
     return 1;
   
-  raptor_iostream_write_byte(' ', iostr);
-  if(raptor_term_escaped_write(statement->object, flags, iostr))
+  raptor_iostream_batch_copy(&batch, " ", 1);
+  if(raptor_ntriples_batch_term(&batch, statement->object, flags))
     return 1;
 
   if(statement->graph && write_graph_term) {
-    raptor_iostream_write_byte(' ', iostr);
-    if(raptor_term_escaped_write(statement->graph, flags, iostr))
+    raptor_iostream_batch_copy(&batch, " ", 1);
+    if(raptor_ntriples_batch_term(&batch, statement->graph, flags))
       return 1;
   }
   
-  raptor_iostream_counted_string_write(" .\n", 3, iostr);
+  raptor_iostream_batch_copy(&batch, " .\n", 3);
 
-  return 0;
+  return raptor_iostream_batch_flush(&batch);
 }
 
 
@@ -222,6 +330,23 @@ raptor_ntriples_serialize_statement(raptor_serializer* serializer,
 
   ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
 
+  if(ntriples_serializer->sorter) {
+    raptor_statement triple;
+
+    if(ntriples_serializer->is_nquads)
+      return raptor_statement_sorter_add(ntriples_serializer->sorter,
+                                         statement) < 0;
+
+    /* the graph is not written so must not make triples distinct */
+    raptor_statement_init(&triple, serializer->world);
+    triple.subject = statement->subject;
+    triple.predicate = statement->predicate;
+    triple.object = statement->object;
+
+    return raptor_statement_sorter_add(ntriples_serializer->sorter,
+                                       &triple) < 0;
+  }
+
   raptor_statement_ntriples_write(statement,
                                   serializer->iostream,
                                   ntriples_serializer->is_nquads);
@@ -229,14 +354,42 @@ raptor_ntriples_serialize_statement(raptor_serializer* serializer,
 }
 
 
-#if 0
+static int
+raptor_ntriples_serialize_sorter_visit(void* user_data,
+                                       raptor_statement* statement)
+{
+  raptor_serializer* serializer = (raptor_serializer*)user_data;
+  raptor_ntriples_serializer_context* ntriples_serializer;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
+
+  return raptor_statement_ntriples_write(statement,
+                                         serializer->iostream,
+                                         ntriples_serializer->is_nquads);
+}
+
+
 /* end a serialize */
 static int
 raptor_ntriples_serialize_end(raptor_serializer* serializer)
 {
-  return 0;
+  raptor_ntriples_serializer_context* ntriples_serializer;
+  int rc;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
+
+  if(!ntriples_serializer->sorter)
+    return 0;
+
+  rc = raptor_statement_sorter_visit(ntriples_serializer->sorter,
+                                     raptor_ntriples_serialize_sorter_visit,
+                                     serializer);
+
+  raptor_free_statement_sorter(ntriples_serializer->sorter);
+  ntriples_serializer->sorter = NULL;
+
+  return rc;
 }
-#endif
   
 /* finish the serializer factory */
 static void
@@ -276,9 +429,9 @@ raptor_ntriples_serializer_register_factory(raptor_serializer_factory *factory)
   factory->init                = raptor_ntriples_serialize_init;
   factory->terminate           = raptor_ntriples_serialize_terminate;
   factory->declare_namespace   = raptor_ntriples_serialize_declare_namespace;
-  factory->serialize_start     = NULL;
+  factory->serialize_start     = raptor_ntriples_serialize_start;
   factory->serialize_statement = raptor_ntriples_serialize_statement;
-  factory->serialize_end       = NULL;
+  factory->serialize_end       = raptor_ntriples_serialize_end;
   factory->finish_factory      = raptor_ntriples_serialize_finish_factory;
 
   return 0;
@@ -314,9 +467,9 @@ raptor_nquads_serializer_register_factory(raptor_serializer_factory *factory)
   factory->init                = raptor_ntriples_serialize_init;
   factory->terminate           = raptor_ntriples_serialize_terminate;
   factory->declare_namespace   = raptor_ntriples_serialize_declare_namespace;
-  factory->serialize_start     = NULL;
+  factory->serialize_start     = raptor_ntriples_serialize_start;
   factory->serialize_statement = raptor_ntriples_serialize_statement;
-  factory->serialize_end       = NULL;
+  factory->serialize_end       = raptor_ntriples_serialize_end;
   factory->finish_factory      = raptor_ntriples_serialize_finish_factory;
 
   return 0;
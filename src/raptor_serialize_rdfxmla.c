@@ -855,15 +855,18 @@ raptor_rdfxmla_serialize_init(raptor_serializer* serializer, const char *name)
 
   context->subjects =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_subject_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_subject, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_subject,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
 
   context->blanks =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_subject_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_subject, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_subject,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
   
   context->nodes =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_node_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_node, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_node,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
 
   type_term = RAPTOR_RDF_type_term(serializer->world);
   context->rdf_type = raptor_new_abbrev_node(serializer->world, type_term);
@@ -290,6 +290,30 @@ raptor_rss10_serialize_terminate(raptor_serializer* serializer)
 }
   
 
+/*
+ * raptor_rss10_copy_literal_string:
+ * @term: literal term
+ *
+ * INTERNAL - Copy the string of a literal term for a field value
+ *
+ * The term is not modified since terms may be shared.
+ *
+ * Return value: new string or NULL on failure
+ */
+static unsigned char*
+raptor_rss10_copy_literal_string(raptor_term* term)
+{
+  size_t len = term->value.literal.string_len;
+  unsigned char* string;
+
+  string = RAPTOR_MALLOC(unsigned char*, len + 1);
+  if(string)
+    memcpy(string, term->value.literal.string, len + 1);
+
+  return string;
+}
+
+
 /**
  * raptor_rss10_move_statements:
  * @rss_serializer: serializer object
@@ -358,10 +382,9 @@ raptor_rss10_move_statements(raptor_rss10_serializer_context *rss_serializer,
          * object value over 
          */
         if(s->object->type == RAPTOR_TERM_TYPE_URI) {
-          field->uri = s->object->value.uri;
-          s->object->value.uri = NULL;
+          field->uri = raptor_uri_copy(s->object->value.uri);
         } else {
-          field->value = s->object->value.literal.string;
+          field->value = raptor_rss10_copy_literal_string(s->object);
           if(s->object->value.literal.datatype &&
              raptor_uri_equals(s->object->value.literal.datatype,
                                rss_serializer->xml_literal_dt))
@@ -372,8 +395,6 @@ raptor_rss10_move_statements(raptor_rss10_serializer_context *rss_serializer,
 
           if(f == RAPTOR_RSS_FIELD_ATOM_SUMMARY && *field->value == '<')
             field->is_xml = 1;
-
-          s->object->value.literal.string = NULL;
         }
 
         if(is_atom) { 
@@ -676,11 +697,10 @@ raptor_rss10_store_statement(raptor_rss10_serializer_context *rss_serializer,
         field = raptor_rss_new_field(rss_serializer->world);
 
         if(s->object->type == RAPTOR_TERM_TYPE_URI) {
-          field->uri = s->object->value.uri;
-          s->object->value.uri = NULL;
+          field->uri = raptor_uri_copy(s->object->value.uri);
         } else {
           /* must be literal - checked above */
-          field->value = s->object->value.literal.string;
+          field->value = raptor_rss10_copy_literal_string(s->object);
 
           if(s->object->value.literal.datatype &&
              raptor_uri_equals(s->object->value.literal.datatype,
@@ -692,7 +712,6 @@ raptor_rss10_store_statement(raptor_rss10_serializer_context *rss_serializer,
 
           if(f == RAPTOR_RSS_FIELD_ATOM_SUMMARY && *field->value == '<')
             field->is_xml = 1;
-          s->object->value.literal.string = NULL;
         }
 
         if(is_atom) { 
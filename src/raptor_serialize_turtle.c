@@ -1047,6 +1047,220 @@ raptor_turtle_emit_subject(raptor_serializer *serializer,
 }
 
 
+/* POLICY - number of blocks of subjects queued per worker thread */
+#define RAPTOR_TURTLE_BLOCKS_PER_THREAD 4
+
+/*
+ * A contiguous run of top-level subjects emitted by one worker into
+ * its own string.  The serializer and context are shallow copies of
+ * the real ones so that the emit functions can be used unchanged
+ * with a private turtle writer.
+ */
+typedef struct {
+  raptor_serializer serializer;
+  raptor_turtle_context context;
+
+  raptor_abbrev_subject** subjects;
+  int subjects_count;
+
+  unsigned char* string;
+  size_t string_len;
+} raptor_turtle_emit_block;
+
+
+/*
+ * raptor_turtle_emit_subject_is_top_level:
+ * @subject: subject
+ *
+ * Check if a subject is emitted at depth 0 - the same tests that
+ * raptor_turtle_emit_subject() makes at depth 0 before writing
+ * anything.
+ *
+ * Return value: non-0 if the subject is written at the top level
+ */
+static int
+raptor_turtle_emit_subject_is_top_level(raptor_abbrev_subject* subject)
+{
+  if(!raptor_abbrev_subject_valid(subject))
+    return 0;
+
+  if(subject->node->term->type == RAPTOR_TERM_TYPE_BLANK &&
+     subject->node->count_as_subject == 1 &&
+     subject->node->count_as_object == 1)
+    return 0;
+
+  return raptor_avltree_size(subject->properties) > 0;
+}
+
+
+static int
+raptor_turtle_emit_block_run(void* data)
+{
+  raptor_turtle_emit_block* block = (raptor_turtle_emit_block*)data;
+  raptor_serializer* serializer = &block->serializer;
+  raptor_turtle_context* context = &block->context;
+  raptor_iostream* iostr;
+  raptor_turtle_writer* turtle_writer;
+  int i;
+  int rc = 0;
+
+  iostr = raptor_new_iostream_to_string(serializer->world,
+                                        (void**)&block->string,
+                                        &block->string_len, NULL);
+  if(!iostr)
+    return 1;
+
+  turtle_writer = raptor_new_turtle_writer(serializer->world,
+                                           serializer->base_uri,
+                                           0,
+                                           context->nstack,
+                                           iostr,
+                                           context->turtle_writer_flags);
+  if(!turtle_writer) {
+    raptor_free_iostream(iostr);
+    return 1;
+  }
+
+  raptor_turtle_writer_set_option(turtle_writer,
+                                  RAPTOR_OPTION_WRITER_AUTO_INDENT, 1);
+  raptor_turtle_writer_set_option(turtle_writer,
+                                  RAPTOR_OPTION_WRITER_INDENT_WIDTH, 2);
+
+  context->turtle_writer = turtle_writer;
+
+  for(i = 0; !rc && i < block->subjects_count; i++)
+    rc = raptor_turtle_emit_subject(serializer, block->subjects[i], 0);
+
+  context->turtle_writer = NULL;
+  raptor_free_turtle_writer(turtle_writer);
+  /* finishes the string */
+  raptor_free_iostream(iostr);
+
+  return rc;
+}
+
+
+/*
+ * raptor_turtle_emit_parallel:
+ * @serializer: #raptor_serializer object
+ * @pool: thread pool with at least one worker thread
+ *
+ * Emit Turtle for all stored triples using worker threads.
+ *
+ * The top-level subjects are split, in output order, into
+ * contiguous blocks that are each emitted into a string by a worker.
+ * The strings are then written to the output in order, giving the
+ * same bytes as raptor_turtle_emit() run serially.  Blank nodes
+ * that are written inline are only reachable from the one subject
+ * that refers to them so no two workers touch the same subject.
+ *
+ * Return value: non-0 on failure
+ **/
+static int
+raptor_turtle_emit_parallel(raptor_serializer *serializer,
+                            raptor_thread_pool* pool)
+{
+  raptor_turtle_context* context = (raptor_turtle_context*)serializer->context;
+  raptor_world* world = serializer->world;
+  raptor_abbrev_subject** subjects = NULL;
+  raptor_turtle_emit_block* blocks = NULL;
+  raptor_avltree* trees[2];
+  int subjects_count = 0;
+  int blocks_count;
+  int i;
+  int rc = 0;
+
+  subjects = RAPTOR_CALLOC(raptor_abbrev_subject**,
+                           raptor_avltree_size(context->subjects) +
+                           raptor_avltree_size(context->blanks) + 1,
+                           sizeof(raptor_abbrev_subject*));
+  if(!subjects)
+    return 1;
+
+  /* same order as raptor_turtle_emit(): URI subjects then blank nodes */
+  trees[0] = context->subjects;
+  trees[1] = context->blanks;
+  for(i = 0; i < 2; i++) {
+    raptor_avltree_iterator* iter;
+
+    iter = raptor_new_avltree_iterator(trees[i], NULL, NULL, 1);
+    while(iter) {
+      raptor_abbrev_subject* subject;
+
+      subject = (raptor_abbrev_subject*)raptor_avltree_iterator_get(iter);
+      if(subject && raptor_turtle_emit_subject_is_top_level(subject))
+        subjects[subjects_count++] = subject;
+      if(raptor_avltree_iterator_next(iter))
+        break;
+    }
+    if(iter)
+      raptor_free_avltree_iterator(iter);
+  }
+
+  if(!subjects_count)
+    goto tidy;
+
+  blocks_count = raptor_thread_pool_get_threads_count(pool) *
+                 RAPTOR_TURTLE_BLOCKS_PER_THREAD;
+  if(blocks_count > subjects_count)
+    blocks_count = subjects_count;
+
+  blocks = RAPTOR_CALLOC(raptor_turtle_emit_block*,
+                         RAPTOR_GOOD_CAST(size_t, blocks_count),
+                         sizeof(raptor_turtle_emit_block));
+  if(!blocks) {
+    rc = 1;
+    goto tidy;
+  }
+
+  raptor_world_internal_threads_start(world);
+
+  for(i = 0; i < blocks_count; i++) {
+    raptor_turtle_emit_block* block = &blocks[i];
+    int start = (int)(((long)subjects_count * i) / blocks_count);
+    int end = (int)(((long)subjects_count * (i + 1)) / blocks_count);
+
+    memcpy(&block->serializer, serializer, sizeof(*serializer));
+    memcpy(&block->context, context, sizeof(*context));
+    block->serializer.context = &block->context;
+    block->subjects = &subjects[start];
+    block->subjects_count = end - start;
+
+    if(raptor_thread_pool_add_task(pool, raptor_turtle_emit_block_run,
+                                   block)) {
+      rc = 1;
+      break;
+    }
+  }
+
+  if(raptor_thread_pool_wait(pool))
+    rc = 1;
+
+  raptor_world_internal_threads_end(world);
+
+  for(i = 0; i < blocks_count; i++) {
+    raptor_turtle_emit_block* block = &blocks[i];
+
+    if(!block->string)
+      continue;
+
+    if(!rc && block->string_len)
+      rc = raptor_iostream_write_bytes(block->string, 1, block->string_len,
+                                       serializer->iostream) !=
+           (int)block->string_len;
+
+    raptor_free_memory(block->string);
+  }
+
+  tidy:
+  if(blocks)
+    RAPTOR_FREE(raptor_turtle_emit_block*, blocks);
+  RAPTOR_FREE(raptor_abbrev_subject**, subjects);
+
+  return rc;
+}
+
+
 /*
  * raptor_turtle_emit:
  * @serializer: #raptor_serializer object
@@ -1063,6 +1277,27 @@ raptor_turtle_emit(raptor_serializer *serializer)
   raptor_abbrev_subject* blank;
   int rc;
   raptor_avltree_iterator* iter = NULL;
+  int threads;
+
+  threads = RAPTOR_OPTIONS_GET_NUMERIC(serializer, RAPTOR_OPTION_THREADS);
+  if(!context->emit_mkr && threads > 1) {
+    raptor_thread_pool* pool;
+
+    /* The mKR output carries result set state from one subject to
+     * the next so only Turtle is emitted in parallel */
+    pool = raptor_new_thread_pool(serializer->world, threads);
+    if(!pool)
+      return 1;
+
+    if(raptor_thread_pool_get_threads_count(pool)) {
+      rc = raptor_turtle_emit_parallel(serializer, pool);
+      raptor_free_thread_pool(pool);
+      return rc;
+    }
+
+    /* no worker threads available */
+    raptor_free_thread_pool(pool);
+  }
 
   iter = raptor_new_avltree_iterator(context->subjects, NULL, NULL, 1);
   while(iter) {
@@ -1130,15 +1365,18 @@ raptor_turtle_serialize_init(raptor_serializer* serializer, const char *name)
 
   context->subjects =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_subject_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_subject, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_subject,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
 
   context->blanks =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_subject_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_subject, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_subject,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
 
   context->nodes =
     raptor_new_avltree((raptor_data_compare_handler)raptor_abbrev_node_compare,
-                       (raptor_data_free_handler)raptor_free_abbrev_node, 0);
+                       (raptor_data_free_handler)raptor_free_abbrev_node,
+                       RAPTOR_AVLTREE_FLAG_BTREE);
 
   rdf_type_uri = raptor_new_uri_for_rdf_concept(serializer->world,
                                                 (const unsigned char*)"type");
@@ -63,8 +63,8 @@ struct raptor_base_id_set_s
   struct raptor_base_id_set_s* prev;
   struct raptor_base_id_set_s* next;
 
-  /* binary tree */
-  raptor_avltree* tree;
+  /* set of ID strings */
+  raptor_hashmap* ids;
 };
 typedef struct raptor_base_id_set_s raptor_base_id_set;
 
@@ -116,8 +116,8 @@ raptor_new_id_set(raptor_world* world)
 static void
 raptor_free_base_id_set(raptor_base_id_set *base) 
 {
-  if(base->tree)
-    raptor_free_avltree(base->tree);
+  if(base->ids)
+    raptor_free_hashmap(base->ids);
   if(base->uri)
     raptor_free_uri(base->uri);
   RAPTOR_FREE(raptor_base_id_set, base);
@@ -166,6 +166,7 @@ raptor_id_set_add(raptor_id_set* set, raptor_uri *base_uri,
 {
   raptor_base_id_set *base;
   char* item;
+  int rc;
   
   if(!base_uri || !id || !id_len)
     return -1;
@@ -187,8 +188,13 @@ raptor_id_set_add(raptor_id_set* set, raptor_uri *base_uri,
 
     base->uri = raptor_uri_copy(base_uri);
 
-    base->tree = raptor_new_avltree((raptor_data_compare_handler)strcmp,
-                                    free, 0);
+    base->ids = raptor_new_hashmap(raptor_hashmap_string_hash,
+                                   raptor_hashmap_string_equals,
+                                   free, NULL, 0);
+    if(!base->ids) {
+      raptor_free_base_id_set(base);
+      return -1;
+    }
   
     /* Add to the start of the list */
     if(set->first)
@@ -208,10 +214,11 @@ raptor_id_set_add(raptor_id_set* set, raptor_uri *base_uri,
       set->first->prev = base;
       base->prev = NULL;
       base->next = set->first;
+      set->first = base;
     }
   }
   
-  item = (char*)raptor_avltree_search(base->tree, id);
+  item = (char*)raptor_hashmap_get_key(base->ids, id);
 
   /* if already there, error */
   if(item) {
@@ -231,7 +238,11 @@ raptor_id_set_add(raptor_id_set* set, raptor_uri *base_uri,
 
   memcpy(item, id, id_len + 1);
 
-  return raptor_avltree_add(base->tree, item);
+  rc = raptor_hashmap_add(base->ids, item, NULL);
+  if(rc)
+    free(item);
+
+  return rc;
 }
 
 
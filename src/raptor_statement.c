@@ -396,6 +396,334 @@ raptor_statement_compare(const raptor_statement *s1,
 }
 
 
+/* POLICY - buckets smaller than this are sorted by comparison */
+#define RAPTOR_STATEMENT_RADIX_MIN_ITEMS 32
+
+/* POLICY - deepest bucket split before sorting by comparison */
+#define RAPTOR_STATEMENT_RADIX_MAX_DEPTH 48
+
+/* key components per term and per statement (4 terms) */
+#define RAPTOR_STATEMENT_RADIX_SLOTS 6
+#define RAPTOR_STATEMENT_RADIX_COMPONENTS (4 * RAPTOR_STATEMENT_RADIX_SLOTS)
+
+/* key values: 0 for the end of a component, else 1 + a byte value */
+#define RAPTOR_STATEMENT_RADIX_KEYS 257
+
+
+static int
+raptor_statement_radix_compare(const void* a, const void* b)
+{
+  return raptor_statement_compare(*(raptor_statement* const*)a,
+                                  *(raptor_statement* const*)b);
+}
+
+
+/* single byte strings for type and flag key components */
+static const unsigned char raptor_statement_radix_tags[7] = {
+  1, 2, 3, 4, 5, 6, 7
+};
+
+
+/* One key component of a statement */
+typedef struct {
+  const unsigned char* string;
+  size_t length;
+  /* key of a NUL byte: 0 if it ends the string as for strcmp() */
+  unsigned int nul_key;
+} raptor_statement_radix_string;
+
+
+static void
+raptor_statement_radix_set_tag(raptor_statement_radix_string* key,
+                               unsigned int tag)
+{
+  key->string = &raptor_statement_radix_tags[tag];
+  key->length = 1;
+}
+
+
+static void
+raptor_statement_radix_set_uri(raptor_statement_radix_string* key,
+                               raptor_uri* uri)
+{
+  /* as raptor_uri_compare(): all bytes then the shorter first */
+  key->string = raptor_uri_as_counted_string(uri, &key->length);
+  key->nul_key = 1;
+}
+
+
+/*
+ * Get key component @component of @statement.
+ *
+ * Each term has RAPTOR_STATEMENT_RADIX_SLOTS components that sort in
+ * raptor_term_compare() order:
+ *   0: term type, with NULL first
+ *   1: URI, blank node or literal string
+ *   2, 3: literal language present flag then language
+ *   4, 5: literal datatype present flag then datatype URI
+ * Components that do not apply to a term type are empty.
+ */
+static void
+raptor_statement_radix_get(const raptor_statement* statement, int component,
+                           raptor_statement_radix_string* key)
+{
+  const raptor_term* term;
+  int slot = component % RAPTOR_STATEMENT_RADIX_SLOTS;
+
+  switch(component / RAPTOR_STATEMENT_RADIX_SLOTS) {
+    case 0:
+      term = statement->subject;
+      break;
+    case 1:
+      term = statement->predicate;
+      break;
+    case 2:
+      term = statement->object;
+      break;
+    default:
+      term = statement->graph;
+      break;
+  }
+
+  key->string = NULL;
+  key->length = 0;
+  key->nul_key = 0;
+
+  if(!slot) {
+    raptor_statement_radix_set_tag(key, term ?
+                                   RAPTOR_GOOD_CAST(unsigned int, term->type) + 1 : 0);
+    return;
+  }
+
+  if(!term)
+    return;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      if(slot == 1)
+        raptor_statement_radix_set_uri(key, term->value.uri);
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      if(slot == 1) {
+        key->string = term->value.blank.string;
+        key->length = term->value.blank.string_len;
+      }
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      switch(slot) {
+        case 1:
+          key->string = term->value.literal.string;
+          key->length = term->value.literal.string_len;
+          break;
+
+        case 2:
+          raptor_statement_radix_set_tag(key,
+                                         term->value.literal.language != NULL);
+          break;
+
+        case 3:
+          key->string = term->value.literal.language;
+          key->length = term->value.literal.language_len;
+          break;
+
+        case 4:
+          raptor_statement_radix_set_tag(key,
+                                         term->value.literal.datatype != NULL);
+          break;
+
+        default:
+          if(term->value.literal.datatype)
+            raptor_statement_radix_set_uri(key, term->value.literal.datatype);
+          break;
+      }
+      break;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+}
+
+
+/* Get the key of byte @offset of a component: 0 at the end, else 1 + byte */
+static unsigned int
+raptor_statement_radix_byte(const raptor_statement_radix_string* key,
+                            size_t offset)
+{
+  unsigned int c;
+
+  if(offset >= key->length)
+    return 0;
+
+  c = key->string[offset];
+  return c ? c + 1 : key->nul_key;
+}
+
+
+static unsigned int
+raptor_statement_radix_key(const raptor_statement* statement, int component,
+                           size_t offset)
+{
+  raptor_statement_radix_string key;
+
+  raptor_statement_radix_get(statement, component, &key);
+  return raptor_statement_radix_byte(&key, offset);
+}
+
+
+/*
+ * Count the bytes from @offset of key @component that all @count
+ * statements share, up to the end of the shortest.
+ */
+static size_t
+raptor_statement_radix_common(raptor_statement** items, size_t count,
+                              int component, size_t offset)
+{
+  raptor_statement_radix_string first;
+  size_t common;
+  size_t i;
+
+  raptor_statement_radix_get(items[0], component, &first);
+  common = 0;
+  while(raptor_statement_radix_byte(&first, offset + common))
+    common++;
+
+  for(i = 1; i < count && common; i++) {
+    raptor_statement_radix_string key;
+    size_t j;
+
+    raptor_statement_radix_get(items[i], component, &key);
+    for(j = 0; j < common; j++) {
+      if(raptor_statement_radix_byte(&key, offset + j) !=
+         raptor_statement_radix_byte(&first, offset + j))
+        break;
+    }
+    common = j;
+  }
+
+  return common;
+}
+
+
+/*
+ * MSD radix sort of @count statements that have equal keys before
+ * byte @offset of key @component.  @buffer and @keys are scratch
+ * space of at least @count items.
+ */
+static void
+raptor_statement_radix_sort_range(raptor_statement** items,
+                                  raptor_statement** buffer,
+                                  unsigned short* keys,
+                                  size_t count, int component, size_t offset,
+                                  int depth)
+{
+  size_t ends[RAPTOR_STATEMENT_RADIX_KEYS];
+  size_t start;
+  size_t sum;
+  size_t i;
+  int k;
+
+  while(count > 1) {
+    if(count < RAPTOR_STATEMENT_RADIX_MIN_ITEMS ||
+       depth >= RAPTOR_STATEMENT_RADIX_MAX_DEPTH) {
+      qsort(items, count, sizeof(*items), raptor_statement_radix_compare);
+      return;
+    }
+
+    if(component >= RAPTOR_STATEMENT_RADIX_COMPONENTS)
+      /* all keys are equal */
+      return;
+
+    memset(ends, 0, sizeof(ends));
+    for(i = 0; i < count; i++) {
+      keys[i] = RAPTOR_GOOD_CAST(unsigned short,
+                                 raptor_statement_radix_key(items[i],
+                                                            component,
+                                                            offset));
+      ends[keys[i]]++;
+    }
+
+    if(ends[keys[0]] == count) {
+      /* one bucket: skip the bytes all share or move to the next component */
+      if(keys[0])
+        offset += 1 + raptor_statement_radix_common(items, count, component,
+                                                    offset + 1);
+      else {
+        component++;
+        offset = 0;
+      }
+      continue;
+    }
+
+    /* bucket starts, which become bucket ends as items are placed */
+    sum = 0;
+    for(k = 0; k < RAPTOR_STATEMENT_RADIX_KEYS; k++) {
+      size_t c = ends[k];
+      ends[k] = sum;
+      sum += c;
+    }
+    for(i = 0; i < count; i++)
+      buffer[ends[keys[i]]++] = items[i];
+    memcpy(items, buffer, count * sizeof(*items));
+
+    start = 0;
+    for(k = 0; k < RAPTOR_STATEMENT_RADIX_KEYS; k++) {
+      if(ends[k] - start > 1) {
+        if(k)
+          raptor_statement_radix_sort_range(&items[start], buffer, keys,
+                                            ends[k] - start,
+                                            component, offset + 1, depth + 1);
+        else
+          raptor_statement_radix_sort_range(&items[start], buffer, keys,
+                                            ends[k] - start,
+                                            component + 1, 0, depth + 1);
+      }
+      start = ends[k];
+    }
+
+    return;
+  }
+}
+
+
+/**
+ * raptor_statement_radix_sort:
+ * @statements: array of statements
+ * @count: number of statements
+ *
+ * INTERNAL - Sort an array of statements into raptor_statement_compare() order
+ *
+ * Uses a most significant byte first radix sort over the term types
+ * and string bytes, falling back to comparison for small buckets or
+ * if memory runs out.  Statements must not be NULL.
+ */
+void
+raptor_statement_radix_sort(raptor_statement** statements, size_t count)
+{
+  raptor_statement** buffer;
+  unsigned short* keys;
+
+  if(count < 2)
+    return;
+
+  buffer = RAPTOR_MALLOC(raptor_statement**, count * sizeof(*buffer));
+  keys = RAPTOR_MALLOC(unsigned short*, count * sizeof(*keys));
+  if(buffer && keys)
+    raptor_statement_radix_sort_range(statements, buffer, keys, count,
+                                      0, 0, 0);
+  else
+    qsort(statements, count, sizeof(*statements),
+          raptor_statement_radix_compare);
+
+  if(keys)
+    RAPTOR_FREE(unsigned short*, keys);
+  if(buffer)
+    RAPTOR_FREE(raptor_statement**, buffer);
+}
+
+
 /**
  * raptor_statement_equals:
  * @s1: first statement
@@ -403,6 +731,9 @@ raptor_statement_compare(const raptor_statement *s1,
  *
  * Compare a pair of #raptor_statement for equality
  *
+ * Statements with a term whose raptor_term_hash() differs are
+ * rejected before any term values are compared.
+ *
  * Return value: non-0 if statements are equal
  */
 int
@@ -411,6 +742,11 @@ raptor_statement_equals(const raptor_statement* s1, const raptor_statement* s2)
   if(!s1 || !s2)
     return 0;
   
+  if(raptor_term_hash(s1->subject) != raptor_term_hash(s2->subject) ||
+     raptor_term_hash(s1->predicate) != raptor_term_hash(s2->predicate) ||
+     raptor_term_hash(s1->object) != raptor_term_hash(s2->object))
+    return 0;
+  
   if(!raptor_term_equals(s1->subject, s2->subject))
     return 0;
   
@@ -422,3 +758,42 @@ raptor_statement_equals(const raptor_statement* s1, const raptor_statement* s2)
 
   return 1;
 }
+
+
+/**
+ * raptor_statement_hash:
+ * @statement: statement
+ *
+ * Get a 64-bit hash of a #raptor_statement
+ *
+ * The hash combines the raptor_term_hash() values of the subject,
+ * predicate and object, which are calculated when the terms are made.
+ * Like raptor_statement_equals(), the graph is not used; callers that
+ * need it can combine raptor_term_hash() of the graph.
+ *
+ * Return value: hash value
+ */
+raptor_hash
+raptor_statement_hash(const raptor_statement* statement)
+{
+  raptor_term* terms[3];
+  unsigned char buffer[3 * 8];
+  int i;
+
+  if(!statement)
+    return 0;
+
+  terms[0] = statement->subject;
+  terms[1] = statement->predicate;
+  terms[2] = statement->object;
+
+  for(i = 0; i < 3; i++) {
+    raptor_hash h = raptor_term_hash(terms[i]);
+    int j;
+
+    for(j = 0; j < 8; j++, h >>= 8)
+      buffer[i * 8 + j] = RAPTOR_GOOD_CAST(unsigned char, h & 0xff);
+  }
+
+  return raptor_hash_bytes(buffer, sizeof(buffer), 0);
+}
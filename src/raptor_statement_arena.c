@@ -0,0 +1,669 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_statement_arena.c - Raptor statement arena
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * A statement arena holds copies of statements in large blocks.
+ *
+ * Statements are stored in arrays of statement blocks, in the order
+ * they were copied, so visiting them walks contiguous memory.  Terms
+ * and their literal and blank node strings are copied into data
+ * blocks.  URIs are interned so only a reference is kept; the same is
+ * done for literal and blank node terms when the world interns terms.
+ * All of it is released with one call to raptor_free_statement_arena()
+ * or raptor_statement_arena_clear().
+ */
+
+
+/* POLICY - statements per statement block */
+#define RAPTOR_STATEMENT_ARENA_BLOCK_STATEMENTS 1024
+
+/* POLICY - bytes per data block; larger terms get a block of their own */
+#define RAPTOR_STATEMENT_ARENA_BLOCK_SIZE 65536
+
+
+/* strictest alignment needed by anything stored in a data block */
+typedef union {
+  void* pointer;
+  double number;
+  raptor_hash hash;
+} raptor_statement_arena_align;
+
+#define RAPTOR_STATEMENT_ARENA_ALIGN sizeof(raptor_statement_arena_align)
+
+#define RAPTOR_STATEMENT_ARENA_ROUND(size) \
+  (((size) + RAPTOR_STATEMENT_ARENA_ALIGN - 1) & ~(RAPTOR_STATEMENT_ARENA_ALIGN - 1))
+
+
+typedef struct raptor_statement_arena_block_s {
+  struct raptor_statement_arena_block_s* next;
+
+  /* bytes (data blocks) or statements (statement blocks) */
+  size_t size;
+  size_t used;
+
+  /* storage follows, aligned */
+  raptor_statement_arena_align data[1];
+} raptor_statement_arena_block;
+
+
+struct raptor_statement_arena_s {
+  raptor_world* world;
+
+  /* statement blocks in copy order */
+  raptor_statement_arena_block* statements_first;
+  raptor_statement_arena_block* statements_last;
+
+  /* data blocks; the first has the free space */
+  raptor_statement_arena_block* data;
+
+  /* references held on interned URIs (raptor_uri*) and terms
+   * (raptor_term*) */
+  void** uris;
+  size_t uris_count;
+  size_t uris_size;
+
+  void** terms;
+  size_t terms_count;
+  size_t terms_size;
+
+  int statements_count;
+};
+
+
+/**
+ * raptor_new_statement_arena:
+ * @world: raptor world
+ *
+ * Constructor - create a new statement arena
+ *
+ * Return value: new statement arena or NULL on failure
+ */
+raptor_statement_arena*
+raptor_new_statement_arena(raptor_world* world)
+{
+  raptor_statement_arena* arena;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  raptor_world_open(world);
+
+  arena = RAPTOR_CALLOC(raptor_statement_arena*, 1, sizeof(*arena));
+  if(!arena)
+    return NULL;
+
+  arena->world = world;
+
+  return arena;
+}
+
+
+static void
+raptor_free_statement_arena_blocks(raptor_statement_arena_block* block)
+{
+  while(block) {
+    raptor_statement_arena_block* next = block->next;
+
+    RAPTOR_FREE(raptor_statement_arena_block, block);
+    block = next;
+  }
+}
+
+
+/**
+ * raptor_statement_arena_clear:
+ * @arena: statement arena
+ *
+ * Remove all statements from a statement arena
+ *
+ * All statements and terms returned by raptor_statement_arena_copy()
+ * become invalid.
+ */
+void
+raptor_statement_arena_clear(raptor_statement_arena* arena)
+{
+  size_t i;
+
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN(arena, raptor_statement_arena);
+
+  for(i = 0; i < arena->uris_count; i++)
+    raptor_free_uri((raptor_uri*)arena->uris[i]);
+  arena->uris_count = 0;
+
+  for(i = 0; i < arena->terms_count; i++)
+    raptor_free_term((raptor_term*)arena->terms[i]);
+  arena->terms_count = 0;
+
+  raptor_free_statement_arena_blocks(arena->statements_first);
+  arena->statements_first = NULL;
+  arena->statements_last = NULL;
+
+  raptor_free_statement_arena_blocks(arena->data);
+  arena->data = NULL;
+
+  arena->statements_count = 0;
+}
+
+
+/**
+ * raptor_free_statement_arena:
+ * @arena: statement arena
+ *
+ * Destructor - destroy a statement arena and all statements in it
+ */
+void
+raptor_free_statement_arena(raptor_statement_arena* arena)
+{
+  if(!arena)
+    return;
+
+  raptor_statement_arena_clear(arena);
+
+  if(arena->uris)
+    RAPTOR_FREE(void**, arena->uris);
+  if(arena->terms)
+    RAPTOR_FREE(void**, arena->terms);
+
+  RAPTOR_FREE(raptor_statement_arena, arena);
+}
+
+
+static raptor_statement_arena_block*
+raptor_new_statement_arena_block(size_t data_size)
+{
+  raptor_statement_arena_block* block;
+
+  block = RAPTOR_MALLOC(raptor_statement_arena_block*,
+                        sizeof(*block) - sizeof(block->data) + data_size);
+  if(!block)
+    return NULL;
+
+  block->next = NULL;
+  block->size = data_size;
+  block->used = 0;
+
+  return block;
+}
+
+
+/* Allocate @size bytes of aligned data storage */
+static void*
+raptor_statement_arena_alloc(raptor_statement_arena* arena, size_t size)
+{
+  raptor_statement_arena_block* block = arena->data;
+  unsigned char* p;
+
+  size = RAPTOR_STATEMENT_ARENA_ROUND(size);
+
+  if(!block || block->size - block->used < size) {
+    size_t block_size = RAPTOR_STATEMENT_ARENA_BLOCK_SIZE;
+
+    if(size > block_size / 4) {
+      /* big item: a block of its own behind the current one */
+      block = raptor_new_statement_arena_block(size);
+      if(!block)
+        return NULL;
+      block->used = size;
+      if(arena->data) {
+        block->next = arena->data->next;
+        arena->data->next = block;
+      } else
+        arena->data = block;
+      return block->data;
+    }
+
+    block = raptor_new_statement_arena_block(block_size);
+    if(!block)
+      return NULL;
+    block->next = arena->data;
+    arena->data = block;
+  }
+
+  p = RAPTOR_GOOD_CAST(unsigned char*, block->data) + block->used;
+  block->used += size;
+
+  return p;
+}
+
+
+/* Remember a reference to release when the arena is cleared */
+static int
+raptor_statement_arena_add_ref(void*** array_p, size_t* count_p,
+                               size_t* size_p, void* ref)
+{
+  if(*count_p == *size_p) {
+    size_t size = *size_p ? *size_p * 2 : 256;
+    void** array;
+
+    array = RAPTOR_CALLOC(void**, size, sizeof(void*));
+    if(!array)
+      return 1;
+    if(*array_p) {
+      memcpy(array, *array_p, *count_p * sizeof(void*));
+      RAPTOR_FREE(void**, *array_p);
+    }
+    *array_p = array;
+    *size_p = size;
+  }
+
+  (*array_p)[(*count_p)++] = ref;
+
+  return 0;
+}
+
+
+static raptor_uri*
+raptor_statement_arena_uri(raptor_statement_arena* arena, raptor_uri* uri)
+{
+  uri = raptor_uri_copy(uri);
+  if(!uri)
+    return NULL;
+
+  if(raptor_statement_arena_add_ref(&arena->uris,
+                                    &arena->uris_count, &arena->uris_size,
+                                    uri)) {
+    raptor_free_uri(uri);
+    return NULL;
+  }
+
+  return uri;
+}
+
+
+static raptor_term*
+raptor_statement_arena_term(raptor_statement_arena* arena, raptor_term* term)
+{
+  raptor_term* t;
+  unsigned char* p;
+  size_t size;
+  size_t language_len = 0;
+
+  if(!term)
+    return NULL;
+
+  if(term->type != RAPTOR_TERM_TYPE_URI && term->world->terms_tree) {
+    /* interned terms are already shared */
+    t = raptor_term_copy(term);
+    if(raptor_statement_arena_add_ref(&arena->terms,
+                                      &arena->terms_count, &arena->terms_size,
+                                      t)) {
+      raptor_free_term(t);
+      return NULL;
+    }
+    return t;
+  }
+
+  /* terms carry their hash like those made by the constructors */
+  size = sizeof(raptor_term_private);
+  if(term->type == RAPTOR_TERM_TYPE_BLANK)
+    size += term->value.blank.string_len + 1;
+  else if(term->type == RAPTOR_TERM_TYPE_LITERAL) {
+    size += term->value.literal.string_len + 1;
+    if(term->value.literal.language) {
+      language_len = strlen(RAPTOR_GOOD_CAST(const char*,
+                                             term->value.literal.language));
+      size += language_len + 1;
+    }
+  }
+
+  t = (raptor_term*)raptor_statement_arena_alloc(arena, size);
+  if(!t)
+    return NULL;
+
+  memcpy(t, term, sizeof(raptor_term_private));
+  /* static - owned by the arena; raptor_term_copy() makes a real copy */
+  t->usage = -1;
+  p = RAPTOR_GOOD_CAST(unsigned char*, t) + sizeof(raptor_term_private);
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      t->value.uri = raptor_statement_arena_uri(arena, term->value.uri);
+      if(!t->value.uri)
+        return NULL;
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      memcpy(p, term->value.blank.string, term->value.blank.string_len + 1);
+      t->value.blank.string = p;
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      memcpy(p, term->value.literal.string,
+             term->value.literal.string_len + 1);
+      t->value.literal.string = p;
+      p += term->value.literal.string_len + 1;
+
+      if(term->value.literal.language) {
+        memcpy(p, term->value.literal.language, language_len + 1);
+        t->value.literal.language = p;
+      }
+
+      if(term->value.literal.datatype) {
+        t->value.literal.datatype = raptor_statement_arena_uri(arena,
+                                                               term->value.literal.datatype);
+        if(!t->value.literal.datatype)
+          return NULL;
+      }
+      break;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  return t;
+}
+
+
+/**
+ * raptor_statement_arena_copy:
+ * @arena: statement arena
+ * @statement: statement to copy
+ *
+ * Copy a statement into a statement arena
+ *
+ * The returned statement and its terms are owned by the arena and
+ * stay valid until the arena is cleared or freed.  They are static
+ * so raptor_free_statement() and raptor_free_term() do not free them,
+ * and raptor_statement_copy() and raptor_term_copy() return copies
+ * that can outlive the arena.
+ *
+ * Return value: shared statement or NULL on failure
+ */
+raptor_statement*
+raptor_statement_arena_copy(raptor_statement_arena* arena,
+                            raptor_statement* statement)
+{
+  raptor_statement_arena_block* block;
+  raptor_statement* s;
+  size_t uris_count;
+  size_t terms_count;
+
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(arena, raptor_statement_arena, NULL);
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(statement, raptor_statement, NULL);
+
+  block = arena->statements_last;
+  if(!block || block->used == block->size) {
+    block = raptor_new_statement_arena_block(RAPTOR_STATEMENT_ARENA_BLOCK_STATEMENTS *
+                                             sizeof(raptor_statement));
+    if(!block)
+      return NULL;
+    block->size = RAPTOR_STATEMENT_ARENA_BLOCK_STATEMENTS;
+
+    if(arena->statements_last)
+      arena->statements_last->next = block;
+    else
+      arena->statements_first = block;
+    arena->statements_last = block;
+  }
+
+  s = RAPTOR_GOOD_CAST(raptor_statement*, block->data) + block->used;
+
+  raptor_statement_init(s, arena->world);
+
+  uris_count = arena->uris_count;
+  terms_count = arena->terms_count;
+
+  if((statement->subject &&
+      !(s->subject = raptor_statement_arena_term(arena, statement->subject))) ||
+     (statement->predicate &&
+      !(s->predicate = raptor_statement_arena_term(arena, statement->predicate))) ||
+     (statement->object &&
+      !(s->object = raptor_statement_arena_term(arena, statement->object))) ||
+     (statement->graph &&
+      !(s->graph = raptor_statement_arena_term(arena, statement->graph)))) {
+    /* release the references taken for the terms copied so far */
+    while(arena->uris_count > uris_count)
+      raptor_free_uri((raptor_uri*)arena->uris[--arena->uris_count]);
+    while(arena->terms_count > terms_count)
+      raptor_free_term((raptor_term*)arena->terms[--arena->terms_count]);
+    return NULL;
+  }
+
+  block->used++;
+  arena->statements_count++;
+
+  return s;
+}
+
+
+/**
+ * raptor_statement_arena_size:
+ * @arena: statement arena
+ *
+ * Get the number of statements in a statement arena
+ *
+ * Return value: number of statements
+ */
+int
+raptor_statement_arena_size(raptor_statement_arena* arena)
+{
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(arena, raptor_statement_arena, 0);
+
+  return arena->statements_count;
+}
+
+
+/**
+ * raptor_statement_arena_visit:
+ * @arena: statement arena
+ * @handler: function to call with each statement
+ * @user_data: user data for @handler
+ *
+ * Call a function with each statement in a statement arena in the
+ * order they were copied
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_statement_arena_visit(raptor_statement_arena* arena,
+                             raptor_statement_handler handler,
+                             void* user_data)
+{
+  raptor_statement_arena_block* block;
+
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(arena, raptor_statement_arena, 1);
+
+  for(block = arena->statements_first; block; block = block->next) {
+    raptor_statement* s = RAPTOR_GOOD_CAST(raptor_statement*, block->data);
+    size_t i;
+
+    for(i = 0; i < block->used; i++)
+      handler(user_data, &s[i]);
+  }
+
+  return 0;
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_ITEMS 5000
+
+static int test_visit_count = 0;
+static int test_visit_errors = 0;
+
+static raptor_statement*
+test_make_statement(raptor_world* world, int i)
+{
+  unsigned char buffer[64];
+  raptor_term* s;
+  raptor_term* p;
+  raptor_term* o;
+
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/s%d", i % 97);
+  s = (i % 3) ? raptor_new_term_from_uri_string(world, buffer)
+              : raptor_new_term_from_blank(world, buffer + 19);
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/p%d", i % 5);
+  p = raptor_new_term_from_uri_string(world, buffer);
+  snprintf((char*)buffer, sizeof(buffer), "literal %d", i);
+  o = raptor_new_term_from_literal(world, buffer, NULL,
+                                   (i % 2) ? (const unsigned char*)"en" : NULL);
+
+  return raptor_new_statement_from_nodes(world, s, p, o, NULL);
+}
+
+
+static void
+test_visit_handler(void* user_data, raptor_statement* statement)
+{
+  raptor_world* world = (raptor_world*)user_data;
+  raptor_statement* expected;
+
+  expected = test_make_statement(world, test_visit_count++);
+  if(!raptor_statement_equals(expected, statement) ||
+     !raptor_term_equals(expected->object, statement->object))
+    test_visit_errors++;
+  raptor_free_statement(expected);
+}
+
+
+static int
+test_arena(const char* program, int interning)
+{
+  raptor_world* world;
+  raptor_statement_arena* arena;
+  raptor_statement* st = NULL;
+  raptor_statement* kept = NULL;
+  int i;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world ||
+     raptor_world_set_flag(world, RAPTOR_WORLD_FLAG_TERM_INTERNING, interning) ||
+     raptor_world_open(world))
+    return 1;
+
+  arena = raptor_new_statement_arena(world);
+  if(!arena) {
+    fprintf(stderr, "%s: raptor_new_statement_arena() failed\n", program);
+    raptor_free_world(world);
+    return 1;
+  }
+
+  for(i = 0; i < TEST_ITEMS; i++) {
+    raptor_statement* statement = test_make_statement(world, i);
+    raptor_statement* copy;
+
+    copy = raptor_statement_arena_copy(arena, statement);
+    /* the original terms go away; the copy must not depend on them */
+    raptor_free_statement(statement);
+    if(!copy) {
+      fprintf(stderr, "%s: raptor_statement_arena_copy() failed\n", program);
+      rc = 1;
+      goto tidy;
+    }
+  }
+
+  if(raptor_statement_arena_size(arena) != TEST_ITEMS) {
+    fprintf(stderr, "%s: arena has %d statements, expected %d\n", program,
+            raptor_statement_arena_size(arena), TEST_ITEMS);
+    rc = 1;
+    goto tidy;
+  }
+
+  test_visit_count = 0;
+  test_visit_errors = 0;
+  raptor_statement_arena_visit(arena, test_visit_handler, world);
+  if(test_visit_count != TEST_ITEMS || test_visit_errors) {
+    fprintf(stderr, "%s: visited %d statements with %d errors, expected %d with none\n",
+            program, test_visit_count, test_visit_errors, TEST_ITEMS);
+    rc = 1;
+    goto tidy;
+  }
+
+  /* copies of arena statements must outlive the arena contents */
+  st = test_make_statement(world, 1);
+  kept = raptor_statement_arena_copy(arena, st);
+  if(kept)
+    kept = raptor_statement_copy(kept);
+  if(!kept) {
+    fprintf(stderr, "%s: copying an arena statement failed\n", program);
+    rc = 1;
+    goto tidy;
+  }
+
+  raptor_statement_arena_clear(arena);
+  if(raptor_statement_arena_size(arena)) {
+    fprintf(stderr, "%s: arena is not empty after clear\n", program);
+    rc = 1;
+    goto tidy;
+  }
+
+  if(!raptor_statement_equals(st, kept) ||
+     !raptor_term_equals(st->object, kept->object)) {
+    fprintf(stderr, "%s: copy of an arena statement changed after clear\n",
+            program);
+    rc = 1;
+    goto tidy;
+  }
+
+  tidy:
+  if(st)
+    raptor_free_statement(st);
+  if(kept)
+    raptor_free_statement(kept);
+  raptor_free_statement_arena(arena);
+  raptor_free_world(world);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  int rc = 0;
+
+  rc += test_arena(program, 0);
+  rc += test_arena(program, 1);
+
+  return rc;
+}
+
+#endif /* STANDALONE */
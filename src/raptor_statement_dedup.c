@@ -0,0 +1,521 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_statement_dedup.c - Raptor streaming duplicate statement filter
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * A statement dedup filter remembers recently seen statements in two
+ * generations of open addressing hash tables keyed by the 64-bit
+ * raptor_statement_hash() of the statement combined with its graph.
+ * A matching hash is confirmed by comparing the statements so a hash
+ * collision never drops a statement.
+ *
+ * The hash is 64 bits rather than a wider 128-bit digest so that it
+ * can share the term and statement hashes, which are calculated once
+ * when terms are made.  A collision only costs an extra statement
+ * comparison or, in the Bloom filter, a probe of the table that would
+ * otherwise have been skipped.
+ *
+ * New statements go into the current generation, which holds up to
+ * half the limit.  When it is full the previous generation is emptied
+ * and becomes the current one, so the filter forgets the oldest half
+ * at a time and the most recent limit / 2 statements are always
+ * remembered.  Checks look in both generations.
+ *
+ * An optional Bloom filter in front of each table answers most checks
+ * for new statements from a small bit array without probing the table.
+ */
+
+
+/* number of Bloom filter bits set per statement */
+#define RAPTOR_STATEMENT_DEDUP_BLOOM_PROBES 4
+
+/* Bloom filter bits per remembered statement */
+#define RAPTOR_STATEMENT_DEDUP_BLOOM_BITS 8
+
+
+typedef struct {
+  raptor_hash hash;
+  /* NULL if the slot is empty */
+  raptor_statement* statement;
+} raptor_statement_dedup_entry;
+
+
+typedef struct {
+  /* table of 2^n entries */
+  raptor_statement_dedup_entry* table;
+  size_t table_size;
+  int count;
+
+  /* Bloom filter of bloom_size bits (2^n) or NULL */
+  unsigned char* bloom;
+  size_t bloom_size;
+} raptor_statement_dedup_generation;
+
+
+struct raptor_statement_dedup_s {
+  raptor_world* world;
+
+  /* maximum number of statements remembered */
+  int limit;
+
+  /* statements per generation */
+  int generation_limit;
+
+  /* non-0 to check a Bloom filter before each table */
+  int use_bloom;
+
+  /* current and previous generations, allocated on first use */
+  raptor_statement_dedup_generation generations[2];
+  int current;
+  int initialized;
+};
+
+
+/*
+ * Hash a statement including its graph.
+ */
+static raptor_hash
+raptor_statement_dedup_hash_statement(raptor_statement* statement)
+{
+  raptor_hash hashes[2];
+  unsigned char buffer[2 * 8];
+  int i;
+  int j;
+
+  hashes[0] = raptor_statement_hash(statement);
+  if(!statement->graph)
+    return hashes[0];
+
+  hashes[1] = raptor_term_hash(statement->graph);
+  for(i = 0; i < 2; i++) {
+    raptor_hash h = hashes[i];
+
+    for(j = 0; j < 8; j++, h >>= 8)
+      buffer[i * 8 + j] = RAPTOR_GOOD_CAST(unsigned char, h & 0xff);
+  }
+
+  return raptor_hash_bytes(buffer, sizeof(buffer), 0);
+}
+
+
+/**
+ * raptor_new_statement_dedup:
+ * @world: raptor world
+ * @limit: maximum number of statements to remember (>0)
+ * @use_bloom: non-0 to use a Bloom filter before the hash table
+ *
+ * INTERNAL - Constructor - create a new duplicate statement filter
+ *
+ * At least the most recent @limit / 2 new statements are remembered.
+ *
+ * Return value: new filter or NULL on failure
+ */
+raptor_statement_dedup*
+raptor_new_statement_dedup(raptor_world* world, int limit, int use_bloom)
+{
+  raptor_statement_dedup* dedup;
+
+  if(limit <= 0)
+    return NULL;
+
+  dedup = RAPTOR_CALLOC(raptor_statement_dedup*, 1, sizeof(*dedup));
+  if(!dedup)
+    return NULL;
+
+  dedup->world = world;
+  dedup->limit = limit;
+  dedup->generation_limit = (limit > 1) ? limit / 2 : 1;
+  dedup->use_bloom = use_bloom;
+
+  return dedup;
+}
+
+
+static void
+raptor_statement_dedup_clear(raptor_statement_dedup_generation* generation)
+{
+  size_t i;
+
+  for(i = 0; i < generation->table_size; i++) {
+    if(generation->table[i].statement) {
+      raptor_free_statement(generation->table[i].statement);
+      generation->table[i].statement = NULL;
+    }
+  }
+  generation->count = 0;
+
+  if(generation->bloom)
+    memset(generation->bloom, 0, generation->bloom_size / 8);
+}
+
+
+/**
+ * raptor_free_statement_dedup:
+ * @dedup: duplicate statement filter
+ *
+ * INTERNAL - Destructor - destroy a duplicate statement filter
+ */
+void
+raptor_free_statement_dedup(raptor_statement_dedup* dedup)
+{
+  int g;
+
+  if(!dedup)
+    return;
+
+  for(g = 0; g < 2; g++) {
+    raptor_statement_dedup_generation* generation = &dedup->generations[g];
+
+    if(generation->table) {
+      raptor_statement_dedup_clear(generation);
+      RAPTOR_FREE(raptor_statement_dedup_entry*, generation->table);
+    }
+
+    if(generation->bloom)
+      RAPTOR_FREE(char*, generation->bloom);
+  }
+
+  RAPTOR_FREE(raptor_statement_dedup, dedup);
+}
+
+
+static int
+raptor_statement_dedup_init_generation(raptor_statement_dedup* dedup,
+                                       raptor_statement_dedup_generation* generation)
+{
+  size_t limit = RAPTOR_GOOD_CAST(size_t, dedup->generation_limit);
+  size_t size = 16;
+
+  /* keep the table at most half full */
+  while(size < limit * 2)
+    size <<= 1;
+
+  generation->table = RAPTOR_CALLOC(raptor_statement_dedup_entry*, size,
+                                    sizeof(raptor_statement_dedup_entry));
+  if(!generation->table)
+    return 1;
+  generation->table_size = size;
+
+  if(dedup->use_bloom) {
+    size_t bits = 64;
+
+    while(bits < limit * RAPTOR_STATEMENT_DEDUP_BLOOM_BITS)
+      bits <<= 1;
+
+    generation->bloom = RAPTOR_CALLOC(unsigned char*, bits / 8, 1);
+    if(!generation->bloom)
+      return 1;
+    generation->bloom_size = bits;
+  }
+
+  return 0;
+}
+
+
+/*
+ * Check the Bloom bits for @hash, setting them if @add is non-0;
+ * return non-0 if they were all set before
+ */
+static int
+raptor_statement_dedup_bloom_check(raptor_statement_dedup_generation* generation,
+                                   raptor_hash hash, int add)
+{
+  size_t mask = generation->bloom_size - 1;
+  /* derive the probes from two halves of the hash */
+  size_t h1 = RAPTOR_GOOD_CAST(size_t, (hash >> 32) & 0xffffffffUL);
+  size_t h2 = RAPTOR_GOOD_CAST(size_t, hash & 0xffffffffUL) | 1;
+  int present = 1;
+  int i;
+
+  for(i = 0; i < RAPTOR_STATEMENT_DEDUP_BLOOM_PROBES; i++) {
+    size_t bit = (h1 + RAPTOR_GOOD_CAST(size_t, i) * h2) & mask;
+    unsigned char flag = RAPTOR_GOOD_CAST(unsigned char, 1 << (bit & 7));
+
+    if(!(generation->bloom[bit >> 3] & flag)) {
+      present = 0;
+      if(!add)
+        break;
+      generation->bloom[bit >> 3] |= flag;
+    }
+  }
+
+  return present;
+}
+
+
+/*
+ * Look for @statement with @hash in @generation, setting its Bloom
+ * bits if @add is non-0.  Return non-0 if found; *slot_p is set to
+ * the free slot where it would be added.
+ */
+static int
+raptor_statement_dedup_find(raptor_statement_dedup_generation* generation,
+                            raptor_statement* statement, raptor_hash hash,
+                            int add, size_t* slot_p)
+{
+  size_t mask = generation->table_size - 1;
+  size_t i = RAPTOR_GOOD_CAST(size_t, hash) & mask;
+  int maybe_present = generation->count > 0;
+
+  if(generation->bloom) {
+    int bloom_present = raptor_statement_dedup_bloom_check(generation, hash,
+                                                           add);
+    maybe_present = maybe_present && bloom_present;
+  }
+
+  for(; generation->table[i].statement; i = (i + 1) & mask) {
+    raptor_statement_dedup_entry* entry = &generation->table[i];
+
+    /* a Bloom filter miss needs only the free slot */
+    if(maybe_present &&
+       entry->hash == hash &&
+       raptor_statement_equals(entry->statement, statement) &&
+       !raptor_term_compare(entry->statement->graph, statement->graph))
+      return 1;
+  }
+
+  *slot_p = i;
+  return 0;
+}
+
+
+/**
+ * raptor_statement_dedup_check:
+ * @dedup: duplicate statement filter
+ * @statement: statement
+ *
+ * INTERNAL - Check if a statement was seen before and remember it if not
+ *
+ * The statement is copied when it is remembered.  The graph term is
+ * part of the comparison.
+ *
+ * Return value: >0 if @statement is a duplicate, 0 if it is new, <0 on failure
+ */
+int
+raptor_statement_dedup_check(raptor_statement_dedup* dedup,
+                             raptor_statement* statement)
+{
+  raptor_statement_dedup_generation* current;
+  raptor_statement_dedup_generation* previous;
+  raptor_statement_dedup_entry* entry;
+  raptor_hash hash;
+  size_t slot = 0;
+  size_t previous_slot = 0;
+
+  if(!dedup->initialized) {
+    if(raptor_statement_dedup_init_generation(dedup, &dedup->generations[0]) ||
+       raptor_statement_dedup_init_generation(dedup, &dedup->generations[1]))
+      return -1;
+    dedup->initialized = 1;
+  }
+
+  current = &dedup->generations[dedup->current];
+  previous = &dedup->generations[1 - dedup->current];
+
+  hash = raptor_statement_dedup_hash_statement(statement);
+
+  if(raptor_statement_dedup_find(current, statement, hash, 1, &slot) ||
+     (previous->count &&
+      raptor_statement_dedup_find(previous, statement, hash, 0,
+                                  &previous_slot)))
+    return 1;
+
+  if(current->count == dedup->generation_limit) {
+    /* forget the previous generation and start a new current one */
+    raptor_statement_dedup_clear(previous);
+    dedup->current = 1 - dedup->current;
+    current = previous;
+
+    /* find the free slot and set the Bloom bits in the new table */
+    raptor_statement_dedup_find(current, statement, hash, 1, &slot);
+  }
+
+  entry = &current->table[slot];
+  entry->statement = raptor_statement_copy(statement);
+  if(!entry->statement)
+    return -1;
+  entry->hash = hash;
+  current->count++;
+
+  return 0;
+}
+
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_ITEMS 2000
+
+static raptor_statement*
+test_make_statement(raptor_world* world, int i, int with_graph)
+{
+  unsigned char buffer[64];
+  raptor_term* s;
+  raptor_term* p;
+  raptor_term* o;
+  raptor_term* g = NULL;
+
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/s%d", i % 97);
+  s = (i % 3) ? raptor_new_term_from_uri_string(world, buffer)
+              : raptor_new_term_from_blank(world, buffer + 19);
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/p%d", i % 5);
+  p = raptor_new_term_from_uri_string(world, buffer);
+  snprintf((char*)buffer, sizeof(buffer), "value %d", i);
+  if(i % 2)
+    o = raptor_new_term_from_literal(world, buffer, NULL,
+                                     (const unsigned char*)"en");
+  else
+    o = raptor_new_term_from_literal(world, buffer, NULL, NULL);
+  if(with_graph)
+    g = raptor_new_term_from_uri_string(world, (const unsigned char*)"http://example.org/g");
+
+  return raptor_new_statement_from_nodes(world, s, p, o, g);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  int bloom;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  for(bloom = 0; bloom < 2; bloom++) {
+    raptor_statement_dedup* dedup;
+    int new_count = 0;
+    int i;
+
+    /* half the limit covers the distinct statements: exact */
+    dedup = raptor_new_statement_dedup(world, TEST_ITEMS * 4, bloom);
+    if(!dedup) {
+      fprintf(stderr, "%s: raptor_new_statement_dedup() failed\n", program);
+      rc = 1;
+      break;
+    }
+
+    /* every triple twice and again in a graph, which is distinct */
+    for(i = 0; i < TEST_ITEMS * 4; i++) {
+      raptor_statement* statement;
+      int r;
+
+      statement = test_make_statement(world, (i * 7) % TEST_ITEMS,
+                                      (i / TEST_ITEMS) & 1);
+      r = raptor_statement_dedup_check(dedup, statement);
+      raptor_free_statement(statement);
+      if(r < 0) {
+        fprintf(stderr, "%s: raptor_statement_dedup_check() failed\n",
+                program);
+        rc = 1;
+        break;
+      }
+      if(!r)
+        new_count++;
+    }
+
+    if(new_count != TEST_ITEMS * 2) {
+      fprintf(stderr, "%s: bloom %d found %d new statements, expected %d\n",
+              program, bloom, new_count, TEST_ITEMS * 2);
+      rc = 1;
+    }
+    raptor_free_statement_dedup(dedup);
+
+    /* small limit: every repeat further apart than the limit passes */
+    dedup = raptor_new_statement_dedup(world, 10, bloom);
+    new_count = 0;
+    for(i = 0; i < TEST_ITEMS * 2; i++) {
+      raptor_statement* statement;
+
+      statement = test_make_statement(world, i % TEST_ITEMS, 0);
+      if(!raptor_statement_dedup_check(dedup, statement))
+        new_count++;
+      raptor_free_statement(statement);
+    }
+    if(new_count != TEST_ITEMS * 2) {
+      fprintf(stderr, "%s: bloom %d limit 10 found %d new statements, expected %d\n",
+              program, bloom, new_count, TEST_ITEMS * 2);
+      rc = 1;
+    }
+    raptor_free_statement_dedup(dedup);
+
+    /* repeats within half the limit are found across generation swaps */
+    dedup = raptor_new_statement_dedup(world, 10, bloom);
+    for(i = 0; i < TEST_ITEMS; i++) {
+      raptor_statement* statement;
+      int j;
+
+      statement = test_make_statement(world, i, 0);
+      if(raptor_statement_dedup_check(dedup, statement)) {
+        fprintf(stderr, "%s: bloom %d statement %d is not new\n",
+                program, bloom, i);
+        rc = 1;
+      }
+      raptor_free_statement(statement);
+
+      for(j = (i > 4) ? i - 4 : 0; j <= i; j++) {
+        statement = test_make_statement(world, j, 0);
+        if(raptor_statement_dedup_check(dedup, statement) != 1) {
+          fprintf(stderr, "%s: bloom %d statement %d forgotten after %d\n",
+                  program, bloom, j, i);
+          rc = 1;
+        }
+        raptor_free_statement(statement);
+      }
+    }
+    raptor_free_statement_dedup(dedup);
+  }
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif /* STANDALONE */
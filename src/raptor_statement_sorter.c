@@ -0,0 +1,1140 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_statement_sorter.c - Raptor bounded-memory statement sorting
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * A statement sorter collects statements and returns them in
+ * raptor_statement_compare() order with duplicates removed.
+ *
+ * Statements are appended to an array and sorted only when needed,
+ * with a radix sort or, if worker threads are enabled, a parallel
+ * merge sort.  If a memory limit is set and the estimated size of
+ * the array exceeds it, the array is sorted and written in order to
+ * a temporary file (a sorted run) and emptied.  When the statements
+ * are visited the runs are merged.  With no limit or a small input
+ * nothing is written to disk.  Duplicates are removed as the sorted
+ * statements are written or visited.
+ *
+ * To bound the number of open run files, runs are merged in tiers:
+ * each run has a level, 0 for a spilled run, and when there are
+ * RAPTOR_STATEMENT_SORTER_MERGE_RUNS runs of one level they are
+ * merged into one run of the next level.  Only runs of similar size
+ * are merged, so each statement is rewritten once per level rather
+ * than at every merge.  The levels of the runs never increase from
+ * first to last so runs of the same level are always the last ones.
+ *
+ * Run files hold a sequence of statements in an internal
+ * native-endian format only ever read back by the same process:
+ *   term   := type-byte [ body ]
+ *   body   := string                      for URI and blank terms
+ *           | string string string        for literals: value,
+ *                                         datatype URI, language
+ *   string := size_t length, length bytes
+ * and a statement is four terms (graph is RAPTOR_TERM_TYPE_UNKNOWN
+ * when absent).
+ */
+
+
+/* POLICY - number of runs of one level merged into a run of the next */
+#define RAPTOR_STATEMENT_SORTER_MERGE_RUNS 16
+
+/* POLICY - smallest number of statements sorted with worker threads */
+#define RAPTOR_STATEMENT_SORTER_PARALLEL_MIN 16384
+
+
+struct raptor_statement_sorter_s {
+  raptor_world* world;
+
+  /* approximate maximum bytes held in memory; 0 for no limit */
+  size_t memory_limit;
+
+  /* approximate bytes used by statements in @statements */
+  size_t memory_used;
+
+  /* number of threads to sort with; 0 or 1 to sort serially */
+  int threads;
+
+  /* in-memory unsorted statements, copied into @arena */
+  raptor_statement** statements;
+  size_t statements_count;
+  size_t statements_size;
+  raptor_statement_arena* arena;
+
+  /* sorted runs on disk and the merge level of each */
+  FILE** runs;
+  int* run_levels;
+  int runs_count;
+  int runs_size;
+
+  /* last statement returned by a merge; kept alive until the next one */
+  raptor_statement* last;
+
+  /* scratch buffer for reading strings back from runs */
+  unsigned char* buffer;
+  size_t buffer_size;
+};
+
+
+/* A sorted run being read during a merge */
+typedef struct {
+  FILE* fh;
+
+  /* next statement from this run (owned) or NULL at end */
+  raptor_statement* statement;
+} raptor_statement_sorter_reader;
+
+
+/**
+ * raptor_new_statement_sorter:
+ * @world: raptor world
+ * @memory_limit: approximate maximum number of bytes to hold in memory or 0 for no limit
+ *
+ * INTERNAL - Constructor - create a statement sorter
+ *
+ * Return value: new statement sorter or NULL on failure
+ */
+raptor_statement_sorter*
+raptor_new_statement_sorter(raptor_world* world, size_t memory_limit)
+{
+  raptor_statement_sorter* sorter;
+
+  sorter = RAPTOR_CALLOC(raptor_statement_sorter*, 1, sizeof(*sorter));
+  if(!sorter)
+    return NULL;
+
+  sorter->world = world;
+  sorter->memory_limit = memory_limit;
+
+  sorter->arena = raptor_new_statement_arena(world);
+  if(!sorter->arena) {
+    raptor_free_statement_sorter(sorter);
+    return NULL;
+  }
+
+  return sorter;
+}
+
+
+/**
+ * raptor_free_statement_sorter:
+ * @sorter: statement sorter
+ *
+ * INTERNAL - Destructor - destroy a statement sorter and remove any
+ * temporary files
+ */
+void
+raptor_free_statement_sorter(raptor_statement_sorter* sorter)
+{
+  int i;
+
+  if(!sorter)
+    return;
+
+  if(sorter->statements)
+    RAPTOR_FREE(raptor_statement**, sorter->statements);
+
+  if(sorter->arena)
+    raptor_free_statement_arena(sorter->arena);
+
+  for(i = 0; i < sorter->runs_count; i++)
+    fclose(sorter->runs[i]);
+  if(sorter->runs)
+    RAPTOR_FREE(FILE**, sorter->runs);
+  if(sorter->run_levels)
+    RAPTOR_FREE(int*, sorter->run_levels);
+
+  if(sorter->last)
+    raptor_free_statement(sorter->last);
+
+  if(sorter->buffer)
+    RAPTOR_FREE(char*, sorter->buffer);
+
+  RAPTOR_FREE(raptor_statement_sorter, sorter);
+}
+
+
+/**
+ * raptor_statement_sorter_set_threads:
+ * @sorter: statement sorter
+ * @threads: number of threads to sort with; 0 or 1 to sort serially
+ *
+ * INTERNAL - Set the number of worker threads used to sort statements
+ */
+void
+raptor_statement_sorter_set_threads(raptor_statement_sorter* sorter,
+                                    int threads)
+{
+  sorter->threads = threads;
+}
+
+
+static size_t
+raptor_statement_sorter_term_size(raptor_term* term)
+{
+  size_t size;
+
+  if(!term)
+    return 0;
+
+  size = sizeof(*term);
+  if(term->type == RAPTOR_TERM_TYPE_BLANK)
+    size += term->value.blank.string_len + 1;
+  else if(term->type == RAPTOR_TERM_TYPE_LITERAL)
+    size += term->value.literal.string_len + 1 +
+            term->value.literal.language_len;
+  /* URIs are interned and shared so are not counted */
+
+  return size;
+}
+
+
+static int
+raptor_statement_sorter_write_string(FILE* fh, const unsigned char* string,
+                                     size_t length)
+{
+  if(fwrite(&length, sizeof(length), 1, fh) != 1)
+    return 1;
+
+  if(length && fwrite(string, 1, length, fh) != length)
+    return 1;
+
+  return 0;
+}
+
+
+static int
+raptor_statement_sorter_write_uri(FILE* fh, raptor_uri* uri)
+{
+  const unsigned char* string = NULL;
+  size_t length = 0;
+
+  if(uri)
+    string = raptor_uri_as_counted_string(uri, &length);
+
+  return raptor_statement_sorter_write_string(fh, string, length);
+}
+
+
+static int
+raptor_statement_sorter_write_term(FILE* fh, raptor_term* term)
+{
+  unsigned char type;
+
+  type = RAPTOR_GOOD_CAST(unsigned char,
+                          term ? term->type : RAPTOR_TERM_TYPE_UNKNOWN);
+  if(fputc(type, fh) == EOF)
+    return 1;
+
+  if(!term)
+    return 0;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      return raptor_statement_sorter_write_uri(fh, term->value.uri);
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      return raptor_statement_sorter_write_string(fh,
+                                                  term->value.blank.string,
+                                                  term->value.blank.string_len);
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      if(raptor_statement_sorter_write_string(fh,
+                                              term->value.literal.string,
+                                              term->value.literal.string_len))
+        return 1;
+      if(raptor_statement_sorter_write_uri(fh, term->value.literal.datatype))
+        return 1;
+      return raptor_statement_sorter_write_string(fh,
+                                                  term->value.literal.language,
+                                                  term->value.literal.language_len);
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+
+static int
+raptor_statement_sorter_write_statement(FILE* fh, raptor_statement* statement)
+{
+  if(raptor_statement_sorter_write_term(fh, statement->subject) ||
+     raptor_statement_sorter_write_term(fh, statement->predicate) ||
+     raptor_statement_sorter_write_term(fh, statement->object) ||
+     raptor_statement_sorter_write_term(fh, statement->graph))
+    return 1;
+
+  return 0;
+}
+
+
+/*
+ * Read a string into the sorter scratch buffer, NUL terminated.
+ * Return value: <0 on failure
+ */
+static int
+raptor_statement_sorter_read_string(raptor_statement_sorter* sorter,
+                                    FILE* fh, size_t* length_p)
+{
+  size_t length;
+
+  if(fread(&length, sizeof(length), 1, fh) != 1)
+    return -1;
+
+  if(length + 1 > sorter->buffer_size) {
+    unsigned char* buffer;
+    size_t size = sorter->buffer_size ? sorter->buffer_size : 256;
+
+    while(size < length + 1)
+      size <<= 1;
+
+    buffer = RAPTOR_MALLOC(unsigned char*, size);
+    if(!buffer)
+      return -1;
+    if(sorter->buffer)
+      RAPTOR_FREE(char*, sorter->buffer);
+    sorter->buffer = buffer;
+    sorter->buffer_size = size;
+  }
+
+  if(length && fread(sorter->buffer, 1, length, fh) != length)
+    return -1;
+  sorter->buffer[length] = '\0';
+
+  *length_p = length;
+
+  return 0;
+}
+
+
+/*
+ * Read a term from a run.
+ * Return value: <0 on failure, >0 at end of file, 0 on success
+ */
+static int
+raptor_statement_sorter_read_term(raptor_statement_sorter* sorter, FILE* fh,
+                                  raptor_term** term_p)
+{
+  raptor_world* world = sorter->world;
+  raptor_term* term = NULL;
+  raptor_uri* datatype = NULL;
+  unsigned char* string;
+  size_t string_len;
+  size_t length;
+  int c;
+
+  *term_p = NULL;
+
+  c = fgetc(fh);
+  if(c == EOF)
+    return 1;
+
+  switch((raptor_term_type)c) {
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+      return 0;
+
+    case RAPTOR_TERM_TYPE_URI:
+      if(raptor_statement_sorter_read_string(sorter, fh, &length))
+        return -1;
+      term = raptor_new_term_from_counted_uri_string(world, sorter->buffer,
+                                                     length);
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      if(raptor_statement_sorter_read_string(sorter, fh, &length))
+        return -1;
+      term = raptor_new_term_from_counted_blank(world, sorter->buffer, length);
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      /* the value is copied as the buffer is reused for the datatype */
+      if(raptor_statement_sorter_read_string(sorter, fh, &length))
+        return -1;
+      string_len = length;
+      string = RAPTOR_MALLOC(unsigned char*, string_len + 1);
+      if(!string)
+        return -1;
+      memcpy(string, sorter->buffer, string_len + 1);
+
+      if(raptor_statement_sorter_read_string(sorter, fh, &length)) {
+        RAPTOR_FREE(char*, string);
+        return -1;
+      }
+      if(length) {
+        datatype = raptor_new_uri_from_counted_string(world, sorter->buffer,
+                                                      length);
+        if(!datatype) {
+          RAPTOR_FREE(char*, string);
+          return -1;
+        }
+      }
+
+      if(raptor_statement_sorter_read_string(sorter, fh, &length)) {
+        if(datatype)
+          raptor_free_uri(datatype);
+        RAPTOR_FREE(char*, string);
+        return -1;
+      }
+
+      term = raptor_new_term_from_counted_literal(world,
+                                                  string, string_len,
+                                                  datatype,
+                                                  length ? sorter->buffer : NULL,
+                                                  RAPTOR_BAD_CAST(unsigned char, length));
+      if(datatype)
+        raptor_free_uri(datatype);
+      RAPTOR_FREE(char*, string);
+      break;
+
+    default:
+      return -1;
+  }
+
+  if(!term)
+    return -1;
+
+  *term_p = term;
+
+  return 0;
+}
+
+
+/*
+ * Read the next statement from a run into @reader.
+ * Return value: <0 on failure, >0 at end of file, 0 on success
+ */
+static int
+raptor_statement_sorter_read_statement(raptor_statement_sorter* sorter,
+                                       raptor_statement_sorter_reader* reader)
+{
+  raptor_term* terms[4] = { NULL, NULL, NULL, NULL };
+  int i;
+  int rc = 0;
+
+  reader->statement = NULL;
+
+  for(i = 0; i < 4; i++) {
+    rc = raptor_statement_sorter_read_term(sorter, reader->fh, &terms[i]);
+    if(rc)
+      break;
+  }
+
+  if(rc) {
+    /* end of file is only expected before the first term */
+    if(rc > 0 && i)
+      rc = -1;
+    for(i = 0; i < 4; i++) {
+      if(terms[i])
+        raptor_free_term(terms[i]);
+    }
+    return rc;
+  }
+
+  reader->statement = raptor_new_statement_from_nodes(sorter->world,
+                                                      terms[0], terms[1],
+                                                      terms[2], terms[3]);
+
+  return reader->statement ? 0 : -1;
+}
+
+
+static int
+raptor_statement_sorter_add_run(raptor_statement_sorter* sorter, FILE* fh,
+                                int level)
+{
+  if(sorter->runs_count == sorter->runs_size) {
+    int size = sorter->runs_size ? sorter->runs_size << 1 : 8;
+    FILE** runs;
+    int* run_levels;
+
+    runs = RAPTOR_CALLOC(FILE**, RAPTOR_GOOD_CAST(size_t, size), sizeof(FILE*));
+    if(!runs)
+      return 1;
+    run_levels = RAPTOR_CALLOC(int*, RAPTOR_GOOD_CAST(size_t, size),
+                               sizeof(int));
+    if(!run_levels) {
+      RAPTOR_FREE(FILE**, runs);
+      return 1;
+    }
+    if(sorter->runs) {
+      memcpy(runs, sorter->runs, sizeof(FILE*) * sorter->runs_count);
+      memcpy(run_levels, sorter->run_levels, sizeof(int) * sorter->runs_count);
+      RAPTOR_FREE(FILE**, sorter->runs);
+      RAPTOR_FREE(int*, sorter->run_levels);
+    }
+    sorter->runs = runs;
+    sorter->run_levels = run_levels;
+    sorter->runs_size = size;
+  }
+
+  sorter->run_levels[sorter->runs_count] = level;
+  sorter->runs[sorter->runs_count++] = fh;
+
+  return 0;
+}
+
+
+static FILE*
+raptor_statement_sorter_new_run_file(raptor_statement_sorter* sorter)
+{
+  FILE* fh;
+
+  fh = tmpfile();
+  if(!fh)
+    raptor_log_error(sorter->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                     "Failed to create temporary file for sorting statements");
+
+  return fh;
+}
+
+
+static int raptor_statement_sorter_merge(raptor_statement_sorter* sorter, int first, raptor_statement_sorter_handler handler, void* user_data);
+
+
+static int
+raptor_statement_sorter_write_handler(void* user_data,
+                                      raptor_statement* statement)
+{
+  return raptor_statement_sorter_write_statement((FILE*)user_data, statement);
+}
+
+
+/*
+ * While the last RAPTOR_STATEMENT_SORTER_MERGE_RUNS runs have the
+ * same level, merge them into one run of the next level.
+ */
+static int
+raptor_statement_sorter_compact_runs(raptor_statement_sorter* sorter)
+{
+  while(sorter->runs_count >= RAPTOR_STATEMENT_SORTER_MERGE_RUNS) {
+    int first = sorter->runs_count - RAPTOR_STATEMENT_SORTER_MERGE_RUNS;
+    int level = sorter->run_levels[first];
+    FILE* fh;
+    int rc;
+
+    if(sorter->run_levels[sorter->runs_count - 1] != level)
+      break;
+
+    fh = raptor_statement_sorter_new_run_file(sorter);
+    if(!fh)
+      return 1;
+
+    rc = raptor_statement_sorter_merge(sorter, first,
+                                       raptor_statement_sorter_write_handler,
+                                       fh);
+    if(!rc && fflush(fh))
+      rc = 1;
+    if(rc) {
+      fclose(fh);
+      return rc;
+    }
+
+    /* the merge has consumed and closed the merged runs */
+    rewind(fh);
+    if(raptor_statement_sorter_add_run(sorter, fh, level + 1)) {
+      fclose(fh);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+static int
+raptor_statement_sorter_compare(const void* a, const void* b)
+{
+  return raptor_statement_compare(*(raptor_statement* const*)a,
+                                  *(raptor_statement* const*)b);
+}
+
+
+/*
+ * Sort the in-memory statements, sharing the work between worker
+ * threads when enabled and there are enough statements.
+ */
+static void
+raptor_statement_sorter_sort(raptor_statement_sorter* sorter)
+{
+  raptor_thread_pool* pool = NULL;
+
+  if(sorter->threads > 1 &&
+     sorter->statements_count >= RAPTOR_STATEMENT_SORTER_PARALLEL_MIN)
+    pool = raptor_new_thread_pool(sorter->world, sorter->threads);
+
+  if(pool && raptor_thread_pool_get_threads_count(pool)) {
+    /* comparing URIs is read-only while the world is shared */
+    raptor_world_internal_threads_start(sorter->world);
+    raptor_sort_parallel((void**)sorter->statements, sorter->statements_count,
+                         raptor_statement_sorter_compare, pool);
+    raptor_world_internal_threads_end(sorter->world);
+  } else
+    raptor_statement_radix_sort(sorter->statements, sorter->statements_count);
+
+  if(pool)
+    raptor_free_thread_pool(pool);
+}
+
+
+/*
+ * Sort the in-memory statements and call @handler with each distinct
+ * one in order.
+ */
+static int
+raptor_statement_sorter_visit_memory(raptor_statement_sorter* sorter,
+                                     raptor_statement_sorter_handler handler,
+                                     void* user_data)
+{
+  raptor_statement* last = NULL;
+  size_t i;
+
+  raptor_statement_sorter_sort(sorter);
+
+  for(i = 0; i < sorter->statements_count; i++) {
+    raptor_statement* statement = sorter->statements[i];
+
+    if(last && !raptor_statement_compare(last, statement))
+      continue;
+
+    if(handler(user_data, statement))
+      return 1;
+
+    last = statement;
+  }
+
+  return 0;
+}
+
+
+/*
+ * Write the in-memory statements to a new sorted run and empty them.
+ */
+static int
+raptor_statement_sorter_spill(raptor_statement_sorter* sorter)
+{
+  FILE* fh;
+  int rc;
+
+  if(!sorter->statements_count)
+    return 0;
+
+  fh = raptor_statement_sorter_new_run_file(sorter);
+  if(!fh)
+    return 1;
+
+  rc = raptor_statement_sorter_visit_memory(sorter,
+                                            raptor_statement_sorter_write_handler,
+                                            fh);
+  if(!rc && fflush(fh))
+    rc = 1;
+
+  if(rc) {
+    raptor_log_error(sorter->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                     "Failed to write statements to temporary file");
+    fclose(fh);
+    return rc;
+  }
+
+  rewind(fh);
+  if(raptor_statement_sorter_add_run(sorter, fh, 0)) {
+    fclose(fh);
+    return 1;
+  }
+
+  sorter->statements_count = 0;
+  raptor_statement_arena_clear(sorter->arena);
+  sorter->memory_used = 0;
+
+  return raptor_statement_sorter_compact_runs(sorter);
+}
+
+
+/**
+ * raptor_statement_sorter_add:
+ * @sorter: statement sorter
+ * @statement: statement to add (copied)
+ *
+ * INTERNAL - Add a statement to a sorter
+ *
+ * Duplicates are kept until the statements are sorted so are not
+ * reported here.
+ *
+ * Return value: 0 on success, <0 on failure
+ */
+int
+raptor_statement_sorter_add(raptor_statement_sorter* sorter,
+                            raptor_statement* statement)
+{
+  raptor_statement* s;
+  size_t size;
+
+  if(sorter->statements_count == sorter->statements_size) {
+    size_t new_size = sorter->statements_size ? sorter->statements_size << 1
+                                              : 1024;
+    raptor_statement** statements;
+
+    statements = RAPTOR_MALLOC(raptor_statement**,
+                               new_size * sizeof(*statements));
+    if(!statements)
+      return -1;
+    if(sorter->statements) {
+      memcpy(statements, sorter->statements,
+             sorter->statements_count * sizeof(*statements));
+      RAPTOR_FREE(raptor_statement**, sorter->statements);
+    }
+    sorter->statements = statements;
+    sorter->statements_size = new_size;
+  }
+
+  s = raptor_statement_arena_copy(sorter->arena, statement);
+  if(!s)
+    return -1;
+
+  sorter->statements[sorter->statements_count++] = s;
+
+  size = sizeof(*s) + sizeof(s) +
+         raptor_statement_sorter_term_size(s->subject) +
+         raptor_statement_sorter_term_size(s->predicate) +
+         raptor_statement_sorter_term_size(s->object) +
+         raptor_statement_sorter_term_size(s->graph);
+
+  sorter->memory_used += size;
+
+  if(sorter->memory_limit && sorter->memory_used > sorter->memory_limit) {
+    if(raptor_statement_sorter_spill(sorter))
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * Binary min-heap of readers ordered by their current statement.
+ */
+static void
+raptor_statement_sorter_heap_down(raptor_statement_sorter_reader** heap,
+                                  int size, int i)
+{
+  while(1) {
+    int smallest = i;
+    int l = 2 * i + 1;
+    int r = l + 1;
+
+    if(l < size && raptor_statement_compare(heap[l]->statement,
+                                            heap[smallest]->statement) < 0)
+      smallest = l;
+    if(r < size && raptor_statement_compare(heap[r]->statement,
+                                            heap[smallest]->statement) < 0)
+      smallest = r;
+    if(smallest == i)
+      break;
+
+    {
+      raptor_statement_sorter_reader* tmp = heap[i];
+      heap[i] = heap[smallest];
+      heap[smallest] = tmp;
+    }
+    i = smallest;
+  }
+}
+
+
+/*
+ * Merge the runs from index @first to the last, calling @handler with
+ * each distinct statement in order.  The runs are consumed and closed.
+ */
+static int
+raptor_statement_sorter_merge(raptor_statement_sorter* sorter, int first,
+                              raptor_statement_sorter_handler handler,
+                              void* user_data)
+{
+  raptor_statement_sorter_reader* readers = NULL;
+  raptor_statement_sorter_reader** heap = NULL;
+  raptor_statement* last = NULL;
+  int count = sorter->runs_count - first;
+  int heap_size = 0;
+  int i;
+  int rc = 0;
+
+  if(!count)
+    return 0;
+
+  readers = RAPTOR_CALLOC(raptor_statement_sorter_reader*,
+                          RAPTOR_GOOD_CAST(size_t, count), sizeof(*readers));
+  heap = RAPTOR_CALLOC(raptor_statement_sorter_reader**,
+                       RAPTOR_GOOD_CAST(size_t, count), sizeof(*heap));
+  if(!readers || !heap) {
+    rc = 1;
+    goto tidy;
+  }
+
+  for(i = 0; i < count; i++) {
+    int r;
+
+    readers[i].fh = sorter->runs[first + i];
+    r = raptor_statement_sorter_read_statement(sorter, &readers[i]);
+    if(r < 0) {
+      rc = 1;
+      goto tidy;
+    }
+    if(!r)
+      heap[heap_size++] = &readers[i];
+  }
+
+  for(i = heap_size / 2 - 1; i >= 0; i--)
+    raptor_statement_sorter_heap_down(heap, heap_size, i);
+
+  while(heap_size) {
+    raptor_statement_sorter_reader* reader = heap[0];
+    raptor_statement* statement = reader->statement;
+    int r;
+
+    r = raptor_statement_sorter_read_statement(sorter, reader);
+    if(r < 0) {
+      raptor_free_statement(statement);
+      rc = 1;
+      break;
+    }
+    if(r)
+      heap[0] = heap[--heap_size];
+    raptor_statement_sorter_heap_down(heap, heap_size, 0);
+
+    if(last && !raptor_statement_compare(last, statement)) {
+      /* duplicate from another run */
+      raptor_free_statement(statement);
+      continue;
+    }
+
+    if(handler(user_data, statement)) {
+      raptor_free_statement(statement);
+      rc = 1;
+      break;
+    }
+
+    /* the handler may refer to the previous statement until now */
+    if(last)
+      raptor_free_statement(last);
+    last = statement;
+  }
+
+  tidy:
+  if(readers) {
+    for(i = 0; i < count; i++) {
+      if(readers[i].statement)
+        raptor_free_statement(readers[i].statement);
+    }
+    RAPTOR_FREE(raptor_statement_sorter_reader*, readers);
+  }
+  if(heap)
+    RAPTOR_FREE(raptor_statement_sorter_reader**, heap);
+
+  for(i = 0; i < count; i++)
+    fclose(sorter->runs[first + i]);
+  sorter->runs_count = first;
+
+  if(sorter->last)
+    raptor_free_statement(sorter->last);
+  sorter->last = last;
+
+  return rc;
+}
+
+
+/**
+ * raptor_statement_sorter_visit:
+ * @sorter: statement sorter
+ * @handler: function to call with each statement
+ * @user_data: user data for @handler
+ *
+ * INTERNAL - Call a handler with all statements in order, with
+ * duplicates removed, and empty the sorter.
+ *
+ * Each statement passed to @handler remains valid until @handler is
+ * next called, or until the sorter is freed for the last one.  A
+ * non-0 return from @handler stops the visit.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_statement_sorter_visit(raptor_statement_sorter* sorter,
+                              raptor_statement_sorter_handler handler,
+                              void* user_data)
+{
+  if(sorter->runs_count) {
+    /* merge the in-memory statements as one more run */
+    if(raptor_statement_sorter_spill(sorter))
+      return 1;
+
+    return raptor_statement_sorter_merge(sorter, 0, handler, user_data);
+  }
+
+  /* statements stay in the arena, and valid, until the sorter is freed */
+  return raptor_statement_sorter_visit_memory(sorter, handler, user_data);
+}
+
+
+/**
+ * raptor_statement_sorter_get_runs_count:
+ * @sorter: statement sorter
+ *
+ * INTERNAL - Get the number of sorted runs written to temporary files
+ *
+ * Return value: number of runs
+ */
+int
+raptor_statement_sorter_get_runs_count(raptor_statement_sorter* sorter)
+{
+  return sorter->runs_count;
+}
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_ITEMS 2000
+
+/* enough for a parallel sort */
+#define TEST_PARALLEL_ITEMS 40000
+
+typedef struct {
+  const char* program;
+  raptor_statement* previous;
+  int count;
+  int errors;
+} test_visit_state;
+
+
+static int
+test_visit_handler(void* user_data, raptor_statement* statement)
+{
+  test_visit_state* state = (test_visit_state*)user_data;
+
+  if(state->previous &&
+     raptor_statement_compare(state->previous, statement) >= 0) {
+    fprintf(stderr, "%s: statement %d is out of order or a duplicate\n",
+            state->program, state->count);
+    state->errors++;
+  }
+
+  state->previous = statement;
+  state->count++;
+
+  return 0;
+}
+
+
+static raptor_statement*
+test_make_statement(raptor_world* world, int i)
+{
+  unsigned char buffer[64];
+  raptor_term* s;
+  raptor_term* p;
+  raptor_term* o;
+
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/s%d", i % 97);
+  s = (i % 3) ? raptor_new_term_from_uri_string(world, buffer)
+              : raptor_new_term_from_blank(world, buffer + 19);
+  snprintf((char*)buffer, sizeof(buffer), "http://example.org/p%d", i % 5);
+  p = raptor_new_term_from_uri_string(world, buffer);
+  snprintf((char*)buffer, sizeof(buffer), "value %d", i);
+  if(i % 4 == 0)
+    o = raptor_new_term_from_literal(world, buffer, NULL,
+                                     (const unsigned char*)"en");
+  else if(i % 4 == 1) {
+    raptor_uri* dt = raptor_new_uri(world, (const unsigned char*)"http://www.w3.org/2001/XMLSchema#string");
+    o = raptor_new_term_from_literal(world, buffer, dt, NULL);
+    raptor_free_uri(dt);
+  } else if(i % 4 == 2)
+    o = raptor_new_term_from_literal(world, (const unsigned char*)"", NULL,
+                                     NULL);
+  else
+    o = raptor_new_term_from_uri_string(world, (const unsigned char*)"http://example.org/o");
+
+  return raptor_new_statement_from_nodes(world, s, p, o, NULL);
+}
+
+
+static int
+test_compare(const void* a, const void* b)
+{
+  return raptor_statement_compare(*(raptor_statement* const*)a,
+                                  *(raptor_statement* const*)b);
+}
+
+
+/* Check the radix sort gives the same order as comparison sorting */
+static int
+test_radix_sort(const char* program, raptor_world* world)
+{
+  raptor_statement* statements[TEST_ITEMS];
+  raptor_statement* sorted[TEST_ITEMS];
+  int i;
+  int rc = 0;
+
+  for(i = 0; i < TEST_ITEMS; i++) {
+    statements[i] = test_make_statement(world, (i * 7) % TEST_ITEMS);
+    if(i % 5 == 0) {
+      /* some statements with a graph, of either term type */
+      unsigned char buffer[32];
+
+      snprintf((char*)buffer, sizeof(buffer), "g%d", i % 3);
+      statements[i]->graph = (i % 2) ?
+        raptor_new_term_from_blank(world, buffer) :
+        raptor_new_term_from_uri_string(world, buffer);
+    }
+    sorted[i] = statements[i];
+  }
+
+  qsort(statements, TEST_ITEMS, sizeof(raptor_statement*), test_compare);
+  raptor_statement_radix_sort(sorted, TEST_ITEMS);
+
+  for(i = 0; i < TEST_ITEMS; i++) {
+    if(raptor_statement_compare(statements[i], sorted[i])) {
+      fprintf(stderr, "%s: radix sorted statement %d is out of order\n",
+              program, i);
+      rc = 1;
+      break;
+    }
+  }
+
+  for(i = 0; i < TEST_ITEMS; i++)
+    raptor_free_statement(statements[i]);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  size_t limits[5] = { 0, 4096, 64, 0, 0 };
+  int threads[5] = { 0, 0, 0, 0, 4 };
+  int items[5] = { TEST_ITEMS, TEST_ITEMS, TEST_ITEMS,
+                   TEST_PARALLEL_ITEMS, TEST_PARALLEL_ITEMS };
+  int expected[2] = { -1, -1 };
+  int l;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  if(test_radix_sort(program, world))
+    rc = 1;
+
+  for(l = 0; l < 5; l++) {
+    raptor_statement_sorter* sorter;
+    test_visit_state state;
+    int e;
+    int i;
+
+    sorter = raptor_new_statement_sorter(world, limits[l]);
+    if(!sorter) {
+      fprintf(stderr, "%s: raptor_new_statement_sorter() failed\n", program);
+      rc = 1;
+      break;
+    }
+    raptor_statement_sorter_set_threads(sorter, threads[l]);
+
+    /* add every statement twice so duplicates land in different runs */
+    for(i = 0; i < items[l] * 2; i++) {
+      raptor_statement* statement;
+
+      statement = test_make_statement(world, (i * 7) % items[l]);
+      if(raptor_statement_sorter_add(sorter, statement) < 0) {
+        fprintf(stderr, "%s: raptor_statement_sorter_add() failed\n",
+                program);
+        rc = 1;
+      }
+      raptor_free_statement(statement);
+    }
+
+    if(limits[l] && !raptor_statement_sorter_get_runs_count(sorter)) {
+      fprintf(stderr, "%s: limit %d wrote no runs\n", program,
+              (int)limits[l]);
+      rc = 1;
+    }
+
+    /* with a tiny limit every add spills; merging keeps few runs */
+    if(limits[l] && raptor_statement_sorter_get_runs_count(sorter) > 64) {
+      fprintf(stderr, "%s: limit %d kept %d runs\n", program,
+              (int)limits[l], raptor_statement_sorter_get_runs_count(sorter));
+      rc = 1;
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.program = program;
+    if(raptor_statement_sorter_visit(sorter, test_visit_handler, &state)) {
+      fprintf(stderr, "%s: raptor_statement_sorter_visit() failed\n",
+              program);
+      rc = 1;
+    }
+    if(state.errors)
+      rc = 1;
+
+    e = (items[l] != TEST_ITEMS);
+    if(expected[e] < 0)
+      expected[e] = state.count;
+    else if(state.count != expected[e]) {
+      fprintf(stderr, "%s: limit %d threads %d returned %d statements, expected %d\n",
+              program, (int)limits[l], threads[l], state.count, expected[e]);
+      rc = 1;
+    }
+
+    raptor_free_statement_sorter(sorter);
+  }
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
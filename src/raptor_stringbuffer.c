@@ -44,27 +44,24 @@
 
 #ifndef STANDALONE
 
-struct raptor_stringbuffer_node_s
-{
-  struct raptor_stringbuffer_node_s* next;
-  unsigned char *string;
-  size_t length;
-};
-typedef struct raptor_stringbuffer_node_s raptor_stringbuffer_node;
-
+/* size of the storage inside the stringbuffer object used before
+ * a string is allocated */
+#define RAPTOR_STRINGBUFFER_INLINE_SIZE 64
 
 struct raptor_stringbuffer_s
 {
-  /* Pointing to the first item in the list of nodes */
-  raptor_stringbuffer_node* head;
-  /* and the last */
-  raptor_stringbuffer_node* tail;
-  
-  /* total length of the string */
+  /* string storage: either inline_string or allocated; always
+   * '\0' terminated at length */
+  unsigned char *string;
+
+  /* length of the string */
   size_t length;
 
-  /* frozen string if already calculated, or NULL if not present */
-  unsigned char *string;
+  /* size of the string storage */
+  size_t size;
+
+  /* initial string storage to avoid allocating for short strings */
+  unsigned char inline_string[RAPTOR_STRINGBUFFER_INLINE_SIZE];
 };
 
 
@@ -87,6 +84,12 @@ raptor_new_stringbuffer(void)
   raptor_stringbuffer* sb;
   
   sb = RAPTOR_CALLOC(raptor_stringbuffer*, 1, sizeof(*sb));
+  if(!sb)
+    return NULL;
+
+  sb->string = sb->inline_string;
+  sb->size = RAPTOR_STRINGBUFFER_INLINE_SIZE;
+
   return sb;
 }
 
@@ -104,26 +107,73 @@ raptor_free_stringbuffer(raptor_stringbuffer *stringbuffer)
   if(!stringbuffer)
     return;
 
-  if(stringbuffer->head) {
-    raptor_stringbuffer_node *node = stringbuffer->head;
-  
-    while(node) {
-      raptor_stringbuffer_node *next = node->next;
-      
-      if(node->string)
-        RAPTOR_FREE(char*, node->string);
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      node = next;
-    }
-  }
-
-  if(stringbuffer->string)
+  if(stringbuffer->string != stringbuffer->inline_string)
     RAPTOR_FREE(char*, stringbuffer->string);
 
   RAPTOR_FREE(raptor_stringbuffer, stringbuffer);
 }
 
 
+/*
+ * raptor_stringbuffer_ensure:
+ * @stringbuffer: raptor stringbuffer
+ * @length: extra length needed
+ *
+ * INTERNAL - Make room for @length more bytes and a '\0'
+ *
+ * The storage grows geometrically so appends are amortized O(1).
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_stringbuffer_ensure(raptor_stringbuffer* stringbuffer, size_t length)
+{
+  size_t needed = stringbuffer->length + length + 1;
+  size_t size;
+  unsigned char *string;
+
+  if(needed <= stringbuffer->size)
+    return 0;
+
+  /* check for overflow */
+  if(needed < length)
+    return 1;
+
+  size = stringbuffer->size << 1;
+  if(size < needed)
+    size = needed;
+
+  if(stringbuffer->string == stringbuffer->inline_string) {
+    string = RAPTOR_MALLOC(unsigned char*, size);
+    if(!string)
+      return 1;
+    memcpy(string, stringbuffer->string, stringbuffer->length + 1);
+  } else {
+    string = RAPTOR_REALLOC(unsigned char*, stringbuffer->string, size);
+    if(!string)
+      return 1;
+  }
+
+  stringbuffer->string = string;
+  stringbuffer->size = size;
+
+  return 0;
+}
+
+
+/* Release any allocated storage and make the stringbuffer empty */
+static void
+raptor_stringbuffer_reset(raptor_stringbuffer* stringbuffer)
+{
+  if(stringbuffer->string != stringbuffer->inline_string)
+    RAPTOR_FREE(char*, stringbuffer->string);
+
+  stringbuffer->string = stringbuffer->inline_string;
+  stringbuffer->size = RAPTOR_STRINGBUFFER_INLINE_SIZE;
+  stringbuffer->length = 0;
+  *stringbuffer->string = '\0';
+}
+
 
 /**
  * raptor_stringbuffer_append_string_common:
@@ -150,45 +200,23 @@ raptor_stringbuffer_append_string_common(raptor_stringbuffer* stringbuffer,
                                          size_t length,
                                          int do_copy)
 {
-  raptor_stringbuffer_node *node;
+  int rc = 0;
 
   if(!string || !length)
     return 0;
-  
-  node = RAPTOR_MALLOC(raptor_stringbuffer_node*, sizeof(*node));
-  if(!node) {
-    if(!do_copy)
-      RAPTOR_FREE(char*, string);
-    return 1;
-  }
 
-  if(do_copy) {
-    /* Note this copy does not include the \0 character - not needed  */
-    node->string = RAPTOR_MALLOC(unsigned char*, length);
-    if(!node->string) {
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      return 1;
-    }
-    memcpy(node->string, string, length);
+  if(!raptor_stringbuffer_ensure(stringbuffer, length)) {
+    memcpy(stringbuffer->string + stringbuffer->length, string, length);
+    stringbuffer->length += length;
+    stringbuffer->string[stringbuffer->length] = '\0';
   } else
-    node->string = (unsigned char*)string;
-  node->length = length;
+    rc = 1;
 
+  /* the string is always copied so an owned one can go now */
+  if(!do_copy)
+    RAPTOR_FREE(char*, string);
 
-  if(stringbuffer->tail) {
-    stringbuffer->tail->next = node;
-    stringbuffer->tail = node;
-  } else
-    stringbuffer->head = stringbuffer->tail = node;
-  node->next = NULL;
-
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
-  }
-  stringbuffer->length += length;
-
-  return 0;
+  return rc;
 }
 
 
@@ -308,33 +336,26 @@ int
 raptor_stringbuffer_append_stringbuffer(raptor_stringbuffer* stringbuffer, 
                                         raptor_stringbuffer* append)
 {
-  raptor_stringbuffer_node *node = append->head;
-
-  if(!node)
+  if(!append->length)
     return 0;
 
-  /* move all append nodes to stringbuffer */
-  if(stringbuffer->tail) {
-    stringbuffer->tail->next = node;
-  } else
-    stringbuffer->head = node;
-
-  stringbuffer->tail = append->tail;
-
-  /* adjust our length */
-  stringbuffer->length += append->length;
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
-  }
+  if(!stringbuffer->length &&
+     append->string != append->inline_string) {
+    /* take over the allocated string */
+    if(stringbuffer->string != stringbuffer->inline_string)
+      RAPTOR_FREE(char*, stringbuffer->string);
+    stringbuffer->string = append->string;
+    stringbuffer->size = append->size;
+    stringbuffer->length = append->length;
+
+    append->string = append->inline_string;
+  } else if(raptor_stringbuffer_append_string_common(stringbuffer,
+                                                     append->string,
+                                                     append->length, 1))
+    return 1;
 
   /* zap append content */
-  append->head = append->tail = NULL;
-  append->length = 0;
-  if(append->string) {
-    RAPTOR_FREE(char*, append->string);
-    append->string = NULL;
-  }
+  raptor_stringbuffer_reset(append);
   
   return 0;
 }
@@ -364,37 +385,19 @@ raptor_stringbuffer_prepend_string_common(raptor_stringbuffer* stringbuffer,
                                           const unsigned char *string, size_t length,
                                           int do_copy)
 {
-  raptor_stringbuffer_node *node;
-
-  node = RAPTOR_MALLOC(raptor_stringbuffer_node*, sizeof(*node));
-  if(!node)
+  if(raptor_stringbuffer_ensure(stringbuffer, length))
     return 1;
 
-  if(do_copy) {
-    /* Note this copy does not include the \0 character - not needed  */
-    node->string = RAPTOR_MALLOC(unsigned char*, length);
-    if(!node->string) {
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      return 1;
-    }
-    memcpy(node->string, string, length);
-  } else
-    node->string = (unsigned char*)string;
-  node->length = length;
-
-
-  node->next = stringbuffer->head;
-  if(stringbuffer->head)
-    stringbuffer->head = node;
-  else
-    stringbuffer->head = stringbuffer->tail = node;
-
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
-  }
+  /* move the existing string and its '\0' up */
+  memmove(stringbuffer->string + length, stringbuffer->string,
+          stringbuffer->length + 1);
+  memcpy(stringbuffer->string, string, length);
   stringbuffer->length += length;
 
+  /* the string is always copied so an owned one can go now */
+  if(!do_copy)
+    RAPTOR_FREE(char*, string);
+
   return 0;
 }
 
@@ -470,7 +473,8 @@ raptor_stringbuffer_length(raptor_stringbuffer* stringbuffer)
  * Return the stringbuffer as a C string.
  * 
  * Note: the return value is a to a shared string that the stringbuffer
- * allocates and manages.
+ * allocates and manages.  It is only valid until the stringbuffer is
+ * next changed.
  *
  * Return value: NULL on failure or stringbuffer is empty, otherwise
  *   a pointer to a shared copy of the string.
@@ -478,26 +482,9 @@ raptor_stringbuffer_length(raptor_stringbuffer* stringbuffer)
 unsigned char *
 raptor_stringbuffer_as_string(raptor_stringbuffer* stringbuffer)
 {
-  raptor_stringbuffer_node *node;
-  unsigned char *p;
-  
   if(!stringbuffer->length)
     return NULL;
-  if(stringbuffer->string)
-    return stringbuffer->string;
-
-  stringbuffer->string = RAPTOR_MALLOC(unsigned char*, stringbuffer->length + 1);
-  if(!stringbuffer->string)
-    return NULL;
 
-  node = stringbuffer->head;
-  p = stringbuffer->string;
-  while(node) {
-    memcpy(p, node->string, node->length);
-    p+= node->length;
-    node = node->next;
-  }
-  *p='\0';
   return stringbuffer->string;
 }
 
@@ -519,26 +506,19 @@ int
 raptor_stringbuffer_copy_to_string(raptor_stringbuffer* stringbuffer,
                                    unsigned char *string, size_t length)
 {
-  raptor_stringbuffer_node *node;
-  unsigned char *p;
-  
   if(!string || length < 1)
     return 1;
 
-  if(!stringbuffer->length)
-    return 0;
-
-  p = string;
-  for(node = stringbuffer->head; node; node = node->next) {
-    if(node->length > length) {
-      p[-1]='\0';
-      return 1;
-    }
-    memcpy(p, node->string, node->length);
-    p+= node->length;
-    length-= node->length;
+  /* a string of exactly @length bytes still fits: callers allocate
+   * @length + 1 for the '\0' */
+  if(stringbuffer->length > length) {
+    /* truncate to fit */
+    memcpy(string, stringbuffer->string, length - 1);
+    string[length - 1] = '\0';
+    return 1;
   }
-  *p='\0';
+
+  memcpy(string, stringbuffer->string, stringbuffer->length + 1);
   return 0;
 }
 
@@ -597,39 +577,37 @@ raptor_stringbuffer_append_uri_escaped_counted_string(raptor_stringbuffer* sb,
                                                       int space_is_plus)
 {
   unsigned int i;
-  unsigned char buf[2];
-  buf[1] = '\0';
+  unsigned char *p;
 
   if(!string || !length)
     return 0;
-  
+
+  /* worst case: every character is percent-encoded */
+  if(raptor_stringbuffer_ensure(sb, length * 3))
+    return 1;
+
+  p = sb->string + sb->length;
   for(i = 0; i < length; i++) {
     char c = string[i];
     if(!c)
       break;
     
     if(IS_URI_SAFE(c)) {
-      *buf = RAPTOR_GOOD_CAST(unsigned char, c);
-
-      if(raptor_stringbuffer_append_counted_string(sb, buf, 1, 1))
-        return 1;
+      *p++ = RAPTOR_GOOD_CAST(unsigned char, c);
     } else if (c == ' ' && space_is_plus) {
-      *buf = '+';
-
-      if(raptor_stringbuffer_append_counted_string(sb, buf, 1, 1))
-        return 1;
+      *p++ = '+';
     } else {
-      *buf = '%';
-      if(raptor_stringbuffer_append_counted_string(sb, buf, 1, 1))
-        return 1;
+      int hex;
 
-      if(raptor_stringbuffer_append_hexadecimal(sb, (c & 0xf0) >> 4))
-        return 1;
-
-      if(raptor_stringbuffer_append_hexadecimal(sb, (c & 0x0f)))
-        return 1;
+      *p++ = '%';
+      hex = (c & 0xf0) >> 4;
+      *p++ = RAPTOR_GOOD_CAST(unsigned char, (hex < 10) ? ('0' + hex) : ('A' + hex - 10));
+      hex = (c & 0x0f);
+      *p++ = RAPTOR_GOOD_CAST(unsigned char, (hex < 10) ? ('0' + hex) : ('A' + hex - 10));
     }
   }
+  *p = '\0';
+  sb->length = RAPTOR_GOOD_CAST(size_t, p - sb->string);
 
   return 0;
 }
@@ -886,6 +864,65 @@ main(int argc, char *argv[])
     exit(1);
   }
   free(copy_string);
+
+
+  /* test growing well past the initial storage */
+
+  raptor_free_stringbuffer(sb2);
+  sb2 = raptor_new_stringbuffer();
+  if(!sb2) {
+    fprintf(stderr, "%s: Failed to create string buffer\n", program);
+    exit(1);
+  }
+
+#define TEST_GROW_COUNT 1000
+  for(i = 0; i < TEST_GROW_COUNT; i++) {
+    if(raptor_stringbuffer_append_counted_string(sb2, (unsigned char*)items_string, items_len, 1)) {
+      fprintf(stderr, "%s: Growing string buffer failed at item %d\n",
+              program, i);
+      exit(1);
+    }
+  }
+  if(raptor_stringbuffer_prepend_string(sb2, (unsigned char*)"<", 1) ||
+     raptor_stringbuffer_append_uri_escaped_counted_string(sb2, "a b/c", 5, 1)) {
+    fprintf(stderr, "%s: Adding to grown string buffer failed\n", program);
+    exit(1);
+  }
+
+  len = raptor_stringbuffer_length(sb2);
+  if(len != 1 + items_len * TEST_GROW_COUNT + 7) {
+    fprintf(stderr, "%s: grown string buffer len is %d, expected %d\n",
+            program, (int)len, (int)(1 + items_len * TEST_GROW_COUNT + 7));
+    exit(1);
+  }
+
+  str = raptor_stringbuffer_as_string(sb2);
+  if(str[0] != '<' ||
+     strncmp((const char*)str + 1 + items_len * (TEST_GROW_COUNT - 1),
+             items_string, items_len) ||
+     strcmp((const char*)str + len - 7, "a+b%2Fc")) {
+    fprintf(stderr, "%s: grown string buffer has wrong content\n", program);
+    exit(1);
+  }
+
+  copy_string = (unsigned char*)malloc(COPY_STRING_BUFFER_SIZE);
+  if(!raptor_stringbuffer_copy_to_string(sb2, copy_string, COPY_STRING_BUFFER_SIZE) ||
+     strlen((const char*)copy_string) != COPY_STRING_BUFFER_SIZE - 1) {
+    fprintf(stderr, "%s: copying grown string buffer to a short string did not truncate\n",
+            program);
+    exit(1);
+  }
+  free(copy_string);
+
+  /* appending an allocated string buffer to an empty one */
+  raptor_free_stringbuffer(sb);
+  sb = raptor_new_stringbuffer();
+  if(!sb || raptor_stringbuffer_append_stringbuffer(sb, sb2) ||
+     raptor_stringbuffer_length(sb) != len ||
+     raptor_stringbuffer_length(sb2)) {
+    fprintf(stderr, "%s: Failed to append grown string buffer\n", program);
+    exit(1);
+  }
   
   
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
@@ -39,6 +39,170 @@
 
 #ifndef STANDALONE
 
+/*
+ * raptor_term_intern_compare:
+ * @a: first term
+ * @b: second term
+ *
+ * INTERNAL - Compare two literal or blank node terms for the intern table
+ *
+ * Orders by type, then counted string, then language and datatype.
+ * The literal or blank node string of either term need not be NUL
+ * terminated, which allows looking up a constructor's arguments
+ * without copying them.
+ *
+ * Return value: <0, 0 or >0 as for raptor_term_compare()
+ */
+static int
+raptor_term_intern_compare(const void* a, const void* b)
+{
+  const raptor_term* t1 = (const raptor_term*)a;
+  const raptor_term* t2 = (const raptor_term*)b;
+  const unsigned char* s1;
+  const unsigned char* s2;
+  unsigned int len1;
+  unsigned int len2;
+  int d;
+
+  if(t1->type != t2->type)
+    return (t1->type - t2->type);
+
+  if(t1->type == RAPTOR_TERM_TYPE_BLANK) {
+    s1 = t1->value.blank.string;
+    len1 = t1->value.blank.string_len;
+    s2 = t2->value.blank.string;
+    len2 = t2->value.blank.string_len;
+  } else {
+    s1 = t1->value.literal.string;
+    len1 = t1->value.literal.string_len;
+    s2 = t2->value.literal.string;
+    len2 = t2->value.literal.string_len;
+  }
+
+  if(len1 != len2)
+    return (len1 < len2) ? -1 : 1;
+
+  d = len1 ? memcmp(s1, s2, len1) : 0;
+  if(d || t1->type == RAPTOR_TERM_TYPE_BLANK)
+    return d;
+
+  if(t1->value.literal.language && t2->value.literal.language) {
+    d = strcmp((const char*)t1->value.literal.language,
+               (const char*)t2->value.literal.language);
+    if(d)
+      return d;
+  } else if(t1->value.literal.language || t2->value.literal.language)
+    return (!t1->value.literal.language ? -1 : 1);
+
+  return raptor_uri_compare(t1->value.literal.datatype,
+                            t2->value.literal.datatype);
+}
+
+
+/*
+ * raptor_term_intern_find:
+ * @world: raptor world
+ * @key: term to look for (on stack)
+ *
+ * INTERNAL - Find an interned term equal to @key
+ *
+ * Return value: new reference to the interned term or NULL if not found
+ */
+static raptor_term*
+raptor_term_intern_find(raptor_world* world, raptor_term* key)
+{
+  raptor_term* t;
+
+  RAPTOR_WORLD_LOCK(world);
+  t = (raptor_term*)raptor_avltree_search(world->terms_tree, key);
+  if(t)
+    t->usage++;
+  RAPTOR_WORLD_UNLOCK(world);
+
+  return t;
+}
+
+
+/*
+ * raptor_term_intern_add:
+ * @world: raptor world
+ * @term: new term
+ *
+ * INTERNAL - Intern a newly constructed term
+ *
+ * If an equal term was interned since it was last looked up, @term
+ * is freed and the interned one is returned instead.  If the term
+ * cannot be added to the table, it is returned un-interned.
+ *
+ * Return value: the term to return to the caller
+ */
+static raptor_term*
+raptor_term_intern_add(raptor_world* world, raptor_term* term)
+{
+  raptor_term* t;
+
+  RAPTOR_WORLD_LOCK(world);
+  t = (raptor_term*)raptor_avltree_search(world->terms_tree, term);
+  if(t)
+    t->usage++;
+  else
+    raptor_avltree_add(world->terms_tree, term);
+  RAPTOR_WORLD_UNLOCK(world);
+
+  if(t) {
+    raptor_free_term(term);
+    term = t;
+  }
+
+  return term;
+}
+
+
+/* start of the string storage allocated after a term */
+#define RAPTOR_TERM_DATA(term) \
+  (RAPTOR_GOOD_CAST(unsigned char*, (term)) + sizeof(raptor_term_private))
+
+/* is @string stored in the same allocation as @term */
+#define RAPTOR_TERM_DATA_OWNS(term, string) \
+  (RAPTOR_GOOD_CAST(unsigned char*, (string)) == RAPTOR_TERM_DATA(term) || \
+   ((term)->type == RAPTOR_TERM_TYPE_LITERAL && \
+    RAPTOR_GOOD_CAST(unsigned char*, (string)) == \
+      RAPTOR_TERM_DATA(term) + (term)->value.literal.string_len + 1))
+
+
+/*
+ * raptor_new_term_with_data:
+ * @world: raptor world
+ * @type: term type
+ * @data_len: bytes of string storage to allocate after the term
+ *
+ * INTERNAL - Allocate a term with its string storage in one block
+ *
+ * Literal and blank node strings are stored after the term so that
+ * a term costs a single allocation and its strings share its cache
+ * lines.  The storage starts at RAPTOR_TERM_DATA().  The caller sets
+ * the hash with raptor_term_calculate_hash() once the value is set.
+ *
+ * Return value: new term with usage 1 or NULL on failure
+ */
+static raptor_term*
+raptor_new_term_with_data(raptor_world* world, raptor_term_type type,
+                          size_t data_len)
+{
+  raptor_term *t;
+
+  t = RAPTOR_CALLOC(raptor_term*, 1, sizeof(raptor_term_private) + data_len);
+  if(!t)
+    return NULL;
+
+  t->usage = 1;
+  t->world = world;
+  t->type = type;
+
+  return t;
+}
+
+
 /**
  * raptor_new_term_from_uri:
  * @world: raptor world
@@ -62,14 +226,12 @@ raptor_new_term_from_uri(raptor_world* world, raptor_uri* uri)
   
   raptor_world_open(world);
 
-  t = RAPTOR_CALLOC(raptor_term*, 1, sizeof(*t));
+  t = raptor_new_term_with_data(world, RAPTOR_TERM_TYPE_URI, 0);
   if(!t)
     return NULL;
 
-  t->usage = 1;
-  t->world = world;
-  t->type = RAPTOR_TERM_TYPE_URI;
   t->value.uri = raptor_uri_copy(uri);
+  RAPTOR_TERM_PRIVATE(t)->hash = raptor_term_calculate_hash(t);
 
   return t;
 }
@@ -173,6 +335,7 @@ raptor_new_term_from_counted_literal(raptor_world* world,
   raptor_term *t;
   unsigned char* new_literal = NULL;
   unsigned char* new_language = NULL;
+  size_t new_language_len = 0;
 
   RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
 
@@ -184,29 +347,57 @@ raptor_new_term_from_counted_literal(raptor_world* world,
   if(language && datatype)
     return NULL;
   
-
-  new_literal = RAPTOR_MALLOC(unsigned char*, literal_len + 1);
-  if(!new_literal)
-    return NULL;
-
   if(!literal || !*literal)
     literal_len = 0;
 
-  if(literal_len) {
+  if(world->terms_tree) {
+    raptor_term key; /* on stack - not allocated */
+    unsigned char key_language[256];
+    size_t i = 0;
+
+    memset(&key, 0, sizeof(key));
+    key.type = RAPTOR_TERM_TYPE_LITERAL;
+    key.value.literal.string = RAPTOR_GOOD_CAST(unsigned char*, literal);
+    key.value.literal.string_len = RAPTOR_LANG_LEN_FROM_INT(literal_len);
+    key.value.literal.datatype = datatype;
+
+    if(language) {
+      /* normalize the language the same way as the copy below */
+      for(i = 0; language[i] && i < sizeof(key_language) - 1; i++)
+        key_language[i] = (language[i] == '_') ? '-' : language[i];
+      key_language[i] = '\0';
+      key.value.literal.language = key_language;
+    }
+
+    /* an over-long language is not looked up but still interned below */
+    if(!language || !language[i]) {
+      t = raptor_term_intern_find(world, &key);
+      if(t)
+        return t;
+    }
+  }
+
+  /* the language is copied up to its NUL */
+  if(language)
+    new_language_len = strlen(RAPTOR_GOOD_CAST(const char*, language));
+
+  /* one allocation for the term, literal and language */
+  t = raptor_new_term_with_data(world, RAPTOR_TERM_TYPE_LITERAL,
+                                literal_len + 1 +
+                                (language ? new_language_len + 1 : 0));
+  if(!t)
+    return NULL;
+
+  new_literal = RAPTOR_TERM_DATA(t);
+  if(literal_len)
     memcpy(new_literal, literal, literal_len);
-    new_literal[literal_len] = '\0';
-  } else
-    *new_literal = '\0';
+  new_literal[literal_len] = '\0';
 
   if(language) {
     unsigned char c;
     unsigned char* l;
     
-    new_language = RAPTOR_MALLOC(unsigned char*, language_len + 1);
-    if(!new_language) {
-      RAPTOR_FREE(char*, new_literal);
-      return NULL;
-    }
+    new_language = new_literal + literal_len + 1;
 
     l = new_language;
     while((c = *language++)) {
@@ -215,31 +406,22 @@ raptor_new_term_from_counted_literal(raptor_world* world,
       *l++ = c;
     }
     *l = '\0';
+    language_len = RAPTOR_BAD_CAST(unsigned char, new_language_len);
   } else
     language_len = 0;
 
   if(datatype)
     datatype = raptor_uri_copy(datatype);
-  
 
-  t = RAPTOR_CALLOC(raptor_term*, 1, sizeof(*t));
-  if(!t) {
-    if(new_literal)
-      RAPTOR_FREE(char*, new_literal);
-    if(new_language)
-      RAPTOR_FREE(char*, new_language);
-    if(datatype)
-      raptor_free_uri(datatype);
-    return NULL;
-  }
-  t->usage = 1;
-  t->world = world;
-  t->type = RAPTOR_TERM_TYPE_LITERAL;
   t->value.literal.string = new_literal;
   t->value.literal.string_len = RAPTOR_LANG_LEN_FROM_INT(literal_len);
   t->value.literal.language = new_language;
   t->value.literal.language_len = language_len;
   t->value.literal.datatype = datatype;
+  RAPTOR_TERM_PRIVATE(t)->hash = raptor_term_calculate_hash(t);
+
+  if(world->terms_tree)
+    t = raptor_term_intern_add(world, t);
 
   return t;
 }
@@ -312,33 +494,53 @@ raptor_new_term_from_counted_blank(raptor_world* world,
 {
   raptor_term *t;
   unsigned char* new_id;
+  unsigned char* generated_id = NULL;
 
   RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
 
   raptor_world_open(world);
 
-  if (blank) {
-    new_id = RAPTOR_MALLOC(unsigned char*, length + 1);
-    if(!new_id)
+  if(blank && world->terms_tree) {
+    raptor_term key; /* on stack - not allocated */
+
+    memset(&key, 0, sizeof(key));
+    key.type = RAPTOR_TERM_TYPE_BLANK;
+    key.value.blank.string = RAPTOR_GOOD_CAST(unsigned char*, blank);
+    key.value.blank.string_len = RAPTOR_BAD_CAST(int, length);
+
+    t = raptor_term_intern_find(world, &key);
+    if(t)
+      return t;
+  }
+
+  if(!blank) {
+    generated_id = raptor_world_generate_bnodeid(world);
+    if(!generated_id)
       return NULL;
+    blank = generated_id;
+    length = strlen((const char*)generated_id);
+  }
+
+  /* one allocation for the term and identifier */
+  t = raptor_new_term_with_data(world, RAPTOR_TERM_TYPE_BLANK, length + 1);
+  if(t) {
+    new_id = RAPTOR_TERM_DATA(t);
     memcpy(new_id, blank, length);
     new_id[length] = '\0';
-  } else {
-    new_id = raptor_world_generate_bnodeid(world);
-    length = strlen((const char*)new_id);
   }
 
-  t = RAPTOR_CALLOC(raptor_term*, 1, sizeof(*t));
-  if(!t) {
-    RAPTOR_FREE(char*, new_id);
+  if(generated_id)
+    RAPTOR_FREE(char*, generated_id);
+
+  if(!t)
     return NULL;
-  }
 
-  t->usage = 1;
-  t->world = world;
-  t->type = RAPTOR_TERM_TYPE_BLANK;
   t->value.blank.string = new_id;
   t->value.blank.string_len = RAPTOR_BAD_CAST(int, length);
+  RAPTOR_TERM_PRIVATE(t)->hash = raptor_term_calculate_hash(t);
+
+  if(world->terms_tree)
+    t = raptor_term_intern_add(world, t);
 
   return t;
 }
@@ -413,7 +615,7 @@ raptor_new_term_from_counted_string(raptor_world* world,
   locator.line = -1;
 
   bytes_read = raptor_ntriples_parse_term(world, &locator,
-                                          string, &length, &term, 1);
+                                          string, string, &length, &term, 1);
 
   if(!bytes_read || length != 0) {
     if(term)
@@ -431,16 +633,52 @@ raptor_new_term_from_counted_string(raptor_world* world,
  *
  * Copy constructor - get a copy of a statement term
  *
+ * A static term that is not usage counted, such as one owned by a
+ * #raptor_statement_arena, is copied into a new term.
+ *
  * Return value: new term object or NULL on failure
  */
 raptor_term*
 raptor_term_copy(raptor_term* term)
 {
+  int usage;
+
   if(!term)
     return NULL;
 
-  term->usage++;
-  return term;
+  RAPTOR_WORLD_LOCK(term->world);
+  usage = term->usage;
+  if(usage >= 0)
+    term->usage++;
+  RAPTOR_WORLD_UNLOCK(term->world);
+
+  if(usage >= 0)
+    return term;
+
+  /* static - not usage counted; the copy will be a dynamic term */
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      return raptor_new_term_from_uri(term->world, term->value.uri);
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      return raptor_new_term_from_counted_blank(term->world,
+                                                term->value.blank.string,
+                                                term->value.blank.string_len);
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      return raptor_new_term_from_counted_literal(term->world,
+                                                  term->value.literal.string,
+                                                  term->value.literal.string_len,
+                                                  term->value.literal.datatype,
+                                                  term->value.literal.language,
+                                                  term->value.literal.language_len);
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  return NULL;
 }
 
 
@@ -450,14 +688,32 @@ raptor_term_copy(raptor_term* term)
  *
  * Destructor - destroy a raptor_term object.
  *
+ * Static terms that are not usage counted are not freed.
+ *
  **/
 void
 raptor_free_term(raptor_term *term)
 {
+  int usage;
+
   if(!term)
     return;
   
-  if(--term->usage)
+  RAPTOR_WORLD_LOCK(term->world);
+  if(term->usage < 0) {
+    /* static - owned elsewhere */
+    RAPTOR_WORLD_UNLOCK(term->world);
+    return;
+  }
+  usage = --term->usage;
+  /* this does not free the term */
+  if(!usage && term->world->terms_tree &&
+     term->type != RAPTOR_TERM_TYPE_URI &&
+     raptor_avltree_search(term->world->terms_tree, term) == term)
+    raptor_avltree_delete(term->world->terms_tree, term);
+  RAPTOR_WORLD_UNLOCK(term->world);
+
+  if(usage)
     return;
   
   switch(term->type) {
@@ -469,27 +725,27 @@ raptor_free_term(raptor_term *term)
       break;
 
     case RAPTOR_TERM_TYPE_BLANK:
-      if(term->value.blank.string) {
+      if(term->value.blank.string &&
+         !RAPTOR_TERM_DATA_OWNS(term, term->value.blank.string))
         RAPTOR_FREE(char*, term->value.blank.string);
-        term->value.blank.string = NULL;
-      }
+      term->value.blank.string = NULL;
       break;
       
     case RAPTOR_TERM_TYPE_LITERAL:
-      if(term->value.literal.string) {
+      if(term->value.literal.language &&
+         !RAPTOR_TERM_DATA_OWNS(term, term->value.literal.language))
+        RAPTOR_FREE(char*, term->value.literal.language);
+      term->value.literal.language = NULL;
+
+      if(term->value.literal.string &&
+         !RAPTOR_TERM_DATA_OWNS(term, term->value.literal.string))
         RAPTOR_FREE(char*, term->value.literal.string);
-        term->value.literal.string = NULL;
-      }
+      term->value.literal.string = NULL;
 
       if(term->value.literal.datatype) {
         raptor_free_uri(term->value.literal.datatype);
         term->value.literal.datatype = NULL;
       }
-      
-      if(term->value.literal.language) {
-        RAPTOR_FREE(char*, term->value.literal.language);
-        term->value.literal.language = NULL;
-      }
       break;
       
     case RAPTOR_TERM_TYPE_UNKNOWN:
@@ -611,6 +867,9 @@ raptor_term_print_as_ntriples(const raptor_term *term, FILE* stream)
  *
  * Compare a pair of #raptor_term for equality
  *
+ * Terms with different raptor_term_hash() values are rejected without
+ * comparing their values.
+ *
  * Return value: non-0 if the terms are equal
  */
 int
@@ -627,6 +886,10 @@ raptor_term_equals(raptor_term* t1, raptor_term* t2)
   if(t1 == t2)
     return 1;
   
+  /* hashes are calculated when terms are made so this is cheap */
+  if(RAPTOR_TERM_PRIVATE(t1)->hash != RAPTOR_TERM_PRIVATE(t2)->hash)
+    return 0;
+  
   switch(t1->type) {
     case RAPTOR_TERM_TYPE_URI:
       d = raptor_uri_equals(t1->value.uri, t2->value.uri);
@@ -637,8 +900,8 @@ raptor_term_equals(raptor_term* t1, raptor_term* t2)
         /* different lengths */
         break;
 
-      d = !strcmp((const char*)t1->value.blank.string, 
-                  (const char*)t2->value.blank.string);
+      d = !memcmp(t1->value.blank.string, t2->value.blank.string,
+                  t1->value.blank.string_len);
       break;
 
     case RAPTOR_TERM_TYPE_LITERAL:
@@ -646,8 +909,9 @@ raptor_term_equals(raptor_term* t1, raptor_term* t2)
         /* different lengths */
         break;
 
-      d = !strcmp((const char*)t1->value.literal.string,
-                  (const char*)t2->value.literal.string);
+      /* same length so compare all the bytes including any NULs */
+      d = !memcmp(t1->value.literal.string, t2->value.literal.string,
+                  t1->value.literal.string_len);
       if(!d)
         break;
       
@@ -682,6 +946,173 @@ raptor_term_equals(raptor_term* t1, raptor_term* t2)
 }
 
 
+/* 64-bit multiplier from MurmurHash64A, built without a C99 suffix */
+#define RAPTOR_HASH_M ((((raptor_hash)0xc6a4a793UL) << 32) | 0x5bd1e995UL)
+
+/* seeds so that terms of different types with the same string differ */
+#define RAPTOR_HASH_SEED_URI      0x55524931UL
+#define RAPTOR_HASH_SEED_BLANK    0x424c4e4bUL
+#define RAPTOR_HASH_SEED_LITERAL  0x4c49544cUL
+#define RAPTOR_HASH_SEED_LANGUAGE 0x4c414e47UL
+#define RAPTOR_HASH_SEED_DATATYPE 0x44545950UL
+
+
+/*
+ * raptor_hash_bytes:
+ * @data: bytes to hash
+ * @len: number of bytes
+ * @seed: hash seed
+ *
+ * INTERNAL - Calculate a fast non-cryptographic 64-bit hash of some bytes
+ *
+ * This is MurmurHash64A reading 8 bytes at a time.  Bytes are read
+ * in little-endian order so the value is the same on all platforms.
+ *
+ * Return value: hash value
+ */
+raptor_hash
+raptor_hash_bytes(const unsigned char* data, size_t len, raptor_hash seed)
+{
+  const raptor_hash m = RAPTOR_HASH_M;
+  raptor_hash h = seed ^ (RAPTOR_GOOD_CAST(raptor_hash, len) * m);
+  raptor_hash k;
+
+  for(; len >= 8; len -= 8, data += 8) {
+    k = RAPTOR_GOOD_CAST(raptor_hash, data[0]) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[1]) << 8) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[2]) << 16) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[3]) << 24) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[4]) << 32) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[5]) << 40) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[6]) << 48) |
+        (RAPTOR_GOOD_CAST(raptor_hash, data[7]) << 56);
+    k *= m;
+    k ^= k >> 47;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+
+  if(len) {
+    k = 0;
+    while(len--)
+      k |= RAPTOR_GOOD_CAST(raptor_hash, data[len]) << (8 * len);
+    h ^= k;
+    h *= m;
+  }
+
+  h ^= h >> 47;
+  h *= m;
+  h ^= h >> 47;
+
+  return h;
+}
+
+
+/*
+ * raptor_hash_uri:
+ * @uri: URI
+ * @seed: hash seed
+ *
+ * INTERNAL - Hash the hash of a URI with a seed
+ *
+ * Return value: hash value
+ */
+static raptor_hash
+raptor_hash_uri(raptor_uri* uri, raptor_hash seed)
+{
+  raptor_hash h = raptor_uri_get_hash(uri);
+  unsigned char buffer[8];
+  int i;
+
+  for(i = 0; i < 8; i++, h >>= 8)
+    buffer[i] = RAPTOR_GOOD_CAST(unsigned char, h & 0xff);
+
+  return raptor_hash_bytes(buffer, sizeof(buffer), seed);
+}
+
+
+/*
+ * raptor_term_calculate_hash:
+ * @term: term
+ *
+ * INTERNAL - Calculate the raptor_term_hash() value of a term
+ *
+ * Called once when a term is made, while only the constructing
+ * thread can see it.
+ *
+ * Return value: non-0 hash value
+ */
+raptor_hash
+raptor_term_calculate_hash(raptor_term* term)
+{
+  raptor_hash h = 0;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      h = raptor_hash_uri(term->value.uri, RAPTOR_HASH_SEED_URI);
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      h = raptor_hash_bytes(term->value.blank.string,
+                            term->value.blank.string_len,
+                            RAPTOR_HASH_SEED_BLANK);
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      h = raptor_hash_bytes(term->value.literal.string,
+                            term->value.literal.string_len,
+                            RAPTOR_HASH_SEED_LITERAL);
+      if(term->value.literal.language) {
+        const unsigned char* language = term->value.literal.language;
+
+        /* equality uses strcmp() so hash up to the NUL */
+        h = raptor_hash_bytes(language,
+                              strlen(RAPTOR_GOOD_CAST(const char*, language)),
+                              h ^ RAPTOR_HASH_SEED_LANGUAGE);
+      }
+      if(term->value.literal.datatype)
+        h = raptor_hash_uri(term->value.literal.datatype,
+                            h ^ RAPTOR_HASH_SEED_DATATYPE);
+      break;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  /* 0 is returned only for NULL */
+  if(!h)
+    h = 1;
+
+  return h;
+}
+
+
+/**
+ * raptor_term_hash:
+ * @term: term
+ *
+ * Get a 64-bit hash of a #raptor_term value
+ *
+ * Terms that are equal with raptor_term_equals() have the same hash.
+ * The hash is calculated when the term is made, so this is cheap and
+ * safe to call from any thread sharing the term.  The value is the
+ * same across platforms and runs but is not suitable for
+ * cryptographic use.
+ *
+ * Return value: non-0 hash value or 0 if @term is NULL
+ */
+raptor_hash
+raptor_term_hash(raptor_term* term)
+{
+  if(!term)
+    return 0;
+
+  return RAPTOR_TERM_PRIVATE(term)->hash;
+}
+
+
 /**
  * raptor_term_compare:
  * @t1: first term
@@ -757,6 +1188,33 @@ raptor_term_compare(const raptor_term *t1,  const raptor_term *t2)
 
   return d;
 }
+
+
+int
+raptor_terms_init(raptor_world* world)
+{
+  if(world->term_interning && !world->terms_tree) {
+    world->terms_tree = raptor_new_avltree(raptor_term_intern_compare,
+                                           /* free */ NULL, 0);
+    if(!world->terms_tree) {
+      raptor_log_error(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                       "Failed to create raptor term avltree");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+void
+raptor_terms_finish(raptor_world* world)
+{
+  if(world->terms_tree) {
+    raptor_free_avltree(world->terms_tree);
+    world->terms_tree = NULL;
+  }
+}
 #endif
 
 
@@ -766,6 +1224,9 @@ raptor_term_compare(const raptor_term *t1,  const raptor_term *t2)
 /* one more prototype */
 int main(int argc, char *argv[]);
 
+/* a 64-bit hash value from two 32-bit halves */
+#define TEST_HASH(high, low) ((((raptor_hash)(high)) << 32) | (low))
+
 static const unsigned char *uri_string1 = (const unsigned char *)"http://http://www.dajobe.org/";
 static unsigned int uri_string1_len = 29; /* strlen(uri_string1) */
 static raptor_term_type uri_string1_type = RAPTOR_TERM_TYPE_URI;
@@ -779,6 +1240,8 @@ static const unsigned char *bnodeid1 = (const unsigned char *)"abc123";
 static unsigned int bnodeid1_len = 6; /* strlen(bnode_id1) */
 static raptor_term_type bnodeid1_type = RAPTOR_TERM_TYPE_BLANK;
 static const unsigned char* language1 = (const unsigned char*)"en";
+static const unsigned char* language2 = (const unsigned char*)"en_GB";
+static const unsigned char* language3 = (const unsigned char*)"en-GB";
 
 int
 main(int argc, char *argv[])
@@ -791,6 +1254,9 @@ main(int argc, char *argv[])
   raptor_term* term3 = NULL; /* blank node 1 */
   raptor_term* term4 = NULL; /* URI string 2 */
   raptor_term* term5 = NULL; /* URI string 1 again */
+  raptor_term* term6 = NULL; /* interned term */
+  raptor_term* term7 = NULL; /* interned term again */
+  raptor_world *world2 = NULL;
   raptor_uri* uri1;
   unsigned char* uri_str;
   size_t uri_len;
@@ -1019,6 +1485,110 @@ main(int argc, char *argv[])
   }
   
 
+  /* check equal terms hash the same */
+  if(raptor_term_hash(term1) != raptor_term_hash(term5)) {
+    fprintf(stderr, "%s: raptor_term_hash (URI %s) differs for equal terms\n",
+            program, uri_string1);
+    rc = 1;
+    goto tidy;
+  }
+
+  if(raptor_term_hash(term1) == raptor_term_hash(term4) ||
+     raptor_term_hash(term2) == raptor_term_hash(term3)) {
+    fprintf(stderr, "%s: raptor_term_hash returned the same hash for different terms\n",
+            program);
+    rc = 1;
+    goto tidy;
+  }
+
+  if(raptor_term_hash(NULL)) {
+    fprintf(stderr, "%s: raptor_term_hash(NULL) returned non-0\n", program);
+    rc = 1;
+    goto tidy;
+  }
+
+  /* check the hash matches MurmurHash64A so it is the same everywhere */
+  if(raptor_hash_bytes((const unsigned char*)"", 0, 1) !=
+       TEST_HASH(0xc6a4a793UL, 0x5bd064dcUL) ||
+     raptor_hash_bytes((const unsigned char*)"hello", 5, 0) !=
+       TEST_HASH(0x1e68d17cUL, 0x457bf117UL) ||
+     raptor_hash_bytes((const unsigned char*)"The quick brown fox jumps over the lazy dog", 43, 0) !=
+       TEST_HASH(0x5589ca33UL, 0x042a861bUL)) {
+    fprintf(stderr, "%s: raptor_hash_bytes returned an unexpected hash\n",
+            program);
+    rc = 1;
+    goto tidy;
+  }
+
+
+  /* check equal literals and blank nodes are shared when interning */
+  world2 = raptor_new_world();
+  if(!world2 ||
+     raptor_world_set_flag(world2, RAPTOR_WORLD_FLAG_TERM_INTERNING, 1) ||
+     raptor_world_open(world2)) {
+    fprintf(stderr, "%s: failed to open a term interning world\n", program);
+    rc = 1;
+    goto tidy;
+  }
+
+  term6 = raptor_new_term_from_counted_literal(world2, literal_string1,
+                                               literal_string1_len, NULL,
+                                               language2, 5);
+  term7 = raptor_new_term_from_literal(world2, literal_string1, NULL,
+                                       language3);
+  if(!term6 || term6 != term7) {
+    fprintf(stderr, "%s: interned literals %s@%s and %s@%s are different objects, expected the same\n",
+            program, literal_string1, language2, literal_string1, language3);
+    rc = 1;
+    goto tidy;
+  }
+  raptor_free_term(term7);
+
+  if(strcmp((const char*)term6->value.literal.language, (const char*)language3) ||
+     term6->value.literal.language_len != 5 ||
+     term6->value.literal.string_len != literal_string1_len) {
+    fprintf(stderr, "%s: literal %s@%s has language %s length %d, expected %s length 5\n",
+            program, literal_string1, language2,
+            term6->value.literal.language, term6->value.literal.language_len,
+            language3);
+    rc = 1;
+    goto tidy;
+  }
+
+  term7 = raptor_new_term_from_counted_literal(world2, literal_string1,
+                                               literal_string1_len, NULL,
+                                               NULL, 0);
+  if(!term7 || term6 == term7 || raptor_term_equals(term6, term7)) {
+    fprintf(stderr, "%s: interned literals with and without a language are the same, expected different\n",
+            program);
+    rc = 1;
+    goto tidy;
+  }
+  raptor_free_term(term7);
+  raptor_free_term(term6);
+
+  term6 = raptor_new_term_from_counted_blank(world2, bnodeid1, bnodeid1_len);
+  term7 = raptor_new_term_from_blank(world2, bnodeid1);
+  if(!term6 || term6 != term7) {
+    fprintf(stderr, "%s: interned blank nodes %s are different objects, expected the same\n",
+            program, bnodeid1);
+    rc = 1;
+    goto tidy;
+  }
+  raptor_free_term(term7);
+  raptor_free_term(term6);
+  term6 = NULL;
+
+  /* a freed interned term is removed from the table */
+  term7 = raptor_new_term_from_blank(world2, bnodeid1);
+  if(!term7 || term7->usage != 1) {
+    fprintf(stderr, "%s: re-created interned blank node %s has usage %d, expected 1\n",
+            program, bnodeid1, term7 ? term7->usage : 0);
+    rc = 1;
+    goto tidy;
+  }
+  
+
   tidy:
   if(term1)
     raptor_free_term(term1);
@@ -1030,8 +1600,14 @@ main(int argc, char *argv[])
     raptor_free_term(term4);
   if(term5)
     raptor_free_term(term5);
+  if(term6)
+    raptor_free_term(term6);
+  if(term7)
+    raptor_free_term(term7);
   
   raptor_free_world(world);
+  if(world2)
+    raptor_free_world(world2);
 
   return rc;
 }
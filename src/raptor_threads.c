@@ -0,0 +1,622 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_threads.c - Raptor mutexes and worker thread pool
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef RAPTOR_THREADS
+#include <pthread.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * When raptor is built without thread support (RAPTOR_THREADS
+ * undefined) the mutex operations do nothing and a thread pool runs
+ * every task inline in raptor_thread_pool_add_task(), so callers
+ * need no conditional code.
+ */
+
+struct raptor_mutex_s {
+#ifdef RAPTOR_THREADS
+  pthread_mutex_t mutex;
+#else
+  int unused;
+#endif
+};
+
+
+typedef struct raptor_thread_task_s {
+  struct raptor_thread_task_s* next;
+  raptor_thread_task_handler handler;
+  void* data;
+} raptor_thread_task;
+
+
+struct raptor_thread_pool_s {
+  raptor_world* world;
+
+  /* number of worker threads running (0 when tasks are run inline) */
+  int threads_count;
+
+  /* count of tasks that returned non-0 since the last wait */
+  int failures;
+
+#ifdef RAPTOR_THREADS
+  pthread_t* threads;
+
+  /* protects all fields below */
+  pthread_mutex_t lock;
+
+  /* signalled when a task is queued or the pool is shutting down */
+  pthread_cond_t work_cond;
+
+  /* signalled when the queue drains and no task is running */
+  pthread_cond_t idle_cond;
+
+  /* FIFO queue of tasks */
+  raptor_thread_task* head;
+  raptor_thread_task* tail;
+
+  /* tasks taken from the queue but not yet finished */
+  int running;
+
+  int shutdown;
+#endif
+};
+
+
+/**
+ * raptor_new_mutex:
+ * @world: raptor world
+ *
+ * INTERNAL - Constructor - create a recursive mutex
+ *
+ * Return value: new mutex or NULL on failure
+ */
+raptor_mutex*
+raptor_new_mutex(raptor_world* world)
+{
+  raptor_mutex* mutex;
+#ifdef RAPTOR_THREADS
+  pthread_mutexattr_t attr;
+#endif
+
+  mutex = RAPTOR_CALLOC(raptor_mutex*, 1, sizeof(*mutex));
+  if(!mutex)
+    return NULL;
+
+#ifdef RAPTOR_THREADS
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  if(pthread_mutex_init(&mutex->mutex, &attr)) {
+    pthread_mutexattr_destroy(&attr);
+    raptor_log_error(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                     "Failed to initialize mutex");
+    RAPTOR_FREE(raptor_mutex, mutex);
+    return NULL;
+  }
+  pthread_mutexattr_destroy(&attr);
+#endif
+
+  return mutex;
+}
+
+
+/**
+ * raptor_free_mutex:
+ * @mutex: mutex
+ *
+ * INTERNAL - Destructor - destroy a mutex
+ */
+void
+raptor_free_mutex(raptor_mutex* mutex)
+{
+  if(!mutex)
+    return;
+
+#ifdef RAPTOR_THREADS
+  pthread_mutex_destroy(&mutex->mutex);
+#endif
+  RAPTOR_FREE(raptor_mutex, mutex);
+}
+
+
+/**
+ * raptor_mutex_lock:
+ * @mutex: mutex
+ *
+ * INTERNAL - Lock a mutex; may be called recursively by the owner
+ */
+void
+raptor_mutex_lock(raptor_mutex* mutex)
+{
+#ifdef RAPTOR_THREADS
+  pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+
+/**
+ * raptor_mutex_unlock:
+ * @mutex: mutex
+ *
+ * INTERNAL - Unlock a mutex
+ */
+void
+raptor_mutex_unlock(raptor_mutex* mutex)
+{
+#ifdef RAPTOR_THREADS
+  pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+
+#ifdef RAPTOR_THREADS
+static void*
+raptor_thread_pool_worker(void* arg)
+{
+  raptor_thread_pool* pool = (raptor_thread_pool*)arg;
+
+  pthread_mutex_lock(&pool->lock);
+  while(1) {
+    raptor_thread_task* task;
+    int rc;
+
+    while(!pool->head && !pool->shutdown)
+      pthread_cond_wait(&pool->work_cond, &pool->lock);
+
+    if(!pool->head)
+      break; /* shutdown and nothing left to do */
+
+    task = pool->head;
+    pool->head = task->next;
+    if(!pool->head)
+      pool->tail = NULL;
+    pool->running++;
+    pthread_mutex_unlock(&pool->lock);
+
+    rc = task->handler(task->data);
+    RAPTOR_FREE(raptor_thread_task, task);
+
+    pthread_mutex_lock(&pool->lock);
+    if(rc)
+      pool->failures++;
+    pool->running--;
+    if(!pool->head && !pool->running)
+      pthread_cond_broadcast(&pool->idle_cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+#endif
+
+
+/**
+ * raptor_new_thread_pool:
+ * @world: raptor world
+ * @threads: number of worker threads
+ *
+ * INTERNAL - Constructor - create a pool of worker threads
+ *
+ * If @threads is less than 2 or raptor was built without thread
+ * support, no threads are started and tasks run inline when they
+ * are added.
+ *
+ * Return value: new thread pool or NULL on failure
+ */
+raptor_thread_pool*
+raptor_new_thread_pool(raptor_world* world, int threads)
+{
+  raptor_thread_pool* pool;
+
+  pool = RAPTOR_CALLOC(raptor_thread_pool*, 1, sizeof(*pool));
+  if(!pool)
+    return NULL;
+
+  pool->world = world;
+
+#ifdef RAPTOR_THREADS
+  if(threads < 2)
+    return pool;
+
+  pool->threads = RAPTOR_CALLOC(pthread_t*, RAPTOR_GOOD_CAST(size_t, threads),
+                                sizeof(pthread_t));
+  if(!pool->threads) {
+    RAPTOR_FREE(raptor_thread_pool, pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->idle_cond, NULL);
+
+  for(; pool->threads_count < threads; pool->threads_count++) {
+    if(pthread_create(&pool->threads[pool->threads_count], NULL,
+                      raptor_thread_pool_worker, pool))
+      break;
+  }
+
+  if(!pool->threads_count) {
+    /* Could not start any threads: fall back to running inline */
+    raptor_log_error(world, RAPTOR_LOG_LEVEL_WARN, NULL,
+                     "Failed to start worker threads - running tasks serially");
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    RAPTOR_FREE(pthread_t*, pool->threads);
+    pool->threads = NULL;
+  }
+#endif
+
+  return pool;
+}
+
+
+/**
+ * raptor_free_thread_pool:
+ * @pool: thread pool
+ *
+ * INTERNAL - Destructor - wait for queued tasks, stop the worker
+ * threads and destroy the pool
+ */
+void
+raptor_free_thread_pool(raptor_thread_pool* pool)
+{
+  if(!pool)
+    return;
+
+#ifdef RAPTOR_THREADS
+  if(pool->threads_count) {
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(i = 0; i < pool->threads_count; i++)
+      pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    RAPTOR_FREE(pthread_t*, pool->threads);
+  }
+#endif
+
+  RAPTOR_FREE(raptor_thread_pool, pool);
+}
+
+
+/**
+ * raptor_thread_pool_get_threads_count:
+ * @pool: thread pool
+ *
+ * INTERNAL - Get the number of worker threads in the pool
+ *
+ * Return value: number of threads or 0 if tasks are run inline
+ */
+int
+raptor_thread_pool_get_threads_count(raptor_thread_pool* pool)
+{
+  return pool->threads_count;
+}
+
+
+/**
+ * raptor_thread_pool_add_task:
+ * @pool: thread pool
+ * @handler: task function
+ * @data: task data passed to @handler
+ *
+ * INTERNAL - Queue a task to be run by a worker thread
+ *
+ * The task is run inline if the pool has no worker threads.  A
+ * non-0 return from @handler is counted as a failure and reported
+ * by raptor_thread_pool_wait().
+ *
+ * Return value: non-0 on failure to queue the task
+ */
+int
+raptor_thread_pool_add_task(raptor_thread_pool* pool,
+                            raptor_thread_task_handler handler, void* data)
+{
+#ifdef RAPTOR_THREADS
+  raptor_thread_task* task;
+
+  if(pool->threads_count) {
+    task = RAPTOR_CALLOC(raptor_thread_task*, 1, sizeof(*task));
+    if(!task)
+      return 1;
+
+    task->handler = handler;
+    task->data = data;
+
+    pthread_mutex_lock(&pool->lock);
+    if(pool->tail)
+      pool->tail->next = task;
+    else
+      pool->head = task;
+    pool->tail = task;
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+  }
+#endif
+
+  if(handler(data))
+    pool->failures++;
+
+  return 0;
+}
+
+
+/**
+ * raptor_thread_pool_wait:
+ * @pool: thread pool
+ *
+ * INTERNAL - Wait for all queued tasks to finish
+ *
+ * Return value: number of tasks that failed since the last wait
+ */
+int
+raptor_thread_pool_wait(raptor_thread_pool* pool)
+{
+  int failures;
+
+#ifdef RAPTOR_THREADS
+  if(pool->threads_count) {
+    pthread_mutex_lock(&pool->lock);
+    while(pool->head || pool->running)
+      pthread_cond_wait(&pool->idle_cond, &pool->lock);
+    failures = pool->failures;
+    pool->failures = 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    return failures;
+  }
+#endif
+
+  failures = pool->failures;
+  pool->failures = 0;
+
+  return failures;
+}
+
+
+/**
+ * raptor_threads_init:
+ * @world: raptor world
+ *
+ * INTERNAL - Initialise the world lock
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_threads_init(raptor_world* world)
+{
+  world->threads_active = 0;
+  world->mutex = raptor_new_mutex(world);
+
+  return (world->mutex == NULL);
+}
+
+
+/**
+ * raptor_threads_finish:
+ * @world: raptor world
+ *
+ * INTERNAL - Destroy the world lock
+ */
+void
+raptor_threads_finish(raptor_world* world)
+{
+  if(world->mutex) {
+    raptor_free_mutex(world->mutex);
+    world->mutex = NULL;
+  }
+}
+
+
+/**
+ * raptor_world_internal_threads_start:
+ * @world: raptor world
+ *
+ * INTERNAL - Mark the start of a section where worker threads share @world
+ *
+ * While any such section is active, updates to world-shared state
+ * such as the URI intern tree and URI/term reference counts are made
+ * while holding the world lock.  Must be called from the thread that
+ * owns the world, before any worker is given a task.
+ */
+void
+raptor_world_internal_threads_start(raptor_world* world)
+{
+  world->threads_active++;
+}
+
+
+/**
+ * raptor_world_internal_threads_end:
+ * @world: raptor world
+ *
+ * INTERNAL - Mark the end of a section started with
+ * raptor_world_internal_threads_start()
+ *
+ * Must be called only after all workers have finished with @world.
+ */
+void
+raptor_world_internal_threads_end(raptor_world* world)
+{
+  if(world->threads_active > 0)
+    world->threads_active--;
+}
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TEST_TASKS_COUNT 200
+
+typedef struct {
+  raptor_world* world;
+  int index;
+  int fail;
+  int result;
+} test_task_data;
+
+
+static int
+test_task_handler(void* data)
+{
+  test_task_data* task = (test_task_data*)data;
+  unsigned char uri_string[64];
+  raptor_uri* uri;
+  int i;
+
+  /* Exercise URI interning and reference counting on a shared
+   * world: every task uses the same small set of URI strings */
+  for(i = 0; i < 50; i++) {
+    snprintf((char*)uri_string, sizeof(uri_string),
+             "http://example.org/thread-test#%d", i % 10);
+    uri = raptor_new_uri(task->world, uri_string);
+    if(!uri)
+      return 1;
+    raptor_free_uri(raptor_uri_copy(uri));
+    raptor_free_uri(uri);
+  }
+
+  task->result = task->index * 2;
+
+  return task->fail;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  raptor_thread_pool* pool;
+  raptor_mutex* mutex;
+  test_task_data tasks[TEST_TASKS_COUNT];
+  int threads;
+  int failures;
+  int i;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  mutex = raptor_new_mutex(world);
+  if(!mutex) {
+    fprintf(stderr, "%s: raptor_new_mutex() failed\n", program);
+    exit(1);
+  }
+  /* recursive locking must not deadlock */
+  raptor_mutex_lock(mutex);
+  raptor_mutex_lock(mutex);
+  raptor_mutex_unlock(mutex);
+  raptor_mutex_unlock(mutex);
+  raptor_free_mutex(mutex);
+
+  for(threads = 0; threads <= 4; threads += 4) {
+    pool = raptor_new_thread_pool(world, threads);
+    if(!pool) {
+      fprintf(stderr, "%s: raptor_new_thread_pool(%d) failed\n", program,
+              threads);
+      rc = 1;
+      break;
+    }
+
+    raptor_world_internal_threads_start(world);
+
+    for(i = 0; i < TEST_TASKS_COUNT; i++) {
+      tasks[i].world = world;
+      tasks[i].index = i;
+      tasks[i].fail = (i % 50 == 7);
+      tasks[i].result = -1;
+      if(raptor_thread_pool_add_task(pool, test_task_handler, &tasks[i])) {
+        fprintf(stderr, "%s: raptor_thread_pool_add_task() failed\n",
+                program);
+        rc = 1;
+      }
+    }
+
+    failures = raptor_thread_pool_wait(pool);
+
+    raptor_world_internal_threads_end(world);
+
+    if(failures != TEST_TASKS_COUNT / 50) {
+      fprintf(stderr, "%s: %d threads: got %d task failures, expected %d\n",
+              program, threads, failures, TEST_TASKS_COUNT / 50);
+      rc = 1;
+    }
+
+    for(i = 0; i < TEST_TASKS_COUNT; i++) {
+      if(tasks[i].result != i * 2) {
+        fprintf(stderr, "%s: %d threads: task %d returned %d, expected %d\n",
+                program, threads, i, tasks[i].result, i * 2);
+        rc = 1;
+        break;
+      }
+    }
+
+    /* failures are reset by a wait */
+    if(raptor_thread_pool_wait(pool)) {
+      fprintf(stderr, "%s: %d threads: failures not reset by wait\n",
+              program, threads);
+      rc = 1;
+    }
+
+    raptor_free_thread_pool(pool);
+  }
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
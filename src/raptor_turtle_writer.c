@@ -635,6 +635,18 @@ raptor_turtle_writer_set_option(raptor_turtle_writer *turtle_writer,
     /* Turtle serializer option */
     case RAPTOR_OPTION_WRITE_BASE_URI:
 
+    /* Serializer options */
+    case RAPTOR_OPTION_THREADS:
+    case RAPTOR_OPTION_MEMORY_LIMIT:
+    case RAPTOR_OPTION_SORT_UNIQUE:
+    case RAPTOR_OPTION_DEDUP:
+    case RAPTOR_OPTION_DEDUP_BLOOM:
+    case RAPTOR_OPTION_READ_AHEAD:
+    case RAPTOR_OPTION_COMPRESSION:
+    case RAPTOR_OPTION_IO_QUEUE_DEPTH:
+    case RAPTOR_OPTION_IO_BUFFER_SIZE:
+    case RAPTOR_OPTION_READ_BUFFER_SIZE:
+
     /* WWW option */
     case RAPTOR_OPTION_WWW_HTTP_CACHE_CONTROL:
     case RAPTOR_OPTION_WWW_HTTP_USER_AGENT:
@@ -759,6 +771,18 @@ raptor_turtle_writer_get_option(raptor_turtle_writer *turtle_writer,
     /* Turtle serializer option */
     case RAPTOR_OPTION_WRITE_BASE_URI:
 
+    /* Serializer options */
+    case RAPTOR_OPTION_THREADS:
+    case RAPTOR_OPTION_MEMORY_LIMIT:
+    case RAPTOR_OPTION_SORT_UNIQUE:
+    case RAPTOR_OPTION_DEDUP:
+    case RAPTOR_OPTION_DEDUP_BLOOM:
+    case RAPTOR_OPTION_READ_AHEAD:
+    case RAPTOR_OPTION_COMPRESSION:
+    case RAPTOR_OPTION_IO_QUEUE_DEPTH:
+    case RAPTOR_OPTION_IO_BUFFER_SIZE:
+    case RAPTOR_OPTION_READ_BUFFER_SIZE:
+
     /* WWW option */
     case RAPTOR_OPTION_WWW_HTTP_CACHE_CONTROL:
     case RAPTOR_OPTION_WWW_HTTP_USER_AGENT:
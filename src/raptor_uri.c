@@ -72,6 +72,11 @@ struct raptor_uri_s {
   unsigned int length;
   /* usage count */
   int usage;
+  /* rank in the world's sorted URIs when ordinal_epoch is current */
+  unsigned long ordinal;
+  unsigned long ordinal_epoch;
+  /* hash of the string, set when the URI is created */
+  raptor_hash hash;
 };
 
 
@@ -105,6 +110,8 @@ raptor_new_uri_from_counted_string(raptor_world* world,
 
   raptor_world_open(world);
 
+  RAPTOR_WORLD_LOCK(world);
+
   if(world->uris_tree) {
     raptor_uri key; /* on stack - not allocated */
 
@@ -154,6 +161,7 @@ raptor_new_uri_from_counted_string(raptor_world* world,
   memcpy((char*)new_string, (const char*)uri_string, length);
   new_string[length] = '\0';
   new_uri->string = new_string;
+  new_uri->hash = raptor_hash_bytes(new_string, length, 0);
 
   new_uri->usage = 1; /* for user */
 
@@ -163,10 +171,15 @@ raptor_new_uri_from_counted_string(raptor_world* world,
       RAPTOR_FREE(char*, new_string);
       RAPTOR_FREE(raptor_uri, new_uri);
       new_uri = NULL;
+    } else if(world->uri_ordinals) {
+      /* all existing ordinals are now stale */
+      if(!++world->uri_ordinals_epoch)
+        world->uri_ordinals_epoch++;
     }
   }
 
  unlock:
+  RAPTOR_WORLD_UNLOCK(world);
 
   return new_uri;
 }
@@ -471,9 +484,15 @@ raptor_new_uri_from_uri_or_file_string(raptor_world* world,
 void
 raptor_free_uri(raptor_uri *uri)
 {
+  raptor_world* world;
+
   if(!uri)
     return;
 
+  world = uri->world;
+
+  RAPTOR_WORLD_LOCK(world);
+
   uri->usage--;
   
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
@@ -482,12 +501,15 @@ raptor_free_uri(raptor_uri *uri)
 
   /* decrement usage, don't free if not 0 yet*/
   if(uri->usage > 0) {
+    RAPTOR_WORLD_UNLOCK(world);
     return;
   }
 
   /* this does not free the uri */
-  if(uri->world->uris_tree)
-    raptor_avltree_delete(uri->world->uris_tree, uri);
+  if(world->uris_tree)
+    raptor_avltree_delete(world->uris_tree, uri);
+
+  RAPTOR_WORLD_UNLOCK(world);
 
   if(uri->string)
     RAPTOR_FREE(char*, uri->string);
@@ -529,19 +551,9 @@ raptor_uri_equals(raptor_uri* uri1, raptor_uri* uri2)
 }
 
 
-/**
- * raptor_uri_compare:
- * @uri1: URI 1 (may be NULL)
- * @uri2: URI 2 (may be NULL)
- * 
- * Compare two URIs, ala strcmp.
- * 
- * A NULL URI is always less than (never equal to) a non-NULL URI.
- *
- * Return value: -1 if uri1 < uri2, 0 if equal, 1 if uri1 > uri2
- **/
-int
-raptor_uri_compare(raptor_uri* uri1, raptor_uri* uri2)
+/* Compare two URIs by their strings */
+static int
+raptor_uri_compare_strings(raptor_uri* uri1, raptor_uri* uri2)
 {
   if(uri1 == uri2)
     return 0;
@@ -565,6 +577,82 @@ raptor_uri_compare(raptor_uri* uri1, raptor_uri* uri2)
 }
 
 
+static int
+raptor_uri_ordinals_visit(int depth, void* data, void* user_data)
+{
+  raptor_uri* uri = (raptor_uri*)data;
+  raptor_world* world = (raptor_world*)user_data;
+
+  uri->ordinal = ++world->uri_ordinals_count;
+  uri->ordinal_epoch = world->uri_ordinals_epoch;
+
+  return 1;
+}
+
+
+/*
+ * raptor_uri_ordinals_update:
+ * @world: world
+ *
+ * INTERNAL - Number all interned URIs in sorted order for the current epoch
+ */
+static void
+raptor_uri_ordinals_update(raptor_world* world)
+{
+  world->uri_ordinals_count = 0;
+  raptor_avltree_visit(world->uris_tree, raptor_uri_ordinals_visit, world);
+  world->uri_ordinals_misses = 0;
+}
+
+
+/**
+ * raptor_uri_compare:
+ * @uri1: URI 1 (may be NULL)
+ * @uri2: URI 2 (may be NULL)
+ * 
+ * Compare two URIs, ala strcmp.
+ * 
+ * A NULL URI is always less than (never equal to) a non-NULL URI.
+ *
+ * If the world flag #RAPTOR_WORLD_FLAG_URI_ORDINALS is set, URIs
+ * are compared by their ordinals when these are current.
+ *
+ * Return value: -1 if uri1 < uri2, 0 if equal, 1 if uri1 > uri2
+ **/
+int
+raptor_uri_compare(raptor_uri* uri1, raptor_uri* uri2)
+{
+  raptor_world* world;
+
+  if(uri1 == uri2)
+    return 0;
+
+  if(!uri1 || !uri2)
+    /* One arg is NULL - sort that first */
+    return (!uri1) ? -1 : 1;
+
+  world = uri1->world;
+  /* ordinals are only read and renumbered while single-threaded */
+  if(world && world->uri_ordinals && !world->threads_active &&
+     uri2->world == world) {
+    if(uri1->ordinal_epoch != world->uri_ordinals_epoch ||
+       uri2->ordinal_epoch != world->uri_ordinals_epoch) {
+      /* renumber once enough comparisons have missed to pay for it */
+      if(++world->uri_ordinals_misses <
+         (unsigned long)raptor_avltree_size(world->uris_tree))
+        return raptor_uri_compare_strings(uri1, uri2);
+
+      raptor_uri_ordinals_update(world);
+    }
+
+    /* distinct interned URIs always have distinct ordinals */
+    return (uri1->ordinal < uri2->ordinal) ? -1 : 1;
+  }
+
+  return raptor_uri_compare_strings(uri1, uri2);
+}
+
+
 /**
  * raptor_uri_copy:
  * @uri: URI object
@@ -578,7 +666,10 @@ raptor_uri_copy(raptor_uri *uri)
 {
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(uri, raptor_uri, NULL);
   
+  RAPTOR_WORLD_LOCK(uri->world);
   uri->usage++;
+  RAPTOR_WORLD_UNLOCK(uri->world);
+
   return uri;
 }
 
@@ -629,6 +720,24 @@ raptor_uri_as_counted_string(raptor_uri *uri, size_t* len_p)
 }
 
 
+/*
+ * raptor_uri_get_hash:
+ * @uri: URI object
+ *
+ * INTERNAL - Get the raptor_hash_bytes() hash of a URI string
+ *
+ * The hash is calculated when the URI is created so reading it is
+ * safe from any thread sharing the world.
+ *
+ * Return value: hash value
+ */
+raptor_hash
+raptor_uri_get_hash(raptor_uri* uri)
+{
+  return uri->hash;
+}
+
+
 /**
  * raptor_uri_counted_filename_to_uri_string:
  * @filename: The filename to convert
@@ -1162,7 +1271,7 @@ int
 raptor_uri_init(raptor_world* world)
 {
   if(world->uri_interning && !world->uris_tree) {
-    world->uris_tree = raptor_new_avltree((raptor_data_compare_handler)raptor_uri_compare,
+    world->uris_tree = raptor_new_avltree((raptor_data_compare_handler)raptor_uri_compare_strings,
                                           /* free */ NULL, 0);
     if(!world->uris_tree) {
 #ifdef RAPTOR_DEBUG
@@ -1175,6 +1284,10 @@ raptor_uri_init(raptor_world* world)
     
   }
 
+  /* ordinals are kept for interned URIs only */
+  if(!world->uris_tree)
+    world->uri_ordinals = 0;
+
   return 0;
 }
 
@@ -2081,6 +2194,68 @@ main(int argc, char *argv[])
 
   raptor_free_world(world);
 
+  /* check compare with URI ordinals agrees with the strings, before
+   * and after numbering and after new URIs make the numbers stale */
+  world = raptor_new_world();
+  if(!world ||
+     raptor_world_set_flag(world, RAPTOR_WORLD_FLAG_URI_ORDINALS, 1) ||
+     raptor_world_open(world))
+    exit(1);
+
+  if(1) {
+#define ORDINAL_URIS_COUNT 64
+    raptor_uri* uris[ORDINAL_URIS_COUNT];
+    unsigned char buffer[64];
+    int pass;
+    int j;
+    int k;
+
+    for(k = 0; k < ORDINAL_URIS_COUNT; k++)
+      uris[k] = NULL;
+
+    for(pass = 0; pass < 4; pass++) {
+      /* add a quarter of the URIs in a scattered order each pass */
+      for(k = pass; k < ORDINAL_URIS_COUNT; k += 4) {
+        int n = (k * 37) % ORDINAL_URIS_COUNT;
+        sprintf((char*)buffer, "http://example.org/resource/%d", n);
+        uris[k] = raptor_new_uri(world, buffer);
+      }
+
+      for(k = 0; k < ORDINAL_URIS_COUNT; k++) {
+        for(j = 0; j < ORDINAL_URIS_COUNT; j++) {
+          int ret;
+          int expected;
+
+          if(!uris[k] || !uris[j])
+            continue;
+
+          ret = raptor_uri_compare(uris[k], uris[j]);
+          expected = strcmp((const char*)raptor_uri_as_string(uris[k]),
+                            (const char*)raptor_uri_as_string(uris[j]));
+          if((ret < 0) != (expected < 0) || (ret > 0) != (expected > 0)) {
+            fprintf(stderr,
+                    "%s: raptor_uri_compare(%s, %s) with ordinals FAILED gave %d expected %d\n",
+                    program, raptor_uri_as_string(uris[k]),
+                    raptor_uri_as_string(uris[j]), ret, expected);
+            failures++;
+          }
+        }
+      }
+
+      /* that many comparisons will have renumbered the URIs */
+      if(uris[pass]->ordinal_epoch != world->uri_ordinals_epoch) {
+        fprintf(stderr, "%s: URI %s ordinal was not renumbered\n",
+                program, raptor_uri_as_string(uris[pass]));
+        failures++;
+      }
+    }
+
+    for(k = 0; k < ORDINAL_URIS_COUNT; k++)
+      raptor_free_uri(uris[k]);
+  }
+
+  raptor_free_world(world);
+
   return failures ;
 }
 
@@ -0,0 +1,1069 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_uring.c - Raptor file iostreams with queued reads and writes
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#if defined(HAVE_PREAD) && defined(HAVE_PWRITE) && defined(HAVE_UNISTD_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_ERRNO_H)
+#define RAPTOR_FILE_QUEUE 1
+#endif
+
+#if defined(RAPTOR_FILE_QUEUE) && defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYS_SYSCALL_H) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_UIO_H) && defined(__GNUC__)
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define RAPTOR_IO_URING 1
+#endif
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+#ifdef RAPTOR_FILE_QUEUE
+
+/*
+ * A file is read or written in a ring of large buffers, each with one
+ * request for its part of the file in flight at a time.  Reading keeps
+ * every buffer not being consumed filled with the content that
+ * follows; writing sends each buffer as soon as it is full and only
+ * waits when the buffer it needs next is still being written.
+ *
+ * Requests go through an io_uring on Linux so several are in flight
+ * at once.  Where io_uring is not available or cannot be set up, such
+ * as when it is disabled by the system, each request is made at once
+ * with a blocking pread() or pwrite() instead.
+ */
+
+typedef enum {
+  RAPTOR_URING_BUFFER_IDLE,
+  /* request in flight */
+  RAPTOR_URING_BUFFER_BUSY,
+  /* request finished */
+  RAPTOR_URING_BUFFER_DONE
+} raptor_uring_buffer_state;
+
+
+typedef struct {
+  unsigned char* data;
+
+  /* bytes to write, or read */
+  size_t length;
+
+  /* bytes of the request transferred so far */
+  size_t done;
+
+  /* bytes consumed by the reader */
+  size_t used;
+
+  /* file offset of data[0] */
+  off_t offset;
+
+  raptor_uring_buffer_state state;
+
+#ifdef RAPTOR_IO_URING
+  struct iovec iov;
+#endif
+} raptor_uring_buffer;
+
+
+#ifdef RAPTOR_IO_URING
+typedef struct {
+  int fd;
+
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+
+  void* sq_map;
+  size_t sq_map_size;
+  void* cq_map;
+  size_t cq_map_size;
+  size_t sqes_size;
+} raptor_uring_ring;
+#endif
+
+
+typedef struct {
+  raptor_world* world;
+
+  /* FILE* owning the file descriptor */
+  FILE* handle;
+  int close_handle;
+  int fd;
+
+  int is_write;
+
+  raptor_uring_buffer* buffers;
+  int depth;
+  size_t buffer_size;
+
+  /* buffer being consumed or filled */
+  int current;
+
+  /* file offset of the first byte read */
+  off_t start_offset;
+  /* file offset of the next buffer to request */
+  off_t next_offset;
+  /* bytes consumed by the reader */
+  size_t consumed;
+
+  /* requests in flight */
+  int busy;
+
+  /* reading: a request found the end of the file */
+  int end_seen;
+  /* reading: all content was consumed */
+  int eof;
+  /* writing: all content was written */
+  int ended;
+
+  int failed;
+
+#ifdef RAPTOR_IO_URING
+  int use_ring;
+  raptor_uring_ring ring;
+#endif
+} raptor_uring_context;
+
+
+#ifdef RAPTOR_IO_URING
+static int
+raptor_uring_ring_enter(raptor_uring_ring* ring, unsigned int to_submit,
+                        unsigned int min_complete, unsigned int flags)
+{
+  long rc;
+
+  do {
+    rc = syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete,
+                 flags, NULL, 0);
+  } while(rc < 0 && errno == EINTR);
+
+  return (rc < 0);
+}
+
+
+static void
+raptor_uring_ring_close(raptor_uring_ring* ring)
+{
+  if(ring->sqes)
+    munmap(ring->sqes, ring->sqes_size);
+  if(ring->cq_map && ring->cq_map != ring->sq_map)
+    munmap(ring->cq_map, ring->cq_map_size);
+  if(ring->sq_map)
+    munmap(ring->sq_map, ring->sq_map_size);
+  if(ring->fd >= 0)
+    close(ring->fd);
+
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+}
+
+
+static int
+raptor_uring_ring_open(raptor_uring_ring* ring, unsigned int entries)
+{
+  struct io_uring_params params;
+  unsigned char* sq;
+  unsigned char* cq;
+
+  memset(ring, 0, sizeof(*ring));
+  memset(&params, 0, sizeof(params));
+
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if(ring->fd < 0)
+    return 1;
+
+  ring->sq_map_size = params.sq_off.array +
+                      params.sq_entries * sizeof(unsigned);
+  ring->cq_map_size = params.cq_off.cqes +
+                      params.cq_entries * sizeof(struct io_uring_cqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+  if(params.features & IORING_FEAT_SINGLE_MMAP) {
+    if(ring->cq_map_size > ring->sq_map_size)
+      ring->sq_map_size = ring->cq_map_size;
+    ring->cq_map_size = ring->sq_map_size;
+  }
+#endif
+
+  ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if(ring->sq_map == MAP_FAILED) {
+    ring->sq_map = NULL;
+    goto failed;
+  }
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+    ring->cq_map = ring->sq_map;
+  else
+#endif
+  {
+    ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_CQ_RING);
+    if(ring->cq_map == MAP_FAILED) {
+      ring->cq_map = NULL;
+      goto failed;
+    }
+  }
+
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size,
+                                          PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE,
+                                          ring->fd, IORING_OFF_SQES);
+  if(ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    goto failed;
+  }
+
+  sq = (unsigned char*)ring->sq_map;
+  ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+
+  cq = (unsigned char*)ring->cq_map;
+  ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+  return 0;
+
+  failed:
+  raptor_uring_ring_close(ring);
+  return 1;
+}
+
+
+/* queue one request; the ring always has room for every buffer */
+static int
+raptor_uring_ring_submit(raptor_uring_ring* ring, int is_write, int fd,
+                         struct iovec* iov, off_t offset, int index)
+{
+  unsigned int tail = *ring->sq_tail;
+  unsigned int slot = tail & *ring->sq_mask;
+  struct io_uring_sqe* sqe = &ring->sqes[slot];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long)iov;
+  sqe->len = 1;
+  sqe->off = (unsigned long long)offset;
+  sqe->user_data = (unsigned long long)index;
+  ring->sq_array[slot] = slot;
+
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return raptor_uring_ring_enter(ring, 1, 0, 0);
+}
+
+
+/* wait for the next finished request */
+static int
+raptor_uring_ring_wait(raptor_uring_ring* ring, int* index_p, int* result_p)
+{
+  while(1) {
+    unsigned int head = *ring->cq_head;
+
+    if(head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+
+      *index_p = (int)cqe->user_data;
+      *result_p = cqe->res;
+      __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+      return 0;
+    }
+
+    if(raptor_uring_ring_enter(ring, 0, 1, IORING_ENTER_GETEVENTS))
+      return 1;
+  }
+}
+#endif
+
+
+static void raptor_uring_complete(raptor_uring_context* ctx, int index, long result);
+
+/* request the rest of the transfer of buffer @index */
+static void
+raptor_uring_request(raptor_uring_context* ctx, int index)
+{
+  raptor_uring_buffer* b = &ctx->buffers[index];
+  unsigned char* data = b->data + b->done;
+  size_t len = b->length - b->done;
+  off_t offset = b->offset + RAPTOR_GOOD_CAST(off_t, b->done);
+  ssize_t n;
+
+  b->state = RAPTOR_URING_BUFFER_BUSY;
+
+#ifdef RAPTOR_IO_URING
+  if(ctx->use_ring) {
+    b->iov.iov_base = data;
+    b->iov.iov_len = len;
+    if(!raptor_uring_ring_submit(&ctx->ring, ctx->is_write, ctx->fd,
+                                 &b->iov, offset, index)) {
+      ctx->busy++;
+      return;
+    }
+    /* The request may still be queued in the ring so the buffer
+     * cannot be reused; give up */
+    ctx->failed = 1;
+    ctx->use_ring = 0;
+    return;
+  }
+#endif
+
+  do {
+    if(ctx->is_write)
+      n = pwrite(ctx->fd, data, len, offset);
+    else
+      n = pread(ctx->fd, data, len, offset);
+  } while(n < 0 && errno == EINTR);
+
+  raptor_uring_complete(ctx, index, (n < 0) ? -errno : (long)n);
+}
+
+
+/* handle a finished transfer of @result bytes or -errno */
+static void
+raptor_uring_complete(raptor_uring_context* ctx, int index, long result)
+{
+  raptor_uring_buffer* b = &ctx->buffers[index];
+
+  if(result == -EINTR || result == -EAGAIN) {
+    raptor_uring_request(ctx, index);
+    return;
+  }
+
+  if(result < 0 || (!result && ctx->is_write && b->done < b->length)) {
+    ctx->failed = 1;
+    b->state = RAPTOR_URING_BUFFER_DONE;
+    return;
+  }
+
+  b->done += RAPTOR_GOOD_CAST(size_t, result);
+  if(result > 0 && b->done < b->length) {
+    /* short transfer */
+    raptor_uring_request(ctx, index);
+    return;
+  }
+
+  if(!ctx->is_write) {
+    b->length = b->done;
+    if(b->length < ctx->buffer_size)
+      ctx->end_seen = 1;
+  }
+  b->state = RAPTOR_URING_BUFFER_DONE;
+}
+
+
+/* wait for buffer @index to finish its request */
+static int
+raptor_uring_wait_buffer(raptor_uring_context* ctx, int index)
+{
+#ifdef RAPTOR_IO_URING
+  while(ctx->buffers[index].state == RAPTOR_URING_BUFFER_BUSY) {
+    int done_index;
+    int result;
+
+    if(!ctx->use_ring || !ctx->busy ||
+       raptor_uring_ring_wait(&ctx->ring, &done_index, &result)) {
+      ctx->failed = 1;
+      return 1;
+    }
+
+    ctx->busy--;
+    if(done_index < 0 || done_index >= ctx->depth) {
+      ctx->failed = 1;
+      return 1;
+    }
+    raptor_uring_complete(ctx, done_index, result);
+  }
+#endif
+
+  return ctx->failed;
+}
+
+
+/* wait for all requests in flight */
+static void
+raptor_uring_wait_all(raptor_uring_context* ctx)
+{
+  int i;
+
+  for(i = 0; i < ctx->depth; i++) {
+    if(raptor_uring_wait_buffer(ctx, i) &&
+       ctx->buffers[i].state == RAPTOR_URING_BUFFER_BUSY)
+      break;
+  }
+}
+
+
+/* request the next part of the file into buffer @index */
+static void
+raptor_uring_start_read(raptor_uring_context* ctx, int index)
+{
+  raptor_uring_buffer* b = &ctx->buffers[index];
+
+  b->length = ctx->buffer_size;
+  b->done = 0;
+  b->used = 0;
+  b->offset = ctx->next_offset;
+
+  if(ctx->end_seen) {
+    /* there is nothing more to read */
+    b->length = 0;
+    b->state = RAPTOR_URING_BUFFER_DONE;
+    return;
+  }
+
+  ctx->next_offset += RAPTOR_GOOD_CAST(off_t, ctx->buffer_size);
+  raptor_uring_request(ctx, index);
+}
+
+
+/* write the filled part of buffer @index */
+static void
+raptor_uring_start_write(raptor_uring_context* ctx, int index)
+{
+  raptor_uring_buffer* b = &ctx->buffers[index];
+
+  b->done = 0;
+  b->offset = ctx->next_offset;
+  ctx->next_offset += RAPTOR_GOOD_CAST(off_t, b->length);
+  raptor_uring_request(ctx, index);
+}
+
+
+/* write everything not yet written and wait for it */
+static int
+raptor_uring_flush(raptor_uring_context* ctx)
+{
+  raptor_uring_buffer* b = &ctx->buffers[ctx->current];
+
+  if(b->state == RAPTOR_URING_BUFFER_IDLE && b->length && !ctx->failed) {
+    raptor_uring_start_write(ctx, ctx->current);
+    ctx->current = (ctx->current + 1) % ctx->depth;
+  }
+
+  raptor_uring_wait_all(ctx);
+
+  return ctx->failed;
+}
+
+
+/* iostream handler methods */
+
+static void
+raptor_uring_iostream_finish(void* user_data)
+{
+  raptor_uring_context* ctx = (raptor_uring_context*)user_data;
+  int in_flight = 0;
+  int i;
+
+  if(ctx->buffers) {
+    if(ctx->is_write && !ctx->ended)
+      raptor_uring_flush(ctx);
+    else
+      raptor_uring_wait_all(ctx);
+
+    for(i = 0; i < ctx->depth; i++) {
+      if(ctx->buffers[i].state == RAPTOR_URING_BUFFER_BUSY)
+        in_flight = 1;
+    }
+  }
+
+#ifdef RAPTOR_IO_URING
+  if(ctx->ring.fd >= 0)
+    raptor_uring_ring_close(&ctx->ring);
+#endif
+
+  if(ctx->buffers) {
+    /* A request the ring lost track of might still use its buffer so
+     * leak the buffers rather than free them */
+    if(!in_flight) {
+      for(i = 0; i < ctx->depth; i++) {
+        if(ctx->buffers[i].data)
+          RAPTOR_FREE(char*, ctx->buffers[i].data);
+      }
+      RAPTOR_FREE(raptor_uring_buffer*, ctx->buffers);
+    }
+  }
+
+  if(ctx->handle) {
+    if(ctx->close_handle)
+      fclose(ctx->handle);
+    else if(!ctx->is_write) {
+      /* leave the stream after the content that was consumed */
+      fseek(ctx->handle,
+            RAPTOR_GOOD_CAST(long, ctx->start_offset) +
+            RAPTOR_GOOD_CAST(long, ctx->consumed), SEEK_SET);
+    }
+  }
+
+  RAPTOR_FREE(raptor_uring_context, ctx);
+}
+
+
+static int
+raptor_uring_iostream_write_bytes(void* user_data, const void* ptr,
+                                  size_t size, size_t nmemb)
+{
+  raptor_uring_context* ctx = (raptor_uring_context*)user_data;
+  const unsigned char* p = (const unsigned char*)ptr;
+  size_t left = size * nmemb;
+
+  while(left && !ctx->failed) {
+    raptor_uring_buffer* b = &ctx->buffers[ctx->current];
+    size_t len;
+
+    if(b->state != RAPTOR_URING_BUFFER_IDLE) {
+      /* reuse the buffer once its last content is written */
+      if(raptor_uring_wait_buffer(ctx, ctx->current))
+        break;
+      b->state = RAPTOR_URING_BUFFER_IDLE;
+      b->length = 0;
+    }
+
+    len = ctx->buffer_size - b->length;
+    if(len > left)
+      len = left;
+    memcpy(b->data + b->length, p, len);
+    b->length += len;
+    p += len;
+    left -= len;
+
+    if(b->length == ctx->buffer_size) {
+      raptor_uring_start_write(ctx, ctx->current);
+      ctx->current = (ctx->current + 1) % ctx->depth;
+    }
+  }
+
+  return ctx->failed ? -1 : RAPTOR_BAD_CAST(int, nmemb);
+}
+
+
+static int
+raptor_uring_iostream_write_byte(void* user_data, const int byte)
+{
+  unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+
+  return (raptor_uring_iostream_write_bytes(user_data, &c, 1, 1) != 1);
+}
+
+
+static int
+raptor_uring_iostream_write_end(void* user_data)
+{
+  raptor_uring_context* ctx = (raptor_uring_context*)user_data;
+
+  ctx->ended = 1;
+  return raptor_uring_flush(ctx);
+}
+
+
+static int
+raptor_uring_iostream_read_bytes(void* user_data, void* ptr,
+                                 size_t size, size_t nmemb)
+{
+  raptor_uring_context* ctx = (raptor_uring_context*)user_data;
+  unsigned char* p = (unsigned char*)ptr;
+  size_t want = size * nmemb;
+  size_t got = 0;
+
+  if(!want)
+    return 0;
+
+  while(got < want && !ctx->eof) {
+    raptor_uring_buffer* b = &ctx->buffers[ctx->current];
+    size_t len;
+
+    if(raptor_uring_wait_buffer(ctx, ctx->current))
+      return -1;
+
+    len = b->length - b->used;
+    if(len > want - got)
+      len = want - got;
+    memcpy(p + got, b->data + b->used, len);
+    b->used += len;
+    got += len;
+    ctx->consumed += len;
+
+    if(b->used == b->length) {
+      if(b->length < ctx->buffer_size) {
+        ctx->eof = 1;
+        break;
+      }
+
+      /* refill the buffer with content after the other buffers */
+      raptor_uring_start_read(ctx, ctx->current);
+      ctx->current = (ctx->current + 1) % ctx->depth;
+    }
+  }
+
+  return RAPTOR_BAD_CAST(int, got / size);
+}
+
+
+static int
+raptor_uring_iostream_read_eof(void* user_data)
+{
+  raptor_uring_context* ctx = (raptor_uring_context*)user_data;
+
+  return ctx->eof;
+}
+
+
+static const raptor_iostream_handler raptor_uring_iostream_write_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_uring_iostream_finish,
+  /* .write_byte  = */ raptor_uring_iostream_write_byte,
+  /* .write_bytes = */ raptor_uring_iostream_write_bytes,
+  /* .write_end   = */ raptor_uring_iostream_write_end,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL,
+  /* .write_iov   = */ NULL
+};
+
+
+static const raptor_iostream_handler raptor_uring_iostream_read_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_uring_iostream_finish,
+  /* .write_byte  = */ NULL,
+  /* .write_bytes = */ NULL,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ raptor_uring_iostream_read_bytes,
+  /* .read_eof    = */ raptor_uring_iostream_read_eof,
+  /* .write_iov   = */ NULL
+};
+
+
+static raptor_uring_context*
+raptor_new_uring_context(raptor_world* world, FILE* handle, int is_write,
+                         int queue_depth, size_t buffer_size)
+{
+  raptor_uring_context* ctx;
+  int i;
+
+  if(queue_depth > RAPTOR_URING_MAX_QUEUE_DEPTH)
+    queue_depth = RAPTOR_URING_MAX_QUEUE_DEPTH;
+  if(!buffer_size)
+    buffer_size = RAPTOR_URING_BUFFER_SIZE;
+  else if(buffer_size < RAPTOR_URING_MIN_BUFFER_SIZE)
+    buffer_size = RAPTOR_URING_MIN_BUFFER_SIZE;
+
+  ctx = RAPTOR_CALLOC(raptor_uring_context*, 1, sizeof(*ctx));
+  if(!ctx)
+    return NULL;
+
+  ctx->world = world;
+  ctx->handle = handle;
+  ctx->fd = fileno(handle);
+  ctx->is_write = is_write;
+  ctx->depth = queue_depth;
+  ctx->buffer_size = buffer_size;
+#ifdef RAPTOR_IO_URING
+  ctx->ring.fd = -1;
+#endif
+
+  ctx->buffers = RAPTOR_CALLOC(raptor_uring_buffer*,
+                               RAPTOR_GOOD_CAST(size_t, queue_depth),
+                               sizeof(raptor_uring_buffer));
+  if(!ctx->buffers)
+    goto failed;
+
+  for(i = 0; i < queue_depth; i++) {
+    ctx->buffers[i].data = RAPTOR_MALLOC(unsigned char*, buffer_size);
+    if(!ctx->buffers[i].data)
+      goto failed;
+  }
+
+#ifdef RAPTOR_IO_URING
+  /* a single buffer has nothing to overlap with */
+  if(queue_depth > 1 &&
+     !raptor_uring_ring_open(&ctx->ring,
+                             RAPTOR_GOOD_CAST(unsigned int, queue_depth)))
+    ctx->use_ring = 1;
+#endif
+
+  return ctx;
+
+  failed:
+  ctx->handle = NULL;
+  raptor_uring_iostream_finish(ctx);
+  return NULL;
+}
+
+#endif
+
+
+/**
+ * raptor_new_iostream_from_file_handle_uring:
+ * @world: raptor world
+ * @handle: FILE* of a regular file to read from
+ * @queue_depth: number of buffers to keep reads in flight for
+ * @buffer_size: size of each buffer or 0 for the default
+ *
+ * INTERNAL - Constructor - create an iostream reading the rest of a
+ * regular file with several large reads in flight
+ *
+ * The reads are made through an io_uring where supported, otherwise
+ * one at a time with blocking reads.  The content is read from the
+ * file descriptor of @handle starting at the current position of
+ * @handle, which is moved to after the content consumed when the
+ * iostream is freed.  @handle is not closed.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure, or
+ * if @handle is not a regular file or this build cannot read files
+ * this way, when @handle should be read as usual
+ */
+raptor_iostream*
+raptor_new_iostream_from_file_handle_uring(raptor_world* world, FILE* handle,
+                                           int queue_depth,
+                                           size_t buffer_size)
+{
+#ifdef RAPTOR_FILE_QUEUE
+  raptor_uring_context* ctx;
+  raptor_iostream* iostr;
+  struct stat buf;
+  long offset;
+  int i;
+
+  if(queue_depth < 1 || fileno(handle) < 0 ||
+     fstat(fileno(handle), &buf) || !S_ISREG(buf.st_mode))
+    return NULL;
+
+  offset = ftell(handle);
+  if(offset < 0)
+    return NULL;
+
+  ctx = raptor_new_uring_context(world, handle, 0, queue_depth, buffer_size);
+  if(!ctx)
+    return NULL;
+
+  ctx->start_offset = RAPTOR_GOOD_CAST(off_t, offset);
+  ctx->next_offset = ctx->start_offset;
+
+  /* start reading into every buffer */
+  for(i = 0; i < ctx->depth; i++)
+    raptor_uring_start_read(ctx, i);
+
+  iostr = raptor_new_iostream_from_handler(world, ctx,
+                                           &raptor_uring_iostream_read_handler);
+  if(!iostr)
+    raptor_uring_iostream_finish(ctx);
+
+  return iostr;
+#else
+  return NULL;
+#endif
+}
+
+
+/**
+ * raptor_new_iostream_to_filename_uring:
+ * @world: raptor world
+ * @filename: Output filename to open and write to
+ * @queue_depth: number of buffers to keep writes in flight for
+ * @buffer_size: size of each buffer or 0 for the default
+ *
+ * INTERNAL - Constructor - create an iostream writing to a filename
+ * with several large writes in flight
+ *
+ * The writes are made through an io_uring where supported, otherwise
+ * one at a time with blocking writes.  All content is written when
+ * the iostream is ended or freed.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure, or
+ * if this build cannot write files this way, when the file should be
+ * written with raptor_new_iostream_to_filename()
+ */
+raptor_iostream*
+raptor_new_iostream_to_filename_uring(raptor_world* world,
+                                      const char* filename,
+                                      int queue_depth, size_t buffer_size)
+{
+#ifdef RAPTOR_FILE_QUEUE
+  raptor_uring_context* ctx;
+  raptor_iostream* iostr;
+  FILE* handle;
+
+  if(!filename || queue_depth < 1)
+    return NULL;
+
+  handle = fopen(filename, "wb");
+  if(!handle)
+    return NULL;
+
+  ctx = raptor_new_uring_context(world, handle, 1, queue_depth, buffer_size);
+  if(!ctx) {
+    fclose(handle);
+    return NULL;
+  }
+  ctx->close_handle = 1;
+
+  iostr = raptor_new_iostream_from_handler(world, ctx,
+                                           &raptor_uring_iostream_write_handler);
+  if(!iostr)
+    raptor_uring_iostream_finish(ctx);
+
+  return iostr;
+#else
+  return NULL;
+#endif
+}
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define OUT_FILENAME "raptor_uring_test.nt"
+#define TEST_LINES 30000
+
+static int
+test_statement_handler_count;
+
+static void
+test_statement_handler(void* user_data, raptor_statement* statement)
+{
+  test_statement_handler_count++;
+}
+
+
+static int
+test_write_read(raptor_world* world, const char* program, int queue_depth,
+                size_t buffer_size)
+{
+  raptor_iostream* iostr;
+  unsigned char* expected;
+  unsigned char* got;
+  size_t length = 3 * 4096 + 123;
+  size_t i;
+  FILE* fh;
+  int rc = 0;
+
+  expected = (unsigned char*)malloc(length);
+  got = (unsigned char*)malloc(length + 1);
+  if(!expected || !got)
+    exit(1);
+  for(i = 0; i < length; i++)
+    expected[i] = (unsigned char)((i * 7) ^ (i >> 8));
+
+  iostr = raptor_new_iostream_to_filename_uring(world, OUT_FILENAME,
+                                                queue_depth, buffer_size);
+  if(!iostr) {
+    /* reading and writing with pread and pwrite is not supported */
+    free(expected);
+    free(got);
+    return 0;
+  }
+
+  /* bytes, then parts shorter and longer than a buffer */
+  for(i = 0; i < 100; i++)
+    raptor_iostream_write_byte(expected[i], iostr);
+  raptor_iostream_write_bytes(expected + 100, 1, 900, iostr);
+  raptor_iostream_write_bytes(expected + 1000, 1, length - 1000, iostr);
+  if(raptor_iostream_write_end(iostr)) {
+    fprintf(stderr, "%s: Writing with queue depth %d failed\n", program,
+            queue_depth);
+    rc = 1;
+  }
+  raptor_free_iostream(iostr);
+
+  fh = fopen(OUT_FILENAME, "rb");
+  if(!fh) {
+    fprintf(stderr, "%s: Failed to open %s\n", program, OUT_FILENAME);
+    exit(1);
+  }
+
+  /* start reading after the first byte, as after checking magic */
+  fgetc(fh);
+  iostr = raptor_new_iostream_from_file_handle_uring(world, fh, queue_depth,
+                                                     buffer_size);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to read with queue depth %d\n", program,
+            queue_depth);
+    exit(1);
+  }
+
+  i = 0;
+  while(!raptor_iostream_read_eof(iostr)) {
+    int n = raptor_iostream_read_bytes(got + i, 1, 1000, iostr);
+    if(n < 0) {
+      rc = 1;
+      break;
+    }
+    i += RAPTOR_GOOD_CAST(size_t, n);
+  }
+  raptor_free_iostream(iostr);
+
+  if(i != length - 1 || memcmp(got, expected + 1, length - 1)) {
+    fprintf(stderr,
+            "%s: Read %d bytes with queue depth %d, expected %d or wrong content\n",
+            program, (int)i, queue_depth, (int)(length - 1));
+    rc = 1;
+  }
+  if(ftell(fh) != RAPTOR_BAD_CAST(long, length)) {
+    fprintf(stderr, "%s: Stream left at %ld after reading, expected %d\n",
+            program, ftell(fh), (int)length);
+    rc = 1;
+  }
+
+  fclose(fh);
+  remove(OUT_FILENAME);
+  free(expected);
+  free(got);
+
+  return rc;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = raptor_basename(argv[0]);
+  raptor_world *world;
+  raptor_parser* parser;
+  raptor_serializer* serializer;
+  raptor_uri* base_uri;
+  raptor_statement* statement;
+  int i;
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  /* file size not a multiple of the smallest buffer size */
+  rc += test_write_read(world, program, 1, 4096);
+  rc += test_write_read(world, program, 2, 4096);
+  rc += test_write_read(world, program, 5, 1);
+  rc += test_write_read(world, program, 3, 0);
+
+  /* serialize and parse through the options */
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  serializer = raptor_new_serializer(world, "ntriples");
+  statement = raptor_new_statement(world);
+  if(!base_uri || !serializer || !statement) {
+    fprintf(stderr, "%s: Failed to create serializer\n", program);
+    exit(1);
+  }
+  raptor_serializer_set_option(serializer, RAPTOR_OPTION_IO_QUEUE_DEPTH,
+                               NULL, 4);
+  raptor_serializer_set_option(serializer, RAPTOR_OPTION_IO_BUFFER_SIZE,
+                               NULL, 8192);
+  if(raptor_serializer_start_to_filename(serializer, OUT_FILENAME)) {
+    fprintf(stderr, "%s: Failed to start serializing\n", program);
+    exit(1);
+  }
+  for(i = 0; i < TEST_LINES; i++) {
+    char s[40];
+
+    sprintf(s, "http://example.org/s%d", i);
+    statement->subject = raptor_new_term_from_uri_string(world,
+                                                         (const unsigned char*)s);
+    statement->predicate = raptor_new_term_from_uri_string(world,
+                                                           (const unsigned char*)"http://example.org/p");
+    statement->object = raptor_new_term_from_literal(world,
+                                                     (const unsigned char*)s,
+                                                     NULL, NULL);
+    raptor_serializer_serialize_statement(serializer, statement);
+    raptor_statement_clear(statement);
+  }
+  raptor_serializer_serialize_end(serializer);
+  raptor_free_serializer(serializer);
+  raptor_free_statement(statement);
+
+  parser = raptor_new_parser(world, "ntriples");
+  if(!parser) {
+    fprintf(stderr, "%s: Failed to create parser\n", program);
+    exit(1);
+  }
+  raptor_parser_set_option(parser, RAPTOR_OPTION_IO_QUEUE_DEPTH, NULL, 3);
+  raptor_parser_set_option(parser, RAPTOR_OPTION_IO_BUFFER_SIZE, NULL, 8192);
+  raptor_parser_set_statement_handler(parser, NULL, test_statement_handler);
+  {
+    FILE* fh = fopen(OUT_FILENAME, "rb");
+
+    if(!fh || raptor_parser_parse_file_stream(parser, fh, NULL, base_uri)) {
+      fprintf(stderr, "%s: Parsing failed\n", program);
+      rc++;
+    }
+    if(fh)
+      fclose(fh);
+  }
+  if(test_statement_handler_count != TEST_LINES) {
+    fprintf(stderr, "%s: Parsing returned %d statements, expected %d\n",
+            program, test_statement_handler_count, TEST_LINES);
+    rc++;
+  }
+
+  raptor_free_parser(parser);
+  raptor_free_uri(base_uri);
+  remove(OUT_FILENAME);
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
@@ -134,6 +134,13 @@ raptor_new_www_with_connection(raptor_world* world, void *connection)
   www->connection_timeout = 10;
   www->cache_control = NULL;
 
+  www->buffer_size = RAPTOR_WWW_BUFFER_SIZE;
+  www->buffer = RAPTOR_MALLOC(char*, www->buffer_size + 1);
+  if(!www->buffer) {
+    RAPTOR_FREE(raptor_www, www);
+    return NULL;
+  }
+
 #ifdef RAPTOR_WWW_LIBCURL
   www->curl_handle = (CURL*)connection;
   raptor_www_curl_init(www);
@@ -220,6 +227,9 @@ raptor_free_www(raptor_www* www)
   if(www->final_uri)
     raptor_free_uri(www->final_uri);
 
+  if(www->buffer)
+    RAPTOR_FREE(char*, www->buffer);
+
   RAPTOR_FREE(www, www);
 }
 
@@ -585,11 +595,43 @@ raptor_www_error(raptor_www* www, const char *message, ...)
 }
 
   
+/*
+ * raptor_www_set_buffer_size:
+ * @www: WWW object
+ * @size: buffer size in bytes
+ *
+ * INTERNAL - Set the size of the buffer content is read into
+ *
+ * Return value: non-0 on failure, when the buffer is unchanged
+ */
+int
+raptor_www_set_buffer_size(raptor_www* www, size_t size)
+{
+  char* buffer;
+
+  if(!size)
+    return 1;
+
+  if(size == www->buffer_size)
+    return 0;
+
+  buffer = RAPTOR_MALLOC(char*, size + 1);
+  if(!buffer)
+    return 1;
+
+  RAPTOR_FREE(char*, www->buffer);
+  www->buffer = buffer;
+  www->buffer_size = size;
+
+  return 0;
+}
+
+
 static int 
 raptor_www_file_handle_fetch(raptor_www* www, FILE* fh) 
 {
   while(!feof(fh)) {
-    size_t len = fread(www->buffer, 1, RAPTOR_WWW_BUFFER_SIZE, fh);
+    size_t len = fread(www->buffer, 1, www->buffer_size, fh);
     if(len > 0) {
       www->total_bytes += len;
       www->buffer[len]='\0';
@@ -609,11 +651,37 @@ raptor_www_file_handle_fetch(raptor_www* www, FILE* fh)
 }
 
 
+static int
+raptor_www_file_mapped_fetch(raptor_www* www, raptor_mapped_file* mapped)
+{
+  const unsigned char* p = mapped->data;
+  size_t remaining = mapped->length;
+
+  while(remaining && !www->failed) {
+    size_t len = (remaining < RAPTOR_MMAP_WINDOW_SIZE) ? remaining :
+                 RAPTOR_MMAP_WINDOW_SIZE;
+
+    www->total_bytes += len;
+    if(www->write_bytes)
+      www->write_bytes(www, www->write_bytes_userdata, p, len, 1);
+
+    p += len;
+    remaining -= len;
+  }
+
+  if(!www->failed)
+    www->status_code = 200;
+
+  return www->failed;
+}
+
+
 static int 
 raptor_www_file_fetch(raptor_www* www) 
 {
   char *filename;
   FILE *fh;
+  raptor_mapped_file mapped;
   unsigned char *uri_string = raptor_uri_as_string(www->uri);
 #if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_STAT_H)
   struct stat buf;
@@ -647,7 +715,11 @@ raptor_www_file_fetch(raptor_www* www)
     return www->failed;
   }
 
-  raptor_www_file_handle_fetch(www, fh);
+  if(!raptor_mapped_file_open(&mapped, fh, RAPTOR_MMAP_MIN_SIZE)) {
+    raptor_www_file_mapped_fetch(www, &mapped);
+    raptor_mapped_file_close(&mapped);
+  } else
+    raptor_www_file_handle_fetch(www, fh);
   fclose(fh);
 
   RAPTOR_FREE(char*, filename);
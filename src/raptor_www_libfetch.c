@@ -79,14 +79,14 @@ raptor_www_libfetch_fetch(raptor_www *www)
   www->status_code = 200;
   
   while(!feof(stream)) {
-    size_t len = fread(www->buffer, 1, RAPTOR_WWW_BUFFER_SIZE, stream);
+    size_t len = fread(www->buffer, 1, www->buffer_size, stream);
     
     www->total_bytes += len;
 
     if(www->write_bytes)
       www->write_bytes(www, www->write_bytes_userdata, www->buffer, len, 1);
     
-    if(len < RAPTOR_WWW_BUFFER_SIZE)
+    if(len < www->buffer_size)
       break;
   }
   fclose(stream);
@@ -138,7 +138,8 @@ raptor_www_libxml_fetch(raptor_www *www)
   www->status_code = xmlNanoHTTPReturnCode(www->ctxt);
   
   while(1) {
-    int len = xmlNanoHTTPRead(www->ctxt, www->buffer, RAPTOR_WWW_BUFFER_SIZE);
+    int len = xmlNanoHTTPRead(www->ctxt, www->buffer,
+                              RAPTOR_BAD_CAST(int, www->buffer_size));
     if(len < 0)
       break;
     
@@ -147,7 +148,7 @@ raptor_www_libxml_fetch(raptor_www *www)
     if(www->write_bytes)
       www->write_bytes(www, www->write_bytes_userdata, www->buffer, len, 1);
     
-    if(len < RAPTOR_WWW_BUFFER_SIZE || www->failed)
+    if(RAPTOR_GOOD_CAST(size_t, len) < www->buffer_size || www->failed)
       break;
   }
   
@@ -26,6 +26,7 @@
 
 
 #include <stdio.h>
+#include <string.h>
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
 #endif
@@ -72,6 +73,241 @@ raptor_sort_r(void *base, size_t nel, size_t width,
 }
 
 
+/* POLICY - smallest number of items sorted or merged by one task */
+#define RAPTOR_SORT_PARALLEL_MIN_ITEMS 4096
+
+typedef struct {
+  raptor_data_compare_handler compare;
+
+  /* array read from and, for merges, array written to */
+  void** src;
+  void** dst;
+
+  /* left run src[left_start, left_end) and right run
+   * src[right_start, right_end) are merged into dst starting at @out;
+   * a sort task sorts the left run in place */
+  size_t left_start;
+  size_t left_end;
+  size_t right_start;
+  size_t right_end;
+  size_t out;
+} raptor_sort_parallel_task;
+
+
+static int
+raptor_sort_parallel_sort_task(void* data)
+{
+  raptor_sort_parallel_task* task = (raptor_sort_parallel_task*)data;
+
+  qsort(&task->src[task->left_start], task->left_end - task->left_start,
+        sizeof(void*), task->compare);
+
+  return 0;
+}
+
+
+static int
+raptor_sort_parallel_merge_task(void* data)
+{
+  raptor_sort_parallel_task* task = (raptor_sort_parallel_task*)data;
+  void** src = task->src;
+  void** out = &task->dst[task->out];
+  size_t i = task->left_start;
+  size_t j = task->right_start;
+
+  /* ties take the left item so the merge is stable */
+  while(i < task->left_end && j < task->right_end) {
+    if(task->compare(&src[j], &src[i]) < 0)
+      *out++ = src[j++];
+    else
+      *out++ = src[i++];
+  }
+
+  if(i < task->left_end) {
+    memcpy(out, &src[i], (task->left_end - i) * sizeof(void*));
+    out += task->left_end - i;
+  }
+  if(j < task->right_end)
+    memcpy(out, &src[j], (task->right_end - j) * sizeof(void*));
+
+  return 0;
+}
+
+
+/*
+ * Find how many items of the left run are in the first @k items of
+ * the stable merge of the left and right runs, so one merge can be
+ * split into independent parts.
+ */
+static size_t
+raptor_sort_parallel_split(raptor_sort_parallel_task* run, size_t k)
+{
+  size_t m = run->left_end - run->left_start;
+  size_t n = run->right_end - run->right_start;
+  size_t lo = (k > n) ? k - n : 0;
+  size_t hi = (k < m) ? k : m;
+
+  while(lo < hi) {
+    size_t i = lo + (hi - lo) / 2;
+    size_t j = k - i;
+
+    /* i < m and j > 0 here */
+    if(run->compare(&run->src[run->left_start + i],
+                    &run->src[run->right_start + j - 1]) <= 0)
+      lo = i + 1;
+    else
+      hi = i;
+  }
+
+  return lo;
+}
+
+
+static void
+raptor_sort_parallel_add_task(raptor_thread_pool* pool,
+                              raptor_thread_task_handler handler,
+                              raptor_sort_parallel_task* task)
+{
+  /* a task that cannot be queued is run here instead */
+  if(raptor_thread_pool_add_task(pool, handler, task))
+    handler(task);
+}
+
+
+/**
+ * raptor_sort_parallel:
+ * @base: array of pointers to sort
+ * @nel: number of pointers in @base
+ * @compare: comparison function with args (a, b)
+ * @pool: thread pool or NULL
+ *
+ * INTERNAL - Sort an array of pointers using the worker threads of a pool
+ *
+ * The array is split into one run per worker which are sorted
+ * concurrently with qsort() and then merged in rounds, each merge
+ * itself split across the workers.  The comparison function is as
+ * for raptor_sequence_sort() and must be safe to call from several
+ * threads at once.  Small arrays, a NULL @pool or one with no worker
+ * threads, or running out of memory, all sort with qsort() in the
+ * calling thread.
+ */
+void
+raptor_sort_parallel(void** base, size_t nel,
+                     raptor_data_compare_handler compare,
+                     raptor_thread_pool* pool)
+{
+  raptor_sort_parallel_task* tasks = NULL;
+  void** buffer = NULL;
+  size_t* bounds = NULL;
+  void** src;
+  void** dst;
+  size_t threads;
+  size_t runs;
+  size_t r;
+
+  threads = pool ? RAPTOR_GOOD_CAST(size_t,
+                                    raptor_thread_pool_get_threads_count(pool))
+                 : 0;
+  runs = threads;
+  while(runs > 1 && runs * RAPTOR_SORT_PARALLEL_MIN_ITEMS > nel)
+    runs--;
+
+  if(runs > 1) {
+    buffer = RAPTOR_MALLOC(void**, nel * sizeof(void*));
+    bounds = RAPTOR_MALLOC(size_t*, (runs + 1) * sizeof(size_t));
+    /* each round has at most one task per worker plus one per merge */
+    tasks = RAPTOR_CALLOC(raptor_sort_parallel_task*, runs + threads,
+                          sizeof(*tasks));
+  }
+
+  if(!buffer || !bounds || !tasks) {
+    if(nel > 1)
+      qsort(base, nel, sizeof(void*), compare);
+    goto tidy;
+  }
+
+  for(r = 0; r <= runs; r++)
+    bounds[r] = (nel * r) / runs;
+
+  for(r = 0; r < runs; r++) {
+    tasks[r].compare = compare;
+    tasks[r].src = base;
+    tasks[r].left_start = bounds[r];
+    tasks[r].left_end = bounds[r + 1];
+    raptor_sort_parallel_add_task(pool, raptor_sort_parallel_sort_task,
+                                  &tasks[r]);
+  }
+  raptor_thread_pool_wait(pool);
+
+  src = base;
+  dst = buffer;
+  while(runs > 1) {
+    size_t pairs = (runs + 1) / 2;
+    size_t parts = (threads + pairs - 1) / pairs;
+    size_t t = 0;
+
+    for(r = 0; r < runs; r += 2) {
+      raptor_sort_parallel_task run;
+      size_t size;
+      size_t p;
+      size_t count;
+
+      run.compare = compare;
+      run.src = src;
+      run.dst = dst;
+      run.left_start = bounds[r];
+      run.left_end = bounds[r + 1];
+      /* an odd last run is merged with nothing to copy it over */
+      run.right_start = bounds[r + 1];
+      run.right_end = (r + 1 < runs) ? bounds[r + 2] : bounds[r + 1];
+      run.out = bounds[r];
+
+      size = run.right_end - run.left_start;
+      count = parts;
+      while(count > 1 && count * RAPTOR_SORT_PARALLEL_MIN_ITEMS > size)
+        count--;
+
+      for(p = 0; p < count; p++) {
+        raptor_sort_parallel_task* task = &tasks[t++];
+        size_t k_start = (size * p) / count;
+        size_t k_end = (size * (p + 1)) / count;
+        size_t i_start = raptor_sort_parallel_split(&run, k_start);
+        size_t i_end = raptor_sort_parallel_split(&run, k_end);
+
+        *task = run;
+        task->left_start = run.left_start + i_start;
+        task->left_end = run.left_start + i_end;
+        task->right_start = run.right_start + (k_start - i_start);
+        task->right_end = run.right_start + (k_end - i_end);
+        task->out = run.out + k_start;
+        raptor_sort_parallel_add_task(pool, raptor_sort_parallel_merge_task,
+                                      task);
+      }
+    }
+    raptor_thread_pool_wait(pool);
+
+    /* merged runs end at every other old boundary */
+    for(r = 0; r < pairs; r++)
+      bounds[r + 1] = bounds[(r * 2 + 2 < runs) ? r * 2 + 2 : runs];
+    runs = pairs;
+
+    src = dst;
+    dst = (dst == buffer) ? base : buffer;
+  }
+
+  if(src != base)
+    memcpy(base, src, nel * sizeof(void*));
+
+  tidy:
+  if(tasks)
+    RAPTOR_FREE(raptor_sort_parallel_task*, tasks);
+  if(bounds)
+    RAPTOR_FREE(size_t*, bounds);
+  if(buffer)
+    RAPTOR_FREE(void**, buffer);
+}
+
+
 #endif
 
 
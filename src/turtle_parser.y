@@ -1899,6 +1899,7 @@ raptor_turtle_parser_register_factory(raptor_parser_factory *factory)
   factory->terminate = raptor_turtle_parse_terminate;
   factory->start     = raptor_turtle_parse_start;
   factory->chunk     = raptor_turtle_parse_chunk;
+  factory->mmap_whole_file = 1;
   factory->recognise_syntax = raptor_turtle_parse_recognise_syntax;
   factory->get_graph = raptor_turtle_get_graph;
 
@@ -1942,6 +1943,7 @@ raptor_trig_parser_register_factory(raptor_parser_factory *factory)
   factory->terminate = raptor_turtle_parse_terminate;
   factory->start     = raptor_turtle_parse_start;
   factory->chunk     = raptor_turtle_parse_chunk;
+  factory->mmap_whole_file = 1;
   factory->recognise_syntax = raptor_trig_parse_recognise_syntax;
   factory->get_graph = raptor_turtle_get_graph;
 
@@ -80,6 +80,9 @@ static int triple_count = 0;
 
 static raptor_serializer* serializer = NULL;
 
+/* serializes on another thread if set */
+static raptor_pipeline* pipeline = NULL;
+
 static int guess = 0;
 
 static int reported_guess = 0;
@@ -114,7 +117,10 @@ void print_triples(void *user_data, raptor_statement *triple)
         *s=' ';
   }
 
-  raptor_serializer_serialize_statement(serializer, triple);
+  if(pipeline)
+    raptor_pipeline_serialize_statement(pipeline, triple);
+  else
+    raptor_serializer_serialize_statement(serializer, triple);
   return;
 }
 
@@ -164,7 +170,10 @@ relay_namespaces(void* user_data, raptor_namespace *nspace)
   if(report_namespace)
     print_namespaces(user_data, nspace);
 
-  raptor_serializer_set_namespace_from_namespace(rdf_serializer, nspace);
+  if(pipeline)
+    raptor_pipeline_set_namespace_from_namespace(pipeline, nspace);
+  else
+    raptor_serializer_set_namespace_from_namespace(rdf_serializer, nspace);
 }
 
 
@@ -189,10 +198,13 @@ relay_namespaces(void* user_data, raptor_namespace *nspace)
 #ifdef HAVE_GETOPT_LONG
 #define SHOW_NAMESPACES_FLAG 0x100
 #define SHOW_GRAPHS_FLAG 0x200
+#define COMPRESS_FLAG 0x400
+#define PIPELINE_FLAG 0x800
 
 static const struct option long_options[] =
 {
   /* name, has_arg, flag, val */
+  {"compress", 1, 0, COMPRESS_FLAG},
   {"count", 0, 0, 'c'},
   {"ignore-errors", 0, 0, 'e'},
   {"feature", 1, 0, 'f'},
@@ -202,6 +214,7 @@ static const struct option long_options[] =
   {"input-uri", 1, 0, 'I'},
   {"output", 1, 0, 'o'},
   {"output-uri", 1, 0, 'O'},
+  {"pipeline", 0, 0, PIPELINE_FLAG},
   {"quiet", 0, 0, 'q'},
   {"replace-newlines", 0, 0, 'r'},
   {"show-graphs", 0, 0, SHOW_GRAPHS_FLAG},
@@ -330,6 +343,8 @@ main(int argc, char *argv[])
   raptor_uri *output_base_uri = NULL;
   raptor_sequence* serializer_options = NULL;
   raptor_sequence *namespace_declarations = NULL;
+  const char *compression_name = NULL;
+  int use_pipeline = 0;
 
   /* other variables */
   int rc;
@@ -625,6 +640,18 @@ main(int argc, char *argv[])
         break;
 #endif
 
+#ifdef COMPRESS_FLAG
+      case COMPRESS_FLAG:
+        compression_name = optarg;
+        break;
+#endif
+
+#ifdef PIPELINE_FLAG
+      case PIPELINE_FLAG:
+        use_pipeline = 1;
+        break;
+#endif
+
     } /* end switch */
 
   }
@@ -700,6 +727,12 @@ main(int argc, char *argv[])
         putchar('\n');
     }
     puts(HELP_TEXT("O URI", "output-uri URI  ", "Set the output/serializer base URI. '-' for none.")  HELP_PAD "    Default is input/parser base URI.");
+#ifdef COMPRESS_FLAG
+    puts(HELP_TEXT_LONG("compress NAME   ", "Compress the output with gzip or zstd"));
+#endif
+#ifdef PIPELINE_FLAG
+    puts(HELP_TEXT_LONG("pipeline        ", "Serialize on a separate thread from parsing"));
+#endif
     putchar('\n');
 
     puts("General options:");
@@ -900,8 +933,25 @@ main(int argc, char *argv[])
       serializer_options = NULL;
     }
 
-    raptor_serializer_start_to_file_handle(serializer, 
-                                          output_base_uri, stdout);
+    if(compression_name)
+      raptor_serializer_set_option(serializer, RAPTOR_OPTION_COMPRESSION,
+                                   compression_name, 0);
+
+    if(raptor_serializer_start_to_file_handle(serializer,
+                                              output_base_uri, stdout)) {
+      fprintf(stderr, "%s: Failed to start serializing with serializer %s\n",
+              program, serializer_syntax_name);
+      return(1);
+    }
+
+    if(use_pipeline && !count) {
+      pipeline = raptor_new_pipeline(world, serializer);
+      if(!pipeline) {
+        fprintf(stderr, "%s: Failed to create serializer pipeline\n",
+                program);
+        return(1);
+      }
+    }
 
     if(!report_namespace)
       raptor_parser_set_namespace_handler(rdf_parser, serializer,
@@ -929,6 +979,12 @@ main(int argc, char *argv[])
 
   raptor_free_parser(rdf_parser);
 
+  if(pipeline) {
+    raptor_pipeline_end(pipeline);
+    raptor_free_pipeline(pipeline);
+    pipeline = NULL;
+  }
+
   if(serializer) {
     raptor_serializer_serialize_end(serializer);
     raptor_free_serializer(serializer);
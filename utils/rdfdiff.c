@@ -117,6 +117,8 @@ typedef struct {
   raptor_world *world;
   char *name;
   raptor_parser *parser;
+  /* owns all the statements in the lists */
+  raptor_statement_arena *arena;
   rdfdiff_link *first;
   rdfdiff_link *last;
   rdfdiff_blank *first_blank;
@@ -183,6 +185,12 @@ rdfdiff_new_file(raptor_world *world, const unsigned char *name, const char *syn
     file->name = RAPTOR_MALLOC(char*, strlen((const char*)name) + 1);
     strcpy((char*)file->name, (const char*)name);
     
+    file->arena = raptor_new_statement_arena(world);
+    if(!file->arena) {
+      rdfdiff_free_file(file);
+      return(0);
+    }
+
     file->parser = raptor_new_parser(world, syntax);
     if(file->parser) {
       raptor_world_set_log_handler(world, file, rdfdiff_log_handler);
@@ -215,7 +223,6 @@ rdfdiff_free_file(rdfdiff_file* file)
   for(cur = file->first; cur; cur = next) {
     next = cur->next;
 
-    raptor_free_statement(cur->statement);
     RAPTOR_FREE(rdfdiff_link, cur);
   }
 
@@ -224,6 +231,9 @@ rdfdiff_free_file(rdfdiff_file* file)
 
     rdfdiff_free_blank(cur1);
   }
+
+  if(file->arena)
+    raptor_free_statement_arena(file->arena);
   
   RAPTOR_FREE(rdfdiff_file, file);  
   
@@ -253,13 +263,9 @@ rdfdiff_free_blank(rdfdiff_blank *blank)
   if(blank->blank_id)
     RAPTOR_FREE(char*, blank->blank_id);
 
-  if(blank->owner)
-    raptor_free_statement(blank->owner);
-  
   for(cur = blank->first; cur; cur = next) {
     next = cur->next;
 
-    raptor_free_statement(cur->statement);
     RAPTOR_FREE(rdfdiff_link, cur);
   }
 
@@ -548,7 +554,7 @@ rdfdiff_add_blank_statement(rdfdiff_file* file,
   if(!dlink)
     goto failed;
   
-  dlink->statement = raptor_statement_copy(statement);
+  dlink->statement = raptor_statement_arena_copy(file->arena, statement);
   if(!dlink->statement) {
     RAPTOR_FREE(rdfdiff_link, dlink);
     goto failed;
@@ -582,10 +588,7 @@ rdfdiff_add_blank_statement_owner(rdfdiff_file* file,
   if(!blank)
     goto failed;
 
-  if(blank->owner)
-    raptor_free_statement(blank->owner);
-
-  blank->owner = raptor_statement_copy(statement);
+  blank->owner = raptor_statement_arena_copy(file->arena, statement);
   if(!blank->owner)
     goto failed;
 
@@ -606,7 +609,7 @@ rdfdiff_add_statement(rdfdiff_file* file, raptor_statement *statement)
 
   if(dlink) {
 
-    dlink->statement = raptor_statement_copy(statement);
+    dlink->statement = raptor_statement_arena_copy(file->arena, statement);
 
     if(dlink->statement) {
       
@@ -734,6 +737,8 @@ main(int argc, char *argv[])
   world = raptor_new_world();
   if(!world)
     exit(1);
+  /* both graphs repeat the same literals and blank nodes; share them */
+  raptor_world_set_flag(world, RAPTOR_WORLD_FLAG_TERM_INTERNING, 1);
   rv = raptor_world_open(world);
   if(rv)
     exit(1);
@@ -904,7 +909,6 @@ main(int argc, char *argv[])
       } else {
         prev->next = node->next;
       }
-      raptor_free_statement(node->statement);
       RAPTOR_FREE(rdfdiff_link, node);
     } else {
       if(!brief) {